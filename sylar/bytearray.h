@@ -0,0 +1,283 @@
+/**
+ * @file bytearray.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 二进制数组(序列化/反序列化)
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __BYTEARRAY__H__
+#define __BYTEARRAY__H__
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sylar {
+
+/// @brief 二进制数组, 提供基础类型的序列化与反序列化
+/// @details 数据保存在固定大小的内存块组成的链表中, 追加写入不需要搬移已有数据.
+///          读写共用一个位置, 写入从当前位置覆盖或追加, 读取从当前位置读出.
+///          getReadBuffers/getWriteBuffers返回块的iovec, 配合recvmsg/sendmsg
+///          直接在块上收发, 不经过中间缓冲区.
+///          越界读取抛出std::out_of_range
+class ByteArray {
+public:
+  typedef std::shared_ptr<ByteArray> ptr;
+
+  /// @brief ByteArray的存储节点
+  struct Node {
+    /// @brief 构造指定大小的内存块
+    /// @param s 内存块字节数
+    Node(size_t s);
+
+    /// @brief 无参构造函数
+    Node();
+
+    /// @brief 析构函数, 释放内存
+    ~Node();
+
+    /// 内存块地址指针
+    char *ptr;
+    /// 下一个内存块地址
+    Node *next;
+    /// 内存块大小
+    size_t size;
+  };
+
+  /// @brief 使用指定长度的内存块构造ByteArray
+  /// @param base_size 内存块大小
+  ByteArray(size_t base_size = 4096);
+
+  /// @brief 析构函数
+  ~ByteArray();
+
+  /// @brief 写入固定长度int8_t类型的数据
+  /// @post m_position += sizeof(value), 如果m_position > m_size 则 m_size = m_position
+  void writeFint8(int8_t value);
+
+  /// @brief 写入固定长度uint8_t类型的数据
+  void writeFuint8(uint8_t value);
+
+  /// @brief 写入固定长度int16_t类型的数据(大端/小端)
+  void writeFint16(int16_t value);
+
+  /// @brief 写入固定长度uint16_t类型的数据(大端/小端)
+  void writeFuint16(uint16_t value);
+
+  /// @brief 写入固定长度int32_t类型的数据(大端/小端)
+  void writeFint32(int32_t value);
+
+  /// @brief 写入固定长度uint32_t类型的数据(大端/小端)
+  void writeFuint32(uint32_t value);
+
+  /// @brief 写入固定长度int64_t类型的数据(大端/小端)
+  void writeFint64(int64_t value);
+
+  /// @brief 写入固定长度uint64_t类型的数据(大端/小端)
+  void writeFuint64(uint64_t value);
+
+  /// @brief 写入有符号Varint32类型的数据(zigzag编码, 绝对值小的负数同样短)
+  void writeInt32(int32_t value);
+
+  /// @brief 写入无符号Varint32类型的数据
+  void writeUint32(uint32_t value);
+
+  /// @brief 写入有符号Varint64类型的数据(zigzag编码)
+  void writeInt64(int64_t value);
+
+  /// @brief 写入无符号Varint64类型的数据
+  void writeUint64(uint64_t value);
+
+  /// @brief 写入float类型的数据
+  void writeFloat(float value);
+
+  /// @brief 写入double类型的数据
+  void writeDouble(double value);
+
+  /// @brief 写入std::string类型的数据, 用uint16_t作为长度类型
+  void writeStringF16(const std::string &value);
+
+  /// @brief 写入std::string类型的数据, 用uint32_t作为长度类型
+  void writeStringF32(const std::string &value);
+
+  /// @brief 写入std::string类型的数据, 用uint64_t作为长度类型
+  void writeStringF64(const std::string &value);
+
+  /// @brief 写入std::string类型的数据, 用无符号Varint64作为长度类型
+  void writeStringVint(const std::string &value);
+
+  /// @brief 写入std::string类型的数据, 无长度
+  void writeStringWithoutLength(const std::string &value);
+
+  /// @brief 读取int8_t类型的数据
+  /// @pre getReadSize() >= sizeof(int8_t)
+  /// @post m_position += sizeof(int8_t);
+  /// @exception 如果getReadSize() < sizeof(int8_t) 抛出 std::out_of_range
+  int8_t readFint8();
+
+  /// @brief 读取uint8_t类型的数据
+  uint8_t readFuint8();
+
+  /// @brief 读取int16_t类型的数据
+  int16_t readFint16();
+
+  /// @brief 读取uint16_t类型的数据
+  uint16_t readFuint16();
+
+  /// @brief 读取int32_t类型的数据
+  int32_t readFint32();
+
+  /// @brief 读取uint32_t类型的数据
+  uint32_t readFuint32();
+
+  /// @brief 读取int64_t类型的数据
+  int64_t readFint64();
+
+  /// @brief 读取uint64_t类型的数据
+  uint64_t readFuint64();
+
+  /// @brief 读取有符号Varint32类型的数据
+  int32_t readInt32();
+
+  /// @brief 读取无符号Varint32类型的数据
+  uint32_t readUint32();
+
+  /// @brief 读取有符号Varint64类型的数据
+  int64_t readInt64();
+
+  /// @brief 读取无符号Varint64类型的数据
+  uint64_t readUint64();
+
+  /// @brief 读取float类型的数据
+  float readFloat();
+
+  /// @brief 读取double类型的数据
+  double readDouble();
+
+  /// @brief 读取std::string类型的数据, 用uint16_t作为长度
+  std::string readStringF16();
+
+  /// @brief 读取std::string类型的数据, 用uint32_t作为长度
+  std::string readStringF32();
+
+  /// @brief 读取std::string类型的数据, 用uint64_t作为长度
+  std::string readStringF64();
+
+  /// @brief 读取std::string类型的数据, 用无符号Varint64作为长度
+  std::string readStringVint();
+
+  /// @brief 清空ByteArray, 只保留第一个内存块
+  /// @post m_position = 0, m_size = 0
+  void clear();
+
+  /// @brief 写入size长度的数据
+  /// @param buf 内存缓存指针
+  /// @param size 数据大小
+  void write(const void *buf, size_t size);
+
+  /// @brief 读取size长度的数据
+  /// @exception 如果getReadSize() < size 则抛出 std::out_of_range
+  void read(void *buf, size_t size);
+
+  /// @brief 从position开始读取size长度的数据, 不改变当前位置
+  /// @exception 如果 (m_size - position) < size 则抛出 std::out_of_range
+  void read(void *buf, size_t size, size_t position) const;
+
+  /// @brief 返回ByteArray当前位置
+  size_t getPosition() const {
+    return m_position;
+  }
+
+  /// @brief 设置ByteArray当前位置
+  /// @post 如果m_position > m_size 则 m_size = m_position
+  /// @exception 如果m_position > m_capacity 则抛出 std::out_of_range
+  void setPosition(size_t v);
+
+  /// @brief 释放当前位置之前已完整读过的内存块
+  /// @details 用于持续收发的缓冲区, 已解析的数据不再占用内存.
+  ///          释放的字节数从m_position与m_size中扣除
+  void discardRead();
+
+  /// @brief 返回内存块的大小
+  size_t getBaseSize() const {
+    return m_baseSize;
+  }
+
+  /// @brief 返回可读取数据大小
+  size_t getReadSize() const {
+    return m_size - m_position;
+  }
+
+  /// @brief 是否是小端
+  bool isLittleEndian() const;
+
+  /// @brief 设置是否为小端, 默认大端(网络字节序)
+  void setIsLittleEndian(bool val);
+
+  /// @brief 将ByteArray里面的数据[m_position, m_size)转成std::string
+  std::string toString() const;
+
+  /// @brief 将ByteArray里面的数据[m_position, m_size)转成16进制的std::string
+  ///        (格式:FF FF FF)
+  std::string toHexString() const;
+
+  /// @brief 获取可读取的缓存, 保存成iovec数组
+  /// @param[out] buffers 保存可读取数据的iovec数组
+  /// @param[in] len 读取数据的长度, 如果len > getReadSize() 则 len = getReadSize()
+  /// @return 返回实际数据的长度
+  uint64_t getReadBuffers(std::vector<iovec> &buffers,
+                          uint64_t            len = ~0ull) const;
+
+  /// @brief 获取可读取的缓存, 保存成iovec数组, 从position位置开始
+  uint64_t getReadBuffers(std::vector<iovec> &buffers,
+                          uint64_t            len,
+                          uint64_t            position) const;
+
+  /// @brief 获取可写入的缓存, 保存成iovec数组
+  /// @details 容量不足时追加内存块, 不改变当前位置.
+  ///          写入n字节后调用setPosition(getPosition() + n)
+  /// @return 返回实际的长度
+  uint64_t getWriteBuffers(std::vector<iovec> &buffers, uint64_t len);
+
+  /// @brief 返回数据的长度
+  size_t getSize() const {
+    return m_size;
+  }
+
+private:
+  /// @brief 扩容ByteArray, 使其可以容纳size个数据(如果原本可以容纳, 则不扩容)
+  void addCapacity(size_t size);
+
+  /// @brief 获取当前的可写入容量
+  size_t getCapacity() const {
+    return m_capacity - m_position;
+  }
+
+private:
+  /// 内存块的大小
+  size_t m_baseSize;
+  /// 当前操作位置
+  size_t m_position;
+  /// 当前的总容量
+  size_t m_capacity;
+  /// 当前数据的大小
+  size_t m_size;
+  /// 字节序, 默认大端
+  int8_t m_endian;
+  /// 第一个内存块指针
+  Node *m_root;
+  /// 当前操作的内存块指针
+  Node *m_cur;
+};
+
+}  // namespace sylar
+
+#endif /* __BYTEARRAY__H__ */
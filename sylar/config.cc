@@ -0,0 +1,334 @@
+#include "sylar/config.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+/// 日志配置, 对应log.yml的logs节点, 变化时重置对应的日志器
+static ConfigVar<YAML::Node>::ptr g_log_defines = Config::Lookup(
+    "logs", YAML::Node(YAML::NodeType::Sequence), "logs config");
+
+/// 异步日志配置, 对应log.yml的log_async节点
+static ConfigVar<YAML::Node>::ptr g_log_async =
+    Config::Lookup("log_async", YAML::Node(), "async logs config");
+
+struct LogIniter {
+  LogIniter() {
+    g_log_defines->addListener(
+        [](const YAML::Node &old_value, const YAML::Node &new_value) {
+          SYLAR_LOG_INFO(g_logger) << "on_logger_conf_changed";
+          LoggerMgr::GetInstance()->init(new_value);
+        });
+    g_log_async->addListener(
+        [](const YAML::Node &old_value, const YAML::Node &new_value) {
+          LoggerMgr::GetInstance()->initAsync(new_value);
+        });
+  }
+};
+
+static LogIniter __log_init;
+
+ConfigVarBase::ptr Config::LookupBase(const std::string &name) {
+  RWMutexType::ReadLock lock(GetMutex());
+  auto                  it = GetDatas().find(name);
+  return it == GetDatas().end() ? nullptr : it->second;
+}
+
+// "A.B", 10
+// A:
+//   B: 10
+//   C: str
+static void ListAllMember(
+    const std::string                                         &prefix,
+    const YAML::Node                                          &node,
+    std::list<std::pair<std::string, const YAML::Node> >      &output) {
+  if (prefix.find_first_not_of("abcdefghijklmnopqrstuvwxyz._0123456789") !=
+      std::string::npos) {
+    SYLAR_LOG_DEBUG(g_logger) << "Config invalid name: " << prefix;
+    return;
+  }
+  output.push_back(std::make_pair(prefix, node));
+  if (node.IsMap()) {
+    for (auto it = node.begin(); it != node.end(); ++it) {
+      std::string key = it->first.Scalar();
+      std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+      ListAllMember(prefix.empty() ? key : prefix + "." + key,
+                    it->second,
+                    output);
+    }
+  }
+}
+
+void Config::LoadFromYaml(const YAML::Node &root) {
+  std::list<std::pair<std::string, const YAML::Node> > all_nodes;
+  ListAllMember("", root, all_nodes);
+
+  for (auto &i : all_nodes) {
+    const std::string &key = i.first;
+    if (key.empty()) {
+      continue;
+    }
+    ConfigVarBase::ptr var = LookupBase(key);
+    if (var) {
+      if (i.second.IsScalar()) {
+        var->fromString(i.second.Scalar());
+      } else {
+        std::stringstream ss;
+        ss << i.second;
+        var->fromString(ss.str());
+      }
+    }
+  }
+}
+
+/// @brief 递归列出目录下后缀为subfix的文件
+static void ListAllFile(std::vector<std::string> &files,
+                        const std::string        &path,
+                        const std::string        &subfix) {
+  DIR *dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  struct dirent *dp = nullptr;
+  while ((dp = readdir(dir)) != nullptr) {
+    std::string name = dp->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    std::string file = path + "/" + name;
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0) {
+      continue;
+    }
+    if (S_ISDIR(st.st_mode)) {
+      ListAllFile(files, file, subfix);
+    } else if (S_ISREG(st.st_mode) && name.size() > subfix.size() &&
+               name.compare(name.size() - subfix.size(),
+                            subfix.size(),
+                            subfix) == 0) {
+      files.push_back(file);
+    }
+  }
+  closedir(dir);
+}
+
+void Config::LoadFromConfDir(const std::string &path, bool force) {
+  static std::map<std::string, uint64_t> s_file2modifytime;
+  static Mutex                           s_mutex;
+
+  std::vector<std::string> files;
+  ListAllFile(files, path, ".yml");
+  std::sort(files.begin(), files.end());
+
+  // 串行化重新加载, 保证监听器按文件顺序观察到变化
+  Mutex::Lock lock(s_mutex);
+  for (auto &i : files) {
+    struct stat st;
+    if (stat(i.c_str(), &st) != 0) {
+      continue;
+    }
+    uint64_t mtime =
+        uint64_t(st.st_mtim.tv_sec) * 1000000000ull + st.st_mtim.tv_nsec;
+    if (!force && s_file2modifytime[i] == mtime) {
+      continue;
+    }
+    s_file2modifytime[i] = mtime;
+    try {
+      YAML::Node root = YAML::LoadFile(i);
+      LoadFromYaml(root);
+      SYLAR_LOG_INFO(g_logger) << "LoadConfFile file=" << i << " ok";
+    } catch (std::exception &e) {
+      SYLAR_LOG_ERROR(g_logger)
+          << "LoadConfFile file=" << i << " failed: " << e.what();
+    }
+  }
+}
+
+void Config::Visit(std::function<void(ConfigVarBase::ptr)> cb) {
+  RWMutexType::ReadLock lock(GetMutex());
+  ConfigVarMap         &m = GetDatas();
+  for (auto it = m.begin(); it != m.end(); ++it) {
+    cb(it->second);
+  }
+}
+
+ConfigWatcher::ConfigWatcher(const std::string &path, uint64_t delay_ms)
+    : m_path(path), m_delay(delay_ms) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+  stop();
+}
+
+bool ConfigWatcher::start() {
+  if (m_thread.joinable()) {
+    return true;
+  }
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyFd < 0) {
+    SYLAR_LOG_ERROR(g_logger) << "ConfigWatcher inotify_init1 errno=" << errno
+                              << " errstr=" << strerror(errno);
+    return false;
+  }
+  if (!addWatch(m_path)) {
+    close(m_inotifyFd);
+    m_inotifyFd = -1;
+    m_watches.clear();
+    return false;
+  }
+  m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_eventFd < 0) {
+    SYLAR_LOG_ERROR(g_logger) << "ConfigWatcher eventfd errno=" << errno
+                              << " errstr=" << strerror(errno);
+    close(m_inotifyFd);
+    m_inotifyFd = -1;
+    return false;
+  }
+  m_thread = std::thread(&ConfigWatcher::run, this);
+  return true;
+}
+
+void ConfigWatcher::stop() {
+  if (!m_thread.joinable()) {
+    return;
+  }
+  uint64_t one = 1;
+  if (write(m_eventFd, &one, sizeof(one)) != sizeof(one)) {
+    SYLAR_LOG_ERROR(g_logger) << "ConfigWatcher stop write eventfd errno="
+                              << errno << " errstr=" << strerror(errno);
+  }
+  m_thread.join();
+  close(m_inotifyFd);
+  close(m_eventFd);
+  m_inotifyFd = -1;
+  m_eventFd   = -1;
+  m_watches.clear();
+}
+
+bool ConfigWatcher::addWatch(const std::string &path) {
+  // IN_CREATE只用于发现新建的子目录, 文件在写完(IN_CLOSE_WRITE)时才加载
+  int wd = inotify_add_watch(
+      m_inotifyFd,
+      path.c_str(),
+      IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB | IN_CREATE | IN_ONLYDIR);
+  if (wd < 0) {
+    SYLAR_LOG_ERROR(g_logger)
+        << "ConfigWatcher inotify_add_watch path=" << path
+        << " errno=" << errno << " errstr=" << strerror(errno);
+    return false;
+  }
+  m_watches[wd] = path;
+
+  DIR *dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return true;
+  }
+  struct dirent *dp = nullptr;
+  while ((dp = readdir(dir)) != nullptr) {
+    std::string name = dp->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    std::string sub = path + "/" + name;
+    struct stat st;
+    // 与ListAllFile一致, 跟随指向目录的符号链接
+    if (stat(sub.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      addWatch(sub);
+    }
+  }
+  closedir(dir);
+  return true;
+}
+
+void ConfigWatcher::run() {
+  pthread_setname_np(pthread_self(), "conf_watcher");
+  typedef std::chrono::steady_clock clock;
+
+  bool              pending = false;
+  clock::time_point deadline;
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  while (true) {
+    struct pollfd fds[2];
+    fds[0].fd     = m_inotifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = m_eventFd;
+    fds[1].events = POLLIN;
+
+    int timeout = -1;
+    if (pending) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - clock::now());
+      timeout = std::max<int64_t>(0, left.count() + 1);
+    }
+    int rt = poll(fds, 2, timeout);
+    if (rt < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      SYLAR_LOG_ERROR(g_logger) << "ConfigWatcher poll errno=" << errno
+                                << " errstr=" << strerror(errno);
+      break;
+    }
+    if (fds[1].revents & POLLIN) {
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      ssize_t len = 0;
+      while ((len = read(m_inotifyFd, buf, sizeof(buf))) > 0) {
+        for (char *ptr = buf; ptr < buf + len;) {
+          const struct inotify_event *ev = (const struct inotify_event *)ptr;
+          ptr += sizeof(struct inotify_event) + ev->len;
+
+          std::string name = ev->len ? ev->name : "";
+          bool        yml  = name.size() > 4 &&
+                     name.compare(name.size() - 4, 4, ".yml") == 0;
+          bool subdir = (ev->mask & IN_ISDIR) &&
+                        (ev->mask & (IN_CREATE | IN_MOVED_TO));
+          if (subdir) {
+            // 新的子目录在加入监听前可能已经写入了文件, 一并重新加载
+            auto it = m_watches.find(ev->wd);
+            if (it != m_watches.end()) {
+              addWatch(it->second + "/" + name);
+            }
+          }
+          if (ev->mask & IN_IGNORED) {
+            m_watches.erase(ev->wd);
+          }
+          if (ev->mask & IN_Q_OVERFLOW) {
+            // 事件丢失时可能漏掉了新建的子目录, 重新扫描, 已监听的目录wd不变
+            addWatch(m_path);
+          }
+          if ((yml && !(ev->mask & IN_CREATE)) || subdir ||
+              (ev->mask & IN_Q_OVERFLOW)) {
+            // 编辑器保存通常产生多个事件, 推迟到窗口结束时一次加载
+            pending  = true;
+            deadline = clock::now() + std::chrono::milliseconds(m_delay);
+          }
+        }
+      }
+    }
+
+    if (pending && clock::now() >= deadline) {
+      pending = false;
+      SYLAR_LOG_INFO(g_logger) << "ConfigWatcher reload path=" << m_path;
+      Config::LoadFromConfDir(m_path);
+      m_reloads.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace sylar
@@ -0,0 +1,715 @@
+/**
+ * @file config.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 配置模块, 支持热加载
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __CONFIG__H__
+#define __CONFIG__H__
+
+#include <cxxabi.h>
+#include <stdint.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "sylar/log.h"
+#include "sylar/mutex.h"
+#include "sylar/noncopyable.h"
+
+namespace sylar {
+
+/// @brief 返回类型T的可读名称
+template <class T>
+const char *TypeToName() {
+  static const char *s_name =
+      abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, nullptr);
+  return s_name;
+}
+
+/// @brief 配置变量的基类
+class ConfigVarBase {
+public:
+  typedef std::shared_ptr<ConfigVarBase> ptr;
+
+  /// @brief 构造函数
+  /// @param name 配置参数名称[0-9a-z_.], 大写字母转换为小写
+  /// @param description 配置参数描述
+  ConfigVarBase(const std::string &name, const std::string &description = "")
+      : m_name(name),
+        m_description(description),
+        m_id(s_nextId.fetch_add(1, std::memory_order_relaxed)) {
+    std::transform(m_name.begin(), m_name.end(), m_name.begin(), ::tolower);
+  }
+
+  virtual ~ConfigVarBase() {
+  }
+
+  /// @brief 返回配置参数名称
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  /// @brief 返回配置参数的描述
+  const std::string &getDescription() const {
+    return m_description;
+  }
+
+  /// @brief 返回进程内唯一的配置变量编号, 从0开始连续分配
+  uint32_t getId() const {
+    return m_id;
+  }
+
+  /// @brief 转成字符串
+  virtual std::string toString() = 0;
+
+  /// @brief 从字符串初始化值
+  virtual bool fromString(const std::string &val) = 0;
+
+  /// @brief 返回配置参数值的类型名称
+  virtual std::string getTypeName() const = 0;
+
+protected:
+  /// 配置参数的名称
+  std::string m_name;
+  /// 配置参数的描述
+  std::string m_description;
+  /// 配置变量编号, 用作线程局部缓存的下标
+  uint32_t m_id;
+
+private:
+  /// 下一个配置变量编号
+  static inline std::atomic<uint32_t> s_nextId{0};
+};
+
+/// @brief 类型转换模板类(F 源类型, T 目标类型)
+/// @details 基础类型通过yaml-cpp完成与std::string的转换,
+///          自定义类型可以特化 LexicalCast<std::string, T> 与
+///          LexicalCast<T, std::string>, 或特化 YAML::convert<T>
+template <class F, class T>
+class LexicalCast;
+
+/// @brief 类型转换模板类(std::string 转换成 T)
+template <class T>
+class LexicalCast<std::string, T> {
+public:
+  T operator()(const std::string &v) {
+    return YAML::Load(v).as<T>();
+  }
+};
+
+/// @brief 类型转换模板类(T 转换成 std::string)
+template <class T>
+class LexicalCast<T, std::string> {
+public:
+  std::string operator()(const T &v) {
+    YAML::Node        node(v);
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 类型转换模板类(std::string 转换成 std::string)
+template <>
+class LexicalCast<std::string, std::string> {
+public:
+  std::string operator()(const std::string &v) {
+    return v;
+  }
+};
+
+/// @brief 类型转换模板类(std::string 转换成 YAML::Node)
+template <>
+class LexicalCast<std::string, YAML::Node> {
+public:
+  YAML::Node operator()(const std::string &v) {
+    return YAML::Load(v);
+  }
+};
+
+/// @brief 类型转换模板类(YAML::Node 转换成 std::string)
+template <>
+class LexicalCast<YAML::Node, std::string> {
+public:
+  std::string operator()(const YAML::Node &v) {
+    std::stringstream ss;
+    ss << v;
+    return ss.str();
+  }
+};
+
+/// @brief 判断两个配置值是否相等, 相等时setValue不通知监听器
+template <class T>
+class ConfigValueEqual {
+public:
+  bool operator()(const T &a, const T &b) {
+    return a == b;
+  }
+};
+
+/// @brief YAML::Node的==比较的是节点身份, 重新加载得到的新节点总是不相等,
+///        改为比较序列化结果
+template <>
+class ConfigValueEqual<YAML::Node> {
+public:
+  bool operator()(const YAML::Node &a, const YAML::Node &b) {
+    return a.is(b) || LexicalCast<YAML::Node, std::string>()(a) ==
+                          LexicalCast<YAML::Node, std::string>()(b);
+  }
+};
+
+/// @brief 容器元素的yaml节点转成字符串, 标量直接返回原文
+inline std::string YamlNodeToString(const YAML::Node &node) {
+  if (node.IsScalar()) {
+    return node.Scalar();
+  }
+  std::stringstream ss;
+  ss << node;
+  return ss.str();
+}
+
+/// @brief 容器元素转成yaml节点, 字符串作为标量保存
+template <class T>
+YAML::Node ValueToYamlNode(const T &v) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    return YAML::Node(v);
+  } else {
+    return YAML::Load(LexicalCast<T, std::string>()(v));
+  }
+}
+
+/// @brief 类型转换模板类片特化(YAML String 转换成 std::vector<T>)
+template <class T>
+class LexicalCast<std::string, std::vector<T> > {
+public:
+  std::vector<T> operator()(const std::string &v) {
+    YAML::Node     node = YAML::Load(v);
+    std::vector<T> vec;
+    for (size_t i = 0; i < node.size(); ++i) {
+      vec.push_back(LexicalCast<std::string, T>()(YamlNodeToString(node[i])));
+    }
+    return vec;
+  }
+};
+
+/// @brief 类型转换模板类片特化(std::vector<T> 转换成 YAML String)
+template <class T>
+class LexicalCast<std::vector<T>, std::string> {
+public:
+  std::string operator()(const std::vector<T> &v) {
+    YAML::Node node(YAML::NodeType::Sequence);
+    for (auto &i : v) {
+      node.push_back(ValueToYamlNode(i));
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 类型转换模板类片特化(YAML String 转换成 std::list<T>)
+template <class T>
+class LexicalCast<std::string, std::list<T> > {
+public:
+  std::list<T> operator()(const std::string &v) {
+    YAML::Node   node = YAML::Load(v);
+    std::list<T> vec;
+    for (size_t i = 0; i < node.size(); ++i) {
+      vec.push_back(LexicalCast<std::string, T>()(YamlNodeToString(node[i])));
+    }
+    return vec;
+  }
+};
+
+/// @brief 类型转换模板类片特化(std::list<T> 转换成 YAML String)
+template <class T>
+class LexicalCast<std::list<T>, std::string> {
+public:
+  std::string operator()(const std::list<T> &v) {
+    YAML::Node node(YAML::NodeType::Sequence);
+    for (auto &i : v) {
+      node.push_back(ValueToYamlNode(i));
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 类型转换模板类片特化(YAML String 转换成 std::set<T>)
+template <class T>
+class LexicalCast<std::string, std::set<T> > {
+public:
+  std::set<T> operator()(const std::string &v) {
+    YAML::Node  node = YAML::Load(v);
+    std::set<T> vec;
+    for (size_t i = 0; i < node.size(); ++i) {
+      vec.insert(LexicalCast<std::string, T>()(YamlNodeToString(node[i])));
+    }
+    return vec;
+  }
+};
+
+/// @brief 类型转换模板类片特化(std::set<T> 转换成 YAML String)
+template <class T>
+class LexicalCast<std::set<T>, std::string> {
+public:
+  std::string operator()(const std::set<T> &v) {
+    YAML::Node node(YAML::NodeType::Sequence);
+    for (auto &i : v) {
+      node.push_back(ValueToYamlNode(i));
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 类型转换模板类片特化(YAML String 转换成 std::unordered_set<T>)
+template <class T>
+class LexicalCast<std::string, std::unordered_set<T> > {
+public:
+  std::unordered_set<T> operator()(const std::string &v) {
+    YAML::Node            node = YAML::Load(v);
+    std::unordered_set<T> vec;
+    for (size_t i = 0; i < node.size(); ++i) {
+      vec.insert(LexicalCast<std::string, T>()(YamlNodeToString(node[i])));
+    }
+    return vec;
+  }
+};
+
+/// @brief 类型转换模板类片特化(std::unordered_set<T> 转换成 YAML String)
+template <class T>
+class LexicalCast<std::unordered_set<T>, std::string> {
+public:
+  std::string operator()(const std::unordered_set<T> &v) {
+    YAML::Node node(YAML::NodeType::Sequence);
+    for (auto &i : v) {
+      node.push_back(ValueToYamlNode(i));
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 类型转换模板类片特化(YAML String 转换成 std::map<std::string, T>)
+template <class T>
+class LexicalCast<std::string, std::map<std::string, T> > {
+public:
+  std::map<std::string, T> operator()(const std::string &v) {
+    YAML::Node               node = YAML::Load(v);
+    std::map<std::string, T> vec;
+    for (auto it = node.begin(); it != node.end(); ++it) {
+      vec.insert(std::make_pair(
+          it->first.Scalar(),
+          LexicalCast<std::string, T>()(YamlNodeToString(it->second))));
+    }
+    return vec;
+  }
+};
+
+/// @brief 类型转换模板类片特化(std::map<std::string, T> 转换成 YAML String)
+template <class T>
+class LexicalCast<std::map<std::string, T>, std::string> {
+public:
+  std::string operator()(const std::map<std::string, T> &v) {
+    YAML::Node node(YAML::NodeType::Map);
+    for (auto &i : v) {
+      node[i.first] = ValueToYamlNode(i.second);
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 类型转换模板类片特化(YAML String 转换成 std::unordered_map<std::string, T>)
+template <class T>
+class LexicalCast<std::string, std::unordered_map<std::string, T> > {
+public:
+  std::unordered_map<std::string, T> operator()(const std::string &v) {
+    YAML::Node                         node = YAML::Load(v);
+    std::unordered_map<std::string, T> vec;
+    for (auto it = node.begin(); it != node.end(); ++it) {
+      vec.insert(std::make_pair(
+          it->first.Scalar(),
+          LexicalCast<std::string, T>()(YamlNodeToString(it->second))));
+    }
+    return vec;
+  }
+};
+
+/// @brief 类型转换模板类片特化(std::unordered_map<std::string, T> 转换成 YAML String)
+template <class T>
+class LexicalCast<std::unordered_map<std::string, T>, std::string> {
+public:
+  std::string operator()(const std::unordered_map<std::string, T> &v) {
+    YAML::Node node(YAML::NodeType::Map);
+    for (auto &i : v) {
+      node[i.first] = ValueToYamlNode(i.second);
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
+/// @brief 配置参数模板子类, 保存对应类型的参数值
+/// @details T 参数的具体类型
+///          FromStr 从std::string转换成T类型的仿函数
+///          ToStr 从T转换成std::string的仿函数
+///          值以不可变快照保存在atomic<shared_ptr>中, 更新时整体替换.
+///          libstdc++的atomic<shared_ptr>::load内部使用自旋锁并修改共享的引用计数,
+///          多线程并发调用getSnapshot会在同一缓存行上竞争, 并不比读写锁快.
+///          getValue不经过该锁:
+///          - 不超过8字节的平凡类型只有一次std::atomic<T>读取;
+///          - 其他类型读取线程局部缓存的快照, 版本号不变时只读一次版本号.
+///          需要避免拷贝的热路径可以持有Cached, 按引用读取
+///          写入与监听器回调由m_mutex串行化, 回调中不能修改同一个配置变量
+template <class T,
+          class FromStr = LexicalCast<std::string, T>,
+          class ToStr   = LexicalCast<T, std::string> >
+class ConfigVar : public ConfigVarBase {
+public:
+  typedef Mutex                      MutexType;
+  typedef std::shared_ptr<ConfigVar> ptr;
+  typedef std::function<void(const T &old_value, const T &new_value)>
+      on_change_cb;
+
+  /// @brief 通过参数名, 参数值, 描述构造ConfigVar
+  ConfigVar(const std::string &name,
+            const T           &default_value,
+            const std::string &description = "")
+      : ConfigVarBase(name, description),
+        m_val(std::make_shared<const T>(default_value)) {
+    if constexpr (kAtomic) {
+      m_atomic.store(default_value, std::memory_order_release);
+    }
+  }
+
+  /// @brief 将参数值转换成YAML String
+  std::string toString() override {
+    try {
+      return ToStr()(*getSnapshot());
+    } catch (std::exception &e) {
+      SYLAR_LOG_ERROR(SYLAR_LOG_NAME("system"))
+          << "ConfigVar::toString exception " << e.what()
+          << " convert: " << TypeToName<T>() << " to string"
+          << " name=" << m_name;
+    }
+    return "";
+  }
+
+  /// @brief 从YAML String转成参数的值, 值变化时通知监听器
+  bool fromString(const std::string &val) override {
+    try {
+      setValue(FromStr()(val));
+      return true;
+    } catch (std::exception &e) {
+      SYLAR_LOG_ERROR(SYLAR_LOG_NAME("system"))
+          << "ConfigVar::fromString exception " << e.what()
+          << " convert: string to " << TypeToName<T>() << " name=" << m_name
+          << " - " << val;
+    }
+    return false;
+  }
+
+  /// @brief 获取当前参数的值
+  /// @details 平凡类型只有一次原子读; 其他类型从当前线程缓存的快照拷贝,
+  ///          版本号变化时才经过atomic<shared_ptr>重新获取快照.
+  ///          setValue先替换快照再递增版本号, 读到新版本号时一定能取到新快照
+  T getValue() const {
+    if constexpr (kAtomic) {
+      return m_atomic.load(std::memory_order_acquire);
+    } else {
+      /// 按配置变量编号索引的线程局部快照, 每个ConfigVar类型一份
+      static thread_local std::vector<CacheEntry> t_cache;
+      if (m_id >= t_cache.size()) {
+        t_cache.resize(m_id + 1);
+      }
+      CacheEntry &e       = t_cache[m_id];
+      uint64_t    version = getVersion();
+      if (!e.val || e.version != version) {
+        e.val     = getSnapshot();
+        e.version = version;
+      }
+      return *e.val;
+    }
+  }
+
+  /// @brief 获取当前参数值的快照
+  /// @details 快照不会被修改, 持有期间参数更新不影响已获取的快照.
+  ///          每次调用都经过atomic<shared_ptr>的内部锁与引用计数, 不适合热路径
+  std::shared_ptr<const T> getSnapshot() const {
+    return m_val.load(std::memory_order_acquire);
+  }
+
+  /// @brief 返回参数值的版本号, 每次更新加1
+  uint64_t getVersion() const {
+    return m_version.load(std::memory_order_acquire);
+  }
+
+  /// @brief 设置当前参数的值, 值变化时按注册顺序通知监听器
+  void setValue(const T &v) {
+    MutexType::Lock          lock(m_mutex);
+    std::shared_ptr<const T> old = m_val.load(std::memory_order_relaxed);
+    if (ConfigValueEqual<T>()(*old, v)) {
+      return;
+    }
+    m_val.store(std::make_shared<const T>(v), std::memory_order_release);
+    if constexpr (kAtomic) {
+      m_atomic.store(v, std::memory_order_release);
+    }
+    m_version.fetch_add(1, std::memory_order_release);
+    for (auto &i : m_cbs) {
+      i.second(*old, v);
+    }
+  }
+
+  /// @brief 返回参数值的类型名称
+  std::string getTypeName() const override {
+    return TypeToName<T>();
+  }
+
+  /// @brief 添加变化回调函数
+  /// @return 返回该回调函数对应的唯一id, 用于删除回调
+  uint64_t addListener(on_change_cb cb) {
+    MutexType::Lock lock(m_mutex);
+    uint64_t        id = ++m_cbId;
+    m_cbs[id]          = cb;
+    return id;
+  }
+
+  /// @brief 删除回调函数
+  void delListener(uint64_t key) {
+    MutexType::Lock lock(m_mutex);
+    m_cbs.erase(key);
+  }
+
+  /// @brief 获取回调函数, 不存在返回nullptr
+  on_change_cb getListener(uint64_t key) {
+    MutexType::Lock lock(m_mutex);
+    auto            it = m_cbs.find(key);
+    return it == m_cbs.end() ? nullptr : it->second;
+  }
+
+  /// @brief 清理所有的回调函数
+  void clearListener() {
+    MutexType::Lock lock(m_mutex);
+    m_cbs.clear();
+  }
+
+  /// @brief 读取端缓存的参数快照
+  /// @details 由单个读取者持有(如线程局部变量), get()只读取一次版本号,
+  ///          版本变化时才重新获取快照, 避免多线程共同修改快照引用计数
+  class Cached {
+  public:
+    Cached(ConfigVar::ptr var) : m_var(var) {
+    }
+
+    /// @brief 返回参数值, 引用在下一次get()前有效
+    const T &get() {
+      uint64_t version = m_var->getVersion();
+      if (!m_val || version != m_version) {
+        m_val     = m_var->getSnapshot();
+        m_version = version;
+      }
+      return *m_val;
+    }
+
+  private:
+    ConfigVar::ptr           m_var;
+    std::shared_ptr<const T> m_val;
+    uint64_t                 m_version = 0;
+  };
+
+private:
+  /// @brief getValue的线程局部缓存项
+  struct CacheEntry {
+    uint64_t                 version = 0;
+    std::shared_ptr<const T> val;
+  };
+
+  /// 是否额外保存std::atomic<T>
+  static constexpr bool kAtomic =
+      std::is_trivially_copyable_v<T> &&
+      (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+  /// Mutex, 串行化写入与监听器
+  MutexType m_mutex;
+  /// 参数值快照
+  std::atomic<std::shared_ptr<const T> > m_val;
+  /// 平凡类型的参数值
+  std::conditional_t<kAtomic, std::atomic<T>, char> m_atomic{};
+  /// 版本号, 在参数值更新之后递增
+  std::atomic<uint64_t> m_version{0};
+  /// 变更回调函数组, uint64_t key, 要求唯一
+  std::map<uint64_t, on_change_cb> m_cbs;
+  uint64_t                         m_cbId = 0;
+};
+
+/// @brief ConfigVar的管理类
+/// @details 提供便捷的方法创建/访问ConfigVar
+class Config {
+public:
+  typedef std::unordered_map<std::string, ConfigVarBase::ptr> ConfigVarMap;
+  typedef RWMutex                                              RWMutexType;
+
+  /// @brief 获取/创建对应参数名的配置参数
+  /// @param name 配置参数名称
+  /// @param default_value 参数默认值
+  /// @param description 参数描述
+  /// @details 获取参数名为name的配置参数, 如果存在直接返回;
+  ///          如果不存在, 创建参数配置并用default_value赋值
+  /// @return 返回对应的配置参数, 如果参数名存在但是类型不匹配则返回nullptr
+  /// @exception 如果参数名包含非法字符[^0-9a-z_.] 抛出异常 std::invalid_argument
+  template <class T>
+  static typename ConfigVar<T>::ptr Lookup(
+      const std::string &name,
+      const T           &default_value,
+      const std::string &description = "") {
+    RWMutexType::WriteLock lock(GetMutex());
+    auto                   it = GetDatas().find(name);
+    if (it != GetDatas().end()) {
+      auto tmp = std::dynamic_pointer_cast<ConfigVar<T> >(it->second);
+      if (tmp) {
+        return tmp;
+      }
+      SYLAR_LOG_ERROR(SYLAR_LOG_NAME("system"))
+          << "Lookup name=" << name << " exists but type not "
+          << TypeToName<T>() << " real_type=" << it->second->getTypeName()
+          << " " << it->second->toString();
+      return nullptr;
+    }
+
+    if (name.find_first_not_of("abcdefghijklmnopqrstuvwxyz._0123456789") !=
+        std::string::npos) {
+      SYLAR_LOG_ERROR(SYLAR_LOG_NAME("system"))
+          << "Lookup name invalid " << name;
+      throw std::invalid_argument(name);
+    }
+
+    typename ConfigVar<T>::ptr v(
+        new ConfigVar<T>(name, default_value, description));
+    GetDatas()[name] = v;
+    return v;
+  }
+
+  /// @brief 查找配置参数
+  /// @return 返回配置参数名为name的配置参数, 不存在或类型不匹配返回nullptr
+  template <class T>
+  static typename ConfigVar<T>::ptr Lookup(const std::string &name) {
+    RWMutexType::ReadLock lock(GetMutex());
+    auto                  it = GetDatas().find(name);
+    if (it == GetDatas().end()) {
+      return nullptr;
+    }
+    return std::dynamic_pointer_cast<ConfigVar<T> >(it->second);
+  }
+
+  /// @brief 使用YAML::Node初始化配置模块
+  static void LoadFromYaml(const YAML::Node &root);
+
+  /// @brief 加载path文件夹里面的配置文件(*.yml)
+  /// @param path 目录
+  /// @param force 为false时跳过修改时间未变化的文件
+  static void LoadFromConfDir(const std::string &path, bool force = false);
+
+  /// @brief 查找配置参数, 返回配置参数的基类
+  static ConfigVarBase::ptr LookupBase(const std::string &name);
+
+  /// @brief 遍历配置模块里面所有配置项
+  static void Visit(std::function<void(ConfigVarBase::ptr)> cb);
+
+private:
+  /// @brief 返回所有的配置项
+  static ConfigVarMap &GetDatas() {
+    static ConfigVarMap s_datas;
+    return s_datas;
+  }
+
+  /// @brief 配置项的RWMutex
+  static RWMutexType &GetMutex() {
+    static RWMutexType s_mutex;
+    return s_mutex;
+  }
+};
+
+/// @brief 配置目录监听器
+/// @details 使用inotify监听目录及其子目录中文件的写入/移入/属性变化,
+///          与LoadFromConfDir的递归加载一致, 之后新建或移入的子目录也会加入监听,
+///          合并delay_ms内的多次变化后调用Config::LoadFromConfDir重新加载,
+///          配置变量的监听器在监听线程中执行
+class ConfigWatcher : Noncopyable {
+public:
+  typedef std::shared_ptr<ConfigWatcher> ptr;
+
+  /// @brief 构造函数
+  /// @param path 配置目录
+  /// @param delay_ms 合并变化的时间窗口
+  ConfigWatcher(const std::string &path, uint64_t delay_ms = 200);
+
+  /// @brief 析构函数, 停止监听
+  ~ConfigWatcher();
+
+  /// @brief 开始监听
+  /// @return 是否成功
+  bool start();
+
+  /// @brief 停止监听
+  void stop();
+
+  /// @brief 返回重新加载的次数
+  uint64_t getReloadCount() const {
+    return m_reloads.load(std::memory_order_relaxed);
+  }
+
+private:
+  /// @brief 监听线程主函数
+  void run();
+
+  /// @brief 递归监听path及其子目录
+  /// @return path本身是否监听成功
+  bool addWatch(const std::string &path);
+
+private:
+  /// 配置目录
+  std::string m_path;
+  /// 合并变化的时间窗口
+  uint64_t m_delay;
+  /// inotify fd
+  int m_inotifyFd = -1;
+  /// 用于停止监听线程的eventfd
+  int m_eventFd = -1;
+  /// inotify watch descriptor -> 目录, 只在start与监听线程中访问
+  std::unordered_map<int, std::string> m_watches;
+  /// 重新加载的次数
+  std::atomic<uint64_t> m_reloads{0};
+  /// 监听线程
+  std::thread m_thread;
+};
+
+}  // namespace sylar
+
+#endif /* __CONFIG__H__ */
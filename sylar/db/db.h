@@ -0,0 +1,166 @@
+/**
+ * @file db.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 数据库访问接口
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_DB_DB__H__
+#define __SYLAR_DB_DB__H__
+
+#include <stdint.h>
+#include <time.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace sylar {
+
+/// @brief 查询结果集, 按行遍历
+class ISQLData {
+public:
+  typedef std::shared_ptr<ISQLData> ptr;
+
+  virtual ~ISQLData() {
+  }
+
+  virtual int                getErrno() const  = 0;
+  virtual const std::string &getErrStr() const = 0;
+
+  /// @brief 列数
+  virtual int getColumnCount() = 0;
+  /// @brief 列数据长度
+  virtual int getColumnBytes(int idx) = 0;
+  /// @brief 列名
+  virtual std::string getColumnName(int idx) = 0;
+
+  virtual bool        isNull(int idx)    = 0;
+  virtual int8_t      getInt8(int idx)   = 0;
+  virtual uint8_t     getUint8(int idx)  = 0;
+  virtual int16_t     getInt16(int idx)  = 0;
+  virtual uint16_t    getUint16(int idx) = 0;
+  virtual int32_t     getInt32(int idx)  = 0;
+  virtual uint32_t    getUint32(int idx) = 0;
+  virtual int64_t     getInt64(int idx)  = 0;
+  virtual uint64_t    getUint64(int idx) = 0;
+  virtual float       getFloat(int idx)  = 0;
+  virtual double      getDouble(int idx) = 0;
+  virtual std::string getString(int idx) = 0;
+  /// @brief 返回列数据的视图, 不拷贝, 在next()前有效
+  virtual std::string_view getStringView(int idx) = 0;
+  virtual std::string      getBlob(int idx)       = 0;
+  virtual time_t           getTime(int idx)       = 0;
+
+  /// @brief 移动到下一行
+  /// @return 是否还有数据
+  virtual bool next() = 0;
+};
+
+/// @brief 写操作接口
+class ISQLUpdate {
+public:
+  virtual ~ISQLUpdate() {
+  }
+
+  /// @brief 执行sql
+  /// @return 0成功, 其他为数据库错误码
+  virtual int     execute(const char *format, ...) = 0;
+  virtual int     execute(const std::string &sql)  = 0;
+  virtual int64_t getLastInsertId()                = 0;
+};
+
+/// @brief 查询接口
+class ISQLQuery {
+public:
+  virtual ~ISQLQuery() {
+  }
+
+  virtual ISQLData::ptr query(const char *format, ...) = 0;
+  virtual ISQLData::ptr query(const std::string &sql)  = 0;
+};
+
+/// @brief 预编译语句, 参数序号从1开始
+/// @details bindString/bindBlob不拷贝数据, 数据需保持有效直到执行结束
+class IStmt {
+public:
+  typedef std::shared_ptr<IStmt> ptr;
+
+  virtual ~IStmt() {
+  }
+
+  virtual int bindInt8(int idx, const int8_t &value)             = 0;
+  virtual int bindUint8(int idx, const uint8_t &value)           = 0;
+  virtual int bindInt16(int idx, const int16_t &value)           = 0;
+  virtual int bindUint16(int idx, const uint16_t &value)         = 0;
+  virtual int bindInt32(int idx, const int32_t &value)           = 0;
+  virtual int bindUint32(int idx, const uint32_t &value)         = 0;
+  virtual int bindInt64(int idx, const int64_t &value)           = 0;
+  virtual int bindUint64(int idx, const uint64_t &value)         = 0;
+  virtual int bindFloat(int idx, const float &value)             = 0;
+  virtual int bindDouble(int idx, const double &value)           = 0;
+  virtual int bindString(int idx, const std::string_view &value) = 0;
+  virtual int bindBlob(int idx, const std::string_view &value)   = 0;
+  virtual int bindTime(int idx, const time_t &value)             = 0;
+  virtual int bindNull(int idx)                                  = 0;
+
+  /// @brief 执行写操作
+  /// @return 0成功, 其他为数据库错误码
+  virtual int execute() = 0;
+  /// @brief 执行查询, 结果集在语句下一次执行前有效
+  virtual ISQLData::ptr query() = 0;
+  /// @brief 重置语句, 清除绑定的参数
+  virtual int reset() = 0;
+
+  virtual int64_t getLastInsertId() = 0;
+  /// @brief 上一次执行影响的行数
+  virtual int         getChanges() = 0;
+  virtual int         getErrno()   = 0;
+  virtual std::string getErrStr()  = 0;
+};
+
+/// @brief 事务
+class ITransaction : public ISQLUpdate {
+public:
+  typedef std::shared_ptr<ITransaction> ptr;
+
+  virtual ~ITransaction() {
+  }
+
+  virtual bool begin()    = 0;
+  virtual bool commit()   = 0;
+  virtual bool rollback() = 0;
+};
+
+/// @brief 数据库连接
+class IDB : public ISQLUpdate, public ISQLQuery {
+public:
+  typedef std::shared_ptr<IDB> ptr;
+
+  virtual ~IDB() {
+  }
+
+  /// @brief 预编译语句
+  /// @return 失败返回nullptr
+  virtual IStmt::ptr prepare(const std::string &stmt) = 0;
+
+  /// @brief 返回本连接缓存的预编译语句, 不存在时预编译并缓存
+  /// @details 返回前已重置, 同一sql的语句只有一份, 调用方需在下一次获取同一sql前用完
+  /// @return 失败返回nullptr
+  virtual IStmt::ptr prepareCached(const std::string &stmt) = 0;
+
+  virtual int         getErrno()  = 0;
+  virtual std::string getErrStr() = 0;
+
+  /// @brief 打开事务
+  /// @param auto_commit 析构时未结束的事务是否提交, 否则回滚
+  virtual ITransaction::ptr openTransaction(bool auto_commit = false) = 0;
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_DB_DB__H__ */
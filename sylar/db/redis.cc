@@ -0,0 +1,825 @@
+#include "sylar/db/redis.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <deque>
+
+#include "sylar/config.h"
+#include "sylar/fiber.h"
+#include "sylar/fox_thread.h"
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+/// Redis客户端配置, 对应redis.yml的redis.config节点
+static ConfigVar<std::map<std::string, RedisManager::ConfigMap> >::ptr
+    g_redis_configs =
+        Config::Lookup("redis.config",
+                       std::map<std::string, RedisManager::ConfigMap>(),
+                       "redis config");
+
+struct RedisIniter {
+  RedisIniter() {
+    g_redis_configs->addListener(
+        [](const std::map<std::string, RedisManager::ConfigMap> &old_value,
+           const std::map<std::string, RedisManager::ConfigMap> &new_value) {
+          RedisMgr::GetInstance()->init(new_value);
+        });
+  }
+};
+
+static RedisIniter __redis_init;
+
+/// ASKING命令的编码
+static const std::string_view kAsking = "*1\r\n$6\r\nASKING\r\n";
+/// 发送缓冲区空闲时保留的最大容量
+static const size_t kMaxIdleBuffer = 1024 * 1024;
+/// 集群重定向的最大次数
+static const int kMaxRedirects = 5;
+/// 集群槽位数
+static const size_t kClusterSlots = 16384;
+
+/// @brief 等待count个回调完成
+/// @details 在协程中只挂起当前协程, 否则阻塞当前线程.
+///          latch位于等待方的栈上, wait返回后即被释放, 因此wait必须等到
+///          最后一个countDown的notify, 不能看到计数归零就提前返回. count必须大于0
+class ReplyLatch {
+public:
+  ReplyLatch(size_t count)
+      : m_count(count),
+        m_inFiber(FiberExecutor::GetThis() != nullptr) {
+  }
+
+  void countDown() {
+    bool in_fiber = m_inFiber;
+    if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (in_fiber) {
+        m_fiberSem.notify();
+      } else {
+        m_sem.notify();
+      }
+    }
+  }
+
+  void wait() {
+    if (m_inFiber) {
+      m_fiberSem.wait();
+    } else {
+      m_sem.wait();
+    }
+  }
+
+private:
+  std::atomic<size_t> m_count;
+  bool                m_inFiber;
+  FiberSemaphore      m_fiberSem;
+  Semaphore           m_sem;
+};
+
+RedisReply::ptr IRedis::cmd(const Args &args) {
+  RedisReply::ptr rt;
+  ReplyLatch      latch(1);
+  cmdAsync(args, [&rt, &latch](RedisReply::ptr reply) {
+    rt = std::move(reply);
+    latch.countDown();
+  });
+  latch.wait();
+  return rt;
+}
+
+std::vector<RedisReply::ptr> IRedis::pipeline(const std::vector<Args> &cmds) {
+  std::vector<RedisReply::ptr> rts(cmds.size());
+  if (cmds.empty()) {
+    return rts;
+  }
+  ReplyLatch latch(cmds.size());
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    cmdAsync(cmds[i], [&rts, &latch, i](RedisReply::ptr reply) {
+      rts[i] = std::move(reply);
+      latch.countDown();
+    });
+  }
+  latch.wait();
+  return rts;
+}
+
+/// @brief Redis长连接
+/// @details 提交的命令直接编码进发送缓冲区m_out. 写协程每次取走整个缓冲区一次发出,
+///          发送期间到达的命令在下一轮合并发送, 实现自动流水线.
+///          读协程按FIFO把回复交给请求回调. 连接出错时已发出的请求失败,
+///          未发出的请求保留到重连后发送
+class FoxRedisConn : public std::enable_shared_from_this<FoxRedisConn> {
+public:
+  typedef std::shared_ptr<FoxRedisConn> ptr;
+  typedef Mutex                         MutexType;
+
+  FoxRedisConn(IOManager         *iom,
+               const std::string &host,
+               uint64_t           timeout_ms,
+               const std::string &passwd,
+               int                db)
+      : m_iom(iom),
+        m_host(host),
+        m_timeout(timeout_ms),
+        m_passwd(passwd),
+        m_db(db) {
+  }
+
+  /// @brief 提交命令
+  void submit(const IRedis::Args &args, IRedis::Callback cb) {
+    submit(
+        [&args](std::string &out) {
+          RespParser::Encode(out, args);
+        },
+        std::move(cb),
+        false);
+  }
+
+  /// @brief 提交已编码的命令
+  void submit(std::string_view data, IRedis::Callback cb, bool asking) {
+    submit(
+        [data](std::string &out) {
+          out.append(data);
+        },
+        std::move(cb),
+        asking);
+  }
+
+  /// @brief 关闭连接, 未完成的请求在当前线程以nullptr回调
+  void close();
+
+private:
+  enum State {
+    DISCONNECTED,
+    CONNECTING,
+    CONNECTED,
+    /// 已shutdown, 等待读写协程退出后关闭fd
+    CLOSING,
+  };
+
+  struct Request {
+    IRedis::Callback cb;
+    uint64_t         deadline;
+  };
+
+  template <class Fn>
+  void submit(Fn &&append, IRedis::Callback cb, bool asking);
+
+  void doConnect();
+  void onConnected(int fd);
+  void doWrite();
+  void doRead();
+
+  /// @brief 断开连接, 已发出的请求失败
+  void fail(const char *reason);
+
+  /// @brief 读写协程退出, 最后一个退出时关闭fd并按需重连
+  void releaseIo();
+
+  static void Fail(std::deque<Request> &reqs);
+
+private:
+  IOManager  *m_iom;
+  std::string m_host;
+  uint64_t    m_timeout;
+  std::string m_passwd;
+  int         m_db;
+
+  MutexType m_mutex;
+  State     m_state   = DISCONNECTED;
+  bool      m_closed  = false;
+  bool      m_writing = false;
+  int       m_fd      = -1;
+  /// 读写协程数量
+  int m_ioRefs = 0;
+  /// 待发送的命令
+  std::string m_out;
+  /// 写协程正在发送的命令
+  std::string m_sending;
+  /// 等待回复的请求, 前m_sentCount个已交给写协程
+  std::deque<Request> m_requests;
+  size_t              m_sentCount = 0;
+};
+
+template <class Fn>
+void FoxRedisConn::submit(Fn &&append, IRedis::Callback cb, bool asking) {
+  uint64_t deadline = TimerManager::GetCurrentMS() + m_timeout;
+  bool     connect  = false;
+  bool     write    = false;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_closed) {
+      lock.unlock();
+      if (cb) {
+        cb(nullptr);
+      }
+      return;
+    }
+    if (asking) {
+      m_out.append(kAsking);
+      m_requests.push_back(Request{nullptr, deadline});
+    }
+    append(m_out);
+    m_requests.push_back(Request{std::move(cb), deadline});
+    if (m_state == DISCONNECTED) {
+      m_state = CONNECTING;
+      connect = true;
+    } else if (m_state == CONNECTED && !m_writing) {
+      m_writing = true;
+      ++m_ioRefs;
+      write = true;
+    }
+  }
+  if (connect) {
+    ptr self = shared_from_this();
+    m_iom->schedule([self]() {
+      self->doConnect();
+    });
+  } else if (write) {
+    ptr self = shared_from_this();
+    m_iom->schedule([self]() {
+      self->doWrite();
+    });
+  }
+}
+
+void FoxRedisConn::Fail(std::deque<Request> &reqs) {
+  for (auto &i : reqs) {
+    if (i.cb) {
+      i.cb(nullptr);
+    }
+  }
+  reqs.clear();
+}
+
+void FoxRedisConn::close() {
+  std::deque<Request> failed;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_closed) {
+      return;
+    }
+    m_closed = true;
+    failed.swap(m_requests);
+    m_out.clear();
+    m_sentCount = 0;
+    if (m_state == CONNECTED) {
+      m_state = CLOSING;
+      shutdown(m_fd, SHUT_RDWR);
+    }
+  }
+  Fail(failed);
+}
+
+void FoxRedisConn::doConnect() {
+  sockaddr_in addr;
+  int         fd = -1;
+  if (ParseAddress(m_host, addr)) {
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  } else {
+    errno = EINVAL;
+  }
+  if (fd >= 0 &&
+      m_iom->connect(fd, (sockaddr *)&addr, sizeof(addr), m_timeout) == 0) {
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    onConnected(fd);
+    return;
+  }
+  SYLAR_LOG_ERROR(g_logger) << "redis connect " << m_host
+                            << " failed, errno=" << errno << " "
+                            << strerror(errno);
+  if (fd >= 0) {
+    m_iom->close(fd);
+  }
+  std::deque<Request> failed;
+  {
+    MutexType::Lock lock(m_mutex);
+    m_state = DISCONNECTED;
+    failed.swap(m_requests);
+    m_out.clear();
+    m_sentCount = 0;
+  }
+  Fail(failed);
+}
+
+void FoxRedisConn::onConnected(int fd) {
+  // AUTH/SELECT排在已提交的命令之前
+  std::string         prefix;
+  std::deque<Request> init;
+  std::string         host     = m_host;
+  uint64_t            deadline = TimerManager::GetCurrentMS() + m_timeout;
+  auto                check    = [host](RedisReply::ptr reply) {
+    if (reply && reply->isError()) {
+      SYLAR_LOG_ERROR(g_logger)
+          << "redis " << host << " init: " << reply->getStr();
+    }
+  };
+  if (!m_passwd.empty()) {
+    RespParser::Encode(prefix, {"AUTH", m_passwd});
+    init.push_back(Request{check, deadline});
+  }
+  if (m_db != 0) {
+    std::string db = std::to_string(m_db);
+    RespParser::Encode(prefix, {"SELECT", db});
+    init.push_back(Request{check, deadline});
+  }
+
+  bool write = false;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_closed) {
+      m_state = DISCONNECTED;
+      lock.unlock();
+      m_iom->close(fd);
+      return;
+    }
+    m_fd    = fd;
+    m_state = CONNECTED;
+    m_out.insert(0, prefix);
+    m_requests.insert(m_requests.begin(), init.begin(), init.end());
+    m_ioRefs = 1;
+    if (!m_out.empty()) {
+      m_writing = true;
+      ++m_ioRefs;
+      write = true;
+    }
+  }
+  ptr self = shared_from_this();
+  m_iom->schedule([self]() {
+    self->doRead();
+  });
+  if (write) {
+    doWrite();
+  }
+}
+
+void FoxRedisConn::doWrite() {
+  while (true) {
+    int fd = -1;
+    {
+      MutexType::Lock lock(m_mutex);
+      if (m_state != CONNECTED || m_out.empty()) {
+        m_writing = false;
+        break;
+      }
+      m_sending.clear();
+      if (m_sending.capacity() > kMaxIdleBuffer) {
+        std::string().swap(m_sending);
+      }
+      m_sending.swap(m_out);
+      m_sentCount = m_requests.size();
+      fd          = m_fd;
+    }
+
+    size_t off = 0;
+    while (off < m_sending.size()) {
+      ssize_t n = m_iom->send(
+          fd, m_sending.data() + off, m_sending.size() - off, 0, m_timeout);
+      if (n <= 0) {
+        break;
+      }
+      off += n;
+    }
+    if (off < m_sending.size()) {
+      fail(errno == ETIMEDOUT ? "send timeout" : strerror(errno));
+      MutexType::Lock lock(m_mutex);
+      m_writing = false;
+      break;
+    }
+  }
+  releaseIo();
+}
+
+void FoxRedisConn::doRead() {
+  int fd = -1;
+  {
+    MutexType::Lock lock(m_mutex);
+    fd = m_fd;
+  }
+  RespParser                     parser;
+  std::vector<RedisReply::ptr>   replies;
+  std::vector<IRedis::Callback>  cbs;
+  std::string                    reason;
+  while (reason.empty()) {
+    size_t  len = 0;
+    char   *buf = parser.prepare(len);
+    ssize_t n   = m_iom->recv(fd, buf, len, 0, m_timeout);
+    if (n == 0) {
+      reason = "closed by peer";
+      break;
+    }
+    if (n < 0) {
+      if (errno != ETIMEDOUT) {
+        reason = strerror(errno);
+        break;
+      }
+      MutexType::Lock lock(m_mutex);
+      if (m_sentCount > 0 &&
+          m_requests.front().deadline <= TimerManager::GetCurrentMS()) {
+        reason = "timeout";
+      }
+      continue;
+    }
+
+    parser.commit(n);
+    RedisReply::ptr reply;
+    int             rt = 0;
+    while ((rt = parser.parse(reply)) == 1) {
+      replies.push_back(std::move(reply));
+    }
+    if (rt < 0) {
+      reason = "protocol error: " + parser.getError();
+    }
+    {
+      MutexType::Lock lock(m_mutex);
+      if (replies.size() > m_sentCount) {
+        reason = "unexpected reply";
+        replies.resize(m_sentCount);
+      }
+      for (size_t i = 0; i < replies.size(); ++i) {
+        cbs.push_back(std::move(m_requests.front().cb));
+        m_requests.pop_front();
+      }
+      m_sentCount -= replies.size();
+    }
+    for (size_t i = 0; i < cbs.size(); ++i) {
+      if (cbs[i]) {
+        cbs[i](std::move(replies[i]));
+      }
+    }
+    cbs.clear();
+    replies.clear();
+  }
+  fail(reason.c_str());
+  releaseIo();
+}
+
+void FoxRedisConn::fail(const char *reason) {
+  std::deque<Request> failed;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_state != CONNECTED) {
+      return;
+    }
+    m_state = CLOSING;
+    shutdown(m_fd, SHUT_RDWR);
+    for (size_t i = 0; i < m_sentCount; ++i) {
+      failed.push_back(std::move(m_requests.front()));
+      m_requests.pop_front();
+    }
+    m_sentCount = 0;
+  }
+  SYLAR_LOG_WARN(g_logger) << "redis " << m_host << " disconnected: " << reason
+                           << ", failed requests: " << failed.size();
+  Fail(failed);
+}
+
+void FoxRedisConn::releaseIo() {
+  int  fd        = -1;
+  bool reconnect = false;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (--m_ioRefs > 0) {
+      return;
+    }
+    fd   = m_fd;
+    m_fd = -1;
+    if (m_closed || m_requests.empty()) {
+      m_state = DISCONNECTED;
+    } else {
+      m_state   = CONNECTING;
+      reconnect = true;
+    }
+  }
+  m_iom->close(fd);
+  if (reconnect) {
+    doConnect();
+  }
+}
+
+FoxRedis::FoxRedis(IOManager::ptr     iom,
+                   const std::string &host,
+                   size_t             pool,
+                   uint64_t           timeout_ms,
+                   const std::string &passwd,
+                   int                db)
+    : m_iom(iom), m_host(host) {
+  m_type = FOX_REDIS;
+  m_conns.resize(pool ? pool : 1);
+  for (auto &i : m_conns) {
+    i.reset(new FoxRedisConn(iom.get(), host, timeout_ms, passwd, db));
+  }
+}
+
+FoxRedis::~FoxRedis() {
+  for (auto &i : m_conns) {
+    i->close();
+  }
+}
+
+FoxRedisConn *FoxRedis::next() {
+  size_t idx = m_next.fetch_add(1, std::memory_order_relaxed);
+  return m_conns[idx % m_conns.size()].get();
+}
+
+void FoxRedis::cmdAsync(const Args &args, Callback cb) {
+  next()->submit(args, std::move(cb));
+}
+
+void FoxRedis::cmdRawAsync(std::string_view data, Callback cb, bool asking) {
+  next()->submit(data, std::move(cb), asking);
+}
+
+FoxRedisCluster::FoxRedisCluster(IOManager::ptr     iom,
+                                 const std::string &hosts,
+                                 size_t             pool,
+                                 uint64_t           timeout_ms,
+                                 const std::string &passwd)
+    : m_iom(iom),
+      m_pool(pool),
+      m_timeout(timeout_ms),
+      m_passwd(passwd),
+      m_slots(kClusterSlots, nullptr) {
+  m_type     = FOX_REDIS_CLUSTER;
+  size_t pos = 0;
+  while (pos <= hosts.size()) {
+    size_t end = hosts.find(',', pos);
+    if (end == std::string::npos) {
+      end = hosts.size();
+    }
+    std::string host = hosts.substr(pos, end - pos);
+    if (!host.empty()) {
+      m_seeds.push_back(host);
+    }
+    pos = end + 1;
+  }
+}
+
+uint16_t FoxRedisCluster::KeySlot(std::string_view key) {
+  // CRC16-CCITT(XMODEM), 与redis cluster一致
+  static const std::vector<uint16_t> s_table = []() {
+    std::vector<uint16_t> table(256);
+    for (int i = 0; i < 256; ++i) {
+      uint16_t crc = i << 8;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+      }
+      table[i] = crc;
+    }
+    return table;
+  }();
+
+  size_t begin = key.find('{');
+  if (begin != std::string_view::npos) {
+    size_t end = key.find('}', begin + 1);
+    if (end != std::string_view::npos && end != begin + 1) {
+      key = key.substr(begin + 1, end - begin - 1);
+    }
+  }
+  uint16_t crc = 0;
+  for (unsigned char c : key) {
+    crc = (crc << 8) ^ s_table[((crc >> 8) ^ c) & 0xff];
+  }
+  return crc & (kClusterSlots - 1);
+}
+
+void FoxRedisCluster::cmdAsync(const Args &args, Callback cb) {
+  if (m_seeds.empty()) {
+    cb(nullptr);
+    return;
+  }
+  if (!m_loaded) {
+    refreshSlots();
+  }
+  // 只编码一次, 重定向时复用
+  std::shared_ptr<std::string> req(new std::string);
+  RespParser::Encode(*req, args);
+  int slot = args.size() > 1 ? KeySlot(args[1]) : -1;
+  dispatch(req, slot, std::move(cb), 0, nullptr, false);
+}
+
+void FoxRedisCluster::dispatch(std::shared_ptr<std::string> req,
+                               int                          slot,
+                               Callback                     cb,
+                               int                          redirects,
+                               FoxRedis                    *node,
+                               bool                         asking) {
+  if (!node && slot >= 0) {
+    RWMutex::ReadLock lock(m_mutex);
+    node = m_slots[slot];
+  }
+  if (!node) {
+    node = getNode(m_seeds[m_nextSeed++ % m_seeds.size()]);
+  }
+  std::weak_ptr<FoxRedisCluster> weak = weak_from_this();
+  node->cmdRawAsync(
+      *req,
+      [weak, req, slot, cb, redirects](RedisReply::ptr reply) mutable {
+        auto self = weak.lock();
+        if (!self || !reply || !reply->isError() ||
+            redirects >= kMaxRedirects) {
+          cb(std::move(reply));
+          return;
+        }
+        // MOVED <slot> <ip:port> 或 ASK <slot> <ip:port>
+        std::string_view err   = reply->getStr();
+        bool             moved = err.starts_with("MOVED ");
+        if (!moved && !err.starts_with("ASK ")) {
+          cb(std::move(reply));
+          return;
+        }
+        size_t    pos    = err.rfind(' ');
+        FoxRedis *target = self->getNode(err.substr(pos + 1));
+        if (moved) {
+          int s = atoi(std::string(err.substr(6, pos - 6)).c_str());
+          if (s >= 0 && s < (int)kClusterSlots) {
+            RWMutex::WriteLock lock(self->m_mutex);
+            self->m_slots[s] = target;
+          }
+          self->refreshSlots();
+        }
+        self->dispatch(req, slot, std::move(cb), redirects + 1, target, !moved);
+      },
+      asking);
+}
+
+FoxRedis *FoxRedisCluster::getNode(std::string_view host) {
+  {
+    RWMutex::ReadLock lock(m_mutex);
+    auto              it = m_nodes.find(host);
+    if (it != m_nodes.end()) {
+      return it->second.get();
+    }
+  }
+  RWMutex::WriteLock lock(m_mutex);
+  auto               it = m_nodes.find(host);
+  if (it != m_nodes.end()) {
+    return it->second.get();
+  }
+  FoxRedis::ptr node(
+      new FoxRedis(m_iom, std::string(host), m_pool, m_timeout, m_passwd));
+  node->setName(m_name + "/" + node->getHost());
+  m_nodes.emplace(node->getHost(), node);
+  return node.get();
+}
+
+void FoxRedisCluster::refreshSlots() {
+  if (m_refreshing.exchange(true)) {
+    return;
+  }
+  static const std::string s_req = "*2\r\n$7\r\nCLUSTER\r\n$5\r\nSLOTS\r\n";
+  std::weak_ptr<FoxRedisCluster> weak = weak_from_this();
+  FoxRedis *node = getNode(m_seeds[m_nextSeed++ % m_seeds.size()]);
+  node->cmdRawAsync(s_req, [weak](RedisReply::ptr reply) {
+    if (auto self = weak.lock()) {
+      self->onSlots(reply);
+    }
+  });
+}
+
+void FoxRedisCluster::onSlots(RedisReply::ptr reply) {
+  if (!reply || reply->getType() != RedisReply::ARRAY) {
+    SYLAR_LOG_WARN(g_logger)
+        << "redis cluster " << m_name << " CLUSTER SLOTS failed: "
+        << (reply ? reply->toString() : "no reply");
+    m_refreshing = false;
+    return;
+  }
+  // 每项: [start, end, [ip, port, id], 副本...]
+  struct Range {
+    int64_t   start;
+    int64_t   end;
+    FoxRedis *node;
+  };
+  std::vector<Range> ranges;
+  for (auto &i : reply->getElements()) {
+    if (i.size() < 3 || i[2].size() < 2) {
+      continue;
+    }
+    int64_t start = i[0].getInteger();
+    int64_t end   = i[1].getInteger();
+    if (start < 0 || end < start || end >= (int64_t)kClusterSlots) {
+      continue;
+    }
+    std::string host(i[2][0].getStr());
+    host += ":" + std::to_string(i[2][1].getInteger());
+    ranges.push_back(Range{start, end, getNode(host)});
+  }
+  {
+    RWMutex::WriteLock lock(m_mutex);
+    for (auto &r : ranges) {
+      std::fill(m_slots.begin() + r.start, m_slots.begin() + r.end + 1, r.node);
+    }
+  }
+  SYLAR_LOG_INFO(g_logger) << "redis cluster " << m_name << " loaded "
+                           << ranges.size() << " slot ranges";
+  m_loaded     = true;
+  m_refreshing = false;
+}
+
+RedisManager::RedisManager() {
+  // 保证IO线程组管理器先于本管理器构造, 析构时客户端先关闭, 线程组才能停止
+  FoxThreadMgr::GetInstance();
+}
+
+IRedis::ptr RedisManager::get(const std::string &name) {
+  {
+    RWMutex::ReadLock lock(m_mutex);
+    auto              it = m_datas.find(name);
+    if (it != m_datas.end()) {
+      return it->second;
+    }
+  }
+  RWMutex::WriteLock lock(m_mutex);
+  auto               it = m_datas.find(name);
+  if (it != m_datas.end()) {
+    return it->second;
+  }
+  auto cit = m_configs.find(name);
+  if (cit == m_configs.end()) {
+    return nullptr;
+  }
+  IRedis::ptr rt = create(name, cit->second);
+  if (rt) {
+    m_datas[name] = rt;
+  }
+  return rt;
+}
+
+void RedisManager::init(const std::map<std::string, ConfigMap> &configs) {
+  // 旧客户端在锁外释放, 未完成请求的回调可能再次访问管理器
+  std::vector<IRedis::ptr> olds;
+  RWMutex::WriteLock       lock(m_mutex);
+  for (auto it = m_datas.begin(); it != m_datas.end();) {
+    auto cit = configs.find(it->first);
+    if (cit == configs.end() || cit->second != m_configs[it->first]) {
+      olds.push_back(it->second);
+      it = m_datas.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  m_configs = configs;
+  lock.unlock();
+}
+
+IRedis::ptr RedisManager::create(const std::string &name,
+                                 const ConfigMap   &conf) {
+  auto value = [&conf](const std::string &key, const std::string &def) {
+    auto it = conf.find(key);
+    return it == conf.end() ? def : it->second;
+  };
+  std::string host    = value("host", "");
+  std::string type    = value("type", "fox_redis");
+  std::string thread  = value("thread", "redis");
+  std::string passwd  = value("passwd", "");
+  size_t      pool    = strtoul(value("pool", "1").c_str(), nullptr, 10);
+  uint64_t    timeout = strtoull(value("timeout", "1000").c_str(), nullptr, 10);
+  int         db      = atoi(value("db", "0").c_str());
+  if (host.empty()) {
+    SYLAR_LOG_ERROR(g_logger) << "redis " << name << " host is empty";
+    return nullptr;
+  }
+  IOManager::ptr iom = FoxThreadMgr::GetInstance()->get(thread);
+  if (!iom) {
+    SYLAR_LOG_ERROR(g_logger)
+        << "redis " << name << " fox_thread " << thread << " not exists";
+    return nullptr;
+  }
+
+  IRedis::ptr rt;
+  // redis/redis_cluster与fox实现相同, 全部运行在fox_thread上
+  if (type == "fox_redis" || type == "redis") {
+    rt.reset(new FoxRedis(iom, host, pool, timeout, passwd, db));
+  } else if (type == "fox_redis_cluster" || type == "redis_cluster") {
+    rt.reset(new FoxRedisCluster(iom, host, pool, timeout, passwd));
+  } else {
+    SYLAR_LOG_ERROR(g_logger)
+        << "redis " << name << " invalid type " << type;
+    return nullptr;
+  }
+  rt->setName(name);
+  return rt;
+}
+
+std::ostream &RedisManager::dump(std::ostream &os) {
+  RWMutex::ReadLock lock(m_mutex);
+  for (auto &i : m_configs) {
+    os << i.first << (m_datas.count(i.first) ? " [active]" : "") << ":";
+    for (auto &n : i.second) {
+      os << " " << n.first << "=" << n.second;
+    }
+    os << std::endl;
+  }
+  return os;
+}
+
+}  // namespace sylar
@@ -0,0 +1,227 @@
+/**
+ * @file redis.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief Redis客户端: 连接池, 自动流水线与集群槽路由
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_DB_REDIS__H__
+#define __SYLAR_DB_REDIS__H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "sylar/db/resp.h"
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+#include "sylar/singleton.h"
+
+namespace sylar {
+
+class FoxRedisConn;
+
+/// @brief Redis客户端接口
+class IRedis {
+public:
+  typedef std::shared_ptr<IRedis> ptr;
+  /// 命令参数, 例如 {"SET", key, value}
+  typedef std::vector<std::string_view> Args;
+  /// 回复回调, 在IO线程中执行, 连接失败或超时时参数为nullptr
+  typedef std::function<void(RedisReply::ptr)> Callback;
+
+  enum Type {
+    FOX_REDIS         = 1,
+    FOX_REDIS_CLUSTER = 2,
+  };
+
+  virtual ~IRedis() {
+  }
+
+  /// @brief 异步执行命令
+  /// @details 参数在返回前已编码, 调用方无需保持其有效.
+  ///          同一连接上的命令合并成一次写入, 不必等待前一条的回复
+  virtual void cmdAsync(const Args &args, Callback cb) = 0;
+
+  /// @brief 同步执行命令
+  /// @details 在协程中调用只挂起当前协程, 否则阻塞当前线程.
+  ///          不能在本客户端所属IOManager的线程上以非协程方式调用
+  /// @return 失败或超时返回nullptr
+  RedisReply::ptr cmd(const Args &args);
+
+  /// @brief 批量执行命令, 全部发出后等待回复
+  /// @return 与cmds一一对应的回复
+  std::vector<RedisReply::ptr> pipeline(const std::vector<Args> &cmds);
+
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  void setName(const std::string &v) {
+    m_name = v;
+  }
+
+  Type getType() const {
+    return m_type;
+  }
+
+protected:
+  std::string m_name;
+  Type        m_type = FOX_REDIS;
+};
+
+/// @brief 单节点Redis客户端
+/// @details 持有pool个长连接, 命令按轮询分配到连接上. 连接运行在指定的IOManager,
+///          首次使用时建立, 断开后有待发命令时自动重连
+class FoxRedis : public IRedis {
+public:
+  typedef std::shared_ptr<FoxRedis> ptr;
+
+  /// @brief 构造函数
+  /// @param iom 连接所在的IOManager
+  /// @param host 地址 ip:port
+  /// @param pool 连接数量
+  /// @param timeout_ms 连接与等待回复的超时时间
+  /// @param passwd 密码, 为空不认证
+  /// @param db 数据库序号
+  FoxRedis(IOManager::ptr     iom,
+           const std::string &host,
+           size_t             pool,
+           uint64_t           timeout_ms,
+           const std::string &passwd = "",
+           int                db     = 0);
+
+  /// @brief 析构函数, 关闭全部连接, 未完成的命令以nullptr回调
+  ~FoxRedis();
+
+  void cmdAsync(const Args &args, Callback cb) override;
+
+  /// @brief 发送已编码的命令
+  /// @param asking 是否先发送ASKING(集群ASK重定向)
+  void cmdRawAsync(std::string_view data, Callback cb, bool asking = false);
+
+  const std::string &getHost() const {
+    return m_host;
+  }
+
+private:
+  FoxRedisConn *next();
+
+private:
+  IOManager::ptr                              m_iom;
+  std::string                                 m_host;
+  std::vector<std::shared_ptr<FoxRedisConn> > m_conns;
+  std::atomic<size_t>                         m_next{0};
+};
+
+/// @brief Redis集群客户端
+/// @details 按CRC16(key) % 16384路由, 支持{tag}. 第一个参数作为key,
+///          没有key的命令发往种子节点. 槽位表由CLUSTER SLOTS加载,
+///          收到MOVED时更新槽位并重发, ASK时向目标节点发送ASKING后重发.
+///          必须由shared_ptr持有
+class FoxRedisCluster : public IRedis,
+                        public std::enable_shared_from_this<FoxRedisCluster> {
+public:
+  typedef std::shared_ptr<FoxRedisCluster> ptr;
+
+  /// @brief 构造函数
+  /// @param hosts 种子节点, 逗号分隔的 ip:port 列表
+  /// @param pool 每个节点的连接数量
+  FoxRedisCluster(IOManager::ptr     iom,
+                  const std::string &hosts,
+                  size_t             pool,
+                  uint64_t           timeout_ms,
+                  const std::string &passwd = "");
+
+  void cmdAsync(const Args &args, Callback cb) override;
+
+  /// @brief 异步刷新槽位表, 已有刷新在进行时忽略
+  void refreshSlots();
+
+  /// @brief 返回key所在的槽
+  static uint16_t KeySlot(std::string_view key);
+
+private:
+  /// @brief 发送请求并处理重定向
+  /// @param node 目标节点, nullptr时按槽位表选择
+  void dispatch(std::shared_ptr<std::string> req,
+                int                          slot,
+                Callback                     cb,
+                int                          redirects,
+                FoxRedis                    *node,
+                bool                         asking);
+
+  /// @brief 获取节点, 不存在时创建
+  FoxRedis *getNode(std::string_view host);
+
+  /// @brief 解析CLUSTER SLOTS的回复
+  void onSlots(RedisReply::ptr reply);
+
+private:
+  IOManager::ptr           m_iom;
+  size_t                   m_pool;
+  uint64_t                 m_timeout;
+  std::string              m_passwd;
+  std::vector<std::string> m_seeds;
+  std::atomic<size_t>      m_nextSeed{0};
+  std::atomic<bool>        m_refreshing{false};
+  std::atomic<bool>        m_loaded{false};
+  RWMutex                  m_mutex;
+  /// 节点只增不删, 槽位表直接保存指针
+  std::map<std::string, FoxRedis::ptr, std::less<> > m_nodes;
+  std::vector<FoxRedis *>                            m_slots;
+};
+
+/// @brief Redis客户端管理器
+/// @details 对应配置 redis.config 节点, 例如:
+///          redis:
+///              config:
+///                  local:
+///                      host: 127.0.0.1:6379
+///                      type: fox_redis
+///                      pool: 2
+///                      timeout: 100
+///          type 取值 redis/fox_redis 为单节点, redis_cluster/fox_redis_cluster
+///          为集群; thread 指定fox_thread中的线程组, 默认redis.
+///          客户端在首次get时创建, 配置变化后下次get重新创建
+class RedisManager {
+public:
+  typedef std::map<std::string, std::string> ConfigMap;
+
+  RedisManager();
+
+  /// @brief 获取客户端, 不存在或创建失败返回nullptr
+  IRedis::ptr get(const std::string &name);
+
+  /// @brief 更新配置
+  void init(const std::map<std::string, ConfigMap> &configs);
+
+  std::ostream &dump(std::ostream &os);
+
+private:
+  /// @brief 按配置创建客户端
+  IRedis::ptr create(const std::string &name, const ConfigMap &conf);
+
+private:
+  RWMutex                            m_mutex;
+  std::map<std::string, ConfigMap>   m_configs;
+  std::map<std::string, IRedis::ptr> m_datas;
+};
+
+/// Redis客户端管理器单例
+typedef sylar::Singleton<RedisManager> RedisMgr;
+
+}  // namespace sylar
+
+#endif /* __SYLAR_DB_REDIS__H__ */
@@ -0,0 +1,240 @@
+#include "sylar/db/resp.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <charconv>
+
+namespace sylar {
+
+/// 每次读取至少预留的空间
+static const size_t kMinRead = 1024;
+/// 单个字符串的最大长度, 与redis的proto-max-bulk-len默认值一致
+static const int64_t kMaxBulkLen = 512ll * 1024 * 1024;
+/// 单个数组的最大元素数
+static const int64_t kMaxElements = 64ll * 1024 * 1024;
+/// 数组头部最多预留的元素数, 其余随数据到达增长
+static const int64_t kReserveElements = 1024;
+
+static bool ParseInt(std::string_view v, int64_t &out) {
+  auto rt = std::from_chars(v.data(), v.data() + v.size(), out);
+  return rt.ec == std::errc() && rt.ptr == v.data() + v.size();
+}
+
+std::string RedisReply::toString() const {
+  std::string out;
+  toString(out);
+  return out;
+}
+
+void RedisReply::toString(std::string &out) const {
+  switch (m_type) {
+    case STRING:
+      out.push_back('"');
+      out.append(m_str);
+      out.push_back('"');
+      break;
+    case STATUS:
+      out.append(m_str);
+      break;
+    case ERROR:
+      out.append("(error) ");
+      out.append(m_str);
+      break;
+    case INTEGER:
+      out.append("(integer) ");
+      out.append(std::to_string(m_integer));
+      break;
+    case NIL:
+      out.append("(nil)");
+      break;
+    case ARRAY:
+      out.push_back('[');
+      for (size_t i = 0; i < m_elements.size(); ++i) {
+        if (i) {
+          out.append(", ");
+        }
+        m_elements[i].toString(out);
+      }
+      out.push_back(']');
+      break;
+  }
+}
+
+RespParser::RespParser(size_t buffer_size)
+    : m_buf(new char[buffer_size]),
+      m_cap(buffer_size),
+      m_defaultCap(buffer_size) {
+}
+
+char *RespParser::prepare(size_t &len) {
+  size_t unparsed = m_wpos - m_rpos;
+  size_t target   = std::max(m_need, unparsed + kMinRead);
+  // 正在解析的数组已有元素引用缓冲区
+  bool partial  = m_cur && !m_stack.empty();
+  bool reusable = m_buf.use_count() == 1 && !partial;
+  if (m_cap - m_rpos < target) {
+    if (reusable && m_cap >= target) {
+      memmove(m_buf.get(), m_buf.get() + m_rpos, unparsed);
+    } else {
+      // 缓冲区仍被回复引用, 未解析的数据移到新缓冲区
+      size_t                  cap = std::max(m_defaultCap, target);
+      std::shared_ptr<char[]> buf(new char[cap]);
+      memcpy(buf.get(), m_buf.get() + m_rpos, unparsed);
+      if (partial) {
+        m_cur->m_buffers.push_back(m_buf);
+      }
+      m_buf = buf;
+      m_cap = cap;
+    }
+    m_rpos = 0;
+    m_wpos = unparsed;
+  } else if (unparsed == 0 && reusable) {
+    m_rpos = m_wpos = 0;
+  }
+  len = m_cap - m_wpos;
+  return m_buf.get() + m_wpos;
+}
+
+int RespParser::parse(RedisReply::ptr &reply) {
+  while (true) {
+    RedisReply *r = nullptr;
+    if (!m_cur) {
+      m_cur.reset(new RedisReply);
+      r = m_cur.get();
+    } else if (m_stack.empty()) {
+      r = m_cur.get();
+    } else {
+      // 元素随解析逐个追加, 不按头部声明的长度预分配.
+      // 只有栈顶数组会增长, 外层Frame指向的元素在此期间不会移动
+      Frame                   &f        = m_stack.back();
+      std::vector<RedisReply> &elements = f.reply->m_elements;
+      if (elements.size() == f.next) {
+        elements.emplace_back();
+      }
+      r = &elements[f.next];
+    }
+
+    size_t count = 0;
+    int    rt    = parseItem(*r, count);
+    if (rt <= 0) {
+      return rt;
+    }
+    if (r->m_type == RedisReply::ARRAY && count > 0) {
+      m_stack.push_back(Frame{r, 0, count});
+      continue;
+    }
+    while (!m_stack.empty()) {
+      Frame &f = m_stack.back();
+      if (++f.next < f.count) {
+        break;
+      }
+      m_stack.pop_back();
+    }
+    if (m_stack.empty()) {
+      m_cur->m_buffers.push_back(m_buf);
+      reply = std::move(m_cur);
+      m_cur.reset();
+      return 1;
+    }
+  }
+}
+
+int RespParser::parseItem(RedisReply &r, size_t &count) {
+  const char *begin = m_buf.get() + m_rpos;
+  size_t      avail = m_wpos - m_rpos;
+  if (avail < std::max<size_t>(m_need, 3)) {
+    return 0;
+  }
+  const char *cr = (const char *)memchr(begin, '\r', avail);
+  if (cr == nullptr || cr + 1 == begin + avail) {
+    return 0;
+  }
+  if (cr[1] != '\n') {
+    m_error = "expect CRLF";
+    return -1;
+  }
+  size_t           used = cr - begin + 2;
+  std::string_view line(begin + 1, cr - begin - 1);
+  int64_t          n = 0;
+  switch (begin[0]) {
+    case '+':
+      r.m_type = RedisReply::STATUS;
+      r.m_str  = line;
+      break;
+    case '-':
+      r.m_type = RedisReply::ERROR;
+      r.m_str  = line;
+      break;
+    case ':':
+      r.m_type = RedisReply::INTEGER;
+      if (!ParseInt(line, r.m_integer)) {
+        m_error = "invalid integer";
+        return -1;
+      }
+      break;
+    case '$':
+      if (!ParseInt(line, n) || n > kMaxBulkLen) {
+        m_error = "invalid bulk length";
+        return -1;
+      }
+      if (n < 0) {
+        r.m_type = RedisReply::NIL;
+        break;
+      }
+      if (avail < used + n + 2) {
+        m_need = used + n + 2;
+        return 0;
+      }
+      if (begin[used + n] != '\r' || begin[used + n + 1] != '\n') {
+        m_error = "bulk string not terminated by CRLF";
+        return -1;
+      }
+      r.m_type = RedisReply::STRING;
+      r.m_str  = std::string_view(begin + used, n);
+      used += n + 2;
+      break;
+    case '*':
+      if (!ParseInt(line, n) || n > kMaxElements) {
+        m_error = "invalid array length";
+        return -1;
+      }
+      if (n < 0) {
+        r.m_type = RedisReply::NIL;
+        break;
+      }
+      r.m_type = RedisReply::ARRAY;
+      r.m_elements.reserve(std::min<int64_t>(n, kReserveElements));
+      count = n;
+      break;
+    default:
+      m_error = std::string("unknown type '") + begin[0] + "'";
+      return -1;
+  }
+  m_rpos += used;
+  m_need = 0;
+  return 1;
+}
+
+/// @brief 追加 <prefix><n>\r\n
+static void AppendHeader(std::string &out, char prefix, size_t n) {
+  char buf[24];
+  buf[0]  = prefix;
+  auto rt = std::to_chars(buf + 1, buf + sizeof(buf) - 2, n);
+  rt.ptr[0] = '\r';
+  rt.ptr[1] = '\n';
+  out.append(buf, rt.ptr + 2 - buf);
+}
+
+void RespParser::Encode(std::string            &out,
+                        const std::string_view *args,
+                        size_t                  n) {
+  AppendHeader(out, '*', n);
+  for (size_t i = 0; i < n; ++i) {
+    AppendHeader(out, '$', args[i].size());
+    out.append(args[i]);
+    out.append("\r\n", 2);
+  }
+}
+
+}  // namespace sylar
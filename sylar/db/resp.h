@@ -0,0 +1,161 @@
+/**
+ * @file resp.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief Redis RESP协议编解码
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_DB_RESP__H__
+#define __SYLAR_DB_RESP__H__
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sylar {
+
+/// @brief Redis回复
+/// @details 字符串内容是接收缓冲区的视图, 不拷贝. 顶层回复持有所引用的缓冲区,
+///          子元素的视图在顶层回复存活期间有效
+class RedisReply {
+  friend class RespParser;
+
+public:
+  typedef std::shared_ptr<RedisReply> ptr;
+
+  /// @brief 回复类型, 取值与hiredis的REDIS_REPLY_*一致
+  enum Type {
+    STRING  = 1,
+    ARRAY   = 2,
+    INTEGER = 3,
+    NIL     = 4,
+    STATUS  = 5,
+    ERROR   = 6,
+  };
+
+  Type getType() const {
+    return m_type;
+  }
+
+  bool isError() const {
+    return m_type == ERROR;
+  }
+
+  bool isNil() const {
+    return m_type == NIL;
+  }
+
+  /// @brief INTEGER类型的值
+  int64_t getInteger() const {
+    return m_integer;
+  }
+
+  /// @brief STRING/STATUS/ERROR类型的内容
+  std::string_view getStr() const {
+    return m_str;
+  }
+
+  /// @brief ARRAY类型的元素个数
+  size_t size() const {
+    return m_elements.size();
+  }
+
+  const RedisReply &operator[](size_t idx) const {
+    return m_elements[idx];
+  }
+
+  const std::vector<RedisReply> &getElements() const {
+    return m_elements;
+  }
+
+  /// @brief 调试输出
+  std::string toString() const;
+
+private:
+  void toString(std::string &out) const;
+
+private:
+  Type                    m_type    = NIL;
+  int64_t                 m_integer = 0;
+  std::string_view        m_str;
+  std::vector<RedisReply> m_elements;
+  /// 视图引用的接收缓冲区, 只有顶层回复持有
+  std::vector<std::shared_ptr<char[]> > m_buffers;
+};
+
+/// @brief RESP增量解析器
+/// @details 数据直接读入解析器的缓冲区(prepare/commit), 每次只解析新到达的数据,
+///          已解析的元素不会重复扫描. 缓冲区在没有回复引用时原地复用,
+///          否则另行分配, 旧缓冲区随引用它的回复释放
+class RespParser {
+public:
+  /// @brief 构造函数
+  /// @param buffer_size 缓冲区默认大小
+  RespParser(size_t buffer_size = 16 * 1024);
+
+  /// @brief 返回可写入的缓冲区
+  /// @param[out] len 可写入长度
+  char *prepare(size_t &len);
+
+  /// @brief 确认写入了n字节
+  void commit(size_t n) {
+    m_wpos += n;
+  }
+
+  /// @brief 解析一个完整的回复
+  /// @return 1得到回复, 0数据不足, -1协议错误
+  int parse(RedisReply::ptr &reply);
+
+  /// @brief 协议错误信息
+  const std::string &getError() const {
+    return m_error;
+  }
+
+  /// @brief 按RESP数组格式编码命令, 追加到out
+  static void Encode(std::string &out, const std::string_view *args, size_t n);
+
+  static void Encode(std::string                         &out,
+                     const std::vector<std::string_view> &args) {
+    Encode(out, args.data(), args.size());
+  }
+
+private:
+  /// @brief 解析一个元素(数组只解析头部)
+  /// @param[out] count 数组头部声明的元素个数
+  int parseItem(RedisReply &r, size_t &count);
+
+  /// @brief 数组解析进度
+  struct Frame {
+    RedisReply *reply;
+    /// 正在解析的元素下标
+    size_t next;
+    /// 头部声明的元素个数
+    size_t count;
+  };
+
+private:
+  std::shared_ptr<char[]> m_buf;
+  size_t                  m_cap;
+  size_t                  m_defaultCap;
+  /// 下一个待解析字节
+  size_t m_rpos = 0;
+  /// 已写入数据的末尾
+  size_t m_wpos = 0;
+  /// 当前元素需要的连续字节数(从m_rpos起), 0表示未知
+  size_t m_need = 0;
+  /// 正在解析的顶层回复
+  RedisReply::ptr    m_cur;
+  std::vector<Frame> m_stack;
+  std::string        m_error;
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_DB_RESP__H__ */
@@ -0,0 +1,447 @@
+#include "sylar/db/sqlite3.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+/// @brief 按printf格式生成sql
+static std::string FormatSQL(const char *format, va_list ap) {
+  char *buf = nullptr;
+  int   len = vasprintf(&buf, format, ap);
+  if (len < 0) {
+    return std::string();
+  }
+  std::string sql(buf, len);
+  free(buf);
+  return sql;
+}
+
+SQLite3::SQLite3(sqlite3 *db) : m_db(db) {
+}
+
+SQLite3::~SQLite3() {
+  close();
+}
+
+SQLite3::ptr SQLite3::Create(sqlite3 *db) {
+  return SQLite3::ptr(new SQLite3(db));
+}
+
+SQLite3::ptr SQLite3::Create(const std::string &dbname, int flags) {
+  sqlite3 *db = nullptr;
+  int      rt = sqlite3_open_v2(dbname.c_str(), &db, flags, nullptr);
+  if (rt != SQLITE_OK) {
+    SYLAR_LOG_ERROR(g_logger)
+        << "sqlite3_open_v2 dbname=" << dbname << " errno=" << rt
+        << " errstr=" << (db ? sqlite3_errmsg(db) : sqlite3_errstr(rt));
+    sqlite3_close_v2(db);
+    return nullptr;
+  }
+  return SQLite3::ptr(new SQLite3(db));
+}
+
+int SQLite3::close() {
+  if (!m_db) {
+    return SQLITE_OK;
+  }
+  // 缓存的语句只引用连接, 需先于连接释放
+  clearStmtCache();
+  int rt = sqlite3_close_v2(m_db);
+  if (rt == SQLITE_OK) {
+    m_db = nullptr;
+  }
+  return rt;
+}
+
+void SQLite3::clearStmtCache() {
+  m_stmts.clear();
+}
+
+IStmt::ptr SQLite3::prepare(const std::string &stmt) {
+  return SQLite3Stmt::Create(shared_from_this(), stmt);
+}
+
+IStmt::ptr SQLite3::prepareCached(const std::string &stmt) {
+  auto it = m_stmts.find(stmt);
+  if (it != m_stmts.end()) {
+    it->second->reset();
+    return it->second;
+  }
+  SQLite3Stmt::ptr st(new SQLite3Stmt(m_db, nullptr));
+  int              rt = sqlite3_prepare_v3(m_db,
+                                stmt.c_str(),
+                                stmt.size(),
+                                SQLITE_PREPARE_PERSISTENT,
+                                &st->m_stmt,
+                                nullptr);
+  if (rt != SQLITE_OK) {
+    SYLAR_LOG_ERROR(g_logger) << "sqlite3 prepare sql=" << stmt
+                              << " errno=" << rt << " errstr=" << getErrStr();
+    return nullptr;
+  }
+  m_stmts.emplace(stmt, st);
+  return st;
+}
+
+int SQLite3::getErrno() {
+  return sqlite3_errcode(m_db);
+}
+
+std::string SQLite3::getErrStr() {
+  return sqlite3_errmsg(m_db);
+}
+
+int SQLite3::execute(const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  std::string sql = FormatSQL(format, ap);
+  va_end(ap);
+  return execute(sql);
+}
+
+int SQLite3::execute(const std::string &sql) {
+  char *errmsg = nullptr;
+  int   rt     = sqlite3_exec(m_db, sql.c_str(), nullptr, nullptr, &errmsg);
+  if (rt != SQLITE_OK) {
+    SYLAR_LOG_ERROR(g_logger) << "sqlite3 execute sql=" << sql
+                              << " errno=" << rt
+                              << " errstr=" << (errmsg ? errmsg : "");
+  }
+  sqlite3_free(errmsg);
+  return rt;
+}
+
+int64_t SQLite3::getLastInsertId() {
+  return sqlite3_last_insert_rowid(m_db);
+}
+
+ISQLData::ptr SQLite3::query(const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  std::string sql = FormatSQL(format, ap);
+  va_end(ap);
+  return query(sql);
+}
+
+ISQLData::ptr SQLite3::query(const std::string &sql) {
+  IStmt::ptr stmt = prepare(sql);
+  if (!stmt) {
+    return nullptr;
+  }
+  return stmt->query();
+}
+
+ITransaction::ptr SQLite3::openTransaction(bool auto_commit) {
+  return ITransaction::ptr(
+      new SQLite3Transaction(shared_from_this(), auto_commit));
+}
+
+SQLite3Stmt::SQLite3Stmt(sqlite3 *db, SQLite3::ptr owner)
+    : m_db(db), m_owner(owner) {
+}
+
+SQLite3Stmt::~SQLite3Stmt() {
+  if (m_stmt) {
+    sqlite3_finalize(m_stmt);
+  }
+}
+
+SQLite3Stmt::ptr SQLite3Stmt::Create(SQLite3::ptr db, const std::string &stmt) {
+  SQLite3Stmt::ptr st(new SQLite3Stmt(db->getDB(), db));
+  int              rt = sqlite3_prepare_v2(
+      db->getDB(), stmt.c_str(), stmt.size(), &st->m_stmt, nullptr);
+  if (rt != SQLITE_OK) {
+    SYLAR_LOG_ERROR(g_logger) << "sqlite3 prepare sql=" << stmt
+                              << " errno=" << rt
+                              << " errstr=" << db->getErrStr();
+    return nullptr;
+  }
+  return st;
+}
+
+int SQLite3Stmt::bindInt8(int idx, const int8_t &value) {
+  return sqlite3_bind_int(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindUint8(int idx, const uint8_t &value) {
+  return sqlite3_bind_int(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindInt16(int idx, const int16_t &value) {
+  return sqlite3_bind_int(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindUint16(int idx, const uint16_t &value) {
+  return sqlite3_bind_int(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindInt32(int idx, const int32_t &value) {
+  return sqlite3_bind_int(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindUint32(int idx, const uint32_t &value) {
+  return sqlite3_bind_int64(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindInt64(int idx, const int64_t &value) {
+  return sqlite3_bind_int64(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindUint64(int idx, const uint64_t &value) {
+  return sqlite3_bind_int64(m_stmt, idx, (sqlite3_int64)value);
+}
+
+int SQLite3Stmt::bindFloat(int idx, const float &value) {
+  return sqlite3_bind_double(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindDouble(int idx, const double &value) {
+  return sqlite3_bind_double(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindString(int idx, const std::string_view &value) {
+  // SQLITE_STATIC: 不拷贝, 调用方保证执行结束前数据有效
+  return sqlite3_bind_text(
+      m_stmt, idx, value.data(), value.size(), SQLITE_STATIC);
+}
+
+int SQLite3Stmt::bindBlob(int idx, const std::string_view &value) {
+  return sqlite3_bind_blob(
+      m_stmt, idx, value.data(), value.size(), SQLITE_STATIC);
+}
+
+int SQLite3Stmt::bindTime(int idx, const time_t &value) {
+  return sqlite3_bind_int64(m_stmt, idx, value);
+}
+
+int SQLite3Stmt::bindNull(int idx) {
+  return sqlite3_bind_null(m_stmt, idx);
+}
+
+int SQLite3Stmt::execute() {
+  int rt = sqlite3_step(m_stmt);
+  if (rt == SQLITE_DONE || rt == SQLITE_ROW) {
+    rt = SQLITE_OK;
+  } else {
+    SYLAR_LOG_ERROR(g_logger)
+        << "sqlite3 execute sql=" << sqlite3_sql(m_stmt) << " errno=" << rt
+        << " errstr=" << getErrStr();
+  }
+  // 保留绑定的参数, 以便批量执行时只重新绑定变化的列
+  sqlite3_reset(m_stmt);
+  return rt;
+}
+
+ISQLData::ptr SQLite3Stmt::query() {
+  sqlite3_reset(m_stmt);
+  // 语句已预编译成功, 执行错误由next()记录
+  return ISQLData::ptr(new SQLite3Data(shared_from_this(), SQLITE_OK, ""));
+}
+
+int SQLite3Stmt::reset() {
+  sqlite3_reset(m_stmt);
+  return sqlite3_clear_bindings(m_stmt);
+}
+
+int64_t SQLite3Stmt::getLastInsertId() {
+  return sqlite3_last_insert_rowid(m_db);
+}
+
+int SQLite3Stmt::getChanges() {
+  return sqlite3_changes(m_db);
+}
+
+int SQLite3Stmt::getErrno() {
+  return sqlite3_errcode(m_db);
+}
+
+std::string SQLite3Stmt::getErrStr() {
+  return sqlite3_errmsg(m_db);
+}
+
+SQLite3Data::SQLite3Data(SQLite3Stmt::ptr stmt, int err, const char *errstr)
+    : m_errno(err), m_errstr(errstr), m_stmt(stmt) {
+}
+
+int SQLite3Data::getColumnCount() {
+  return sqlite3_column_count(m_stmt->m_stmt);
+}
+
+int SQLite3Data::getColumnBytes(int idx) {
+  return sqlite3_column_bytes(m_stmt->m_stmt, idx);
+}
+
+std::string SQLite3Data::getColumnName(int idx) {
+  const char *name = sqlite3_column_name(m_stmt->m_stmt, idx);
+  return name ? name : "";
+}
+
+bool SQLite3Data::isNull(int idx) {
+  return sqlite3_column_type(m_stmt->m_stmt, idx) == SQLITE_NULL;
+}
+
+int8_t SQLite3Data::getInt8(int idx) {
+  return sqlite3_column_int(m_stmt->m_stmt, idx);
+}
+
+uint8_t SQLite3Data::getUint8(int idx) {
+  return sqlite3_column_int(m_stmt->m_stmt, idx);
+}
+
+int16_t SQLite3Data::getInt16(int idx) {
+  return sqlite3_column_int(m_stmt->m_stmt, idx);
+}
+
+uint16_t SQLite3Data::getUint16(int idx) {
+  return sqlite3_column_int(m_stmt->m_stmt, idx);
+}
+
+int32_t SQLite3Data::getInt32(int idx) {
+  return sqlite3_column_int(m_stmt->m_stmt, idx);
+}
+
+uint32_t SQLite3Data::getUint32(int idx) {
+  return sqlite3_column_int64(m_stmt->m_stmt, idx);
+}
+
+int64_t SQLite3Data::getInt64(int idx) {
+  return sqlite3_column_int64(m_stmt->m_stmt, idx);
+}
+
+uint64_t SQLite3Data::getUint64(int idx) {
+  return sqlite3_column_int64(m_stmt->m_stmt, idx);
+}
+
+float SQLite3Data::getFloat(int idx) {
+  return sqlite3_column_double(m_stmt->m_stmt, idx);
+}
+
+double SQLite3Data::getDouble(int idx) {
+  return sqlite3_column_double(m_stmt->m_stmt, idx);
+}
+
+std::string SQLite3Data::getString(int idx) {
+  return std::string(getStringView(idx));
+}
+
+std::string_view SQLite3Data::getStringView(int idx) {
+  // 先取数据再取长度, 保证长度对应转换后的文本
+  const char *v = (const char *)sqlite3_column_text(m_stmt->m_stmt, idx);
+  if (v == nullptr) {
+    return std::string_view();
+  }
+  return std::string_view(v, sqlite3_column_bytes(m_stmt->m_stmt, idx));
+}
+
+std::string SQLite3Data::getBlob(int idx) {
+  const char *v = (const char *)sqlite3_column_blob(m_stmt->m_stmt, idx);
+  if (v == nullptr) {
+    return std::string();
+  }
+  return std::string(v, sqlite3_column_bytes(m_stmt->m_stmt, idx));
+}
+
+time_t SQLite3Data::getTime(int idx) {
+  if (sqlite3_column_type(m_stmt->m_stmt, idx) != SQLITE_TEXT) {
+    return sqlite3_column_int64(m_stmt->m_stmt, idx);
+  }
+  // 兼容CURRENT_TIMESTAMP写入的 "YYYY-mm-dd HH:MM:SS" (UTC)
+  const char *v = (const char *)sqlite3_column_text(m_stmt->m_stmt, idx);
+  struct tm   t;
+  memset(&t, 0, sizeof(t));
+  if (strptime(v, "%Y-%m-%d %H:%M:%S", &t) == nullptr) {
+    return 0;
+  }
+  return timegm(&t);
+}
+
+bool SQLite3Data::next() {
+  int rt = sqlite3_step(m_stmt->m_stmt);
+  if (rt == SQLITE_ROW) {
+    return true;
+  }
+  if (rt != SQLITE_DONE) {
+    m_errno  = rt;
+    m_errstr = m_stmt->getErrStr();
+    SYLAR_LOG_ERROR(g_logger)
+        << "sqlite3 query sql=" << sqlite3_sql(m_stmt->m_stmt)
+        << " errno=" << rt << " errstr=" << m_errstr;
+  }
+  return false;
+}
+
+SQLite3Transaction::SQLite3Transaction(SQLite3::ptr db,
+                                       bool         auto_commit,
+                                       Type         type)
+    : m_db(db), m_type(type), m_status(0), m_autoCommit(auto_commit) {
+}
+
+SQLite3Transaction::~SQLite3Transaction() {
+  if (m_status == 1) {
+    if (m_autoCommit) {
+      commit();
+    } else {
+      rollback();
+    }
+  }
+}
+
+bool SQLite3Transaction::begin() {
+  if (m_status != 0) {
+    return false;
+  }
+  static const char *s_begin[] = {
+      "BEGIN", "BEGIN IMMEDIATE", "BEGIN EXCLUSIVE"};
+  if (m_db->execute(s_begin[m_type]) != SQLITE_OK) {
+    return false;
+  }
+  m_status = 1;
+  return true;
+}
+
+bool SQLite3Transaction::commit() {
+  if (m_status != 1) {
+    return m_status == 2;
+  }
+  if (m_db->execute("COMMIT") != SQLITE_OK) {
+    return false;
+  }
+  m_status = 2;
+  return true;
+}
+
+bool SQLite3Transaction::rollback() {
+  if (m_status != 1) {
+    return m_status == 3;
+  }
+  if (m_db->execute("ROLLBACK") != SQLITE_OK) {
+    return false;
+  }
+  m_status = 3;
+  return true;
+}
+
+int SQLite3Transaction::execute(const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  std::string sql = FormatSQL(format, ap);
+  va_end(ap);
+  return execute(sql);
+}
+
+int SQLite3Transaction::execute(const std::string &sql) {
+  return m_db->execute(sql);
+}
+
+int64_t SQLite3Transaction::getLastInsertId() {
+  return m_db->getLastInsertId();
+}
+
+}  // namespace sylar
@@ -0,0 +1,228 @@
+/**
+ * @file sqlite3.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief SQLite3数据库访问封装
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_DB_SQLITE3__H__
+#define __SYLAR_DB_SQLITE3__H__
+
+#include <sqlite3.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "sylar/db/db.h"
+#include "sylar/noncopyable.h"
+
+namespace sylar {
+
+class SQLite3Stmt;
+
+/// @brief SQLite3连接
+/// @details 非线程安全, 一个连接同一时间只能由一个线程(协程)使用.
+///          连接内缓存按sql预编译的语句, 生成的ORM代码通过prepareCached复用
+class SQLite3 : public IDB,
+                public std::enable_shared_from_this<SQLite3>,
+                Noncopyable {
+  friend class SQLite3Stmt;
+
+public:
+  typedef std::shared_ptr<SQLite3> ptr;
+
+  /// @brief 打开标志
+  enum Flags {
+    READONLY  = SQLITE_OPEN_READONLY,
+    READWRITE = SQLITE_OPEN_READWRITE,
+    CREATE    = SQLITE_OPEN_CREATE,
+  };
+
+  /// @brief 包装已打开的连接, 析构时关闭
+  static SQLite3::ptr Create(sqlite3 *db);
+
+  /// @brief 打开数据库
+  /// @param dbname 文件路径, ":memory:"为内存数据库
+  /// @param flags 打开标志
+  /// @return 失败返回nullptr
+  static SQLite3::ptr Create(const std::string &dbname,
+                             int                flags = READWRITE | CREATE);
+
+  ~SQLite3();
+
+  IStmt::ptr prepare(const std::string &stmt) override;
+  IStmt::ptr prepareCached(const std::string &stmt) override;
+
+  int         getErrno() override;
+  std::string getErrStr() override;
+
+  int     execute(const char *format, ...) override;
+  int     execute(const std::string &sql) override;
+  int64_t getLastInsertId() override;
+
+  ISQLData::ptr query(const char *format, ...) override;
+  ISQLData::ptr query(const std::string &sql) override;
+
+  ITransaction::ptr openTransaction(bool auto_commit = false) override;
+
+  /// @brief 返回缓存的预编译语句数量
+  size_t getCachedStmtCount() const {
+    return m_stmts.size();
+  }
+
+  /// @brief 清空预编译语句缓存
+  void clearStmtCache();
+
+  /// @brief 返回原始连接
+  sqlite3 *getDB() const {
+    return m_db;
+  }
+
+  /// @brief 关闭连接
+  int close();
+
+private:
+  SQLite3(sqlite3 *db);
+
+private:
+  sqlite3 *m_db;
+  /// 预编译语句缓存
+  std::unordered_map<std::string, std::shared_ptr<SQLite3Stmt> > m_stmts;
+};
+
+/// @brief SQLite3预编译语句
+class SQLite3Stmt : public IStmt,
+                    public std::enable_shared_from_this<SQLite3Stmt>,
+                    Noncopyable {
+  friend class SQLite3;
+  friend class SQLite3Data;
+
+public:
+  typedef std::shared_ptr<SQLite3Stmt> ptr;
+
+  /// @brief 预编译语句
+  /// @param db 连接
+  /// @param stmt sql
+  /// @return 失败返回nullptr
+  static SQLite3Stmt::ptr Create(SQLite3::ptr db, const std::string &stmt);
+
+  ~SQLite3Stmt();
+
+  int bindInt8(int idx, const int8_t &value) override;
+  int bindUint8(int idx, const uint8_t &value) override;
+  int bindInt16(int idx, const int16_t &value) override;
+  int bindUint16(int idx, const uint16_t &value) override;
+  int bindInt32(int idx, const int32_t &value) override;
+  int bindUint32(int idx, const uint32_t &value) override;
+  int bindInt64(int idx, const int64_t &value) override;
+  int bindUint64(int idx, const uint64_t &value) override;
+  int bindFloat(int idx, const float &value) override;
+  int bindDouble(int idx, const double &value) override;
+  int bindString(int idx, const std::string_view &value) override;
+  int bindBlob(int idx, const std::string_view &value) override;
+  int bindTime(int idx, const time_t &value) override;
+  int bindNull(int idx) override;
+
+  int           execute() override;
+  ISQLData::ptr query() override;
+  int           reset() override;
+
+  int64_t     getLastInsertId() override;
+  int         getChanges() override;
+  int         getErrno() override;
+  std::string getErrStr() override;
+
+private:
+  SQLite3Stmt(sqlite3 *db, SQLite3::ptr owner);
+
+private:
+  sqlite3      *m_db;
+  sqlite3_stmt *m_stmt = nullptr;
+  /// 非缓存的语句持有连接, 缓存的语句由连接持有
+  SQLite3::ptr m_owner;
+};
+
+/// @brief SQLite3查询结果集
+class SQLite3Data : public ISQLData {
+public:
+  typedef std::shared_ptr<SQLite3Data> ptr;
+
+  SQLite3Data(SQLite3Stmt::ptr stmt, int err, const char *errstr);
+
+  int getErrno() const override {
+    return m_errno;
+  }
+
+  const std::string &getErrStr() const override {
+    return m_errstr;
+  }
+
+  int         getColumnCount() override;
+  int         getColumnBytes(int idx) override;
+  std::string getColumnName(int idx) override;
+
+  bool             isNull(int idx) override;
+  int8_t           getInt8(int idx) override;
+  uint8_t          getUint8(int idx) override;
+  int16_t          getInt16(int idx) override;
+  uint16_t         getUint16(int idx) override;
+  int32_t          getInt32(int idx) override;
+  uint32_t         getUint32(int idx) override;
+  int64_t          getInt64(int idx) override;
+  uint64_t         getUint64(int idx) override;
+  float            getFloat(int idx) override;
+  double           getDouble(int idx) override;
+  std::string      getString(int idx) override;
+  std::string_view getStringView(int idx) override;
+  std::string      getBlob(int idx) override;
+  time_t           getTime(int idx) override;
+
+  bool next() override;
+
+private:
+  int              m_errno;
+  std::string      m_errstr;
+  SQLite3Stmt::ptr m_stmt;
+};
+
+/// @brief SQLite3事务
+class SQLite3Transaction : public ITransaction {
+public:
+  /// @brief 事务类型
+  enum Type {
+    DEFERRED  = 0,
+    IMMEDIATE = 1,
+    EXCLUSIVE = 2,
+  };
+
+  SQLite3Transaction(SQLite3::ptr db,
+                     bool         auto_commit = false,
+                     Type         type        = DEFERRED);
+
+  /// @brief 析构函数, 未结束的事务按auto_commit提交或回滚
+  ~SQLite3Transaction();
+
+  bool begin() override;
+  bool commit() override;
+  bool rollback() override;
+
+  int     execute(const char *format, ...) override;
+  int     execute(const std::string &sql) override;
+  int64_t getLastInsertId() override;
+
+private:
+  SQLite3::ptr m_db;
+  Type         m_type;
+  /// 0: 未开始, 1: 已开始, 2: 已提交, 3: 已回滚
+  int8_t m_status;
+  bool   m_autoCommit;
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_DB_SQLITE3__H__ */
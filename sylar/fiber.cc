@@ -0,0 +1,227 @@
+#include "sylar/fiber.h"
+
+#include <stdio.h>
+
+#include <exception>
+
+#include "sylar/fiber_context.h"
+#include "sylar/macro.h"
+#include "valgrind/valgrind.h"
+
+namespace sylar {
+
+/// 协程id生成
+static std::atomic<uint64_t> s_fiber_id{0};
+/// 当前协程总数
+static std::atomic<uint64_t> s_fiber_count{0};
+/// 默认协程栈大小
+static std::atomic<size_t> s_fiber_stack_size{128 * 1024};
+
+/// 线程当前执行的协程
+static thread_local Fiber *t_fiber = nullptr;
+/// 线程主协程
+static thread_local Fiber::ptr t_threadFiber = nullptr;
+/// 线程的协程执行者
+static thread_local FiberExecutor *t_executor = nullptr;
+
+Fiber::Fiber() {
+  m_state = EXEC;
+  m_onCpu.store(true, std::memory_order_relaxed);
+  SetThis(this);
+  ++s_fiber_count;
+}
+
+Fiber::Fiber(std::function<void()> cb, size_t stacksize)
+    : m_id(++s_fiber_id), m_cb(std::move(cb)) {
+  ++s_fiber_count;
+  m_stack = StackAllocatorMgr::GetInstance()->alloc(
+      stacksize ? stacksize : GetDefaultStackSize());
+  m_valgrindStackId = VALGRIND_STACK_REGISTER(m_stack.base, m_stack.top());
+  m_sp              = MakeFiberContext(m_stack.top(), &Fiber::MainFunc, this);
+}
+
+Fiber::~Fiber() {
+  --s_fiber_count;
+  if (m_stack.base) {
+    SYLAR_ASSERT(m_state == TERM || m_state == EXCEPT || m_state == INIT);
+    VALGRIND_STACK_DEREGISTER(m_valgrindStackId);
+    StackAllocatorMgr::GetInstance()->dealloc(m_stack);
+  } else {
+    SYLAR_ASSERT(!m_cb);
+    SYLAR_ASSERT(m_state == EXEC);
+    if (t_fiber == this) {
+      SetThis(nullptr);
+    }
+  }
+}
+
+void Fiber::reset(std::function<void()> cb) {
+  SYLAR_ASSERT(m_stack.base);
+  SYLAR_ASSERT(m_state == TERM || m_state == EXCEPT || m_state == INIT);
+  m_cb    = std::move(cb);
+  m_sp    = MakeFiberContext(m_stack.top(), &Fiber::MainFunc, this);
+  m_state = INIT;
+}
+
+Fiber::State Fiber::resume() {
+  if (SYLAR_UNLIKELY(!t_fiber)) {
+    GetThis();
+  }
+  // 被其他线程唤醒时, 原线程可能尚未完成切出, 需等待其保存完上下文
+  while (m_onCpu.load(std::memory_order_acquire)) {
+    Spinlock::CpuRelax();
+  }
+  // 切出完成后才能读取状态, 重复投递的已结束协程直接返回
+  if (m_state == TERM || m_state == EXCEPT) {
+    return m_state;
+  }
+  SYLAR_ASSERT(m_state != EXEC);
+
+  Fiber *caller = t_fiber;
+  m_onCpu.store(true, std::memory_order_relaxed);
+  m_caller = caller;
+  m_state  = EXEC;
+  SetThis(this);
+  SwitchFiberContext(&caller->m_sp, m_sp);
+  // 本协程已切出, 上下文保存完毕, 此后不能再访问本协程的状态
+  State state = m_state;
+  m_onCpu.store(false, std::memory_order_release);
+  return state;
+}
+
+void Fiber::yield() {
+  SYLAR_ASSERT(t_fiber == this && m_caller);
+  Fiber *caller = m_caller;
+  m_caller      = nullptr;
+  if (m_state == EXEC) {
+    m_state = HOLD;
+  }
+  SetThis(caller);
+  SwitchFiberContext(&m_sp, caller->m_sp);
+}
+
+void Fiber::SetThis(Fiber *f) {
+  t_fiber = f;
+}
+
+Fiber::ptr Fiber::GetThis() {
+  if (t_fiber) {
+    return t_fiber->shared_from_this();
+  }
+  Fiber::ptr main_fiber(new Fiber);
+  SYLAR_ASSERT(t_fiber == main_fiber.get());
+  t_threadFiber = main_fiber;
+  return t_fiber->shared_from_this();
+}
+
+void Fiber::YieldToReady() {
+  Fiber *cur = t_fiber;
+  SYLAR_ASSERT(cur && cur->m_state == EXEC);
+  cur->m_state = READY;
+  cur->yield();
+}
+
+void Fiber::YieldToHold() {
+  Fiber *cur = t_fiber;
+  SYLAR_ASSERT(cur && cur->m_state == EXEC);
+  cur->m_state = HOLD;
+  cur->yield();
+}
+
+uint64_t Fiber::TotalFibers() {
+  return s_fiber_count;
+}
+
+void Fiber::MainFunc(void *arg) {
+  // 协程栈上不持有自身的智能指针, 以保证协程结束后能被正常释放
+  Fiber *cur = static_cast<Fiber *>(arg);
+  try {
+    cur->m_cb();
+    cur->m_cb    = nullptr;
+    cur->m_state = TERM;
+  } catch (std::exception &ex) {
+    cur->m_cb    = nullptr;
+    cur->m_state = EXCEPT;
+    fprintf(stderr,
+            "Fiber Except: %s fiber_id=%lu\n",
+            ex.what(),
+            (unsigned long)cur->getId());
+  } catch (...) {
+    cur->m_cb    = nullptr;
+    cur->m_state = EXCEPT;
+    fprintf(stderr, "Fiber Except fiber_id=%lu\n", (unsigned long)cur->getId());
+  }
+
+  cur->yield();
+  SYLAR_ASSERT2(false, "never reach");
+}
+
+uint64_t Fiber::GetFiberId() {
+  if (t_fiber) {
+    return t_fiber->getId();
+  }
+  return 0;
+}
+
+size_t Fiber::GetDefaultStackSize() {
+  return s_fiber_stack_size.load(std::memory_order_relaxed);
+}
+
+void Fiber::SetDefaultStackSize(size_t size) {
+  s_fiber_stack_size.store(size, std::memory_order_relaxed);
+}
+
+FiberExecutor *FiberExecutor::GetThis() {
+  return t_executor;
+}
+
+void FiberExecutor::SetThis(FiberExecutor *executor) {
+  t_executor = executor;
+}
+
+FiberSemaphore::FiberSemaphore(size_t initial_concurrency)
+    : m_concurrency(initial_concurrency) {
+}
+
+FiberSemaphore::~FiberSemaphore() {
+  SYLAR_ASSERT(m_waiters.empty());
+}
+
+bool FiberSemaphore::tryWait() {
+  MutexType::Lock lock(m_mutex);
+  if (m_concurrency > 0u) {
+    --m_concurrency;
+    return true;
+  }
+  return false;
+}
+
+void FiberSemaphore::wait() {
+  FiberExecutor *executor = FiberExecutor::GetThis();
+  SYLAR_ASSERT2(executor, "FiberSemaphore::wait must run in a FiberExecutor");
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_concurrency > 0u) {
+      --m_concurrency;
+      return;
+    }
+    m_waiters.emplace_back(executor, Fiber::GetThis());
+  }
+  Fiber::YieldToHold();
+}
+
+void FiberSemaphore::notify() {
+  std::pair<FiberExecutor *, Fiber::ptr> waiter;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_waiters.empty()) {
+      ++m_concurrency;
+      return;
+    }
+    waiter = std::move(m_waiters.front());
+    m_waiters.pop_front();
+  }
+  waiter.first->post(std::move(waiter.second));
+}
+
+}  // namespace sylar
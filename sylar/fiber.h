@@ -0,0 +1,210 @@
+/**
+ * @file fiber.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 协程封装
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __FIBER__H__
+#define __FIBER__H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+
+#include "sylar/mutex.h"
+#include "sylar/noncopyable.h"
+#include "sylar/stack_allocator.h"
+
+namespace sylar {
+
+class FiberExecutor;
+
+/// @brief 有栈协程
+/// @details 非对称协程: resume()从调用方切入, yield()切回调用方
+///          上下文切换只保存callee-saved寄存器, 栈来自StackAllocator池
+class Fiber : public std::enable_shared_from_this<Fiber>, Noncopyable {
+public:
+  typedef std::shared_ptr<Fiber> ptr;
+
+  /// @brief 协程状态
+  enum State {
+    /// 初始化状态
+    INIT,
+    /// 暂停状态
+    HOLD,
+    /// 执行中状态
+    EXEC,
+    /// 结束状态
+    TERM,
+    /// 可执行状态
+    READY,
+    /// 异常状态
+    EXCEPT
+  };
+
+private:
+  /// @brief 无参构造函数, 每个线程第一个协程(线程主协程)的构造
+  Fiber();
+
+public:
+  /// @brief 构造函数
+  /// @param cb 协程执行的函数
+  /// @param stacksize 协程栈大小, 0表示使用默认值
+  Fiber(std::function<void()> cb, size_t stacksize = 0);
+
+  /// @brief 析构函数
+  ~Fiber();
+
+  /// @brief 重置协程执行函数, 并设置状态, 复用已分配的栈
+  /// @pre getState() 为 INIT, TERM, EXCEPT
+  /// @post getState() = INIT
+  /// @param cb 协程执行的函数
+  void reset(std::function<void()> cb);
+
+  /// @brief 将当前线程正在执行的协程挂起, 切换到本协程执行
+  /// @pre getState() != EXEC
+  /// @return 本协程切回调用方时的状态, 已结束的协程不执行, 直接返回TERM或EXCEPT
+  /// @details 协程切出后可能立即被其他线程唤醒并修改状态, 调用方应使用返回值,
+  ///          而不是在resume前后调用getState()
+  State resume();
+
+  /// @brief 将本协程挂起, 切回resume它的协程
+  /// @pre getState() = EXEC
+  void yield();
+
+  /// @brief 返回协程id
+  uint64_t getId() const {
+    return m_id;
+  }
+
+  /// @brief 返回协程状态
+  State getState() const {
+    return m_state;
+  }
+
+  /// @brief 设置协程状态
+  void setState(State state) {
+    m_state = state;
+  }
+
+  /// @brief 协程栈大小
+  size_t getStackSize() const {
+    return m_stack.size;
+  }
+
+public:
+  /// @brief 设置当前线程的运行协程
+  /// @param f 运行协程
+  static void SetThis(Fiber *f);
+
+  /// @brief 返回当前所在的协程, 线程首次调用时创建线程主协程
+  static Fiber::ptr GetThis();
+
+  /// @brief 将当前协程切换到后台, 并设置为READY状态
+  static void YieldToReady();
+
+  /// @brief 将当前协程切换到后台, 并设置为HOLD状态
+  static void YieldToHold();
+
+  /// @brief 返回当前协程的总数量
+  static uint64_t TotalFibers();
+
+  /// @brief 协程执行函数, 执行完成返回到调用方
+  static void MainFunc(void *arg);
+
+  /// @brief 获取当前协程的id
+  static uint64_t GetFiberId();
+
+  /// @brief 获取默认协程栈大小
+  static size_t GetDefaultStackSize();
+
+  /// @brief 设置默认协程栈大小
+  static void SetDefaultStackSize(size_t size);
+
+private:
+  /// 协程id
+  uint64_t m_id = 0;
+  /// 协程状态
+  State m_state = INIT;
+  /// 保存的栈指针
+  void *m_sp = nullptr;
+  /// resume本协程的协程
+  Fiber *m_caller = nullptr;
+  /// 协程栈
+  FiberStack m_stack;
+  /// 协程运行函数
+  std::function<void()> m_cb;
+  /// 上下文是否仍在某个线程上, 用于跨线程唤醒时等待切出完成
+  std::atomic<bool> m_onCpu{false};
+  /// valgrind栈注册id
+  unsigned m_valgrindStackId = 0;
+};
+
+/// @brief 协程执行者, 负责把被唤醒的协程重新投递执行
+/// @details 调度器实现该接口, 并在其工作线程上通过SetThis注册
+class FiberExecutor {
+public:
+  virtual ~FiberExecutor() = default;
+
+  /// @brief 投递一个就绪的协程
+  /// @param fiber 协程
+  virtual void post(Fiber::ptr fiber) = 0;
+
+  /// @brief 返回当前线程的执行者
+  static FiberExecutor *GetThis();
+
+  /// @brief 设置当前线程的执行者
+  static void SetThis(FiberExecutor *executor);
+};
+
+/// @brief 协程信号量
+/// @details 等待时只挂起当前协程, 线程继续执行其他协程
+class FiberSemaphore : Noncopyable {
+public:
+  typedef Spinlock MutexType;
+
+  /// @brief 构造函数
+  /// @param initial_concurrency 初始信号量
+  FiberSemaphore(size_t initial_concurrency = 0);
+
+  /// @brief 析构函数
+  ~FiberSemaphore();
+
+  /// @brief 尝试获取信号量
+  /// @return 是否获取成功
+  bool tryWait();
+
+  /// @brief 获取信号量, 无可用时挂起当前协程
+  /// @pre 必须在FiberExecutor管理的协程中调用
+  void wait();
+
+  /// @brief 释放信号量, 有等待者时将其投递回所属执行者
+  void notify();
+
+  /// @brief 当前可用信号量
+  size_t getConcurrency() const {
+    return m_concurrency;
+  }
+
+  /// @brief 清空信号量
+  void reset() {
+    m_concurrency = 0;
+  }
+
+private:
+  MutexType                                          m_mutex;
+  std::list<std::pair<FiberExecutor *, Fiber::ptr> > m_waiters;
+  size_t                                             m_concurrency = 0;
+};
+
+}  // namespace sylar
+
+#endif /* __FIBER__H__ */
@@ -0,0 +1,144 @@
+#include "sylar/fiber_context.h"
+
+#include <stdint.h>
+
+extern "C" {
+/// 首次切换进入协程时的跳板, 从callee-saved寄存器中取出entry和arg
+void sylar_fiber_context_start();
+}
+
+#if defined(__x86_64__)
+
+// 栈布局(低地址 -> 高地址):
+//   [mxcsr/fpucw 16B] r15 r14 r13 r12 rbx rbp ret
+// rdi: void **from, rsi: void *to
+asm(R"(
+    .text
+    .globl  sylar_switch_fiber_context
+    .hidden sylar_switch_fiber_context
+    .type   sylar_switch_fiber_context, @function
+    .p2align 4
+sylar_switch_fiber_context:
+    pushq   %rbp
+    pushq   %rbx
+    pushq   %r12
+    pushq   %r13
+    pushq   %r14
+    pushq   %r15
+    subq    $16, %rsp
+    stmxcsr 8(%rsp)
+    fnstcw  12(%rsp)
+    movq    %rsp, (%rdi)
+    movq    %rsi, %rsp
+    ldmxcsr 8(%rsp)
+    fldcw   12(%rsp)
+    addq    $16, %rsp
+    popq    %r15
+    popq    %r14
+    popq    %r13
+    popq    %r12
+    popq    %rbx
+    popq    %rbp
+    ret
+    .size   sylar_switch_fiber_context, .-sylar_switch_fiber_context
+
+    .globl  sylar_fiber_context_start
+    .hidden sylar_fiber_context_start
+    .type   sylar_fiber_context_start, @function
+    .p2align 4
+sylar_fiber_context_start:
+    movq    %r12, %rdi
+    callq   *%r13
+    ud2
+    .size   sylar_fiber_context_start, .-sylar_fiber_context_start
+)");
+
+namespace sylar {
+
+void *MakeFiberContext(void *stack_top, FiberEntry entry, void *arg) {
+  // 跳板入口处栈需16字节对齐
+  uintptr_t top = reinterpret_cast<uintptr_t>(stack_top) & ~uintptr_t(15);
+  uint64_t *sp  = reinterpret_cast<uint64_t *>(top);
+  *--sp         = reinterpret_cast<uint64_t>(&sylar_fiber_context_start);
+  *--sp         = 0;                                  // rbp
+  *--sp         = 0;                                  // rbx
+  *--sp         = reinterpret_cast<uint64_t>(arg);    // r12
+  *--sp         = reinterpret_cast<uint64_t>(entry);  // r13
+  *--sp         = 0;                                  // r14
+  *--sp         = 0;                                  // r15
+  *--sp         = (uint64_t(0x037f) << 32) | 0x1f80;  // fpucw | mxcsr
+  *--sp         = 0;
+  return sp;
+}
+
+}  // namespace sylar
+
+#elif defined(__aarch64__)
+
+// 栈布局(低地址 -> 高地址): d8-d15 x19-x28 x29 x30
+// x0: void **from, x1: void *to
+asm(R"(
+    .text
+    .globl  sylar_switch_fiber_context
+    .hidden sylar_switch_fiber_context
+    .type   sylar_switch_fiber_context, %function
+    .p2align 4
+sylar_switch_fiber_context:
+    sub     sp, sp, #0xa0
+    stp     d8,  d9,  [sp, #0x00]
+    stp     d10, d11, [sp, #0x10]
+    stp     d12, d13, [sp, #0x20]
+    stp     d14, d15, [sp, #0x30]
+    stp     x19, x20, [sp, #0x40]
+    stp     x21, x22, [sp, #0x50]
+    stp     x23, x24, [sp, #0x60]
+    stp     x25, x26, [sp, #0x70]
+    stp     x27, x28, [sp, #0x80]
+    stp     x29, x30, [sp, #0x90]
+    mov     x2, sp
+    str     x2, [x0]
+    mov     sp, x1
+    ldp     d8,  d9,  [sp, #0x00]
+    ldp     d10, d11, [sp, #0x10]
+    ldp     d12, d13, [sp, #0x20]
+    ldp     d14, d15, [sp, #0x30]
+    ldp     x19, x20, [sp, #0x40]
+    ldp     x21, x22, [sp, #0x50]
+    ldp     x23, x24, [sp, #0x60]
+    ldp     x25, x26, [sp, #0x70]
+    ldp     x27, x28, [sp, #0x80]
+    ldp     x29, x30, [sp, #0x90]
+    add     sp, sp, #0xa0
+    ret
+    .size   sylar_switch_fiber_context, .-sylar_switch_fiber_context
+
+    .globl  sylar_fiber_context_start
+    .hidden sylar_fiber_context_start
+    .type   sylar_fiber_context_start, %function
+    .p2align 4
+sylar_fiber_context_start:
+    mov     x0, x19
+    blr     x20
+    brk     #0
+    .size   sylar_fiber_context_start, .-sylar_fiber_context_start
+)");
+
+namespace sylar {
+
+void *MakeFiberContext(void *stack_top, FiberEntry entry, void *arg) {
+  uintptr_t top = reinterpret_cast<uintptr_t>(stack_top) & ~uintptr_t(15);
+  uint64_t *sp  = reinterpret_cast<uint64_t *>(top) - 20;
+  for (int i = 0; i < 20; ++i) {
+    sp[i] = 0;
+  }
+  sp[8]  = reinterpret_cast<uint64_t>(arg);    // x19
+  sp[9]  = reinterpret_cast<uint64_t>(entry);  // x20
+  sp[19] = reinterpret_cast<uint64_t>(&sylar_fiber_context_start);  // x30
+  return sp;
+}
+
+}  // namespace sylar
+
+#else
+#error "sylar fiber context switch only supports x86-64 and aarch64"
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file fiber_context.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 协程上下文切换(x86-64/aarch64汇编实现)
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __FIBER_CONTEXT__H__
+#define __FIBER_CONTEXT__H__
+
+#include <stddef.h>
+
+extern "C" {
+/// 汇编实现, 见fiber_context.cc
+void sylar_switch_fiber_context(void **from, void *to);
+}
+
+namespace sylar {
+
+/// @brief 协程入口函数
+typedef void (*FiberEntry)(void *arg);
+
+/// @brief 在栈上构造初始上下文
+/// @param stack_top 栈顶(高地址)
+/// @param entry 首次切换进入时调用的函数, 不允许返回
+/// @param arg entry的参数
+/// @return 初始上下文栈指针, 用于SwitchFiberContext
+void *MakeFiberContext(void *stack_top, FiberEntry entry, void *arg);
+
+/// @brief 保存当前上下文到from, 并切换到to
+/// @details 仅保存ABI规定的callee-saved寄存器, 不涉及信号掩码等系统调用
+/// @param from 保存当前栈指针的位置
+/// @param to 目标上下文栈指针
+inline void SwitchFiberContext(void **from, void *to) {
+  sylar_switch_fiber_context(from, to);
+}
+
+}  // namespace sylar
+
+#endif /* __FIBER_CONTEXT__H__ */
@@ -0,0 +1,125 @@
+#include "sylar/fox_thread.h"
+
+#include <yaml-cpp/yaml.h>
+
+#include "sylar/config.h"
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+template <>
+class LexicalCast<std::string, FoxThreadDefine> {
+public:
+  FoxThreadDefine operator()(const std::string &v) {
+    YAML::Node      n = YAML::Load(v);
+    FoxThreadDefine fd;
+    if (n["name"].IsDefined()) {
+      fd.name = n["name"].as<std::string>();
+    }
+    if (n["num"].IsDefined()) {
+      fd.num = n["num"].as<size_t>();
+    }
+    if (n["advance"].IsDefined()) {
+      fd.advance = n["advance"].as<int>();
+    }
+    return fd;
+  }
+};
+
+template <>
+class LexicalCast<FoxThreadDefine, std::string> {
+public:
+  std::string operator()(const FoxThreadDefine &i) {
+    YAML::Node n;
+    n["name"]    = i.name;
+    n["num"]     = i.num;
+    n["advance"] = i.advance;
+    std::stringstream ss;
+    ss << n;
+    return ss.str();
+  }
+};
+
+/// IO线程组配置, 对应fox_thread.yml的fox_thread节点
+static ConfigVar<std::map<std::string, FoxThreadDefine> >::ptr
+    g_fox_thread_defines =
+        Config::Lookup("fox_thread",
+                       std::map<std::string, FoxThreadDefine>(),
+                       "fox thread config");
+
+struct FoxThreadIniter {
+  FoxThreadIniter() {
+    g_fox_thread_defines->addListener(
+        [](const std::map<std::string, FoxThreadDefine> &old_value,
+           const std::map<std::string, FoxThreadDefine> &new_value) {
+          FoxThreadMgr::GetInstance()->init(new_value);
+        });
+  }
+};
+
+static FoxThreadIniter __fox_thread_init;
+
+FoxThreadManager::~FoxThreadManager() {
+  stop();
+}
+
+IOManager::ptr FoxThreadManager::get(const std::string &name) {
+  RWMutex::ReadLock lock(m_mutex);
+  auto              it = m_datas.find(name);
+  return it == m_datas.end() ? nullptr : it->second;
+}
+
+bool FoxThreadManager::init(
+    const std::map<std::string, FoxThreadDefine> &defines) {
+  for (auto &i : defines) {
+    if (i.second.num == 0) {
+      SYLAR_LOG_ERROR(g_logger)
+          << "FoxThreadManager::init " << i.first << " num is 0";
+      return false;
+    }
+  }
+  RWMutex::WriteLock lock(m_mutex);
+  for (auto &i : defines) {
+    auto it = m_datas.find(i.first);
+    if (it != m_datas.end()) {
+      if (it->second->getThreadCount() != i.second.num) {
+        SYLAR_LOG_WARN(g_logger)
+            << "FoxThreadManager::init " << i.first << " num "
+            << it->second->getThreadCount() << " -> " << i.second.num
+            << " takes effect after restart";
+      }
+      continue;
+    }
+    IOManager::ptr iom(new IOManager(
+        i.second.num, i.second.name.empty() ? i.first : i.second.name));
+    iom->start();
+    m_datas[i.first] = iom;
+    SYLAR_LOG_INFO(g_logger) << "FoxThreadManager::init " << i.first
+                             << " num=" << i.second.num << " backend="
+                             << IOManager::BackendToString(iom->getBackend());
+  }
+  return true;
+}
+
+void FoxThreadManager::stop() {
+  std::map<std::string, IOManager::ptr> datas;
+  {
+    RWMutex::WriteLock lock(m_mutex);
+    datas.swap(m_datas);
+  }
+  for (auto &i : datas) {
+    i.second->stop();
+  }
+}
+
+std::ostream &FoxThreadManager::dump(std::ostream &os) {
+  RWMutex::ReadLock lock(m_mutex);
+  for (auto &i : m_datas) {
+    i.second->dump(os) << std::endl;
+  }
+  return os;
+}
+
+}  // namespace sylar
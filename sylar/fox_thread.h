@@ -0,0 +1,81 @@
+/**
+ * @file fox_thread.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 按名称管理的IO线程组
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __FOX_THREAD__H__
+#define __FOX_THREAD__H__
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+#include "sylar/singleton.h"
+
+namespace sylar {
+
+/// @brief IO线程组配置
+struct FoxThreadDefine {
+  /// 线程名称
+  std::string name;
+  /// 线程数量
+  size_t num = 1;
+  /// 兼容旧配置保留, IOManager按工作窃取分发任务, 不再区分分发方式
+  int advance = 0;
+
+  bool operator==(const FoxThreadDefine &oth) const {
+    return name == oth.name && num == oth.num && advance == oth.advance;
+  }
+};
+
+/// @brief IO线程组管理器
+/// @details 对应配置 fox_thread 节点, 例如:
+///          fox_thread:
+///              redis:
+///                  name: redis
+///                  num: 2
+///          每个线程组是一个独立的IOManager, 供redis等长连接客户端使用.
+///          连接的fd注册在所属IOManager上, 因此线程组创建后不随配置重新加载替换,
+///          线程数变化只记录警告, 重启后生效
+class FoxThreadManager {
+public:
+  /// @brief 析构函数, 停止全部线程组
+  ~FoxThreadManager();
+
+  /// @brief 按名称获取线程组
+  /// @return 不存在返回nullptr
+  IOManager::ptr get(const std::string &name);
+
+  /// @brief 按配置创建并启动尚不存在的线程组
+  /// @param defines 线程组名称到配置的映射
+  /// @return 是否成功
+  bool init(const std::map<std::string, FoxThreadDefine> &defines);
+
+  /// @brief 停止全部线程组
+  /// @pre 使用线程组的客户端已关闭, 否则等待其未完成的IO
+  void stop();
+
+  /// @brief 输出全部线程组状态
+  std::ostream &dump(std::ostream &os);
+
+private:
+  RWMutex                               m_mutex;
+  std::map<std::string, IOManager::ptr> m_datas;
+};
+
+/// IO线程组管理器单例
+typedef sylar::Singleton<FoxThreadManager> FoxThreadMgr;
+
+}  // namespace sylar
+
+#endif /* __FOX_THREAD__H__ */
@@ -0,0 +1,1074 @@
+#include "sylar/iomanager.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+
+#include "sylar/macro.h"
+#include "sylar/metrics.h"
+
+#if __has_include(<liburing.h>)
+#include <liburing.h>
+#define SYLAR_HAVE_LIBURING 1
+#else
+#define SYLAR_HAVE_LIBURING 0
+#endif
+
+namespace sylar {
+
+static_assert(int(IOManager::READ) == int(EPOLLIN), "READ != EPOLLIN");
+static_assert(int(IOManager::WRITE) == int(EPOLLOUT), "WRITE != EPOLLOUT");
+
+/// io_uring队列长度
+static constexpr unsigned kRingEntries = 256;
+/// 提交队列积累到该数量时立即提交, 否则在tick/idle中批量提交
+static constexpr unsigned kSubmitBatch = 32;
+/// idle最长阻塞时间(毫秒)
+static constexpr uint64_t kMaxTimeoutMs = 3000;
+/// 固定文件表最大长度, fd直接作为表中序号
+static constexpr size_t kMaxFixedFiles = 4096;
+/// 每2^4次读写计时一次, 两次读时钟的开销与短系统调用相当
+static constexpr uint32_t kIoSampleShift = 4;
+/// 读写计时的采样计数
+static thread_local uint32_t t_ioSampleTick = 0;
+/// 固定文件按线程序号记录在64位图中
+static constexpr size_t kMaxFixedFileRings = 64;
+/// 固定缓冲区数量与大小
+static constexpr size_t kBufferCount = 256;
+static constexpr size_t kBufferSize  = 16 * 1024;
+/// 单次epoll_wait最多处理的事件数
+static constexpr int kMaxEvents = 256;
+
+/// @brief 工作线程的IO上下文
+struct IOManager::IOContext {
+#if SYLAR_HAVE_LIBURING
+  /// io_uring
+  struct io_uring ring;
+#endif
+  /// ring是否已初始化
+  bool ringInited = false;
+  /// epoll后端: 线程的epoll fd, 包含wakefd与本线程负责的fd
+  int epfd = -1;
+  /// 唤醒用的eventfd
+  int wakefd = -1;
+  /// io_uring后端: eventfd读缓冲
+  uint64_t wakeBuf = 0;
+  /// io_uring后端: 是否已提交eventfd读请求
+  bool wakeArmed = false;
+};
+
+/// @brief 进行中的io_uring请求, 位于发起协程的栈上
+struct IOManager::IORequest {
+  /// 发起请求的协程
+  Fiber::ptr fiber;
+  /// 请求结果
+  int res = 0;
+#if SYLAR_HAVE_LIBURING
+  /// 超时时间, 提交时由内核读取
+  struct __kernel_timespec ts;
+#endif
+};
+
+/// @brief socket读写的耗时, 字节数, 失败与超时次数, 按方向区分
+struct IoMetrics {
+  explicit IoMetrics(const char *dir)
+      : seconds(MetricsRegistry::GetInstance()->histogram(
+            "sylar_io_seconds",
+            "socket io time after the fd is ready, excluding the wait; "
+            "sampled 1 in 16 calls, io_uring reads are not timed",
+            {{"dir", dir}})),
+        bytes(MetricsRegistry::GetInstance()->counter(
+            "sylar_io_bytes_total", "socket io bytes", {{"dir", dir}})),
+        errors(MetricsRegistry::GetInstance()->counter(
+            "sylar_io_errors_total",
+            "failed socket io, excluding timeouts",
+            {{"dir", dir}})),
+        timeouts(MetricsRegistry::GetInstance()->counter(
+            "sylar_io_timeouts_total",
+            "socket io that timed out or would block",
+            {{"dir", dir}})) {
+  }
+
+  Histogram::ptr seconds;
+  Counter::ptr   bytes;
+  Counter::ptr   errors;
+  Counter::ptr   timeouts;
+};
+
+/// @brief 一次读写的指标, done记录结果
+/// @details 只计时timed包住的部分, 不含等待就绪: epoll后端包住每次系统调用,
+///          io_uring后端包住写请求从提交到完成. io_uring的读请求在内核中等待数据,
+///          等待与传输无法拆分, 长连接上主要是对端的空闲时间, 因此不计时.
+///          耗时按kIoSampleShift采样, 字节数/失败/超时每次都计数
+class IoScope {
+public:
+  explicit IoScope(IOManager::Event event)
+      : m_metrics(Get(event)),
+        m_sampled(ScopedTimer::Sample(t_ioSampleTick, kIoSampleShift)) {
+  }
+
+  /// @brief 执行一次读写, 采样时累计耗时
+  template <class Fn, class... Args>
+  auto timed(Fn fn, Args... args) -> decltype(fn(args...)) {
+    if (!m_sampled) {
+      return fn(args...);
+    }
+    uint64_t begin = ScopedTimer::Now();
+    auto     rt    = fn(args...);
+    m_ns += ScopedTimer::Now() - begin;
+    m_timed = true;
+    return rt;
+  }
+
+  ssize_t done(ssize_t rt) {
+    if (m_timed) {
+      m_metrics.seconds->record(m_ns);
+    }
+    if (rt >= 0) {
+      m_metrics.bytes->inc(rt);
+    } else if (errno == ETIMEDOUT || errno == EAGAIN ||
+               errno == EWOULDBLOCK) {
+      m_metrics.timeouts->inc();
+    } else {
+      m_metrics.errors->inc();
+    }
+    return rt;
+  }
+
+private:
+  static IoMetrics &Get(IOManager::Event event) {
+    static IoMetrics s_read("read");
+    static IoMetrics s_write("write");
+    return event == IOManager::WRITE ? s_write : s_read;
+  }
+
+private:
+  IoMetrics &m_metrics;
+  bool       m_sampled;
+  uint64_t   m_ns    = 0;
+  bool       m_timed = false;
+};
+
+/// @brief 距截止时间的剩余毫秒数
+static uint64_t Remaining(uint64_t deadline) {
+  if (deadline == ~0ull) {
+    return ~0ull;
+  }
+  uint64_t now = TimerManager::GetCurrentMS();
+  return now >= deadline ? 0 : deadline - now;
+}
+
+#if SYLAR_HAVE_LIBURING
+/// @brief 将-errno形式的结果转换为-1并设置errno
+static int ToErrno(int rt) {
+  if (rt < 0) {
+    errno = -rt;
+    return -1;
+  }
+  return rt;
+}
+#endif
+
+IOManager::IOManager(size_t                  threads,
+                     const std::string      &name,
+                     Backend                 backend,
+                     const std::vector<int> &cpus)
+    : Scheduler(threads, name.empty() ? "iomanager" : name, cpus) {
+  for (size_t i = 0; i < threads; ++i) {
+    m_contexts.emplace_back(new IOContext);
+  }
+  if (backend != EPOLL && initUring()) {
+    m_backend = IO_URING;
+  } else {
+    m_backend = EPOLL;
+  }
+
+  for (auto &ctx : m_contexts) {
+    // io_uring对O_NONBLOCK的文件直接返回-EAGAIN, 因此只有epoll使用非阻塞eventfd
+    int flags   = EFD_CLOEXEC | (m_backend == EPOLL ? EFD_NONBLOCK : 0);
+    ctx->wakefd = eventfd(0, flags);
+    SYLAR_ASSERT(ctx->wakefd >= 0);
+  }
+  if (m_backend == EPOLL) {
+    initEpoll();
+  }
+  initBuffers();
+}
+
+IOManager::~IOManager() {
+  stop();
+  for (auto &ctx : m_contexts) {
+#if SYLAR_HAVE_LIBURING
+    if (ctx->ringInited) {
+      io_uring_queue_exit(&ctx->ring);
+    }
+#endif
+    if (ctx->epfd >= 0) {
+      ::close(ctx->epfd);
+    }
+    ::close(ctx->wakefd);
+  }
+  if (m_bufferBase) {
+    munmap(m_bufferBase, kBufferCount * kBufferSize);
+  }
+  for (auto i : m_fdContexts) {
+    delete i;
+  }
+}
+
+bool IOManager::initUring() {
+#if SYLAR_HAVE_LIBURING
+  for (size_t i = 0; i < m_contexts.size(); ++i) {
+    IOContext *ctx = m_contexts[i].get();
+    if (io_uring_queue_init(kRingEntries, &ctx->ring, 0) < 0) {
+      for (size_t j = 0; j < i; ++j) {
+        io_uring_queue_exit(&m_contexts[j]->ring);
+        m_contexts[j]->ringInited = false;
+      }
+      return false;
+    }
+    ctx->ringInited = true;
+  }
+
+  // 固定文件表大小受RLIMIT_NOFILE限制, 注册失败则不使用固定文件
+  size_t        files = kMaxFixedFiles;
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < files) {
+    files = rl.rlim_cur;
+  }
+  if (m_contexts.size() > kMaxFixedFileRings) {
+    files = 0;
+  }
+  if (files > 0) {
+    std::vector<int> fds(files, -1);
+    size_t           done = 0;
+    for (; done < m_contexts.size(); ++done) {
+      if (io_uring_register_files(&m_contexts[done]->ring, fds.data(), files) <
+          0) {
+        break;
+      }
+    }
+    if (done < m_contexts.size()) {
+      for (size_t j = 0; j < done; ++j) {
+        io_uring_unregister_files(&m_contexts[j]->ring);
+      }
+      files = 0;
+    }
+  }
+  m_fixedFiles = files;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void IOManager::initEpoll() {
+  for (auto &ctx : m_contexts) {
+    ctx->epfd = epoll_create1(EPOLL_CLOEXEC);
+    SYLAR_ASSERT(ctx->epfd >= 0);
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN | EPOLLET;
+    event.data.ptr = ctx.get();
+    int rt         = epoll_ctl(ctx->epfd, EPOLL_CTL_ADD, ctx->wakefd, &event);
+    SYLAR_ASSERT(rt == 0);
+  }
+}
+
+void IOManager::initBuffers() {
+  void *base = mmap(nullptr,
+                    kBufferCount * kBufferSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1,
+                    0);
+  if (base == MAP_FAILED) {
+    return;
+  }
+  m_bufferBase = base;
+  m_buffers.resize(kBufferCount);
+  std::vector<iovec> iovs(kBufferCount);
+  for (size_t i = 0; i < kBufferCount; ++i) {
+    m_buffers[i].data   = (char *)base + i * kBufferSize;
+    m_buffers[i].size   = kBufferSize;
+    m_buffers[i].index  = int(i);
+    iovs[i].iov_base    = m_buffers[i].data;
+    iovs[i].iov_len     = kBufferSize;
+  }
+  m_freeBuffers.reserve(kBufferCount);
+  for (size_t i = kBufferCount; i > 0; --i) {
+    m_freeBuffers.push_back(&m_buffers[i - 1]);
+  }
+
+#if SYLAR_HAVE_LIBURING
+  if (m_backend != IO_URING) {
+    return;
+  }
+  // 每个ring注册同一组缓冲区, 协程迁移到其他线程后序号依然有效
+  // 锁定内存受RLIMIT_MEMLOCK限制, 注册失败时退化为普通读写
+  size_t done = 0;
+  for (; done < m_contexts.size(); ++done) {
+    if (io_uring_register_buffers(
+            &m_contexts[done]->ring, iovs.data(), kBufferCount) < 0) {
+      break;
+    }
+  }
+  if (done < m_contexts.size()) {
+    for (size_t j = 0; j < done; ++j) {
+      io_uring_unregister_buffers(&m_contexts[j]->ring);
+    }
+    return;
+  }
+  m_buffersRegistered = true;
+#endif
+}
+
+IOManager *IOManager::GetThis() {
+  return dynamic_cast<IOManager *>(Scheduler::GetThis());
+}
+
+const char *IOManager::BackendToString(Backend backend) {
+  switch (backend) {
+    case AUTO:
+      return "auto";
+    case IO_URING:
+      return "io_uring";
+    case EPOLL:
+      return "epoll";
+  }
+  return "unknown";
+}
+
+IOManager::IOContext *IOManager::currentContext() {
+  SYLAR_ASSERT2(Scheduler::GetThis() == this,
+                "IOManager io outside of its worker");
+  SYLAR_ASSERT2(Fiber::GetThis().get() != GetMainFiber(),
+                "IOManager io in scheduler fiber");
+  return m_contexts[GetWorkerId()].get();
+}
+
+IOManager::FdContext *IOManager::getFdContext(int fd, bool auto_create) {
+  if (fd < 0) {
+    return nullptr;
+  }
+  {
+    RWMutexType::ReadLock lock(m_mutex);
+    if ((size_t)fd < m_fdContexts.size()) {
+      if (m_fdContexts[fd] || !auto_create) {
+        return m_fdContexts[fd];
+      }
+    } else if (!auto_create) {
+      return nullptr;
+    }
+  }
+
+  RWMutexType::WriteLock lock(m_mutex);
+  if ((size_t)fd >= m_fdContexts.size()) {
+    m_fdContexts.resize(std::max<size_t>(fd * 3 / 2 + 1, 32), nullptr);
+  }
+  if (!m_fdContexts[fd]) {
+    m_fdContexts[fd]     = new FdContext;
+    m_fdContexts[fd]->fd = fd;
+  }
+  return m_fdContexts[fd];
+}
+
+void IOManager::unregisterFixed(FdContext *fd_ctx) {
+#if SYLAR_HAVE_LIBURING
+  int none = -1;
+  for (size_t i = 0; fd_ctx->ringMask && i < m_contexts.size(); ++i) {
+    if (fd_ctx->ringMask & (1ull << i)) {
+      io_uring_register_files_update(&m_contexts[i]->ring, fd_ctx->fd, &none, 1);
+    }
+  }
+#endif
+  fd_ctx->ringMask = 0;
+}
+
+void IOManager::resetFd(int fd) {
+  FdContext *fd_ctx = getFdContext(fd, true);
+  if (!fd_ctx) {
+    return;
+  }
+  // fd可能复用了未经close关闭的旧fd, 清理旧的固定文件注册
+  FdContext::MutexType::Lock lock(fd_ctx->mutex);
+  unregisterFixed(fd_ctx);
+  fd_ctx->nonblock = (m_backend == EPOLL);
+}
+
+int IOManager::fixedFile(IOContext *ctx, int fd) {
+  if ((size_t)fd >= m_fixedFiles) {
+    return -1;
+  }
+#if SYLAR_HAVE_LIBURING
+  uint64_t   bit    = 1ull << GetWorkerId();
+  FdContext *fd_ctx = getFdContext(fd, true);
+  FdContext::MutexType::Lock lock(fd_ctx->mutex);
+  if (!(fd_ctx->ringMask & bit)) {
+    if (io_uring_register_files_update(&ctx->ring, fd, &fd, 1) != 1) {
+      return -1;
+    }
+    fd_ctx->ringMask |= bit;
+  }
+  return fd;
+#else
+  (void)ctx;
+  return -1;
+#endif
+}
+
+#if SYLAR_HAVE_LIBURING
+template <class Prep>
+int IOManager::uringCall(int fd, uint64_t timeout_ms, Prep prep) {
+  IOContext       *ctx  = currentContext();
+  struct io_uring *ring = &ctx->ring;
+  unsigned         need = timeout_ms != ~0ull ? 2 : 1;
+  if (io_uring_sq_space_left(ring) < need) {
+    io_uring_submit(ring);
+  }
+
+  IORequest req;
+  req.fiber = Fiber::GetThis();
+  int file  = fixedFile(ctx, fd);
+
+  struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+  SYLAR_ASSERT(sqe);
+  prep(sqe, file >= 0 ? file : fd);
+  if (file >= 0) {
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  io_uring_sqe_set_data(sqe, &req);
+  if (need == 2) {
+    sqe->flags |= IOSQE_IO_LINK;
+    req.ts.tv_sec                 = timeout_ms / 1000;
+    req.ts.tv_nsec                = (timeout_ms % 1000) * 1000000;
+    struct io_uring_sqe *link_sqe = io_uring_get_sqe(ring);
+    SYLAR_ASSERT(link_sqe);
+    io_uring_prep_link_timeout(link_sqe, &req.ts, 0);
+    io_uring_sqe_set_data(link_sqe, nullptr);
+  }
+  m_pendingOps.fetch_add(1, std::memory_order_relaxed);
+  if (io_uring_sq_ready(ring) >= kSubmitBatch) {
+    io_uring_submit(ring);
+  }
+
+  Fiber::YieldToHold();
+  if (need == 2 && req.res == -ECANCELED) {
+    return -ETIMEDOUT;
+  }
+  return req.res;
+}
+
+template <class Prep>
+int IOManager::uringIO(int fd, uint32_t poll_mask, uint64_t timeout_ms,
+                       Prep prep) {
+  uint64_t deadline =
+      timeout_ms == ~0ull ? ~0ull : TimerManager::GetCurrentMS() + timeout_ms;
+  while (true) {
+    int rt = uringCall(fd, Remaining(deadline), prep);
+    if (rt != -EAGAIN) {
+      return rt;
+    }
+    // 非阻塞fd: 等待就绪后重试
+    uint64_t left = Remaining(deadline);
+    if (left == 0) {
+      return -ETIMEDOUT;
+    }
+    rt = uringCall(fd, left, [poll_mask](io_uring_sqe *sqe, int file) {
+      io_uring_prep_poll_add(sqe, file, poll_mask);
+    });
+    if (rt < 0) {
+      return rt;
+    }
+  }
+}
+#endif
+
+bool IOManager::setNonblock(FdContext *fd_ctx) {
+  FdContext::MutexType::Lock lock(fd_ctx->mutex);
+  if (fd_ctx->nonblock) {
+    return true;
+  }
+  int flags = fcntl(fd_ctx->fd, F_GETFL, 0);
+  if (flags == -1) {
+    return false;
+  }
+  if (!(flags & O_NONBLOCK) &&
+      fcntl(fd_ctx->fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+    return false;
+  }
+  fd_ctx->nonblock = true;
+  return true;
+}
+
+template <class Fn>
+ssize_t IOManager::epollIO(int fd, Event event, uint64_t timeout_ms, Fn fn) {
+  FdContext *fd_ctx = getFdContext(fd, true);
+  if (!fd_ctx) {
+    errno = EBADF;
+    return -1;
+  }
+  if (!setNonblock(fd_ctx)) {
+    return -1;
+  }
+  uint64_t deadline =
+      timeout_ms == ~0ull ? ~0ull : TimerManager::GetCurrentMS() + timeout_ms;
+  while (true) {
+    ssize_t n = fn();
+    if (n >= 0) {
+      return n;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      return -1;
+    }
+    uint64_t left = Remaining(deadline);
+    if (left == 0) {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (waitEvent(fd_ctx, event, left) < 0) {
+      return -1;
+    }
+  }
+}
+
+int IOManager::accept(int        fd,
+                      sockaddr  *addr,
+                      socklen_t *addrlen,
+                      uint64_t   timeout_ms) {
+  int rt = -1;
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    rt = ToErrno(uringIO(
+        fd, POLLIN, timeout_ms, [addr, addrlen](io_uring_sqe *sqe, int file) {
+          io_uring_prep_accept(sqe, file, addr, addrlen, SOCK_CLOEXEC);
+        }));
+  }
+#endif
+  if (m_backend == EPOLL) {
+    rt = epollIO(fd, READ, timeout_ms, [fd, addr, addrlen]() {
+      return ::accept4(fd, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    });
+  }
+  if (rt >= 0) {
+    resetFd(rt);
+  }
+  return rt;
+}
+
+int IOManager::connect(int             fd,
+                       const sockaddr *addr,
+                       socklen_t       addrlen,
+                       uint64_t        timeout_ms) {
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    uint64_t deadline =
+        timeout_ms == ~0ull ? ~0ull : TimerManager::GetCurrentMS() + timeout_ms;
+    int rt = uringCall(fd, timeout_ms, [addr, addrlen](io_uring_sqe *sqe, int file) {
+      io_uring_prep_connect(sqe, file, addr, addrlen);
+    });
+    if (rt == -EINPROGRESS || rt == -EAGAIN) {
+      // 非阻塞socket: 等待可写后读取连接结果
+      rt = uringCall(fd, Remaining(deadline), [](io_uring_sqe *sqe, int file) {
+        io_uring_prep_poll_add(sqe, file, POLLOUT);
+      });
+      if (rt >= 0) {
+        int       error = 0;
+        socklen_t len   = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) {
+          return -1;
+        }
+        rt = -error;
+      }
+    }
+    return ToErrno(rt);
+  }
+#endif
+  FdContext *fd_ctx = getFdContext(fd, true);
+  if (!fd_ctx) {
+    errno = EBADF;
+    return -1;
+  }
+  if (!setNonblock(fd_ctx)) {
+    return -1;
+  }
+  int rt = ::connect(fd, addr, addrlen);
+  if (rt == 0 || errno != EINPROGRESS) {
+    return rt;
+  }
+  if (waitEvent(fd_ctx, WRITE, timeout_ms) < 0) {
+    return -1;
+  }
+  int       error = 0;
+  socklen_t len   = sizeof(error);
+  if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) {
+    return -1;
+  }
+  if (error) {
+    errno = error;
+    return -1;
+  }
+  return 0;
+}
+
+ssize_t IOManager::recv(int      fd,
+                        void    *buf,
+                        size_t   len,
+                        int      flags,
+                        uint64_t timeout_ms) {
+  IoScope scope(READ);
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    return scope.done(ToErrno(uringIO(
+        fd, POLLIN, timeout_ms, [buf, len, flags](io_uring_sqe *sqe, int file) {
+          io_uring_prep_recv(sqe, file, buf, len, flags);
+        })));
+  }
+#endif
+  return scope.done(epollIO(fd, READ, timeout_ms, [&]() {
+    return scope.timed(::recv, fd, buf, len, flags);
+  }));
+}
+
+ssize_t IOManager::send(int         fd,
+                        const void *buf,
+                        size_t      len,
+                        int         flags,
+                        uint64_t    timeout_ms) {
+  IoScope scope(WRITE);
+  flags |= MSG_NOSIGNAL;
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    return scope.done(ToErrno(scope.timed([&]() {
+      return uringIO(fd, POLLOUT, timeout_ms, [buf, len, flags](io_uring_sqe *sqe, int file) {
+        io_uring_prep_send(sqe, file, buf, len, flags);
+      });
+    })));
+  }
+#endif
+  return scope.done(epollIO(fd, WRITE, timeout_ms, [&]() {
+    return scope.timed(::send, fd, buf, len, flags);
+  }));
+}
+
+ssize_t IOManager::recvmsg(int      fd,
+                           msghdr  *msg,
+                           int      flags,
+                           uint64_t timeout_ms) {
+  IoScope scope(READ);
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    return scope.done(ToErrno(uringIO(
+        fd, POLLIN, timeout_ms, [msg, flags](io_uring_sqe *sqe, int file) {
+          io_uring_prep_recvmsg(sqe, file, msg, flags);
+        })));
+  }
+#endif
+  return scope.done(epollIO(fd, READ, timeout_ms, [&]() {
+    return scope.timed(::recvmsg, fd, msg, flags);
+  }));
+}
+
+ssize_t IOManager::sendmsg(int           fd,
+                           const msghdr *msg,
+                           int           flags,
+                           uint64_t      timeout_ms) {
+  IoScope scope(WRITE);
+  flags |= MSG_NOSIGNAL;
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    return scope.done(ToErrno(scope.timed([&]() {
+      return uringIO(fd, POLLOUT, timeout_ms, [msg, flags](io_uring_sqe *sqe, int file) {
+        io_uring_prep_sendmsg(sqe, file, msg, flags);
+      });
+    })));
+  }
+#endif
+  return scope.done(epollIO(fd, WRITE, timeout_ms, [&]() {
+    return scope.timed(::sendmsg, fd, msg, flags);
+  }));
+}
+
+ssize_t IOManager::readFixed(int          fd,
+                             FixedBuffer *buf,
+                             size_t       len,
+                             uint64_t     timeout_ms) {
+  IoScope scope(READ);
+  SYLAR_ASSERT(len <= buf->size);
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    bool fixed = m_buffersRegistered;
+    // 偏移-1表示从当前位置读取, 对socket等流式fd无影响
+    return scope.done(ToErrno(uringIO(
+        fd, POLLIN, timeout_ms, [buf, len, fixed](io_uring_sqe *sqe, int file) {
+          if (fixed) {
+            io_uring_prep_read_fixed(sqe, file, buf->data, len, -1, buf->index);
+          } else {
+            io_uring_prep_read(sqe, file, buf->data, len, -1);
+          }
+        })));
+  }
+#endif
+  return scope.done(epollIO(fd, READ, timeout_ms, [&]() {
+    return scope.timed(::read, fd, buf->data, len);
+  }));
+}
+
+ssize_t IOManager::writeFixed(int                fd,
+                              const FixedBuffer *buf,
+                              size_t             len,
+                              uint64_t           timeout_ms) {
+  IoScope scope(WRITE);
+  SYLAR_ASSERT(len <= buf->size);
+#if SYLAR_HAVE_LIBURING
+  if (m_backend == IO_URING) {
+    bool fixed = m_buffersRegistered;
+    return scope.done(ToErrno(scope.timed([&]() {
+      return uringIO(fd, POLLOUT, timeout_ms, [buf, len, fixed](io_uring_sqe *sqe, int file) {
+        if (fixed) {
+          io_uring_prep_write_fixed(sqe, file, buf->data, len, -1, buf->index);
+        } else {
+          io_uring_prep_write(sqe, file, buf->data, len, -1);
+        }
+      });
+    })));
+  }
+#endif
+  return scope.done(epollIO(fd, WRITE, timeout_ms, [&]() {
+    return scope.timed(::write, fd, buf->data, len);
+  }));
+}
+
+void IOManager::sleep(uint64_t ms) {
+  currentContext();
+  Fiber::ptr fiber = Fiber::GetThis();
+  addTimer(ms, [this, fiber]() { schedule(fiber); });
+  Fiber::YieldToHold();
+}
+
+int IOManager::close(int fd) {
+  FdContext *fd_ctx = getFdContext(fd, false);
+  if (fd_ctx) {
+    if (m_backend == EPOLL) {
+      cancelAll(fd_ctx);
+    }
+    FdContext::MutexType::Lock lock(fd_ctx->mutex);
+    unregisterFixed(fd_ctx);
+    fd_ctx->nonblock = false;
+  }
+  return ::close(fd);
+}
+
+FixedBuffer *IOManager::acquireBuffer() {
+  Spinlock::Lock lock(m_bufferMutex);
+  if (m_freeBuffers.empty()) {
+    return nullptr;
+  }
+  FixedBuffer *buf = m_freeBuffers.back();
+  m_freeBuffers.pop_back();
+  return buf;
+}
+
+void IOManager::releaseBuffer(FixedBuffer *buf) {
+  Spinlock::Lock lock(m_bufferMutex);
+  m_freeBuffers.push_back(buf);
+}
+
+bool IOManager::addEvent(FdContext *fd_ctx, Event event) {
+  FdContext::MutexType::Lock lock(fd_ctx->mutex);
+  SYLAR_ASSERT2(!(fd_ctx->events & event), "duplicate event on fd");
+  int op   = EPOLL_CTL_MOD;
+  int epfd = fd_ctx->epfd;
+  if (!fd_ctx->events) {
+    // 注册到当前线程的epoll, 只有当前线程被该fd的事件唤醒, 唤醒的协程也进入本线程队列
+    int worker = Scheduler::GetThis() == this ? GetWorkerId() : -1;
+    if (worker < 0) {
+      worker = fd_ctx->fd % m_contexts.size();
+    }
+    op   = EPOLL_CTL_ADD;
+    epfd = m_contexts[worker]->epfd;
+  }
+  epoll_event epevent;
+  memset(&epevent, 0, sizeof(epevent));
+  epevent.events   = EPOLLET | fd_ctx->events | event;
+  epevent.data.ptr = fd_ctx;
+  if (epoll_ctl(epfd, op, fd_ctx->fd, &epevent)) {
+    return false;
+  }
+  fd_ctx->epfd = epfd;
+  fd_ctx->events |= event;
+  (event == READ ? fd_ctx->reader : fd_ctx->writer) = Fiber::GetThis();
+  m_pendingOps.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void IOManager::triggerEvent(FdContext *fd_ctx, Event event) {
+  fd_ctx->events &= ~event;
+  Fiber::ptr fiber =
+      std::move(event == READ ? fd_ctx->reader : fd_ctx->writer);
+  schedule(std::move(fiber));
+  m_pendingOps.fetch_sub(1, std::memory_order_release);
+}
+
+bool IOManager::cancelEvent(FdContext *fd_ctx, Event event, int *flag) {
+  FdContext::MutexType::Lock lock(fd_ctx->mutex);
+  if (!(fd_ctx->events & event)) {
+    return false;
+  }
+  uint32_t    left = fd_ctx->events & ~event;
+  epoll_event epevent;
+  memset(&epevent, 0, sizeof(epevent));
+  epevent.events   = EPOLLET | left;
+  epevent.data.ptr = fd_ctx;
+  epoll_ctl(
+      fd_ctx->epfd, left ? EPOLL_CTL_MOD : EPOLL_CTL_DEL, fd_ctx->fd, &epevent);
+  if (!left) {
+    fd_ctx->epfd = -1;
+  }
+  if (flag) {
+    *flag = 1;
+  }
+  triggerEvent(fd_ctx, event);
+  return true;
+}
+
+void IOManager::cancelAll(FdContext *fd_ctx) {
+  FdContext::MutexType::Lock lock(fd_ctx->mutex);
+  if (!fd_ctx->events) {
+    return;
+  }
+  epoll_ctl(fd_ctx->epfd, EPOLL_CTL_DEL, fd_ctx->fd, nullptr);
+  fd_ctx->epfd = -1;
+  if (fd_ctx->events & READ) {
+    triggerEvent(fd_ctx, READ);
+  }
+  if (fd_ctx->events & WRITE) {
+    triggerEvent(fd_ctx, WRITE);
+  }
+}
+
+int IOManager::waitEvent(FdContext *fd_ctx, Event event, uint64_t timeout_ms) {
+  std::shared_ptr<int> timedout(new int(0));
+  Timer::ptr           timer;
+  if (timeout_ms != ~0ull) {
+    std::weak_ptr<int> winfo(timedout);
+    timer = addTimer(timeout_ms, [this, winfo, fd_ctx, event]() {
+      std::shared_ptr<int> flag = winfo.lock();
+      if (flag) {
+        cancelEvent(fd_ctx, event, flag.get());
+      }
+    });
+  }
+  if (!addEvent(fd_ctx, event)) {
+    if (timer) {
+      timer->cancel();
+    }
+    return -1;
+  }
+
+  Fiber::YieldToHold();
+  if (timer) {
+    timer->cancel();
+  }
+  if (*timedout) {
+    errno = ETIMEDOUT;
+    return -1;
+  }
+  return 0;
+}
+
+void IOManager::dispatchEvents(IOContext *ctx, epoll_event *events, int n) {
+  for (int i = 0; i < n; ++i) {
+    if (events[i].data.ptr == ctx) {
+      uint64_t dummy;
+      while (read(ctx->wakefd, &dummy, sizeof(dummy)) > 0)
+        ;
+      continue;
+    }
+    FdContext                 *fd_ctx = (FdContext *)events[i].data.ptr;
+    FdContext::MutexType::Lock lock(fd_ctx->mutex);
+    uint32_t                   real = events[i].events;
+    if (real & (EPOLLERR | EPOLLHUP)) {
+      real |= (EPOLLIN | EPOLLOUT) & fd_ctx->events;
+    }
+    real &= fd_ctx->events & (READ | WRITE);
+    if (!real) {
+      continue;
+    }
+
+    uint32_t    left = fd_ctx->events & ~real;
+    epoll_event epevent;
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.events   = EPOLLET | left;
+    epevent.data.ptr = fd_ctx;
+    epoll_ctl(
+        fd_ctx->epfd, left ? EPOLL_CTL_MOD : EPOLL_CTL_DEL, fd_ctx->fd, &epevent);
+    if (!left) {
+      fd_ctx->epfd = -1;
+    }
+    if (real & READ) {
+      triggerEvent(fd_ctx, READ);
+    }
+    if (real & WRITE) {
+      triggerEvent(fd_ctx, WRITE);
+    }
+  }
+}
+
+void IOManager::reap(IOContext *ctx) {
+#if SYLAR_HAVE_LIBURING
+  struct io_uring     *ring = &ctx->ring;
+  struct io_uring_cqe *cqe  = nullptr;
+  unsigned             head = 0;
+  unsigned             count = 0;
+  io_uring_for_each_cqe(ring, head, cqe) {
+    ++count;
+    void *data = io_uring_cqe_get_data(cqe);
+    // 链接的超时请求与wait_cqe_timeout内部的超时请求没有关联协程
+    if (!data || cqe->user_data == LIBURING_UDATA_TIMEOUT) {
+      continue;
+    }
+    if (data == &ctx->wakeBuf) {
+      ctx->wakeArmed = false;
+      continue;
+    }
+    IORequest *req   = (IORequest *)data;
+    req->res         = cqe->res;
+    Fiber::ptr fiber = std::move(req->fiber);
+    schedule(std::move(fiber));
+    m_pendingOps.fetch_sub(1, std::memory_order_release);
+  }
+  io_uring_cq_advance(ring, count);
+
+  if (!ctx->wakeArmed) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (sqe) {
+      io_uring_prep_read(sqe, ctx->wakefd, &ctx->wakeBuf, sizeof(uint64_t), 0);
+      io_uring_sqe_set_data(sqe, &ctx->wakeBuf);
+      ctx->wakeArmed = true;
+    }
+  }
+  if (io_uring_sq_ready(ring)) {
+    io_uring_submit(ring);
+  }
+#else
+  (void)ctx;
+#endif
+}
+
+void IOManager::processTimers() {
+  std::vector<std::function<void()> > cbs;
+  listExpiredCallbacks(cbs);
+  if (!cbs.empty()) {
+    schedule(cbs.begin(), cbs.end());
+  }
+}
+
+void IOManager::tickle(size_t worker) {
+  uint64_t one = 1;
+  ssize_t  rt  = write(m_contexts[worker]->wakefd, &one, sizeof(one));
+  (void)rt;
+}
+
+bool IOManager::stopping() {
+  return m_pendingOps.load(std::memory_order_acquire) == 0 && !hasTimer() &&
+         Scheduler::stopping();
+}
+
+void IOManager::onThreadStart(size_t worker) {
+  if (m_backend == IO_URING) {
+    // 提交eventfd读请求, 之后tickle才能唤醒阻塞在io_uring上的线程
+    reap(m_contexts[worker].get());
+  }
+}
+
+void IOManager::tick() {
+  IOContext *ctx = m_contexts[GetWorkerId()].get();
+  if (m_backend == IO_URING) {
+    reap(ctx);
+  } else {
+    epoll_event events[kMaxEvents];
+    int         n = epoll_wait(ctx->epfd, events, kMaxEvents, 0);
+    dispatchEvents(ctx, events, n);
+  }
+  processTimers();
+}
+
+void IOManager::idle() {
+  IOContext *ctx = m_contexts[GetWorkerId()].get();
+  while (!stopping()) {
+    if (m_backend == IO_URING) {
+#if SYLAR_HAVE_LIBURING
+      if (io_uring_sq_ready(&ctx->ring)) {
+        io_uring_submit(&ctx->ring);
+      }
+      // 在prepareSleep之后读取定时器, 新插入的首个定时器一定能唤醒本线程
+      if (prepareSleep()) {
+        uint64_t timeout = std::min(getNextTimer(), kMaxTimeoutMs);
+        if (timeout > 0 && io_uring_cq_ready(&ctx->ring) == 0) {
+          struct __kernel_timespec ts;
+          ts.tv_sec                 = timeout / 1000;
+          ts.tv_nsec                = (timeout % 1000) * 1000000;
+          struct io_uring_cqe *cqe = nullptr;
+          io_uring_wait_cqe_timeout(&ctx->ring, &cqe, &ts);
+        }
+      }
+      finishSleep();
+      reap(ctx);
+#endif
+    } else {
+      epoll_event events[kMaxEvents];
+      uint64_t    timeout = 0;
+      if (prepareSleep()) {
+        timeout = std::min(getNextTimer(), kMaxTimeoutMs);
+      }
+      int n = epoll_wait(ctx->epfd, events, kMaxEvents, int(timeout));
+      finishSleep();
+      dispatchEvents(ctx, events, n);
+    }
+
+    processTimers();
+    Fiber::YieldToHold();
+  }
+}
+
+void IOManager::onTimerInsertedAtFront() {
+  wakeup(-1);
+}
+
+bool ParseAddress(std::string_view host, sockaddr_in &addr, bool allow_any_port) {
+  size_t pos = host.rfind(':');
+  if (pos == std::string_view::npos) {
+    return false;
+  }
+  std::string_view port_str = host.substr(pos + 1);
+  int              port     = -1;
+  auto             rt       = std::from_chars(
+      port_str.data(), port_str.data() + port_str.size(), port);
+  if (rt.ec != std::errc() || rt.ptr != port_str.data() + port_str.size() ||
+      port < (allow_any_port ? 0 : 1) || port > 65535) {
+    return false;
+  }
+  std::string ip(host.substr(0, pos));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons(port);
+  return inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) == 1;
+}
+
+}  // namespace sylar
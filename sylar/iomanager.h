@@ -0,0 +1,291 @@
+/**
+ * @file iomanager.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 基于io_uring(或epoll)的IO协程调度器
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __IOMANAGER__H__
+#define __IOMANAGER__H__
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "sylar/mutex.h"
+#include "sylar/scheduler.h"
+#include "sylar/timer.h"
+
+struct io_uring_sqe;
+struct epoll_event;
+
+namespace sylar {
+
+/// @brief 注册到io_uring的固定缓冲区
+struct FixedBuffer {
+  /// 缓冲区地址
+  void *data = nullptr;
+  /// 缓冲区大小
+  size_t size = 0;
+  /// 注册序号
+  int index = -1;
+};
+
+/// @brief IO协程调度器
+/// @details 每个工作线程拥有独立的io_uring, 协程发起的IO请求写入当前线程的提交队列,
+///          在tick/idle中批量提交并收割完成事件, 完成后重新调度发起请求的协程.
+///          内核不支持io_uring时退化为epoll(边缘触发)实现, 每个fd注册在首次等待它的
+///          工作线程的epoll中, 事件只唤醒该线程.
+///          IO接口只能在本调度器的协程中调用, 失败返回-1并设置errno, 超时errno为ETIMEDOUT
+class IOManager : public Scheduler, public TimerManager {
+public:
+  typedef std::shared_ptr<IOManager> ptr;
+  typedef RWMutex                    RWMutexType;
+
+  /// @brief IO后端
+  enum Backend {
+    /// 优先io_uring, 不可用时使用epoll
+    AUTO     = 0,
+    /// io_uring
+    IO_URING = 1,
+    /// epoll
+    EPOLL    = 2,
+  };
+
+  /// @brief IO事件(与EPOLLIN/EPOLLOUT取值一致)
+  enum Event {
+    NONE  = 0x0,
+    READ  = 0x1,
+    WRITE = 0x4,
+  };
+
+  /// @brief 构造函数
+  /// @param threads 线程数量
+  /// @param name 调度器名称
+  /// @param backend IO后端, 指定IO_URING但不可用时同样退化为epoll
+  /// @param cpus 绑定的CPU列表
+  IOManager(size_t                  threads = 1,
+            const std::string      &name    = "",
+            Backend                 backend = AUTO,
+            const std::vector<int> &cpus    = {});
+
+  /// @brief 析构函数, 停止调度器并释放io_uring/epoll资源
+  ~IOManager();
+
+  /// @brief 返回实际使用的IO后端
+  Backend getBackend() const {
+    return m_backend;
+  }
+
+  /// @brief 返回固定缓冲区是否已注册到io_uring
+  bool hasFixedBuffers() const {
+    return m_buffersRegistered;
+  }
+
+  /// @brief 接收连接, 返回的fd在epoll后端下为非阻塞
+  int accept(int              fd,
+             sockaddr        *addr,
+             socklen_t       *addrlen,
+             uint64_t         timeout_ms = ~0ull);
+
+  /// @brief 发起连接
+  int connect(int              fd,
+              const sockaddr  *addr,
+              socklen_t        addrlen,
+              uint64_t         timeout_ms = ~0ull);
+
+  /// @brief 接收数据
+  ssize_t recv(int fd, void *buf, size_t len, int flags = 0,
+               uint64_t timeout_ms = ~0ull);
+
+  /// @brief 发送数据(自动附加MSG_NOSIGNAL)
+  ssize_t send(int fd, const void *buf, size_t len, int flags = 0,
+               uint64_t timeout_ms = ~0ull);
+
+  /// @brief 分散接收, 用于ByteArray等分块缓冲区
+  ssize_t recvmsg(int fd, msghdr *msg, int flags = 0,
+                  uint64_t timeout_ms = ~0ull);
+
+  /// @brief 聚集发送(自动附加MSG_NOSIGNAL)
+  ssize_t sendmsg(int fd, const msghdr *msg, int flags = 0,
+                  uint64_t timeout_ms = ~0ull);
+
+  /// @brief 使用固定缓冲区读取, 适用于socket/pipe等流式fd
+  /// @details 缓冲区未注册时退化为普通read
+  ssize_t readFixed(int fd, FixedBuffer *buf, size_t len,
+                    uint64_t timeout_ms = ~0ull);
+
+  /// @brief 使用固定缓冲区写入
+  ssize_t writeFixed(int fd, const FixedBuffer *buf, size_t len,
+                     uint64_t timeout_ms = ~0ull);
+
+  /// @brief 当前协程睡眠
+  /// @param ms 毫秒
+  void sleep(uint64_t ms);
+
+  /// @brief 关闭fd, 注销io_uring固定文件并唤醒epoll上等待的协程
+  /// @details 经由IOManager读写过的fd必须通过该接口关闭, 否则fd复用时会命中旧的固定文件
+  /// @pre io_uring后端下不能有未完成的请求, 内核持有文件引用, 关闭后请求不会结束
+  int close(int fd);
+
+  /// @brief 申请固定缓冲区, 无可用缓冲区返回nullptr
+  FixedBuffer *acquireBuffer();
+
+  /// @brief 归还固定缓冲区
+  void releaseBuffer(FixedBuffer *buf);
+
+  /// @brief 返回当前线程的IOManager
+  static IOManager *GetThis();
+
+  /// @brief 返回后端名称
+  static const char *BackendToString(Backend backend);
+
+protected:
+  void tickle(size_t worker) override;
+  bool stopping() override;
+  void idle() override;
+  void tick() override;
+  void onThreadStart(size_t worker) override;
+  void onTimerInsertedAtFront() override;
+
+private:
+  struct IOContext;
+  struct IORequest;
+
+  /// @brief fd上下文
+  struct FdContext {
+    typedef Mutex MutexType;
+
+    /// 锁
+    MutexType mutex;
+    /// fd
+    int fd = -1;
+    /// epoll已注册的事件
+    uint32_t events = NONE;
+    /// 注册所在的线程epoll fd, 未注册时为-1
+    int epfd = -1;
+    /// 等待读事件的协程
+    Fiber::ptr reader;
+    /// 等待写事件的协程
+    Fiber::ptr writer;
+    /// epoll后端下是否已设置O_NONBLOCK
+    bool nonblock = false;
+    /// 已注册为固定文件的io_uring(按线程序号的位图)
+    uint64_t ringMask = 0;
+  };
+
+  /// @brief 获取fd上下文
+  FdContext *getFdContext(int fd, bool auto_create);
+
+  /// @brief 新fd(如accept返回)初始化上下文
+  void resetFd(int fd);
+
+  /// @brief 从所有io_uring中注销fd的固定文件, 调用方持有fd_ctx->mutex
+  void unregisterFixed(FdContext *fd_ctx);
+
+  /// @brief epoll后端下设置fd为非阻塞
+  bool setNonblock(FdContext *fd_ctx);
+
+  /// @brief 初始化所有线程的io_uring, 失败时释放已创建的部分
+  bool initUring();
+
+  /// @brief 初始化epoll
+  void initEpoll();
+
+  /// @brief 注册固定缓冲区
+  void initBuffers();
+
+  /// @brief 返回当前线程的IO上下文
+  IOContext *currentContext();
+
+  /// @brief 返回fd在当前线程io_uring中的固定文件序号, 不可用返回-1
+  int fixedFile(IOContext *ctx, int fd);
+
+  /// @brief 在当前线程的io_uring上执行一个请求并等待完成
+  /// @param prep 填充sqe, 参数为sqe和fd(或固定文件序号)
+  /// @return 请求结果, 失败为-errno
+  template <class Prep>
+  int uringCall(int fd, uint64_t timeout_ms, Prep prep);
+
+  /// @brief uringCall的-EAGAIN重试封装, 通过POLL_ADD等待fd就绪
+  template <class Prep>
+  int uringIO(int fd, uint32_t poll_mask, uint64_t timeout_ms, Prep prep);
+
+  /// @brief epoll后端下的IO封装, EAGAIN时等待事件
+  template <class Fn>
+  ssize_t epollIO(int fd, Event event, uint64_t timeout_ms, Fn fn);
+
+  /// @brief 注册epoll事件, 事件触发时调度当前协程
+  bool addEvent(FdContext *fd_ctx, Event event);
+
+  /// @brief 触发事件, 调度等待的协程, 调用方持有fd_ctx->mutex
+  void triggerEvent(FdContext *fd_ctx, Event event);
+
+  /// @brief 取消epoll事件并调度等待的协程
+  /// @param flag 非空时在取消成功后置1
+  bool cancelEvent(FdContext *fd_ctx, Event event, int *flag = nullptr);
+
+  /// @brief 取消fd上所有epoll事件
+  void cancelAll(FdContext *fd_ctx);
+
+  /// @brief 等待epoll事件
+  /// @return 0成功, -1超时或失败(设置errno)
+  int waitEvent(FdContext *fd_ctx, Event event, uint64_t timeout_ms);
+
+  /// @brief 处理线程epoll fd上返回的事件
+  /// @param ctx 当前线程的IO上下文
+  /// @param events epoll_wait返回的事件
+  /// @param n 事件数
+  void dispatchEvents(IOContext *ctx, epoll_event *events, int n);
+
+  /// @brief 收割当前线程io_uring的完成事件并提交积累的请求
+  void reap(IOContext *ctx);
+
+  /// @brief 调度已到期的定时器
+  void processTimers();
+
+private:
+  /// IO后端
+  Backend m_backend = EPOLL;
+  /// 每个工作线程的IO上下文
+  std::vector<std::unique_ptr<IOContext>> m_contexts;
+  /// 未完成的IO请求数(io_uring请求与epoll等待事件)
+  std::atomic<size_t> m_pendingOps{0};
+  /// fd上下文锁
+  RWMutexType m_mutex;
+  /// fd上下文
+  std::vector<FdContext *> m_fdContexts;
+  /// 固定文件表大小, 0表示不使用固定文件
+  size_t m_fixedFiles = 0;
+  /// 固定缓冲区内存
+  void *m_bufferBase = nullptr;
+  /// 固定缓冲区
+  std::vector<FixedBuffer> m_buffers;
+  /// 固定缓冲区是否已注册到所有io_uring
+  bool m_buffersRegistered = false;
+  /// 空闲的固定缓冲区
+  Spinlock                   m_bufferMutex;
+  std::vector<FixedBuffer *> m_freeBuffers;
+};
+
+/// @brief 解析 ip:port 形式的IPv4地址, 供connect/bind使用
+/// @param allow_any_port 是否允许端口0(由内核分配, 只用于监听)
+/// @return ip或端口不合法返回false
+bool ParseAddress(std::string_view host,
+                  sockaddr_in     &addr,
+                  bool             allow_any_port = false);
+
+}  // namespace sylar
+
+#endif /* __IOMANAGER__H__ */
@@ -0,0 +1,1272 @@
+#include "sylar/log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <tuple>
+
+#include "sylar/fiber.h"
+#include "sylar/macro.h"
+
+namespace sylar {
+
+/// 单条日志内容的最大长度占缓冲大小的比例(1/4), 超出部分截断
+static constexpr size_t kMaxMessageShift = 2;
+/// 最小缓冲大小
+static constexpr size_t kMinRingSize = 64 * 1024;
+/// 待写数据块大小
+static constexpr size_t kBlockSize = 64 * 1024;
+/// 待写数据块数量上限, 超过时提前写出
+static constexpr size_t kMaxBlocks = 256;
+/// 刷盘后保留容量的数据块数量
+static constexpr size_t kKeepBlocks = 16;
+
+static uint64_t GetRealtimeNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/// 进程启动时间, 用于%r
+static const uint64_t s_start_time = GetRealtimeNs();
+
+/// @brief 解析 1024/64K/100M/1G 形式的大小
+static bool ParseSize(const std::string &str, uint64_t &val) {
+  char              *end = nullptr;
+  unsigned long long v   = strtoull(str.c_str(), &end, 10);
+  if (end == str.c_str()) {
+    return false;
+  }
+  switch (*end) {
+    case 'k':
+    case 'K':
+      v <<= 10;
+      ++end;
+      break;
+    case 'm':
+    case 'M':
+      v <<= 20;
+      ++end;
+      break;
+    case 'g':
+    case 'G':
+      v <<= 30;
+      ++end;
+      break;
+  }
+  if (*end == 'b' || *end == 'B') {
+    ++end;
+  }
+  if (*end) {
+    return false;
+  }
+  val = v;
+  return true;
+}
+
+/// @brief 逐级创建目录
+static bool MkDirs(const std::string &dirname) {
+  if (dirname.empty()) {
+    return true;
+  }
+  std::string path;
+  size_t      pos = 0;
+  while (pos != std::string::npos) {
+    pos  = dirname.find('/', pos + 1);
+    path = dirname.substr(0, pos);
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *LogLevel::ToString(LogLevel::Level level) {
+  switch (level) {
+#define XX(name)       \
+  case LogLevel::name: \
+    return #name;
+    XX(DEBUG);
+    XX(INFO);
+    XX(WARN);
+    XX(ERROR);
+    XX(FATAL);
+#undef XX
+    default:
+      return "UNKNOW";
+  }
+  return "UNKNOW";
+}
+
+LogLevel::Level LogLevel::FromString(const std::string &str) {
+#define XX(name)                                 \
+  if (strcasecmp(str.c_str(), #name) == 0) {     \
+    return LogLevel::name;                       \
+  }
+  XX(DEBUG);
+  XX(INFO);
+  XX(WARN);
+  XX(ERROR);
+  XX(FATAL);
+  return LogLevel::UNKNOW;
+#undef XX
+}
+
+class MessageFormatItem : public LogFormatter::FormatItem {
+public:
+  MessageFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.append(event.message);
+  }
+};
+
+class LevelFormatItem : public LogFormatter::FormatItem {
+public:
+  LevelFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.append(std::string_view(LogLevel::ToString(event.level)));
+  }
+};
+
+class ElapseFormatItem : public LogFormatter::FormatItem {
+public:
+  ElapseFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    uint64_t elapse =
+        event.time > s_start_time ? (event.time - s_start_time) / 1000000 : 0;
+    fmt::format_to(std::back_inserter(out), "{}", elapse);
+  }
+};
+
+class NameFormatItem : public LogFormatter::FormatItem {
+public:
+  NameFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.append(event.logger->getName());
+  }
+};
+
+class ThreadIdFormatItem : public LogFormatter::FormatItem {
+public:
+  ThreadIdFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    fmt::format_to(std::back_inserter(out), "{}", event.threadId);
+  }
+};
+
+class ThreadNameFormatItem : public LogFormatter::FormatItem {
+public:
+  ThreadNameFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.append(event.threadName);
+  }
+};
+
+class FiberIdFormatItem : public LogFormatter::FormatItem {
+public:
+  FiberIdFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    fmt::format_to(std::back_inserter(out), "{}", event.fiberId);
+  }
+};
+
+/// @brief 时间项, 同一秒内复用上次的格式化结果
+class DateTimeFormatItem : public LogFormatter::FormatItem {
+public:
+  DateTimeFormatItem(const std::string &format = "%Y-%m-%d %H:%M:%S")
+      : m_format(format) {
+    if (m_format.empty()) {
+      m_format = "%Y-%m-%d %H:%M:%S";
+    }
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    time_t sec = event.time / 1000000000ull;
+    if (sec != m_lastSec || m_cache.empty()) {
+      struct tm tm;
+      localtime_r(&sec, &tm);
+      char buf[64];
+      size_t n  = strftime(buf, sizeof(buf), m_format.c_str(), &tm);
+      m_cache   = std::string(buf, n);
+      m_lastSec = sec;
+    }
+    out.append(m_cache);
+  }
+
+private:
+  std::string m_format;
+  std::string m_cache;
+  time_t      m_lastSec = 0;
+};
+
+class FilenameFormatItem : public LogFormatter::FormatItem {
+public:
+  FilenameFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.append(std::string_view(event.file));
+  }
+};
+
+class LineFormatItem : public LogFormatter::FormatItem {
+public:
+  LineFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    fmt::format_to(std::back_inserter(out), "{}", event.line);
+  }
+};
+
+class NewLineFormatItem : public LogFormatter::FormatItem {
+public:
+  NewLineFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.push_back('\n');
+  }
+};
+
+class StringFormatItem : public LogFormatter::FormatItem {
+public:
+  StringFormatItem(const std::string &str) : m_string(str) {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.append(m_string);
+  }
+
+private:
+  std::string m_string;
+};
+
+class TabFormatItem : public LogFormatter::FormatItem {
+public:
+  TabFormatItem(const std::string &str = "") {
+  }
+
+  void format(fmt::memory_buffer &out, const LogEvent &event) override {
+    out.push_back('\t');
+  }
+};
+
+LogFormatter::LogFormatter(const std::string &pattern) : m_pattern(pattern) {
+  init();
+}
+
+void LogFormatter::format(fmt::memory_buffer &out, const LogEvent &event) {
+  for (auto &i : m_items) {
+    i->format(out, event);
+  }
+}
+
+// %xxx %xxx{xxx} %%
+void LogFormatter::init() {
+  // str, format, type(0: 普通字符串, 1: 格式项)
+  std::vector<std::tuple<std::string, std::string, int> > vec;
+  std::string                                            nstr;
+  for (size_t i = 0; i < m_pattern.size(); ++i) {
+    if (m_pattern[i] != '%') {
+      nstr.append(1, m_pattern[i]);
+      continue;
+    }
+    if (i + 1 >= m_pattern.size()) {
+      m_error = true;
+      nstr.append(1, '%');
+      break;
+    }
+    if (m_pattern[i + 1] == '%') {
+      nstr.append(1, '%');
+      ++i;
+      continue;
+    }
+
+    std::string str(1, m_pattern[i + 1]);
+    std::string fmt;
+    size_t      n = i + 2;
+    if (n < m_pattern.size() && m_pattern[n] == '{') {
+      size_t end = m_pattern.find('}', n);
+      if (end == std::string::npos) {
+        m_error = true;
+        vec.push_back(std::make_tuple("<<pattern_error>>", fmt, 0));
+        break;
+      }
+      fmt = m_pattern.substr(n + 1, end - n - 1);
+      n   = end + 1;
+    }
+    if (!nstr.empty()) {
+      vec.push_back(std::make_tuple(nstr, std::string(), 0));
+      nstr.clear();
+    }
+    vec.push_back(std::make_tuple(str, fmt, 1));
+    i = n - 1;
+  }
+  if (!nstr.empty()) {
+    vec.push_back(std::make_tuple(nstr, "", 0));
+  }
+
+  static std::map<std::string,
+                  std::function<FormatItem::ptr(const std::string &str)> >
+      s_format_items = {
+#define XX(str, C)                                                             \
+  {                                                                            \
+#str, [](const std::string &fmt) { return FormatItem::ptr(new C(fmt)); } \
+  }
+          XX(m, MessageFormatItem),
+          XX(p, LevelFormatItem),
+          XX(r, ElapseFormatItem),
+          XX(c, NameFormatItem),
+          XX(t, ThreadIdFormatItem),
+          XX(n, NewLineFormatItem),
+          XX(d, DateTimeFormatItem),
+          XX(f, FilenameFormatItem),
+          XX(l, LineFormatItem),
+          XX(T, TabFormatItem),
+          XX(F, FiberIdFormatItem),
+          XX(N, ThreadNameFormatItem),
+#undef XX
+      };
+
+  for (auto &i : vec) {
+    if (std::get<2>(i) == 0) {
+      m_items.push_back(FormatItem::ptr(new StringFormatItem(std::get<0>(i))));
+      continue;
+    }
+    auto it = s_format_items.find(std::get<0>(i));
+    if (it == s_format_items.end()) {
+      m_items.push_back(FormatItem::ptr(
+          new StringFormatItem("<<error_format %" + std::get<0>(i) + ">>")));
+      m_error = true;
+    } else {
+      m_items.push_back(it->second(std::get<1>(i)));
+    }
+  }
+}
+
+void LogAppender::setFormatter(LogFormatter::ptr val) {
+  MutexType::Lock lock(m_mutex);
+  m_formatter = val;
+}
+
+LogFormatter::ptr LogAppender::getFormatter() {
+  MutexType::Lock lock(m_mutex);
+  return m_formatter;
+}
+
+void LogAppender::append(const LogEvent         &event,
+                         const LogFormatter::ptr &fallback) {
+  if (event.level < m_level.load(std::memory_order_relaxed)) {
+    return;
+  }
+  LogFormatter::ptr formatter = getFormatter();
+  if (!formatter) {
+    formatter = fallback;
+  }
+  m_line.clear();
+  formatter->format(m_line, event);
+
+  size_t len = m_line.size();
+  if (m_used == 0 || (m_blocks[m_used - 1].size() + len > kBlockSize &&
+                      !m_blocks[m_used - 1].empty())) {
+    if (m_used == kMaxBlocks) {
+      flush();
+    }
+    if (m_used == m_blocks.size()) {
+      m_blocks.emplace_back();
+      m_blocks.back().reserve(std::max(kBlockSize, len));
+    }
+    ++m_used;
+  }
+  m_blocks[m_used - 1].append(m_line.data(), len);
+  m_bytes += len;
+}
+
+void LogAppender::flush() {
+  if (m_bytes == 0) {
+    return;
+  }
+  struct iovec iov[kMaxBlocks];
+  for (size_t i = 0; i < m_used; ++i) {
+    iov[i].iov_base = &m_blocks[i][0];
+    iov[i].iov_len  = m_blocks[i].size();
+  }
+  write(iov, int(m_used), m_bytes);
+  for (size_t i = 0; i < m_used; ++i) {
+    m_blocks[i].clear();
+  }
+  if (m_blocks.size() > kKeepBlocks) {
+    m_blocks.resize(kKeepBlocks);
+  }
+  m_used  = 0;
+  m_bytes = 0;
+}
+
+bool LogAppender::WriteAll(int fd, struct iovec *iov, int cnt) {
+  while (cnt > 0) {
+    ssize_t n = ::writev(fd, iov, std::min(cnt, IOV_MAX));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    while (cnt > 0 && size_t(n) >= iov->iov_len) {
+      n -= iov->iov_len;
+      ++iov;
+      --cnt;
+    }
+    if (cnt > 0) {
+      iov->iov_base = (char *)iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+StdoutLogAppender::~StdoutLogAppender() {
+  flush();
+}
+
+void StdoutLogAppender::write(struct iovec *iov, int cnt, size_t bytes) {
+  WriteAll(STDOUT_FILENO, iov, cnt);
+}
+
+FileLogAppender::FileLogAppender(const std::string &filename,
+                                 uint64_t           max_size,
+                                 Rotate             rotate)
+    : m_filename(filename), m_maxSize(max_size), m_rotate(rotate) {
+  reopen();
+  // 已有的非空文件属于其最后修改时间所在的周期, 跨周期时首次写入即滚动
+  struct stat st;
+  if (m_size > 0 && m_fd >= 0 && fstat(m_fd, &st) == 0) {
+    setPeriod(st.st_mtime);
+  } else {
+    setPeriod(time(0));
+  }
+}
+
+FileLogAppender::~FileLogAppender() {
+  flush();
+  if (m_fd >= 0) {
+    ::close(m_fd);
+  }
+}
+
+bool FileLogAppender::reopen() {
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  size_t pos = m_filename.rfind('/');
+  if (pos != std::string::npos && pos > 0) {
+    MkDirs(m_filename.substr(0, pos));
+  }
+  m_fd = ::open(m_filename.c_str(),
+                O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                0644);
+  if (m_fd < 0) {
+    std::cerr << "FileLogAppender open " << m_filename
+              << " error: " << strerror(errno) << std::endl;
+    m_size = 0;
+    return false;
+  }
+  struct stat st;
+  m_size = fstat(m_fd, &st) == 0 ? st.st_size : 0;
+  return true;
+}
+
+FileLogAppender::Rotate FileLogAppender::RotateFromString(
+    const std::string &str) {
+  if (strcasecmp(str.c_str(), "hourly") == 0) {
+    return HOURLY;
+  }
+  if (strcasecmp(str.c_str(), "daily") == 0) {
+    return DAILY;
+  }
+  return NONE;
+}
+
+void FileLogAppender::setPeriod(uint64_t now) {
+  if (m_rotate == NONE) {
+    m_period    = 0;
+    m_periodEnd = ~0ull;
+    return;
+  }
+  time_t    t = now;
+  struct tm tm;
+  localtime_r(&t, &tm);
+  tm.tm_min = tm.tm_sec = 0;
+  if (m_rotate == DAILY) {
+    tm.tm_hour = 0;
+  }
+  tm.tm_isdst = -1;
+  m_period    = mktime(&tm);
+  // mktime规范化越界的字段, 跨夏令时切换时周期长度不一定是整小时数
+  if (m_rotate == DAILY) {
+    ++tm.tm_mday;
+  } else {
+    ++tm.tm_hour;
+  }
+  tm.tm_isdst = -1;
+  m_periodEnd = mktime(&tm);
+}
+
+void FileLogAppender::rotate(uint64_t now) {
+  // 按时间滚动时文件覆盖的是m_period开始的周期, 以周期开始时间命名
+  time_t t = m_rotate == NONE ? now : m_period;
+  setPeriod(now);
+  if (m_fd >= 0 && m_size == 0) {
+    return;
+  }
+  struct tm tm;
+  localtime_r(&t, &tm);
+  char buf[32];
+  strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", &tm);
+
+  std::string base   = m_filename + "." + buf;
+  std::string target = base;
+  for (int i = 1; access(target.c_str(), F_OK) == 0; ++i) {
+    target = base + "." + std::to_string(i);
+  }
+  if (::rename(m_filename.c_str(), target.c_str()) != 0) {
+    std::cerr << "FileLogAppender rotate " << m_filename << " to " << target
+              << " error: " << strerror(errno) << std::endl;
+  }
+  reopen();
+}
+
+void FileLogAppender::write(struct iovec *iov, int cnt, size_t bytes) {
+  uint64_t now = time(0);
+  // 以一次刷盘为粒度滚动, 单个文件可能略大于max_size
+  if ((m_maxSize && m_size > 0 && m_size + bytes > m_maxSize) ||
+      now >= m_periodEnd || now < m_period) {
+    rotate(now);
+  }
+  if (m_fd < 0 && !reopen()) {
+    return;
+  }
+  if (WriteAll(m_fd, iov, cnt)) {
+    m_size += bytes;
+  }
+}
+
+Logger::Logger(const std::string &name)
+    : m_name(name), m_formatter(new LogFormatter) {
+}
+
+void Logger::log(LogLevel::Level  level,
+                 const char      *file,
+                 uint32_t         line,
+                 std::string_view msg) {
+  LoggerMgr::GetInstance()->commit(this, level, file, line, msg);
+}
+
+fmt::memory_buffer &Logger::GetScratch() {
+  static thread_local fmt::memory_buffer t_buf;
+  return t_buf;
+}
+
+void Logger::addAppender(LogAppender::ptr appender) {
+  MutexType::Lock lock(m_mutex);
+  m_appenders.push_back(appender);
+}
+
+void Logger::delAppender(LogAppender::ptr appender) {
+  MutexType::Lock lock(m_mutex);
+  auto it = std::find(m_appenders.begin(), m_appenders.end(), appender);
+  if (it != m_appenders.end()) {
+    m_appenders.erase(it);
+  }
+}
+
+void Logger::clearAppenders() {
+  std::vector<LogAppender::ptr> appenders;
+  MutexType::Lock               lock(m_mutex);
+  m_appenders.swap(appenders);
+  lock.unlock();
+}
+
+std::vector<LogAppender::ptr> Logger::getAppenders() {
+  MutexType::Lock lock(m_mutex);
+  return m_appenders;
+}
+
+void Logger::setFormatter(LogFormatter::ptr val) {
+  MutexType::Lock lock(m_mutex);
+  m_formatter = val;
+}
+
+void Logger::setFormatter(const std::string &val) {
+  LogFormatter::ptr formatter(new LogFormatter(val));
+  if (formatter->isError()) {
+    std::cerr << "Logger setFormatter name=" << m_name << " value=" << val
+              << " invalid formatter" << std::endl;
+    return;
+  }
+  setFormatter(formatter);
+}
+
+LogFormatter::ptr Logger::getFormatter() {
+  MutexType::Lock lock(m_mutex);
+  return m_formatter;
+}
+
+void Logger::write(const LogEvent &event) {
+  // 与flushAppenders一样复制后在锁外输出: 渲染与写满时的刷盘都不持有自旋锁
+  LogFormatter::ptr formatter;
+  Logger::ptr       root;
+  {
+    MutexType::Lock lock(m_mutex);
+    m_writeAppenders.assign(m_appenders.begin(), m_appenders.end());
+    formatter = m_formatter;
+    root      = m_root;
+  }
+  if (m_writeAppenders.empty()) {
+    if (root) {
+      root->write(event);
+    }
+    return;
+  }
+  for (auto &i : m_writeAppenders) {
+    i->append(event, formatter);
+  }
+  m_writeAppenders.clear();
+}
+
+void Logger::flushAppenders() {
+  // 复制后写出, 避免磁盘IO期间持有自旋锁
+  std::vector<LogAppender::ptr> appenders = getAppenders();
+  for (auto &i : appenders) {
+    i->flush();
+  }
+}
+
+LogEventWrap::LogEventWrap(Logger::ptr     logger,
+                           LogLevel::Level level,
+                           const char     *file,
+                           uint32_t        line)
+    : m_logger(logger), m_level(level), m_file(file), m_line(line) {
+}
+
+LogEventWrap::~LogEventWrap() {
+  m_logger->log(m_level, m_file, m_line, m_ss.str());
+}
+
+/// @brief 缓冲中的一条日志, 内容紧随其后, 按8字节对齐
+struct LogRecord {
+  /// 记录总长度(含头部与对齐)
+  uint32_t size;
+  /// 日志级别, 0表示缓冲末尾的填充
+  uint32_t level;
+  /// 行号
+  uint32_t line;
+  /// 内容长度
+  uint32_t msgLen;
+  /// 日志器
+  Logger *logger;
+  /// 文件名
+  const char *file;
+  /// 时间戳
+  uint64_t time;
+  /// 协程id
+  uint64_t fiberId;
+};
+
+static_assert(sizeof(LogRecord) % 8 == 0, "LogRecord must be 8-byte aligned");
+
+/// @brief 单生产者单消费者的日志环形缓冲
+/// @details 生产者为所属线程, 消费者为刷盘线程. head/tail单调递增,
+///          各自独占缓存行; 记录不跨越缓冲末尾, 放不下时写入填充记录
+class LogRing {
+public:
+  /// @brief 刷盘线程收集到的一条日志
+  struct Entry {
+    const LogRecord *record;
+    uint32_t         ring;
+  };
+
+  LogRing(size_t capacity) {
+    m_capacity = kMinRingSize;
+    while (m_capacity < capacity) {
+      m_capacity <<= 1;
+    }
+    m_data.reset(new uint64_t[m_capacity / sizeof(uint64_t)]);
+    m_threadId = uint32_t(syscall(SYS_gettid));
+    char name[16] = {0};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    m_threadName = name;
+  }
+
+  /// @brief 写入一条日志
+  /// @return 写入后已使用的字节数, 空间不足返回0
+  size_t push(Logger          *logger,
+              LogLevel::Level  level,
+              const char      *file,
+              uint32_t         line,
+              uint64_t         now,
+              std::string_view msg) {
+    size_t max_msg = (m_capacity >> kMaxMessageShift) - sizeof(LogRecord);
+    if (msg.size() > max_msg) {
+      msg = msg.substr(0, max_msg);
+    }
+    size_t   need   = (sizeof(LogRecord) + msg.size() + 7) & ~size_t(7);
+    uint64_t head   = m_head.load(std::memory_order_relaxed);
+    size_t   pos    = head & (m_capacity - 1);
+    size_t   contig = m_capacity - pos;
+    size_t   total  = need <= contig ? need : contig + need;
+    if (m_capacity - (head - m_cachedTail) < total) {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if (m_capacity - (head - m_cachedTail) < total) {
+        return 0;
+      }
+    }
+    if (need > contig) {
+      LogRecord *pad = (LogRecord *)(data() + pos);
+      pad->size      = uint32_t(contig);
+      pad->level     = 0;
+      head += contig;
+      pos = 0;
+    }
+    LogRecord *r = (LogRecord *)(data() + pos);
+    r->size      = uint32_t(need);
+    r->level     = level;
+    r->line      = line;
+    r->msgLen    = uint32_t(msg.size());
+    r->logger    = logger;
+    r->file      = file;
+    r->time      = now;
+    r->fiberId   = Fiber::GetFiberId();
+    memcpy(r + 1, msg.data(), msg.size());
+    head += need;
+    m_head.store(head, std::memory_order_release);
+    return head - m_cachedTail;
+  }
+
+  /// @brief 返回缓冲容量
+  size_t capacity() const {
+    return m_capacity;
+  }
+
+  /// @brief 收集所有已提交的日志
+  /// @return 收集结束位置, 日志输出后传给release
+  uint64_t collect(std::vector<Entry> &out, uint32_t ring) {
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    while (tail < head) {
+      const LogRecord *r =
+          (const LogRecord *)(data() + (tail & (m_capacity - 1)));
+      if (r->level) {
+        out.push_back({r, ring});
+      }
+      tail += r->size;
+    }
+    return tail;
+  }
+
+  /// @brief 释放已输出日志占用的空间
+  void release(uint64_t tail) {
+    m_tail.store(tail, std::memory_order_release);
+  }
+
+  /// @brief 是否没有未输出的日志
+  bool empty() const {
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 所属线程已退出
+  void close() {
+    m_closed.store(true, std::memory_order_release);
+  }
+
+  bool isClosed() const {
+    return m_closed.load(std::memory_order_acquire);
+  }
+
+  /// @brief 记录一条被丢弃的日志
+  void drop() {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// @brief 取出并清零丢弃计数
+  uint64_t takeDropped() {
+    if (!m_dropped.load(std::memory_order_relaxed)) {
+      return 0;
+    }
+    return m_dropped.exchange(0, std::memory_order_relaxed);
+  }
+
+  uint32_t getThreadId() const {
+    return m_threadId;
+  }
+
+  const std::string &getThreadName() const {
+    return m_threadName;
+  }
+
+private:
+  char *data() const {
+    return (char *)m_data.get();
+  }
+
+private:
+  /// 生产者写入位置
+  alignas(kCacheLineSize) std::atomic<uint64_t> m_head{0};
+  /// 生产者缓存的消费位置, 减少对m_tail所在缓存行的读取
+  uint64_t m_cachedTail = 0;
+  /// 消费者读取位置
+  alignas(kCacheLineSize) std::atomic<uint64_t> m_tail{0};
+  /// 丢弃计数
+  alignas(kCacheLineSize) std::atomic<uint64_t> m_dropped{0};
+  /// 线程是否已退出
+  std::atomic<bool> m_closed{false};
+  /// 缓冲容量(2的幂)
+  size_t m_capacity = 0;
+  /// 缓冲
+  std::unique_ptr<uint64_t[]> m_data;
+  /// 所属线程id
+  uint32_t m_threadId = 0;
+  /// 所属线程名称
+  std::string m_threadName;
+};
+
+namespace {
+
+/// @brief 线程退出时标记日志缓冲关闭, 由刷盘线程输出剩余日志后回收
+struct LogRingHolder {
+  std::shared_ptr<LogRing> ring;
+
+  ~LogRingHolder() {
+    if (ring) {
+      ring->close();
+    }
+  }
+};
+
+}  // namespace
+
+static thread_local LogRingHolder t_ring;
+
+LoggerManager::LoggerManager() {
+  m_root.reset(new Logger);
+  m_root->addAppender(LogAppender::ptr(new StdoutLogAppender));
+  m_loggers[m_root->m_name] = m_root;
+  m_thread                  = std::thread(&LoggerManager::run, this);
+}
+
+LoggerManager::~LoggerManager() {
+  m_stop.store(true, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  notify();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+Logger::ptr LoggerManager::getLogger(const std::string &name) {
+  MutexType::Lock lock(m_mutex);
+  auto            it = m_loggers.find(name);
+  if (it != m_loggers.end()) {
+    return it->second;
+  }
+  Logger::ptr logger(new Logger(name));
+  logger->m_root  = m_root;
+  m_loggers[name] = logger;
+  return logger;
+}
+
+LogRing *LoggerManager::getRing() {
+  if (SYLAR_UNLIKELY(!t_ring.ring)) {
+    std::shared_ptr<LogRing> ring =
+        std::make_shared<LogRing>(m_bufferSize.load(std::memory_order_relaxed));
+    MutexType::Lock lock(m_mutex);
+    m_rings.push_back(ring);
+    lock.unlock();
+    t_ring.ring = ring;
+  }
+  return t_ring.ring.get();
+}
+
+void LoggerManager::commit(Logger          *logger,
+                           LogLevel::Level  level,
+                           const char      *file,
+                           uint32_t         line,
+                           std::string_view msg) {
+  LogRing *ring = getRing();
+  uint64_t now  = GetRealtimeNs();
+  size_t   used = ring->push(logger, level, file, line, now, msg);
+  while (!used) {
+    // 刷盘线程自己的日志不能等待自己腾出空间
+    if (getFullPolicy() == DROP || m_stop.load(std::memory_order_relaxed) ||
+        std::this_thread::get_id() == m_thread.get_id()) {
+      ring->drop();
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      notify();
+      return;
+    }
+    // 先登记并记下刷盘轮次再重试, 之后释放的空间一定改变轮次, 不会错过唤醒.
+    // 限时等待, 停止时刷盘线程不再递增轮次
+    m_blockWaiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t drained = m_drained.load(std::memory_order_seq_cst);
+    used             = ring->push(logger, level, file, line, now, msg);
+    if (!used) {
+      notify();
+      uint64_t        ms = m_flushInterval.load(std::memory_order_relaxed);
+      struct timespec ts;
+      ts.tv_sec  = ms / 1000;
+      ts.tv_nsec = (ms % 1000) * 1000000;
+      FutexWait(&m_drained, drained, &ts);
+    }
+    m_blockWaiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+  // 超过半满或错误日志时尽快刷盘, 其余情况等待刷盘间隔
+  if (used > ring->capacity() / 2 || level >= LogLevel::ERROR) {
+    notify();
+  }
+}
+
+void LoggerManager::notify() {
+  if (m_sleeping.load(std::memory_order_relaxed) &&
+      m_sleeping.exchange(0, std::memory_order_acq_rel)) {
+    FutexWake(&m_sleeping, 1);
+  }
+}
+
+void LoggerManager::flush() {
+  if (m_stop.load(std::memory_order_acquire)) {
+    return;
+  }
+  uint32_t req = m_flushRequest.fetch_add(1, std::memory_order_seq_cst) + 1;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  notify();
+  while (true) {
+    uint32_t done = m_flushDone.load(std::memory_order_acquire);
+    if (int32_t(done - req) >= 0) {
+      break;
+    }
+    FutexWait(&m_flushDone, done);
+  }
+}
+
+void LoggerManager::run() {
+  pthread_setname_np(pthread_self(), "log_flusher");
+  while (true) {
+    bool     stop  = m_stop.load(std::memory_order_acquire);
+    uint32_t req   = m_flushRequest.load(std::memory_order_acquire);
+    bool     empty = true;
+    drain(empty);
+    if (m_flushDone.load(std::memory_order_relaxed) != req) {
+      m_flushDone.store(req, std::memory_order_release);
+      FutexWake(&m_flushDone, INT_MAX);
+    }
+    if (stop) {
+      break;
+    }
+    if (!empty) {
+      // 繁忙时立即开始下一轮
+      continue;
+    }
+
+    // 与flush/析构配对: 先声明睡眠再检查请求, 避免唤醒丢失
+    m_sleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_flushRequest.load(std::memory_order_relaxed) != req ||
+        m_stop.load(std::memory_order_relaxed)) {
+      m_sleeping.store(0, std::memory_order_relaxed);
+      continue;
+    }
+    uint64_t        ms = m_flushInterval.load(std::memory_order_relaxed);
+    struct timespec ts;
+    ts.tv_sec  = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000;
+    FutexWait(&m_sleeping, 1, &ts);
+    m_sleeping.store(0, std::memory_order_relaxed);
+  }
+}
+
+void LoggerManager::drain(bool &empty) {
+  std::vector<std::shared_ptr<LogRing> > rings;
+  {
+    MutexType::Lock lock(m_mutex);
+    rings = m_rings;
+  }
+
+  std::vector<LogRing::Entry> entries;
+  std::vector<uint64_t>       ends(rings.size());
+  std::vector<bool>           closed(rings.size());
+  size_t                      sources = 0;
+  for (size_t i = 0; i < rings.size(); ++i) {
+    closed[i]   = rings[i]->isClosed();
+    size_t size = entries.size();
+    ends[i]     = rings[i]->collect(entries, uint32_t(i));
+    if (entries.size() > size) {
+      ++sources;
+    }
+  }
+  empty = entries.empty();
+
+  // 多个线程的日志按时间归并, 同一线程内保持写入顺序
+  if (sources > 1) {
+    std::stable_sort(entries.begin(),
+                     entries.end(),
+                     [](const LogRing::Entry &a, const LogRing::Entry &b) {
+                       return a.record->time < b.record->time;
+                     });
+  }
+  for (auto &i : entries) {
+    const LogRecord *r    = i.record;
+    LogRing         *ring = rings[i.ring].get();
+    LogEvent         event;
+    event.logger     = r->logger;
+    event.level      = LogLevel::Level(r->level);
+    event.time       = r->time;
+    event.threadId   = ring->getThreadId();
+    event.threadName = ring->getThreadName();
+    event.fiberId    = r->fiberId;
+    event.file       = r->file;
+    event.line       = r->line;
+    event.message    = std::string_view((const char *)(r + 1), r->msgLen);
+    r->logger->write(event);
+  }
+  for (size_t i = 0; i < rings.size(); ++i) {
+    rings[i]->release(ends[i]);
+  }
+  // 唤醒BLOCK策略下等待空间的线程, 不等写盘完成
+  m_drained.fetch_add(1, std::memory_order_seq_cst);
+  if (m_blockWaiters.load(std::memory_order_seq_cst) > 0) {
+    FutexWake(&m_drained, INT_MAX);
+  }
+
+  for (auto &ring : rings) {
+    uint64_t dropped = ring->takeDropped();
+    if (!dropped) {
+      continue;
+    }
+    std::string msg = fmt::format(
+        "log buffer full, dropped {} log messages", dropped);
+    LogEvent event;
+    event.logger     = m_root.get();
+    event.level      = LogLevel::WARN;
+    event.time       = GetRealtimeNs();
+    event.threadId   = ring->getThreadId();
+    event.threadName = ring->getThreadName();
+    event.file       = __FILE__;
+    event.line       = __LINE__;
+    event.message    = msg;
+    m_root->write(event);
+    empty = false;
+  }
+
+  std::vector<Logger::ptr> loggers;
+  {
+    MutexType::Lock lock(m_mutex);
+    loggers.reserve(m_loggers.size());
+    for (auto &i : m_loggers) {
+      loggers.push_back(i.second);
+    }
+  }
+  for (auto &i : loggers) {
+    i->flushAppenders();
+  }
+
+  // 回收已退出线程的缓冲
+  bool reclaim = false;
+  for (size_t i = 0; i < rings.size(); ++i) {
+    if (closed[i] && rings[i]->empty()) {
+      reclaim = true;
+      break;
+    }
+  }
+  if (reclaim) {
+    MutexType::Lock lock(m_mutex);
+    m_rings.erase(std::remove_if(m_rings.begin(),
+                                 m_rings.end(),
+                                 [](const std::shared_ptr<LogRing> &ring) {
+                                   return ring->isClosed() && ring->empty();
+                                 }),
+                  m_rings.end());
+  }
+}
+
+bool LoggerManager::init(const YAML::Node &logs) {
+  if (!logs.IsSequence()) {
+    std::cerr << "LoggerManager::init logs is not a sequence" << std::endl;
+    return false;
+  }
+  try {
+    for (auto it = logs.begin(); it != logs.end(); ++it) {
+      const YAML::Node &n = *it;
+      if (!n["name"].IsDefined()) {
+        std::cerr << "LoggerManager::init log name is null" << std::endl;
+        return false;
+      }
+      std::string     name  = n["name"].as<std::string>();
+      LogLevel::Level level = LogLevel::DEBUG;
+      if (n["level"].IsDefined()) {
+        level = LogLevel::FromString(n["level"].as<std::string>());
+        if (level == LogLevel::UNKNOW) {
+          std::cerr << "LoggerManager::init log " << name << " invalid level "
+                    << n["level"].as<std::string>() << std::endl;
+          return false;
+        }
+      }
+
+      std::vector<LogAppender::ptr> appenders;
+      if (n["appenders"].IsDefined()) {
+        for (auto a : n["appenders"]) {
+          if (!a["type"].IsDefined()) {
+            std::cerr << "LoggerManager::init log " << name
+                      << " appender type is null" << std::endl;
+            return false;
+          }
+          std::string      type = a["type"].as<std::string>();
+          LogAppender::ptr appender;
+          if (type == "FileLogAppender") {
+            if (!a["file"].IsDefined()) {
+              std::cerr << "LoggerManager::init log " << name
+                        << " FileLogAppender file is null" << std::endl;
+              return false;
+            }
+            uint64_t max_size = 0;
+            if (a["max_size"].IsDefined() &&
+                !ParseSize(a["max_size"].as<std::string>(), max_size)) {
+              std::cerr << "LoggerManager::init log " << name
+                        << " invalid max_size "
+                        << a["max_size"].as<std::string>() << std::endl;
+              return false;
+            }
+            FileLogAppender::Rotate rotate = FileLogAppender::NONE;
+            if (a["rotate"].IsDefined()) {
+              rotate = FileLogAppender::RotateFromString(
+                  a["rotate"].as<std::string>());
+            }
+            appender.reset(new FileLogAppender(a["file"].as<std::string>(),
+                                               max_size,
+                                               rotate));
+          } else if (type == "StdoutLogAppender") {
+            appender.reset(new StdoutLogAppender);
+          } else {
+            std::cerr << "LoggerManager::init log " << name
+                      << " invalid appender type " << type << std::endl;
+            return false;
+          }
+          if (a["level"].IsDefined()) {
+            appender->setLevel(
+                LogLevel::FromString(a["level"].as<std::string>()));
+          }
+          if (a["formatter"].IsDefined()) {
+            LogFormatter::ptr formatter(
+                new LogFormatter(a["formatter"].as<std::string>()));
+            if (formatter->isError()) {
+              std::cerr << "LoggerManager::init log " << name
+                        << " invalid formatter "
+                        << a["formatter"].as<std::string>() << std::endl;
+            } else {
+              appender->setFormatter(formatter);
+            }
+          }
+          appenders.push_back(appender);
+        }
+      }
+
+      Logger::ptr logger = getLogger(name);
+      logger->setLevel(level);
+      if (n["formatter"].IsDefined()) {
+        logger->setFormatter(n["formatter"].as<std::string>());
+      }
+      Logger::MutexType::Lock lock(logger->m_mutex);
+      logger->m_appenders.swap(appenders);
+    }
+  } catch (std::exception &ex) {
+    std::cerr << "LoggerManager::init error: " << ex.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LoggerManager::initAsync(const YAML::Node &async) {
+  if (!async.IsDefined() || async.IsNull()) {
+    return true;
+  }
+  if (!async.IsMap()) {
+    std::cerr << "LoggerManager::initAsync log_async is not a map"
+              << std::endl;
+    return false;
+  }
+  try {
+    if (async["buffer_size"].IsDefined()) {
+      uint64_t size = 0;
+      if (!ParseSize(async["buffer_size"].as<std::string>(), size)) {
+        std::cerr << "LoggerManager::initAsync invalid buffer_size "
+                  << async["buffer_size"].as<std::string>() << std::endl;
+        return false;
+      }
+      setBufferSize(size);
+    }
+    if (async["full_policy"].IsDefined()) {
+      std::string policy = async["full_policy"].as<std::string>();
+      if (strcasecmp(policy.c_str(), "drop") == 0) {
+        setFullPolicy(DROP);
+      } else if (strcasecmp(policy.c_str(), "block") == 0) {
+        setFullPolicy(BLOCK);
+      } else {
+        std::cerr << "LoggerManager::initAsync invalid full_policy " << policy
+                  << std::endl;
+        return false;
+      }
+    }
+    if (async["flush_interval"].IsDefined()) {
+      setFlushInterval(
+          std::max<uint64_t>(1, async["flush_interval"].as<uint64_t>()));
+    }
+  } catch (std::exception &ex) {
+    std::cerr << "LoggerManager::initAsync error: " << ex.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LoggerManager::loadFile(const std::string &file) {
+  try {
+    YAML::Node root = YAML::LoadFile(file);
+    if (!initAsync(root["log_async"])) {
+      return false;
+    }
+    return init(root["logs"]);
+  } catch (std::exception &ex) {
+    std::cerr << "LoggerManager::loadFile " << file << " error: " << ex.what()
+              << std::endl;
+  }
+  return false;
+}
+
+}  // namespace sylar
@@ -0,0 +1,582 @@
+/**
+ * @file log.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 异步日志模块封装
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __LOG__H__
+#define __LOG__H__
+
+#include <fmt/format.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "sylar/mutex.h"
+#include "sylar/singleton.h"
+
+namespace YAML {
+class Node;
+}
+
+/// @brief 编译期最低日志级别, 低于该级别的日志语句连同参数求值被完全消除
+#ifndef SYLAR_LOG_ACTIVE_LEVEL
+#define SYLAR_LOG_ACTIVE_LEVEL 1
+#endif
+
+/// @brief 日志级别是否开启, 关闭时只有一次原子读和一次比较, 参数不会被求值
+#define SYLAR_LOG_ENABLED(logger, level) \
+  ((level) >= SYLAR_LOG_ACTIVE_LEVEL && (logger)->isEnabled(level))
+
+/// @brief 使用流式方式将日志级别level的日志写入到logger
+#define SYLAR_LOG_LEVEL(logger, level)                                  \
+  if (!SYLAR_LOG_ENABLED(logger, level)) {                              \
+  } else                                                                \
+    sylar::LogEventWrap(logger, level, __FILE__, __LINE__).getSS()
+
+#define SYLAR_LOG_DEBUG(logger) SYLAR_LOG_LEVEL(logger, sylar::LogLevel::DEBUG)
+#define SYLAR_LOG_INFO(logger)  SYLAR_LOG_LEVEL(logger, sylar::LogLevel::INFO)
+#define SYLAR_LOG_WARN(logger)  SYLAR_LOG_LEVEL(logger, sylar::LogLevel::WARN)
+#define SYLAR_LOG_ERROR(logger) SYLAR_LOG_LEVEL(logger, sylar::LogLevel::ERROR)
+#define SYLAR_LOG_FATAL(logger) SYLAR_LOG_LEVEL(logger, sylar::LogLevel::FATAL)
+
+/// @brief 使用fmtlib格式将日志级别level的日志写入到logger
+/// @details 格式串在编译期检查, 例如 SYLAR_LOG_FMT_INFO(g_logger, "fd={} rt={}", fd, rt)
+#define SYLAR_LOG_FMT_LEVEL(logger, level, fmt, ...)                   \
+  do {                                                                 \
+    if (SYLAR_LOG_ENABLED(logger, level)) {                            \
+      (logger)->log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__);    \
+    }                                                                  \
+  } while (0)
+
+#define SYLAR_LOG_FMT_DEBUG(logger, fmt, ...) \
+  SYLAR_LOG_FMT_LEVEL(logger, sylar::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define SYLAR_LOG_FMT_INFO(logger, fmt, ...) \
+  SYLAR_LOG_FMT_LEVEL(logger, sylar::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define SYLAR_LOG_FMT_WARN(logger, fmt, ...) \
+  SYLAR_LOG_FMT_LEVEL(logger, sylar::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define SYLAR_LOG_FMT_ERROR(logger, fmt, ...) \
+  SYLAR_LOG_FMT_LEVEL(logger, sylar::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+#define SYLAR_LOG_FMT_FATAL(logger, fmt, ...) \
+  SYLAR_LOG_FMT_LEVEL(logger, sylar::LogLevel::FATAL, fmt, ##__VA_ARGS__)
+
+/// @brief 获取主日志器
+#define SYLAR_LOG_ROOT() sylar::LoggerMgr::GetInstance()->getRoot()
+
+/// @brief 获取name的日志器
+#define SYLAR_LOG_NAME(name) sylar::LoggerMgr::GetInstance()->getLogger(name)
+
+namespace sylar {
+
+class Logger;
+class LogRing;
+
+/// @brief 日志级别
+class LogLevel {
+public:
+  enum Level {
+    UNKNOW = 0,
+    DEBUG  = 1,
+    INFO   = 2,
+    WARN   = 3,
+    ERROR  = 4,
+    FATAL  = 5,
+  };
+
+  /// @brief 将日志级别转成文本输出
+  static const char *ToString(LogLevel::Level level);
+
+  /// @brief 将文本转换成日志级别, 不区分大小写
+  static LogLevel::Level FromString(const std::string &str);
+};
+
+/// @brief 日志事件, 刷盘线程渲染时使用的只读视图
+struct LogEvent {
+  /// 日志器
+  Logger *logger = nullptr;
+  /// 日志级别
+  LogLevel::Level level = LogLevel::UNKNOW;
+  /// 时间戳(纳秒, CLOCK_REALTIME)
+  uint64_t time = 0;
+  /// 线程id
+  uint32_t threadId = 0;
+  /// 线程名称
+  std::string_view threadName;
+  /// 协程id
+  uint64_t fiberId = 0;
+  /// 文件名
+  const char *file = "";
+  /// 行号
+  uint32_t line = 0;
+  /// 日志内容
+  std::string_view message;
+};
+
+/// @brief 日志格式化
+/// @details 只在刷盘线程中调用, 非线程安全
+class LogFormatter {
+public:
+  typedef std::shared_ptr<LogFormatter> ptr;
+
+  /// @brief 构造函数
+  /// @param pattern 格式模板
+  /// @details
+  ///  %m 消息
+  ///  %p 日志级别
+  ///  %r 累计毫秒数
+  ///  %c 日志名称
+  ///  %t 线程id
+  ///  %n 换行
+  ///  %d 时间
+  ///  %f 文件名
+  ///  %l 行号
+  ///  %T 制表符
+  ///  %F 协程id
+  ///  %N 线程名称
+  ///
+  ///  默认格式 "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n"
+  LogFormatter(const std::string &pattern =
+                   "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n");
+
+  /// @brief 将日志事件渲染追加到out
+  void format(fmt::memory_buffer &out, const LogEvent &event);
+
+  /// @brief 是否有错误
+  bool isError() const {
+    return m_error;
+  }
+
+  /// @brief 返回日志模板
+  const std::string &getPattern() const {
+    return m_pattern;
+  }
+
+public:
+  /// @brief 日志内容项格式化
+  class FormatItem {
+  public:
+    typedef std::shared_ptr<FormatItem> ptr;
+
+    virtual ~FormatItem() {
+    }
+
+    virtual void format(fmt::memory_buffer &out, const LogEvent &event) = 0;
+  };
+
+private:
+  /// @brief 解析日志模板
+  void init();
+
+private:
+  /// 日志格式模板
+  std::string m_pattern;
+  /// 日志格式解析后格式
+  std::vector<FormatItem::ptr> m_items;
+  /// 是否有错误
+  bool m_error = false;
+};
+
+/// @brief 日志输出目标
+/// @details 刷盘线程将日志渲染到待写缓冲, 每轮结束后以一次writev写出
+class LogAppender {
+  friend class Logger;
+
+public:
+  typedef std::shared_ptr<LogAppender> ptr;
+  typedef Spinlock                     MutexType;
+
+  virtual ~LogAppender() {
+  }
+
+  /// @brief 渲染日志到待写缓冲
+  /// @param event 日志事件
+  /// @param fallback 未设置格式器时使用的日志器格式器
+  void append(const LogEvent &event, const LogFormatter::ptr &fallback);
+
+  /// @brief 写出待写缓冲
+  void flush();
+
+  /// @brief 更改日志格式器
+  void setFormatter(LogFormatter::ptr val);
+
+  /// @brief 获取日志格式器
+  LogFormatter::ptr getFormatter();
+
+  /// @brief 获取日志级别
+  LogLevel::Level getLevel() const {
+    return m_level;
+  }
+
+  /// @brief 设置日志级别
+  void setLevel(LogLevel::Level val) {
+    m_level = val;
+  }
+
+protected:
+  /// @brief 写出数据
+  /// @param iov 数据块
+  /// @param cnt 数据块数量
+  /// @param bytes 总字节数
+  virtual void write(struct iovec *iov, int cnt, size_t bytes) = 0;
+
+  /// @brief 将iov全部写入fd, 处理部分写入与EINTR
+  static bool WriteAll(int fd, struct iovec *iov, int cnt);
+
+private:
+  /// 日志级别
+  std::atomic<LogLevel::Level> m_level{LogLevel::DEBUG};
+  /// Mutex, 保护m_formatter
+  MutexType m_mutex;
+  /// 日志格式器
+  LogFormatter::ptr m_formatter;
+  /// 渲染缓冲
+  fmt::memory_buffer m_line;
+  /// 待写数据块, 前m_used块有效, 其余保留容量复用
+  std::vector<std::string> m_blocks;
+  size_t                   m_used  = 0;
+  size_t                   m_bytes = 0;
+};
+
+/// @brief 输出到控制台的Appender
+class StdoutLogAppender : public LogAppender {
+public:
+  typedef std::shared_ptr<StdoutLogAppender> ptr;
+
+  ~StdoutLogAppender();
+
+protected:
+  void write(struct iovec *iov, int cnt, size_t bytes) override;
+};
+
+/// @brief 输出到文件的Appender, 支持按大小与按时间滚动
+class FileLogAppender : public LogAppender {
+public:
+  typedef std::shared_ptr<FileLogAppender> ptr;
+
+  /// @brief 按时间滚动的周期
+  enum Rotate {
+    NONE   = 0,
+    HOURLY = 1,
+    DAILY  = 2,
+  };
+
+  /// @brief 构造函数
+  /// @param filename 文件路径, 目录不存在时自动创建
+  /// @param max_size 单个文件最大字节数, 超过后滚动, 0表示不限制
+  /// @param rotate 按时间滚动的周期
+  FileLogAppender(const std::string &filename,
+                  uint64_t           max_size = 0,
+                  Rotate             rotate   = NONE);
+
+  ~FileLogAppender();
+
+  /// @brief 重新打开日志文件
+  bool reopen();
+
+  /// @brief 文本转换成滚动周期
+  static Rotate RotateFromString(const std::string &str);
+
+protected:
+  void write(struct iovec *iov, int cnt, size_t bytes) override;
+
+private:
+  /// @brief 将当前文件重命名为 文件名.时间[.序号] 并打开新文件
+  /// @details 按时间滚动时文件名中的时间为当前文件所在周期的开始时间,
+  ///          否则为滚动时的时间
+  void rotate(uint64_t now);
+
+  /// @brief 把m_period/m_periodEnd设置为时间所在的滚动周期
+  void setPeriod(uint64_t now);
+
+private:
+  /// 文件路径
+  std::string m_filename;
+  /// 文件fd
+  int m_fd = -1;
+  /// 当前文件大小
+  uint64_t m_size = 0;
+  /// 单个文件最大字节数
+  uint64_t m_maxSize = 0;
+  /// 滚动周期
+  Rotate m_rotate = NONE;
+  /// 当前文件所在滚动周期的开始与结束时间(秒)
+  uint64_t m_period    = 0;
+  uint64_t m_periodEnd = 0;
+};
+
+/// @brief 日志器
+/// @details 业务线程格式化日志内容后写入本线程的无锁环形缓冲, 时间格式化与
+///          输出由后台刷盘线程完成. 写入缓冲中的日志引用日志器指针,
+///          因此日志器需存活到日志刷出(LoggerManager创建的日志器不会释放)
+class Logger : public std::enable_shared_from_this<Logger> {
+  friend class LoggerManager;
+
+public:
+  typedef std::shared_ptr<Logger> ptr;
+  typedef Spinlock                MutexType;
+
+  /// @brief 构造函数
+  /// @param name 日志器名称
+  Logger(const std::string &name = "root");
+
+  /// @brief 日志级别是否开启
+  bool isEnabled(LogLevel::Level level) const {
+    return level >= m_level.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 格式化并写日志
+  template <class... Args>
+  void log(LogLevel::Level             level,
+           const char                 *file,
+           uint32_t                    line,
+           fmt::format_string<Args...> fmt,
+           Args &&...args) {
+    fmt::memory_buffer &buf = GetScratch();
+    buf.clear();
+    fmt::format_to(std::back_inserter(buf), fmt, std::forward<Args>(args)...);
+    log(level, file, line, std::string_view(buf.data(), buf.size()));
+  }
+
+  /// @brief 写日志
+  void log(LogLevel::Level  level,
+           const char      *file,
+           uint32_t         line,
+           std::string_view msg);
+
+  /// @brief 添加日志目标
+  void addAppender(LogAppender::ptr appender);
+
+  /// @brief 删除日志目标
+  void delAppender(LogAppender::ptr appender);
+
+  /// @brief 清空日志目标
+  void clearAppenders();
+
+  /// @brief 返回日志目标
+  std::vector<LogAppender::ptr> getAppenders();
+
+  /// @brief 返回日志级别
+  LogLevel::Level getLevel() const {
+    return m_level.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 设置日志级别
+  void setLevel(LogLevel::Level val) {
+    m_level.store(val, std::memory_order_relaxed);
+  }
+
+  /// @brief 返回日志名称
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  /// @brief 设置日志格式器
+  void setFormatter(LogFormatter::ptr val);
+
+  /// @brief 设置日志格式模板, 模板错误时保持原格式
+  void setFormatter(const std::string &val);
+
+  /// @brief 获取日志格式器
+  LogFormatter::ptr getFormatter();
+
+private:
+  /// @brief 刷盘线程调用: 输出到所有日志目标, 没有日志目标时输出到root
+  void write(const LogEvent &event);
+
+  /// @brief 刷盘线程调用: 写出所有日志目标的待写缓冲
+  void flushAppenders();
+
+  /// @brief 本线程的格式化缓冲
+  static fmt::memory_buffer &GetScratch();
+
+private:
+  /// 日志名称
+  std::string m_name;
+  /// 日志级别
+  std::atomic<LogLevel::Level> m_level{LogLevel::DEBUG};
+  /// Mutex
+  MutexType m_mutex;
+  /// 日志目标集合
+  std::vector<LogAppender::ptr> m_appenders;
+  /// write时日志目标的副本, 只在刷盘线程中使用, 保留容量复用
+  std::vector<LogAppender::ptr> m_writeAppenders;
+  /// 日志格式器
+  LogFormatter::ptr m_formatter;
+  /// 主日志器
+  Logger::ptr m_root;
+};
+
+/// @brief 流式日志包装器, 析构时写日志
+class LogEventWrap {
+public:
+  LogEventWrap(Logger::ptr     logger,
+               LogLevel::Level level,
+               const char     *file,
+               uint32_t        line);
+
+  ~LogEventWrap();
+
+  /// @brief 获取日志内容流
+  std::stringstream &getSS() {
+    return m_ss;
+  }
+
+private:
+  Logger::ptr       m_logger;
+  LogLevel::Level   m_level;
+  const char       *m_file;
+  uint32_t          m_line;
+  std::stringstream m_ss;
+};
+
+/// @brief 日志器管理类, 持有每个线程的日志缓冲与后台刷盘线程
+/// @details 对应配置 logs 与 log_async 节点, 例如:
+///          log_async:
+///              buffer_size: 4194304
+///              full_policy: drop
+///              flush_interval: 100
+///          logs:
+///              - name: root
+///                level: info
+///                formatter: "%d%T%m%n"
+///                appenders:
+///                    - type: FileLogAppender
+///                      file: /apps/logs/sylar/root.txt
+///                      max_size: 104857600
+///                      rotate: daily
+///                    - type: StdoutLogAppender
+class LoggerManager {
+public:
+  typedef Mutex MutexType;
+
+  /// @brief 缓冲写满时的策略
+  enum FullPolicy {
+    /// 丢弃并计数, 业务线程不阻塞
+    DROP  = 0,
+    /// 挂起等待刷盘线程腾出空间
+    BLOCK = 1,
+  };
+
+  /// @brief 构造函数, 创建root日志器(输出到控制台)并启动刷盘线程
+  LoggerManager();
+
+  /// @brief 析构函数, 刷出全部日志后停止刷盘线程
+  ~LoggerManager();
+
+  /// @brief 获取日志器, 不存在时创建
+  Logger::ptr getLogger(const std::string &name);
+
+  /// @brief 返回主日志器
+  Logger::ptr getRoot() const {
+    return m_root;
+  }
+
+  /// @brief 按logs配置节点设置日志器, 已存在的日志器会被重置
+  bool init(const YAML::Node &logs);
+
+  /// @brief 按log_async配置节点设置缓冲参数
+  bool initAsync(const YAML::Node &async);
+
+  /// @brief 从yaml文件的logs与log_async节点初始化
+  bool loadFile(const std::string &file);
+
+  /// @brief 设置写满策略
+  void setFullPolicy(FullPolicy val) {
+    m_policy.store(val, std::memory_order_relaxed);
+  }
+
+  /// @brief 返回写满策略
+  FullPolicy getFullPolicy() const {
+    return m_policy.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 设置每个线程的缓冲大小, 对之后创建缓冲的线程生效
+  void setBufferSize(size_t val) {
+    m_bufferSize.store(val, std::memory_order_relaxed);
+  }
+
+  /// @brief 设置刷盘间隔(毫秒)
+  void setFlushInterval(uint64_t val) {
+    m_flushInterval.store(val, std::memory_order_relaxed);
+  }
+
+  /// @brief 等待调用前写入的日志全部写出
+  void flush();
+
+  /// @brief 返回累计丢弃的日志条数
+  uint64_t getDropped() const {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 写入一条日志到本线程缓冲
+  void commit(Logger          *logger,
+              LogLevel::Level  level,
+              const char      *file,
+              uint32_t         line,
+              std::string_view msg);
+
+private:
+  /// @brief 返回本线程的日志缓冲
+  LogRing *getRing();
+
+  /// @brief 唤醒刷盘线程
+  void notify();
+
+  /// @brief 刷盘线程主函数
+  void run();
+
+  /// @brief 收集所有线程缓冲中的日志, 按时间排序后输出
+  /// @param[out] empty 本轮是否没有日志
+  void drain(bool &empty);
+
+private:
+  /// 主日志器
+  Logger::ptr m_root;
+  /// Mutex, 保护m_loggers与m_rings
+  mutable MutexType m_mutex;
+  /// 日志器容器
+  std::map<std::string, Logger::ptr> m_loggers;
+  /// 各线程的日志缓冲
+  std::vector<std::shared_ptr<LogRing>> m_rings;
+  /// 写满策略
+  std::atomic<FullPolicy> m_policy{DROP};
+  /// 线程缓冲大小
+  std::atomic<size_t> m_bufferSize{4 * 1024 * 1024};
+  /// 刷盘间隔
+  std::atomic<uint64_t> m_flushInterval{100};
+  /// 累计丢弃条数
+  std::atomic<uint64_t> m_dropped{0};
+  /// 刷盘线程是否睡眠, 唤醒方通过CAS 1->0 获得唤醒权
+  std::atomic<uint32_t> m_sleeping{0};
+  /// flush请求序号与已完成序号
+  std::atomic<uint32_t> m_flushRequest{0};
+  std::atomic<uint32_t> m_flushDone{0};
+  /// 刷盘轮次, 每轮释放缓冲空间后递增, BLOCK策略的写入方在此等待
+  std::atomic<uint32_t> m_drained{0};
+  /// BLOCK策略下等待空间的线程数
+  std::atomic<uint32_t> m_blockWaiters{0};
+  /// 是否停止
+  std::atomic<bool> m_stop{false};
+  /// 刷盘线程
+  std::thread m_thread;
+};
+
+/// 日志器管理类单例模式
+typedef sylar::Singleton<LoggerManager> LoggerMgr;
+
+}  // namespace sylar
+
+#endif /* __LOG__H__ */
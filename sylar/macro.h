@@ -0,0 +1,48 @@
+/**
+ * @file macro.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 常用宏的封装
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __MACRO__H__
+#define __MACRO__H__
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined __GNUC__ || defined __llvm__
+/// LIKCLY 宏的封装, 告诉编译器优化,条件大概率成立
+#define SYLAR_LIKELY(x) __builtin_expect(!!(x), 1)
+/// LIKCLY 宏的封装, 告诉编译器优化,条件大概率不成立
+#define SYLAR_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define SYLAR_LIKELY(x)   (x)
+#define SYLAR_UNLIKELY(x) (x)
+#endif
+
+/// 断言宏封装
+#define SYLAR_ASSERT(x)                                                        \
+  if (SYLAR_UNLIKELY(!(x))) {                                                  \
+    fprintf(stderr, "ASSERTION: %s at %s:%d\n", #x, __FILE__, __LINE__);       \
+    abort();                                                                   \
+  }
+
+/// 断言宏封装, 附带错误信息
+#define SYLAR_ASSERT2(x, w)                                                    \
+  if (SYLAR_UNLIKELY(!(x))) {                                                  \
+    fprintf(stderr,                                                            \
+            "ASSERTION: %s %s at %s:%d\n",                                     \
+            #x,                                                                \
+            w,                                                                 \
+            __FILE__,                                                          \
+            __LINE__);                                                         \
+    abort();                                                                   \
+  }
+
+#endif /* __MACRO__H__ */
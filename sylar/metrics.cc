@@ -0,0 +1,308 @@
+#include "sylar/metrics.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "sylar/mutex.h"
+
+namespace sylar {
+
+/// @brief 按块延迟分配, 只有所属线程写入
+struct MetricsRegistry::Shard {
+  Shard() {
+    for (auto &i : chunks) {
+      i.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~Shard() {
+    for (auto &i : chunks) {
+      delete[] i.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<std::atomic<uint64_t> *> chunks[kMaxChunks];
+};
+
+/// @brief 线程退出时归还分片
+struct ShardHolder {
+  ~ShardHolder() {
+    if (shard) {
+      MetricsRegistry::GetInstance()->retireShard(shard);
+    }
+    exited = true;
+  }
+
+  MetricsRegistry::Shard *shard  = nullptr;
+  bool                    exited = false;
+};
+
+static thread_local MetricsRegistry::Shard *t_shard = nullptr;
+static thread_local ShardHolder             t_holder;
+static thread_local uint32_t                t_sampleTick = 0;
+
+/// 线程退出阶段的记录写到这里并丢弃
+static std::atomic<uint64_t> s_discard[MetricsRegistry::kChunkSlots];
+
+Metric::Metric(Type                type,
+               const std::string  &name,
+               const std::string  &help,
+               const MetricLabels &labels,
+               uint32_t            slot)
+    : m_type(type),
+      m_name(name),
+      m_help(help),
+      m_labels(labels),
+      m_slot(slot) {
+}
+
+std::atomic<uint64_t> *Metric::LocalSlot(uint32_t slot) {
+  MetricsRegistry::Shard *shard = t_shard;
+  if (!shard) {
+    shard = MetricsRegistry::GetInstance()->addShard();
+    if (!shard) {
+      return s_discard + slot % MetricsRegistry::kChunkSlots;
+    }
+  }
+  uint32_t               index = slot / MetricsRegistry::kChunkSlots;
+  std::atomic<uint64_t> *chunk =
+      shard->chunks[index].load(std::memory_order_relaxed);
+  if (!chunk) {
+    chunk = MetricsRegistry::AllocChunk(shard, index);
+  }
+  return chunk + slot % MetricsRegistry::kChunkSlots;
+}
+
+uint64_t Counter::value() const {
+  uint64_t v = 0;
+  MetricsRegistry::GetInstance()->read(m_slot, 1, &v);
+  return v;
+}
+
+int64_t Gauge::value() const {
+  uint64_t v = 0;
+  MetricsRegistry::GetInstance()->read(m_slot, 1, &v);
+  return (int64_t)v;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t rank = std::min<uint64_t>(std::max(q, 0.0) * count, count - 1);
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen > rank) {
+      return BucketUpperBound(i);
+    }
+  }
+  return BucketUpperBound(kBuckets - 1);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+  uint64_t values[kSlots] = {0};
+  MetricsRegistry::GetInstance()->read(m_slot, kSlots, values);
+  Snapshot rt;
+  rt.buckets.assign(values, values + kBuckets);
+  for (auto i : rt.buckets) {
+    rt.count += i;
+  }
+  rt.sum = values[kBuckets];
+  return rt;
+}
+
+uint64_t Histogram::BucketUpperBound(uint32_t index) {
+  if (index < kSubCount) {
+    return index + 1;
+  }
+  uint32_t e   = (index >> kSubBits) + kSubBits - 1;
+  uint64_t sub = index & (kSubCount - 1);
+  return (kSubCount + sub + 1) << (e - kSubBits);
+}
+
+MetricsRegistry *MetricsRegistry::GetInstance() {
+  static MetricsRegistry *s_instance = new MetricsRegistry;
+  return s_instance;
+}
+
+MetricsRegistry::MetricsRegistry() : m_retired(new Shard) {
+}
+
+template <class T>
+std::shared_ptr<T> MetricsRegistry::getOrCreate(Metric::Type        type,
+                                                const std::string  &name,
+                                                const std::string  &help,
+                                                const MetricLabels &labels,
+                                                uint32_t            slots) {
+  // 名称与标签之间用\x01分隔, 同名指标在排序后相邻
+  std::string key = name;
+  for (auto &i : labels) {
+    key += '\x01' + i.first + '=' + i.second;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto                        tit = m_types.find(name);
+  if (tit != m_types.end() && tit->second != type) {
+    throw std::logic_error("metric " + name + " registered with another type");
+  }
+  auto it = m_metrics.find(key);
+  if (it != m_metrics.end()) {
+    return std::static_pointer_cast<T>(it->second);
+  }
+
+  // 一个指标的槽位不跨块
+  uint32_t slot = m_nextSlot;
+  if (slot % kChunkSlots + slots > kChunkSlots) {
+    slot = (slot / kChunkSlots + 1) * kChunkSlots;
+  }
+  if (slot + slots > kChunkSlots * kMaxChunks) {
+    throw std::logic_error("too many metrics");
+  }
+  m_nextSlot = slot + slots;
+
+  std::shared_ptr<T> rt = std::make_shared<T>(type, name, help, labels, slot);
+  m_metrics[key]        = rt;
+  m_types[name]         = type;
+  return rt;
+}
+
+Counter::ptr MetricsRegistry::counter(const std::string  &name,
+                                      const std::string  &help,
+                                      const MetricLabels &labels) {
+  return getOrCreate<Counter>(Metric::COUNTER, name, help, labels, 1);
+}
+
+Gauge::ptr MetricsRegistry::gauge(const std::string  &name,
+                                  const std::string  &help,
+                                  const MetricLabels &labels) {
+  return getOrCreate<Gauge>(Metric::GAUGE, name, help, labels, 1);
+}
+
+Histogram::ptr MetricsRegistry::histogram(const std::string  &name,
+                                          const std::string  &help,
+                                          const MetricLabels &labels) {
+  return getOrCreate<Histogram>(
+      Metric::HISTOGRAM, name, help, labels, Histogram::kSlots);
+}
+
+std::vector<Metric::ptr> MetricsRegistry::getMetrics() const {
+  std::vector<Metric::ptr>    rt;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  rt.reserve(m_metrics.size());
+  for (auto &i : m_metrics) {
+    rt.push_back(i.second);
+  }
+  return rt;
+}
+
+void MetricsRegistry::read(uint32_t slot, uint32_t count, uint64_t *out) const {
+  uint32_t                    index  = slot / kChunkSlots;
+  uint32_t                    offset = slot % kChunkSlots;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::fill(out, out + count, 0);
+  auto add = [&](Shard *shard) {
+    std::atomic<uint64_t> *chunk =
+        shard->chunks[index].load(std::memory_order_acquire);
+    if (!chunk) {
+      return;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      out[i] += chunk[offset + i].load(std::memory_order_relaxed);
+    }
+  };
+  for (auto shard : m_shards) {
+    add(shard);
+  }
+  add(m_retired);
+}
+
+MetricsRegistry::Shard *MetricsRegistry::addShard() {
+  // 分片归还后仍有记录(如其他thread_local析构时加锁), 不再创建分片
+  if (t_holder.exited) {
+    return nullptr;
+  }
+  Shard *shard = new Shard;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shards.push_back(shard);
+  }
+  t_holder.shard = shard;
+  t_shard        = shard;
+  return shard;
+}
+
+void MetricsRegistry::retireShard(Shard *shard) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (uint32_t i = 0; i < kMaxChunks; ++i) {
+    std::atomic<uint64_t> *chunk =
+        shard->chunks[i].load(std::memory_order_relaxed);
+    if (!chunk) {
+      continue;
+    }
+    std::atomic<uint64_t> *dst = m_retired->chunks[i].load();
+    if (!dst) {
+      dst = new std::atomic<uint64_t>[kChunkSlots]();
+      m_retired->chunks[i].store(dst, std::memory_order_release);
+    }
+    for (uint32_t j = 0; j < kChunkSlots; ++j) {
+      dst[j].fetch_add(chunk[j].load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    }
+  }
+  m_shards.erase(std::find(m_shards.begin(), m_shards.end(), shard));
+  t_shard = nullptr;
+  delete shard;
+}
+
+std::atomic<uint64_t> *MetricsRegistry::AllocChunk(Shard   *shard,
+                                                   uint32_t index) {
+  std::atomic<uint64_t> *chunk = new std::atomic<uint64_t>[kChunkSlots]();
+  shard->chunks[index].store(chunk, std::memory_order_release);
+  return chunk;
+}
+
+uint64_t ScopedTimer::Now() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool ScopedTimer::Sample(uint32_t shift) {
+  return Sample(t_sampleTick, shift);
+}
+
+/// @brief 锁竞争路径的等待时间, 首次竞争时才创建直方图
+static void RecordLockWait(LockWaitType type, uint64_t ns) {
+  static Histogram *s_waits[] = {
+      MetricsRegistry::GetInstance()
+          ->histogram("sylar_lock_wait_seconds",
+                      "time spent waiting for contended locks",
+                      {{"type", "mutex"}})
+          .get(),
+      MetricsRegistry::GetInstance()
+          ->histogram("sylar_lock_wait_seconds",
+                      "time spent waiting for contended locks",
+                      {{"type", "rwmutex_read"}})
+          .get(),
+      MetricsRegistry::GetInstance()
+          ->histogram("sylar_lock_wait_seconds",
+                      "time spent waiting for contended locks",
+                      {{"type", "rwmutex_write"}})
+          .get(),
+  };
+  s_waits[type]->record(ns);
+}
+
+/// 链接metrics后统计锁等待, 注册表使用std::mutex, 记录时不会再进入回调
+struct LockWaitIniter {
+  LockWaitIniter() {
+    SetLockWaitHook(&RecordLockWait);
+  }
+};
+
+static LockWaitIniter __lock_wait_init;
+
+}  // namespace sylar
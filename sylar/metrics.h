@@ -0,0 +1,291 @@
+/**
+ * @file metrics.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 指标统计: 按线程分片的计数器, 仪表与延迟直方图
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_METRICS__H__
+#define __SYLAR_METRICS__H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sylar/noncopyable.h"
+
+namespace sylar {
+
+/// @brief 指标标签
+typedef std::map<std::string, std::string> MetricLabels;
+
+/// @brief 指标基类
+/// @details 每个指标在注册表中占用连续的若干槽位, 每个线程持有自己的一份槽位.
+///          记录时只写本线程的槽位(relaxed读改写, 无锁无原子指令),
+///          读取时在注册表锁内累加全部线程的槽位
+class Metric : Noncopyable {
+public:
+  typedef std::shared_ptr<Metric> ptr;
+
+  /// @brief 指标类型
+  enum Type {
+    COUNTER   = 1,
+    GAUGE     = 2,
+    HISTOGRAM = 3,
+  };
+
+  Metric(Type                type,
+         const std::string  &name,
+         const std::string  &help,
+         const MetricLabels &labels,
+         uint32_t            slot);
+
+  virtual ~Metric() {
+  }
+
+  Type getType() const {
+    return m_type;
+  }
+
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  const std::string &getHelp() const {
+    return m_help;
+  }
+
+  const MetricLabels &getLabels() const {
+    return m_labels;
+  }
+
+protected:
+  /// @brief 返回本线程的第slot个槽位
+  static std::atomic<uint64_t> *LocalSlot(uint32_t slot);
+
+  /// @brief 本线程独占的槽位, 单写者不需要原子读改写
+  static void Bump(std::atomic<uint64_t> *s, uint64_t v) {
+    s->store(s->load(std::memory_order_relaxed) + v,
+             std::memory_order_relaxed);
+  }
+
+protected:
+  Type         m_type;
+  std::string  m_name;
+  std::string  m_help;
+  MetricLabels m_labels;
+  /// 第一个槽位
+  uint32_t m_slot;
+};
+
+/// @brief 单调递增的计数器
+class Counter : public Metric {
+public:
+  typedef std::shared_ptr<Counter> ptr;
+
+  using Metric::Metric;
+
+  void inc(uint64_t v = 1) {
+    Bump(LocalSlot(m_slot), v);
+  }
+
+  /// @brief 合并全部线程的值
+  uint64_t value() const;
+};
+
+/// @brief 可增减的仪表, 各线程记录增量, 读取时求和
+class Gauge : public Metric {
+public:
+  typedef std::shared_ptr<Gauge> ptr;
+
+  using Metric::Metric;
+
+  void add(int64_t v) {
+    Bump(LocalSlot(m_slot), (uint64_t)v);
+  }
+
+  void sub(int64_t v) {
+    Bump(LocalSlot(m_slot), (uint64_t)-v);
+  }
+
+  /// @brief 合并全部线程的值
+  int64_t value() const;
+};
+
+/// @brief 纳秒延迟直方图, HDR风格的对数线性分桶
+/// @details 小于8的值各占一桶, 之后每个2的幂区间均分为8个子桶, 相对误差不超过12.5%.
+///          超过kMaxValue的值记入最后一个桶
+class Histogram : public Metric {
+public:
+  typedef std::shared_ptr<Histogram> ptr;
+
+  /// 每个2的幂区间的子桶数 2^kSubBits
+  static const uint32_t kSubBits  = 3;
+  static const uint32_t kSubCount = 1u << kSubBits;
+  /// 可精确分桶的最大值 2^40 ns, 约18分钟
+  static const uint32_t kMaxBits  = 40;
+  static const uint64_t kMaxValue = (1ull << kMaxBits) - 1;
+  /// 桶数
+  static const uint32_t kBuckets = (kMaxBits - kSubBits + 1) * kSubCount;
+  /// 占用的槽位: 各桶计数与总和
+  static const uint32_t kSlots = kBuckets + 1;
+
+  /// @brief 合并后的直方图
+  struct Snapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t              count = 0;
+    uint64_t              sum   = 0;
+
+    /// @brief 分位数, 返回所在桶的上界, q取值[0, 1]
+    uint64_t quantile(double q) const;
+
+    double mean() const {
+      return count ? (double)sum / count : 0;
+    }
+  };
+
+  using Metric::Metric;
+
+  /// @brief 记录一个值(纳秒)
+  void record(uint64_t v) {
+    std::atomic<uint64_t> *s = LocalSlot(m_slot);
+    Bump(s + BucketIndex(v), 1);
+    Bump(s + kBuckets, v);
+  }
+
+  /// @brief 合并全部线程的值
+  Snapshot snapshot() const;
+
+  /// @brief 值所在的桶
+  static uint32_t BucketIndex(uint64_t v) {
+    if (v < kSubCount) {
+      return v;
+    }
+    if (v > kMaxValue) {
+      return kBuckets - 1;
+    }
+    uint32_t e = 63 - __builtin_clzll(v);
+    return ((e - kSubBits + 1) << kSubBits) +
+           ((v >> (e - kSubBits)) & (kSubCount - 1));
+  }
+
+  /// @brief 桶的上界(不含)
+  static uint64_t BucketUpperBound(uint32_t index);
+};
+
+/// @brief 指标注册表
+/// @details 同名同标签的指标只创建一次, 同名指标的类型必须相同.
+///          线程退出时把该线程的值并入注册表, 之后该线程的记录被丢弃
+class MetricsRegistry : Noncopyable {
+public:
+  /// 每块槽位数, 线程用到某块时才分配
+  static const uint32_t kChunkSlots = 4096;
+  /// 最大块数
+  static const uint32_t kMaxChunks = 64;
+
+  /// @brief 一个线程的槽位, 定义在metrics.cc
+  struct Shard;
+
+  /// @brief 返回全局注册表
+  /// @details 进程退出时其他线程可能仍在记录, 注册表不析构
+  static MetricsRegistry *GetInstance();
+
+  /// @brief 获取或创建计数器
+  /// @exception 同名指标类型不同或槽位耗尽时抛出 std::logic_error
+  Counter::ptr counter(const std::string  &name,
+                       const std::string  &help,
+                       const MetricLabels &labels = {});
+
+  /// @brief 获取或创建仪表
+  Gauge::ptr gauge(const std::string  &name,
+                   const std::string  &help,
+                   const MetricLabels &labels = {});
+
+  /// @brief 获取或创建直方图
+  Histogram::ptr histogram(const std::string  &name,
+                           const std::string  &help,
+                           const MetricLabels &labels = {});
+
+  /// @brief 全部指标, 按名称排序, 同名指标相邻
+  std::vector<Metric::ptr> getMetrics() const;
+
+  /// @brief 累加全部线程从slot开始的count个槽位
+  void read(uint32_t slot, uint32_t count, uint64_t *out) const;
+
+private:
+  friend class Metric;
+  friend struct ShardHolder;
+
+  MetricsRegistry();
+
+  template <class T>
+  std::shared_ptr<T> getOrCreate(Metric::Type        type,
+                                 const std::string  &name,
+                                 const std::string  &help,
+                                 const MetricLabels &labels,
+                                 uint32_t            slots);
+
+  /// @brief 创建本线程的分片
+  Shard *addShard();
+
+  /// @brief 线程退出, 分片的值并入m_retired
+  void retireShard(Shard *shard);
+
+  /// @brief 分配分片的第index块
+  static std::atomic<uint64_t> *AllocChunk(Shard *shard, uint32_t index);
+
+private:
+  mutable std::mutex                  m_mutex;
+  std::map<std::string, Metric::ptr>  m_metrics;
+  std::map<std::string, Metric::Type> m_types;
+  std::vector<Shard *>                m_shards;
+  /// 已退出线程的值
+  Shard   *m_retired;
+  uint32_t m_nextSlot = 0;
+};
+
+/// @brief 作用域计时, 析构时把经过的纳秒数记入直方图
+/// @details 一次计时读两次时钟, 约几十纳秒. 对于本身只有几百纳秒的热点,
+///          用Sample按比例采样计时, 计数另用Counter统计
+class ScopedTimer : Noncopyable {
+public:
+  /// @param hist 为nullptr时不计时
+  explicit ScopedTimer(Histogram *hist)
+      : m_hist(hist),
+        m_start(hist ? Now() : 0) {
+  }
+
+  ~ScopedTimer() {
+    if (m_hist) {
+      m_hist->record(Now() - m_start);
+    }
+  }
+
+  /// @brief 单调时钟, 纳秒
+  static uint64_t Now();
+
+  /// @brief 本线程每2^shift次调用返回一次true
+  static bool Sample(uint32_t shift);
+
+  /// @brief 用调用方的计数器采样, 不同热点各用一个, 避免共用计数时步调重合
+  static bool Sample(uint32_t &tick, uint32_t shift) {
+    return (++tick & ((1u << shift) - 1)) == 0;
+  }
+
+private:
+  Histogram *m_hist;
+  uint64_t   m_start;
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_METRICS__H__ */
@@ -0,0 +1,162 @@
+#include "sylar/metrics_exporter.h"
+
+#include <prometheus/exposer.h>
+
+#include <exception>
+#include <limits>
+
+#include "sylar/config.h"
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+/// 导出的最小桶边界(纳秒), 更小的区间低于计时本身的精度
+static const uint64_t kMinExportBound = 64;
+
+/// /metrics监听地址, 对应metrics.address
+static ConfigVar<std::string>::ptr g_metrics_address =
+    Config::Lookup("metrics.address", std::string(), "metrics listen address");
+
+struct MetricsIniter {
+  MetricsIniter() {
+    g_metrics_address->addListener(
+        [](const std::string &old_value, const std::string &new_value) {
+          if (new_value.empty()) {
+            MetricsServerMgr::GetInstance()->stop();
+          } else {
+            MetricsServerMgr::GetInstance()->start(new_value);
+          }
+        });
+  }
+};
+
+static MetricsIniter __metrics_init;
+
+static prometheus::MetricType ToPrometheusType(Metric::Type type) {
+  switch (type) {
+    case Metric::COUNTER:
+      return prometheus::MetricType::Counter;
+    case Metric::GAUGE:
+      return prometheus::MetricType::Gauge;
+    case Metric::HISTOGRAM:
+      return prometheus::MetricType::Histogram;
+    default:
+      return prometheus::MetricType::Untyped;
+  }
+}
+
+static void FillHistogram(const Histogram          &hist,
+                          prometheus::ClientMetric &out) {
+  Histogram::Snapshot snapshot = hist.snapshot();
+  out.histogram.sample_count   = snapshot.count;
+  out.histogram.sample_sum     = snapshot.sum * 1e-9;
+
+  uint64_t cumulative = 0;
+  for (uint32_t i = 0; i < Histogram::kBuckets - 1; ++i) {
+    cumulative += snapshot.buckets[i];
+    uint64_t upper = Histogram::BucketUpperBound(i);
+    // 每个2的幂区间导出两个边界: 1.5倍与2倍处
+    if ((i & (Histogram::kSubCount / 2 - 1)) !=
+            Histogram::kSubCount / 2 - 1 ||
+        upper < kMinExportBound) {
+      continue;
+    }
+    prometheus::ClientMetric::Bucket bucket;
+    bucket.cumulative_count = cumulative;
+    bucket.upper_bound      = upper * 1e-9;
+    out.histogram.bucket.push_back(bucket);
+  }
+  prometheus::ClientMetric::Bucket inf;
+  inf.cumulative_count = snapshot.count;
+  inf.upper_bound      = std::numeric_limits<double>::infinity();
+  out.histogram.bucket.push_back(inf);
+}
+
+std::vector<prometheus::MetricFamily> MetricsCollector::Collect() const {
+  std::vector<prometheus::MetricFamily> rt;
+  for (auto &m : MetricsRegistry::GetInstance()->getMetrics()) {
+    // 同名指标相邻, 合并为一个指标族
+    if (rt.empty() || rt.back().name != m->getName()) {
+      prometheus::MetricFamily family;
+      family.name = m->getName();
+      family.help = m->getHelp();
+      family.type = ToPrometheusType(m->getType());
+      rt.push_back(std::move(family));
+    }
+
+    prometheus::ClientMetric metric;
+    for (auto &i : m->getLabels()) {
+      prometheus::ClientMetric::Label label;
+      label.name  = i.first;
+      label.value = i.second;
+      metric.label.push_back(label);
+    }
+    switch (m->getType()) {
+      case Metric::COUNTER:
+        metric.counter.value = static_cast<Counter &>(*m).value();
+        break;
+      case Metric::GAUGE:
+        metric.gauge.value = static_cast<Gauge &>(*m).value();
+        break;
+      case Metric::HISTOGRAM:
+        FillHistogram(static_cast<Histogram &>(*m), metric);
+        break;
+    }
+    rt.back().metric.push_back(std::move(metric));
+  }
+  return rt;
+}
+
+MetricsServer::MetricsServer() : m_collector(new MetricsCollector) {
+}
+
+MetricsServer::~MetricsServer() {
+  stop();
+}
+
+bool MetricsServer::start(const std::string &address) {
+  MutexType::Lock lock(m_mutex);
+  if (m_exposer && m_address == address) {
+    return true;
+  }
+  m_exposer.reset();
+  m_address.clear();
+  try {
+    // Exposer监听失败时抛出异常
+    std::unique_ptr<prometheus::Exposer> exposer(
+        new prometheus::Exposer(address, 1));
+    exposer->RegisterCollectable(m_collector, "/metrics");
+    m_exposer = std::move(exposer);
+    m_address = address;
+  } catch (std::exception &e) {
+    SYLAR_LOG_ERROR(g_logger) << "metrics listen on " << address
+                              << " failed: " << e.what();
+    return false;
+  }
+  SYLAR_LOG_INFO(g_logger) << "metrics listen on " << address;
+  return true;
+}
+
+void MetricsServer::stop() {
+  MutexType::Lock lock(m_mutex);
+  m_exposer.reset();
+  m_address.clear();
+}
+
+std::string MetricsServer::getAddress() const {
+  MutexType::Lock lock(m_mutex);
+  return m_address;
+}
+
+int MetricsServer::getPort() const {
+  MutexType::Lock lock(m_mutex);
+  if (!m_exposer) {
+    return 0;
+  }
+  std::vector<int> ports = m_exposer->GetListeningPorts();
+  return ports.empty() ? 0 : ports[0];
+}
+
+}  // namespace sylar
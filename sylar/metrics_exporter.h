@@ -0,0 +1,74 @@
+/**
+ * @file metrics_exporter.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 指标导出: 通过prometheus-cpp在/metrics上提供抓取
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_METRICS_EXPORTER__H__
+#define __SYLAR_METRICS_EXPORTER__H__
+
+#include <prometheus/collectable.h>
+#include <prometheus/metric_family.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sylar/metrics.h"
+#include "sylar/mutex.h"
+#include "sylar/singleton.h"
+
+namespace prometheus {
+class Exposer;
+}
+
+namespace sylar {
+
+/// @brief 把MetricsRegistry转换为prometheus指标族, 每次抓取时合并各线程的值
+/// @details 直方图以秒为单位导出, 每个2的幂区间取2^k与1.5*2^k两个桶边界,
+///          可用histogram_quantile按时间窗口计算p99
+class MetricsCollector : public prometheus::Collectable {
+public:
+  typedef std::shared_ptr<MetricsCollector> ptr;
+
+  std::vector<prometheus::MetricFamily> Collect() const override;
+};
+
+/// @brief /metrics HTTP服务
+/// @details 地址由配置metrics.address(ip:port)指定, 为空时不启动
+class MetricsServer {
+public:
+  typedef Mutex MutexType;
+
+  MetricsServer();
+
+  ~MetricsServer();
+
+  /// @brief 在address上提供/metrics, 已启动时先停止原来的服务
+  /// @return 监听失败返回false
+  bool start(const std::string &address);
+
+  void stop();
+
+  std::string getAddress() const;
+
+  /// @brief 实际监听的端口, address的端口为0时由系统分配, 未启动返回0
+  int getPort() const;
+
+private:
+  mutable MutexType                    m_mutex;
+  std::string                          m_address;
+  std::unique_ptr<prometheus::Exposer> m_exposer;
+  MetricsCollector::ptr                m_collector;
+};
+
+typedef Singleton<MetricsServer> MetricsServerMgr;
+
+}  // namespace sylar
+
+#endif /* __SYLAR_METRICS_EXPORTER__H__ */
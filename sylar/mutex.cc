@@ -1,3 +1,190 @@
 #include "sylar/mutex.h"
 
-namespace sylar {}
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace sylar {
+
+namespace {
+
+/// 进入内核挂起前的自旋次数
+static constexpr int kSpinCount = 100;
+
+/// 锁等待回调, 常量初始化, 其他编译单元静态初始化期间加锁也能使用
+static std::atomic<LockWaitHook> s_lockWaitHook{nullptr};
+
+/// @brief 竞争路径的等待计时, 未注册回调时不计时
+class LockWaitTimer {
+public:
+  explicit LockWaitTimer(LockWaitType type)
+      : m_type(type),
+        m_hook(s_lockWaitHook.load(std::memory_order_relaxed)),
+        m_start(m_hook ? Now() : 0) {
+  }
+
+  ~LockWaitTimer() {
+    if (m_hook) {
+      m_hook(m_type, Now() - m_start);
+    }
+  }
+
+private:
+  static uint64_t Now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+  }
+
+private:
+  LockWaitType m_type;
+  LockWaitHook m_hook;
+  uint64_t     m_start;
+};
+
+}  // namespace
+
+void SetLockWaitHook(LockWaitHook hook) {
+  s_lockWaitHook.store(hook, std::memory_order_relaxed);
+}
+
+int FutexWait(std::atomic<uint32_t> *addr,
+              uint32_t               expected,
+              const struct timespec *timeout) {
+  return syscall(SYS_futex,
+                 reinterpret_cast<uint32_t *>(addr),
+                 FUTEX_WAIT_PRIVATE,
+                 expected,
+                 timeout,
+                 nullptr,
+                 0);
+}
+
+int FutexWake(std::atomic<uint32_t> *addr, int count) {
+  return syscall(SYS_futex,
+                 reinterpret_cast<uint32_t *>(addr),
+                 FUTEX_WAKE_PRIVATE,
+                 count,
+                 nullptr,
+                 nullptr,
+                 0);
+}
+
+Semaphore::Semaphore(uint32_t count) {
+  if (sem_init(&m_semaphore, 0, count)) {
+    throw std::logic_error("sem_init error");
+  }
+}
+
+Semaphore::~Semaphore() {
+  sem_destroy(&m_semaphore);
+}
+
+void Semaphore::wait() {
+  while (sem_wait(&m_semaphore)) {
+    if (errno != EINTR) {
+      throw std::logic_error("sem_wait error");
+    }
+  }
+}
+
+void Semaphore::notify() {
+  if (sem_post(&m_semaphore)) {
+    throw std::logic_error("sem_post error");
+  }
+}
+
+void Mutex::lockSlow() {
+  LockWaitTimer timer(LOCK_WAIT_MUTEX);
+  for (int i = 0; i < kSpinCount; ++i) {
+    uint32_t c = m_state.load(std::memory_order_relaxed);
+    if (c == 0 && m_state.compare_exchange_weak(c,
+                                                1,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+      return;
+    }
+    Spinlock::CpuRelax();
+  }
+
+  // 标记为有等待者, 解锁方据此决定是否需要futex唤醒
+  uint32_t c = m_state.exchange(2, std::memory_order_acquire);
+  while (c != 0) {
+    FutexWait(&m_state, 2);
+    c = m_state.exchange(2, std::memory_order_acquire);
+  }
+}
+
+void Mutex::unlockSlow() {
+  FutexWake(&m_state, 1);
+}
+
+void RWMutex::rdlockSlow() {
+  LockWaitTimer timer(LOCK_WAIT_RWMUTEX_READ);
+  int spin = 0;
+  while (true) {
+    uint32_t s = m_state.load(std::memory_order_relaxed);
+    if (!(s & (kWriter | kWaitMask))) {
+      if (m_state.compare_exchange_weak(s,
+                                        s + 1,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (spin < kSpinCount) {
+      ++spin;
+      Spinlock::CpuRelax();
+      continue;
+    }
+    park(s);
+  }
+}
+
+void RWMutex::wrlockSlow() {
+  LockWaitTimer timer(LOCK_WAIT_RWMUTEX_WRITE);
+  m_state.fetch_add(kWaitUnit, std::memory_order_relaxed);
+  int spin = 0;
+  while (true) {
+    uint32_t s = m_state.load(std::memory_order_relaxed);
+    if (!(s & (kWriter | kReaderMask))) {
+      if (m_state.compare_exchange_weak(s,
+                                        (s - kWaitUnit) | kWriter,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (spin < kSpinCount) {
+      ++spin;
+      Spinlock::CpuRelax();
+      continue;
+    }
+    park(s);
+  }
+}
+
+void RWMutex::wakeAll() {
+  FutexWake(&m_state, INT_MAX);
+}
+
+void RWMutex::park(uint32_t s) {
+  if (!(s & kParked)) {
+    if (!m_state.compare_exchange_weak(s,
+                                       s | kParked,
+                                       std::memory_order_relaxed,
+                                       std::memory_order_relaxed)) {
+      return;
+    }
+    s |= kParked;
+  }
+  FutexWait(&m_state, s);
+}
+
+}  // namespace sylar
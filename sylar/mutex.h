@@ -4,6 +4,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <stdint.h>
+#include <time.h>
 
 #include <atomic>
 #include <functional>
@@ -14,6 +15,44 @@
 
 namespace sylar {
 
+/// @brief 缓存行大小, 用于避免伪共享
+static constexpr size_t kCacheLineSize = 64;
+
+/// @brief futex等待, *addr等于expected时挂起当前线程
+/// @param addr 等待的地址
+/// @param expected 期望值
+/// @param timeout 相对超时时间, nullptr表示一直等待
+/// @return syscall返回值
+int FutexWait(std::atomic<uint32_t> *addr,
+              uint32_t               expected,
+              const struct timespec *timeout = nullptr);
+
+/// @brief 唤醒在addr上等待的线程
+/// @param addr 等待的地址
+/// @param count 最多唤醒的线程数
+/// @return 被唤醒的线程数
+int FutexWake(std::atomic<uint32_t> *addr, int count);
+
+/// @brief 发生等待的锁
+enum LockWaitType {
+  /// Mutex
+  LOCK_WAIT_MUTEX         = 0,
+  /// RWMutex读锁
+  LOCK_WAIT_RWMUTEX_READ  = 1,
+  /// RWMutex写锁
+  LOCK_WAIT_RWMUTEX_WRITE = 2,
+};
+
+/// @brief 锁竞争路径的等待回调
+/// @param type 锁类型
+/// @param ns 本次等待的纳秒数
+typedef void (*LockWaitHook)(LockWaitType type, uint64_t ns);
+
+/// @brief 设置锁等待回调, nullptr表示不计时
+/// @details 锁不依赖指标模块, 由metrics注册回调. 未注册时竞争路径不读取时钟,
+///          无竞争的加锁始终不计时
+void SetLockWaitHook(LockWaitHook hook);
+
 /// @brief  信号量
 class Semaphore : Noncopyable {
 public:
@@ -34,6 +73,333 @@ private:
   sem_t m_semaphore;
 };
 
+/// @brief 局部锁模板
+/// @tparam T 锁类型, 需提供lock/unlock
+template <class T>
+struct ScopedLockImpl {
+public:
+  /// @brief 构造函数, 加锁
+  /// @param mutex 锁
+  ScopedLockImpl(T &mutex) : m_mutex(mutex) {
+    m_mutex.lock();
+    m_locked = true;
+  }
+
+  /// @brief 析构函数, 自动释放锁
+  ~ScopedLockImpl() {
+    unlock();
+  }
+
+  /// @brief 加锁
+  void lock() {
+    if (!m_locked) {
+      m_mutex.lock();
+      m_locked = true;
+    }
+  }
+
+  /// @brief 解锁
+  void unlock() {
+    if (m_locked) {
+      m_mutex.unlock();
+      m_locked = false;
+    }
+  }
+
+private:
+  T   &m_mutex;
+  bool m_locked = false;
+};
+
+/// @brief 局部读锁模板
+/// @tparam T 读写锁类型, 需提供rdlock/unlock
+template <class T>
+struct ReadScopedLockImpl {
+public:
+  /// @brief 构造函数, 加读锁
+  /// @param mutex 读写锁
+  ReadScopedLockImpl(T &mutex) : m_mutex(mutex) {
+    m_mutex.rdlock();
+    m_locked = true;
+  }
+
+  /// @brief 析构函数, 自动释放锁
+  ~ReadScopedLockImpl() {
+    unlock();
+  }
+
+  /// @brief 加读锁
+  void lock() {
+    if (!m_locked) {
+      m_mutex.rdlock();
+      m_locked = true;
+    }
+  }
+
+  /// @brief 释放锁
+  void unlock() {
+    if (m_locked) {
+      m_mutex.unlock();
+      m_locked = false;
+    }
+  }
+
+private:
+  T   &m_mutex;
+  bool m_locked = false;
+};
+
+/// @brief 局部写锁模板
+/// @tparam T 读写锁类型, 需提供wrlock/unlock
+template <class T>
+struct WriteScopedLockImpl {
+public:
+  /// @brief 构造函数, 加写锁
+  /// @param mutex 读写锁
+  WriteScopedLockImpl(T &mutex) : m_mutex(mutex) {
+    m_mutex.wrlock();
+    m_locked = true;
+  }
+
+  /// @brief 析构函数, 自动释放锁
+  ~WriteScopedLockImpl() {
+    unlock();
+  }
+
+  /// @brief 加写锁
+  void lock() {
+    if (!m_locked) {
+      m_mutex.wrlock();
+      m_locked = true;
+    }
+  }
+
+  /// @brief 释放锁
+  void unlock() {
+    if (m_locked) {
+      m_mutex.unlock();
+      m_locked = false;
+    }
+  }
+
+private:
+  T   &m_mutex;
+  bool m_locked = false;
+};
+
+/// @brief 基于futex的互斥量
+/// @details 无竞争时仅一次CAS, 竞争时先在用户态自旋, 仍拿不到锁才进入内核挂起
+///          状态: 0 未加锁, 1 加锁且无等待者, 2 加锁且可能有等待者
+class Mutex : Noncopyable {
+public:
+  /// 局部锁
+  typedef ScopedLockImpl<Mutex> Lock;
+
+  /// @brief 构造函数
+  Mutex() = default;
+
+  /// @brief 加锁
+  void lock() {
+    uint32_t c = 0;
+    if (m_state.compare_exchange_strong(c,
+                                        1,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+      return;
+    }
+    lockSlow();
+  }
+
+  /// @brief 尝试加锁
+  /// @return 是否加锁成功
+  bool tryLock() {
+    uint32_t c = 0;
+    return m_state.compare_exchange_strong(c,
+                                           1,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed);
+  }
+
+  /// @brief 解锁
+  void unlock() {
+    if (m_state.exchange(0, std::memory_order_release) == 2) {
+      unlockSlow();
+    }
+  }
+
+private:
+  /// @brief 竞争路径: 自旋后挂起
+  void lockSlow();
+
+  /// @brief 唤醒一个等待者
+  void unlockSlow();
+
+private:
+  std::atomic<uint32_t> m_state{0};
+};
+
+/// @brief 自旋锁
+/// @details 独占一个缓存行, 避免与相邻数据伪共享, 适用于极短的临界区
+class alignas(kCacheLineSize) Spinlock : Noncopyable {
+public:
+  /// 局部锁
+  typedef ScopedLockImpl<Spinlock> Lock;
+
+  /// @brief 构造函数
+  Spinlock() = default;
+
+  /// @brief 加锁
+  void lock() {
+    while (m_locked.exchange(true, std::memory_order_acquire)) {
+      // 只读等待, 避免锁持有期间反复使缓存行失效
+      while (m_locked.load(std::memory_order_relaxed)) {
+        CpuRelax();
+      }
+    }
+  }
+
+  /// @brief 尝试加锁
+  /// @return 是否加锁成功
+  bool tryLock() {
+    return !m_locked.load(std::memory_order_relaxed) &&
+           !m_locked.exchange(true, std::memory_order_acquire);
+  }
+
+  /// @brief 解锁
+  void unlock() {
+    m_locked.store(false, std::memory_order_release);
+  }
+
+  /// @brief 自旋等待时提示CPU降低功耗/让出流水线
+  static void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+  }
+
+private:
+  std::atomic<bool> m_locked{false};
+};
+
+/// @brief 基于futex的读写锁, 写优先
+/// @details 有写者等待时新的读者会被阻塞, 避免写者饿死
+///          状态位: [31] 写锁持有 [30] 有线程挂起 [16,29] 等待的写者数 [0,15] 读者数
+class RWMutex : Noncopyable {
+public:
+  /// 局部读锁
+  typedef ReadScopedLockImpl<RWMutex> ReadLock;
+
+  /// 局部写锁
+  typedef WriteScopedLockImpl<RWMutex> WriteLock;
+
+  /// @brief 构造函数
+  RWMutex() = default;
+
+  /// @brief 加读锁
+  void rdlock() {
+    uint32_t s = m_state.load(std::memory_order_relaxed);
+    if (!(s & (kWriter | kWaitMask)) &&
+        m_state.compare_exchange_weak(s,
+                                      s + 1,
+                                      std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+      return;
+    }
+    rdlockSlow();
+  }
+
+  /// @brief 加写锁
+  void wrlock() {
+    uint32_t s = 0;
+    if (m_state.compare_exchange_strong(s,
+                                        kWriter,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+      return;
+    }
+    wrlockSlow();
+  }
+
+  /// @brief 解锁(读锁或写锁)
+  void unlock() {
+    uint32_t s = m_state.load(std::memory_order_relaxed);
+    if (s & kWriter) {
+      s = m_state.fetch_and(~(kWriter | kParked), std::memory_order_release);
+    } else {
+      s = m_state.fetch_sub(1, std::memory_order_release);
+      // 仍有其他读者时无需唤醒
+      if (((s - 1) & kReaderMask) != 0 || !(s & kParked)) {
+        return;
+      }
+      s = m_state.fetch_and(~kParked, std::memory_order_relaxed);
+    }
+    if (s & kParked) {
+      wakeAll();
+    }
+  }
+
+private:
+  /// @brief 读锁竞争路径
+  void rdlockSlow();
+
+  /// @brief 写锁竞争路径
+  void wrlockSlow();
+
+  /// @brief 唤醒全部挂起线程
+  void wakeAll();
+
+  /// @brief 设置挂起标志后在状态s上挂起
+  void park(uint32_t s);
+
+private:
+  static constexpr uint32_t kWriter     = 1u << 31;
+  static constexpr uint32_t kParked     = 1u << 30;
+  static constexpr uint32_t kWaitUnit   = 1u << 16;
+  static constexpr uint32_t kWaitMask   = 0x3fffu << 16;
+  static constexpr uint32_t kReaderMask = 0xffffu;
+
+  std::atomic<uint32_t> m_state{0};
+};
+
+/// @brief 空锁(用于调试)
+class NullMutex : Noncopyable {
+public:
+  /// 局部锁
+  typedef ScopedLockImpl<NullMutex> Lock;
+
+  /// @brief 加锁
+  void lock() {
+  }
+
+  /// @brief 解锁
+  void unlock() {
+  }
+};
+
+/// @brief 空读写锁(用于调试)
+class NullRWMutex : Noncopyable {
+public:
+  /// 局部读锁
+  typedef ReadScopedLockImpl<NullRWMutex> ReadLock;
+
+  /// 局部写锁
+  typedef WriteScopedLockImpl<NullRWMutex> WriteLock;
+
+  /// @brief 加读锁
+  void rdlock() {
+  }
+
+  /// @brief 加写锁
+  void wrlock() {
+  }
+
+  /// @brief 解锁
+  void unlock() {
+  }
+};
+
 }  // namespace sylar
 
 #endif /* __MUTEX__H__ */
@@ -0,0 +1,511 @@
+#include "sylar/rock/rock_protocol.h"
+
+#include <snappy.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace sylar {
+
+static const uint8_t kMagic0  = 0xab;
+static const uint8_t kMagic1  = 0xcd;
+static const uint8_t kVersion = 1;
+
+bool RockMessage::serializeToByteArray(ByteArray::ptr bytearray) {
+  bytearray->writeFuint8(getType());
+  bytearray->writeUint32(m_sn);
+  bytearray->writeUint32(m_cmd);
+  bytearray->writeStringVint(m_body);
+  return true;
+}
+
+bool RockMessage::parseFromByteArray(ByteArray::ptr bytearray) {
+  try {
+    if (bytearray->readFuint8() != getType()) {
+      return false;
+    }
+    m_sn   = bytearray->readUint32();
+    m_cmd  = bytearray->readUint32();
+    m_body = bytearray->readStringVint();
+    return true;
+  } catch (std::out_of_range &) {
+    return false;
+  }
+}
+
+std::string RockMessage::toString() const {
+  std::stringstream ss;
+  ss << "[" << (getType() == REQUEST ? "RockRequest" : "RockResponse")
+     << " sn=" << m_sn << " cmd=" << m_cmd << " body.length=" << m_body.size()
+     << "]";
+  return ss.str();
+}
+
+std::shared_ptr<RockResponse> RockRequest::createResponse() {
+  RockResponse::ptr rt(new RockResponse);
+  rt->setSn(m_sn);
+  rt->setCmd(m_cmd);
+  return rt;
+}
+
+bool RockResponse::serializeToByteArray(ByteArray::ptr bytearray) {
+  bytearray->writeFuint8(getType());
+  bytearray->writeUint32(m_sn);
+  bytearray->writeUint32(m_cmd);
+  bytearray->writeInt32(m_result);
+  bytearray->writeStringVint(m_resultStr);
+  bytearray->writeStringVint(m_body);
+  return true;
+}
+
+bool RockResponse::parseFromByteArray(ByteArray::ptr bytearray) {
+  try {
+    if (bytearray->readFuint8() != getType()) {
+      return false;
+    }
+    m_sn        = bytearray->readUint32();
+    m_cmd       = bytearray->readUint32();
+    m_result    = bytearray->readInt32();
+    m_resultStr = bytearray->readStringVint();
+    m_body      = bytearray->readStringVint();
+    return true;
+  } catch (std::out_of_range &) {
+    return false;
+  }
+}
+
+std::string RockResponse::toString() const {
+  std::stringstream ss;
+  ss << "[RockResponse sn=" << m_sn << " cmd=" << m_cmd
+     << " result=" << m_result << " result_str=" << m_resultStr
+     << " body.length=" << m_body.size() << "]";
+  return ss.str();
+}
+
+static void PutUint32(char *p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+static uint32_t GetUint32(const char *p) {
+  const uint8_t *u = (const uint8_t *)p;
+  return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) |
+         ((uint32_t)u[2] << 8) | u[3];
+}
+
+static void WriteHeader(const ByteArray::ptr &ba, int compress, uint32_t len) {
+  char header[RockMessageDecoder::kHeaderSize] = {
+      (char)kMagic0, (char)kMagic1, (char)kVersion, (char)compress};
+  PutUint32(header + 4, len);
+  ba->write(header, sizeof(header));
+}
+
+/// @brief 按顺序读出一组iovec, 压缩时直接读ByteArray的内存块
+class IovecSource : public snappy::Source {
+public:
+  explicit IovecSource(const std::vector<iovec> &iovs)
+      : m_iovs(iovs) {
+    for (auto &i : iovs) {
+      m_left += i.iov_len;
+    }
+  }
+
+  size_t Available() const override {
+    return m_left;
+  }
+
+  const char *Peek(size_t *len) override {
+    if (m_idx == m_iovs.size()) {
+      *len = 0;
+      return nullptr;
+    }
+    *len = m_iovs[m_idx].iov_len - m_off;
+    return (const char *)m_iovs[m_idx].iov_base + m_off;
+  }
+
+  void Skip(size_t n) override {
+    m_left -= n;
+    while (n > 0) {
+      size_t step = std::min(n, m_iovs[m_idx].iov_len - m_off);
+      m_off += step;
+      n -= step;
+      if (m_off == m_iovs[m_idx].iov_len) {
+        ++m_idx;
+        m_off = 0;
+      }
+    }
+  }
+
+private:
+  const std::vector<iovec> &m_iovs;
+  size_t                    m_idx  = 0;
+  size_t                    m_off  = 0;
+  size_t                    m_left = 0;
+};
+
+/// @brief 按顺序写入一组iovec, 写满后丢弃剩余数据并标记溢出
+/// @details 当前块剩余空间足够时snappy直接在块上输出, 否则输出到scratch再拷入
+class IovecSink : public snappy::Sink {
+public:
+  explicit IovecSink(const std::vector<iovec> &iovs)
+      : m_iovs(iovs) {
+  }
+
+  void Append(const char *bytes, size_t n) override {
+    if (bytes == current()) {
+      // 数据已由GetAppendBuffer返回的地址写入
+      advance(n);
+      return;
+    }
+    while (n > 0 && m_idx < m_iovs.size()) {
+      size_t step = std::min(n, m_iovs[m_idx].iov_len - m_off);
+      memcpy(current(), bytes, step);
+      bytes += step;
+      n -= step;
+      advance(step);
+    }
+    if (n > 0) {
+      m_overflow = true;
+    }
+  }
+
+  char *GetAppendBuffer(size_t length, char *scratch) override {
+    return room() >= length ? current() : scratch;
+  }
+
+  char *GetAppendBufferVariable(size_t  min_size,
+                                size_t  desired_size_hint,
+                                char   *scratch,
+                                size_t  scratch_size,
+                                size_t *allocated_size) override {
+    if (room() >= min_size) {
+      *allocated_size = room();
+      return current();
+    }
+    *allocated_size = scratch_size;
+    return scratch;
+  }
+
+  size_t getWritten() const {
+    return m_written;
+  }
+
+  bool isOverflow() const {
+    return m_overflow;
+  }
+
+private:
+  char *current() const {
+    return m_idx < m_iovs.size() ? (char *)m_iovs[m_idx].iov_base + m_off
+                                 : nullptr;
+  }
+
+  /// @brief 当前块的剩余空间
+  size_t room() const {
+    return m_idx < m_iovs.size() ? m_iovs[m_idx].iov_len - m_off : 0;
+  }
+
+  void advance(size_t n) {
+    m_written += n;
+    m_off += n;
+    if (m_off == m_iovs[m_idx].iov_len) {
+      ++m_idx;
+      m_off = 0;
+    }
+  }
+
+private:
+  const std::vector<iovec> &m_iovs;
+  size_t                    m_idx      = 0;
+  size_t                    m_off      = 0;
+  size_t                    m_written  = 0;
+  bool                      m_overflow = false;
+};
+
+/// @brief 用zlib流式压缩in写入out
+/// @param[out] produced 压缩后的长度
+/// @return out放不下时返回false
+static bool Deflate(const std::vector<iovec> &in,
+                    const std::vector<iovec> &out,
+                    size_t                   &produced) {
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  // RPC对延迟敏感, 使用最快的压缩级别
+  if (deflateInit(&zs, Z_BEST_SPEED) != Z_OK) {
+    return false;
+  }
+  size_t i  = 0;
+  size_t o  = 0;
+  int    rt = Z_OK;
+  while (true) {
+    if (zs.avail_in == 0 && i < in.size()) {
+      zs.next_in  = (Bytef *)in[i].iov_base;
+      zs.avail_in = in[i].iov_len;
+      ++i;
+    }
+    if (zs.avail_out == 0) {
+      if (o == out.size()) {
+        break;
+      }
+      zs.next_out  = (Bytef *)out[o].iov_base;
+      zs.avail_out = out[o].iov_len;
+      ++o;
+    }
+    rt = deflate(&zs, i == in.size() ? Z_FINISH : Z_NO_FLUSH);
+    if (rt == Z_STREAM_END || rt == Z_STREAM_ERROR) {
+      break;
+    }
+  }
+  produced = zs.total_out;
+  deflateEnd(&zs);
+  return rt == Z_STREAM_END;
+}
+
+/// @brief 用zlib流式解压in, 输出必须恰好填满out
+static bool Inflate(const std::vector<iovec> &in, const iovec &out) {
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit(&zs) != Z_OK) {
+    return false;
+  }
+  zs.next_out  = (Bytef *)out.iov_base;
+  zs.avail_out = out.iov_len;
+  size_t i     = 0;
+  int    rt    = Z_OK;
+  while (rt == Z_OK) {
+    if (zs.avail_in == 0) {
+      if (i == in.size()) {
+        break;
+      }
+      zs.next_in  = (Bytef *)in[i].iov_base;
+      zs.avail_in = in[i].iov_len;
+      ++i;
+    }
+    rt = inflate(&zs, Z_NO_FLUSH);
+  }
+  bool ok = rt == Z_STREAM_END && zs.avail_out == 0 && zs.avail_in == 0 &&
+            i == in.size();
+  inflateEnd(&zs);
+  return ok;
+}
+
+/// @brief 压缩raw中的数据, 直接写到ba的当前位置
+/// @details 输出写在ba的内存块上, 超过limit时放弃.
+///          zlib压缩的数据前附加4字节的原始长度
+/// @return 成功返回写入的长度并移动位置, 失败返回0, ba的位置未定义
+static size_t CompressData(int                   compress,
+                           const ByteArray::ptr &raw,
+                           const ByteArray::ptr &ba,
+                           size_t                limit) {
+  std::vector<iovec> in;
+  std::vector<iovec> out;
+  raw->getReadBuffers(in, raw->getSize(), 0);
+  size_t start = ba->getPosition();
+  switch (compress) {
+    case RockMessageDecoder::SNAPPY: {
+      ba->getWriteBuffers(out, limit);
+      IovecSource source(in);
+      IovecSink   sink(out);
+      snappy::Compress(&source, &sink);
+      if (sink.isOverflow()) {
+        return 0;
+      }
+      ba->setPosition(start + sink.getWritten());
+      return sink.getWritten();
+    }
+    case RockMessageDecoder::ZLIB: {
+      if (limit <= 4) {
+        return 0;
+      }
+      char len[4];
+      PutUint32(len, raw->getSize());
+      ba->write(len, sizeof(len));
+      ba->getWriteBuffers(out, limit - sizeof(len));
+      size_t produced = 0;
+      if (!Deflate(in, out, produced)) {
+        return 0;
+      }
+      ba->setPosition(start + sizeof(len) + produced);
+      return sizeof(len) + produced;
+    }
+    default:
+      return 0;
+  }
+}
+
+/// @brief 解压ba中[position, position + len)的数据
+/// @details 输入直接读ba的内存块, 输出到一个与原文等长的内存块中
+/// @return 失败返回nullptr
+static ByteArray::ptr UncompressData(int              compress,
+                                     const ByteArray &ba,
+                                     size_t           position,
+                                     size_t           len) {
+  std::vector<iovec> in;
+  uint32_t           raw = 0;
+  switch (compress) {
+    case RockMessageDecoder::SNAPPY: {
+      ba.getReadBuffers(in, len, position);
+      IovecSource source(in);
+      if (!snappy::GetUncompressedLength(&source, &raw)) {
+        return nullptr;
+      }
+      break;
+    }
+    case RockMessageDecoder::ZLIB: {
+      if (len < 4) {
+        return nullptr;
+      }
+      char header[4];
+      ba.read(header, sizeof(header), position);
+      raw = GetUint32(header);
+      ba.getReadBuffers(in, len - sizeof(header), position + sizeof(header));
+      break;
+    }
+    default:
+      return nullptr;
+  }
+  if (raw == 0 || raw > RockMessageDecoder::kMaxBodySize) {
+    return nullptr;
+  }
+
+  ByteArray::ptr     body(new ByteArray(raw));
+  std::vector<iovec> out;
+  body->getWriteBuffers(out, raw);
+  if (compress == RockMessageDecoder::SNAPPY) {
+    IovecSource source(in);
+    IovecSink   sink(out);
+    if (!snappy::Uncompress(&source, &sink) || sink.isOverflow() ||
+        sink.getWritten() != raw) {
+      return nullptr;
+    }
+  } else if (!Inflate(in, out[0])) {
+    return nullptr;
+  }
+  body->setPosition(raw);
+  body->setPosition(0);
+  return body;
+}
+
+void RockMessageDecoder::Encode(const RockMessage::ptr &msg,
+                                const ByteArray::ptr   &ba,
+                                Compress                compress,
+                                size_t                  threshold) {
+  if (compress != NONE && msg->getBody().size() >= threshold) {
+    ByteArray::ptr tmp(new ByteArray(ba->getBaseSize()));
+    msg->serializeToByteArray(tmp);
+    size_t raw   = tmp->getSize();
+    size_t start = ba->getPosition();
+    WriteHeader(ba, compress, 0);
+    // 压缩后不变小时按原文发送, 因此最多输出raw - 1字节
+    size_t len = raw > 1 ? CompressData(compress, tmp, ba, raw - 1) : 0;
+    if (len > 0) {
+      size_t end = ba->getPosition();
+      ba->setPosition(start + 4);
+      ba->writeFuint32(len);
+      ba->setPosition(end);
+      return;
+    }
+    ba->setPosition(start);
+    WriteHeader(ba, NONE, raw);
+    std::vector<iovec> iovs;
+    tmp->getReadBuffers(iovs, raw, 0);
+    for (auto &i : iovs) {
+      ba->write(i.iov_base, i.iov_len);
+    }
+    return;
+  }
+
+  // 不压缩时直接序列化到ba, 再回填长度
+  size_t start = ba->getPosition();
+  WriteHeader(ba, NONE, 0);
+  msg->serializeToByteArray(ba);
+  size_t end = ba->getPosition();
+  ba->setPosition(start + 4);
+  ba->writeFuint32(end - start - kHeaderSize);
+  ba->setPosition(end);
+}
+
+int RockMessageDecoder::Decode(const ByteArray::ptr &ba, RockMessage::ptr &msg) {
+  size_t start = ba->getPosition();
+  if (ba->getReadSize() < kHeaderSize) {
+    return 0;
+  }
+  char header[kHeaderSize];
+  ba->read(header, kHeaderSize, start);
+  if ((uint8_t)header[0] != kMagic0 || (uint8_t)header[1] != kMagic1 ||
+      (uint8_t)header[2] != kVersion) {
+    return -1;
+  }
+  uint32_t len = GetUint32(header + 4);
+  if (len > kMaxBodySize) {
+    return -1;
+  }
+  if (ba->getReadSize() < kHeaderSize + len) {
+    return 0;
+  }
+
+  size_t         end      = start + kHeaderSize + len;
+  int            compress = header[3] & 0x3;
+  ByteArray::ptr body     = ba;
+  if (compress != NONE) {
+    body = UncompressData(compress, *ba, start + kHeaderSize, len);
+    if (!body) {
+      return -1;
+    }
+  } else {
+    ba->setPosition(start + kHeaderSize);
+  }
+
+  if (body->getReadSize() == 0) {
+    return -1;
+  }
+  uint8_t type = 0;
+  body->read(&type, 1, body->getPosition());
+  RockMessage::ptr m;
+  if (type == RockMessage::REQUEST) {
+    m.reset(new RockRequest);
+  } else if (type == RockMessage::RESPONSE) {
+    m.reset(new RockResponse);
+  } else {
+    return -1;
+  }
+  if (!m->parseFromByteArray(body) ||
+      (compress == NONE && ba->getPosition() != end) ||
+      (compress != NONE && body->getReadSize() != 0)) {
+    return -1;
+  }
+  ba->setPosition(end);
+  msg = m;
+  return 1;
+}
+
+const char *RockMessageDecoder::CompressToString(Compress c) {
+  switch (c) {
+    case SNAPPY:
+      return "snappy";
+    case ZLIB:
+      return "zlib";
+    default:
+      return "none";
+  }
+}
+
+RockMessageDecoder::Compress RockMessageDecoder::CompressFromString(
+    const std::string &v) {
+  if (v == "snappy") {
+    return SNAPPY;
+  }
+  if (v == "zlib") {
+    return ZLIB;
+  }
+  return NONE;
+}
+
+}  // namespace sylar
@@ -0,0 +1,178 @@
+/**
+ * @file rock_protocol.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief rock二进制协议: 消息定义与帧编解码
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_ROCK_PROTOCOL__H__
+#define __SYLAR_ROCK_PROTOCOL__H__
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "sylar/bytearray.h"
+
+namespace sylar {
+
+/// @brief rock消息基类
+/// @details 消息体按 type(Fuint8) sn(Uint32) cmd(Uint32) [响应字段] body(StringVint)
+///          序列化, 变长整数使用varint编码
+class RockMessage {
+public:
+  typedef std::shared_ptr<RockMessage> ptr;
+
+  /// @brief 消息类型
+  enum MessageType {
+    REQUEST  = 1,
+    RESPONSE = 2,
+  };
+
+  virtual ~RockMessage() {
+  }
+
+  virtual MessageType getType() const = 0;
+
+  /// @brief 序列化到bytearray的当前位置
+  virtual bool serializeToByteArray(ByteArray::ptr bytearray);
+
+  /// @brief 从bytearray的当前位置解析
+  virtual bool parseFromByteArray(ByteArray::ptr bytearray);
+
+  virtual std::string toString() const;
+
+  /// @brief 序列号, 响应与请求相同, 用于在一个连接上匹配并发的请求
+  uint32_t getSn() const {
+    return m_sn;
+  }
+
+  void setSn(uint32_t v) {
+    m_sn = v;
+  }
+
+  uint32_t getCmd() const {
+    return m_cmd;
+  }
+
+  void setCmd(uint32_t v) {
+    m_cmd = v;
+  }
+
+  const std::string &getBody() const {
+    return m_body;
+  }
+
+  void setBody(const std::string &v) {
+    m_body = v;
+  }
+
+  void setBody(std::string &&v) {
+    m_body = std::move(v);
+  }
+
+protected:
+  uint32_t    m_sn  = 0;
+  uint32_t    m_cmd = 0;
+  std::string m_body;
+};
+
+class RockResponse;
+
+/// @brief rock请求
+class RockRequest : public RockMessage {
+public:
+  typedef std::shared_ptr<RockRequest> ptr;
+
+  MessageType getType() const override {
+    return REQUEST;
+  }
+
+  /// @brief 创建sn与cmd相同的响应
+  std::shared_ptr<RockResponse> createResponse();
+};
+
+/// @brief rock响应
+class RockResponse : public RockMessage {
+public:
+  typedef std::shared_ptr<RockResponse> ptr;
+
+  MessageType getType() const override {
+    return RESPONSE;
+  }
+
+  bool serializeToByteArray(ByteArray::ptr bytearray) override;
+
+  bool parseFromByteArray(ByteArray::ptr bytearray) override;
+
+  std::string toString() const override;
+
+  /// @brief 结果码, 0表示成功
+  int32_t getResult() const {
+    return m_result;
+  }
+
+  void setResult(int32_t v) {
+    m_result = v;
+  }
+
+  const std::string &getResultStr() const {
+    return m_resultStr;
+  }
+
+  void setResultStr(const std::string &v) {
+    m_resultStr = v;
+  }
+
+private:
+  int32_t     m_result = 0;
+  std::string m_resultStr;
+};
+
+/// @brief rock帧编解码
+/// @details 帧格式(大端):
+///          | magic 0xab 0xcd | version 1B | flag 1B | length 4B | body |
+///          flag低2位为body的压缩方式, length为压缩后body的长度.
+///          zlib压缩的body前附加4字节的原始长度, snappy自带长度
+class RockMessageDecoder {
+public:
+  /// @brief 压缩方式
+  enum Compress {
+    NONE   = 0,
+    SNAPPY = 1,
+    ZLIB   = 2,
+  };
+
+  /// 帧头长度
+  static const size_t kHeaderSize = 8;
+  /// body最大长度
+  static const uint32_t kMaxBodySize = 64 * 1024 * 1024;
+
+  /// @brief 编码一帧, 追加到ba的当前位置
+  /// @param compress 压缩方式
+  /// @param threshold 消息body不小于该长度才压缩, 压缩后不变小时按原文发送
+  static void Encode(const RockMessage::ptr &msg,
+                     const ByteArray::ptr   &ba,
+                     Compress                compress  = NONE,
+                     size_t                  threshold = 0);
+
+  /// @brief 从ba的当前位置解码一帧
+  /// @param[out] msg 解码得到的消息
+  /// @return 1成功并移到下一帧, 0数据不足(位置不变), -1协议错误
+  static int Decode(const ByteArray::ptr &ba, RockMessage::ptr &msg);
+
+  /// @brief 压缩方式名称
+  static const char *CompressToString(Compress c);
+
+  /// @brief 按名称解析压缩方式(none/snappy/zlib), 未知返回NONE
+  static Compress CompressFromString(const std::string &v);
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_ROCK_PROTOCOL__H__ */
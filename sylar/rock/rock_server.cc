@@ -0,0 +1,145 @@
+#include "sylar/rock/rock_server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+static std::string AddressToString(const sockaddr_in &addr) {
+  char ip[INET_ADDRSTRLEN] = {0};
+  inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+  return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+RockServer::RockServer(IOManager *iom, const std::string &name)
+    : m_iom(iom),
+      m_name(name) {
+}
+
+RockServer::~RockServer() {
+  if (!m_started) {
+    for (int sock : m_socks) {
+      ::close(sock);
+    }
+  }
+}
+
+bool RockServer::bind(const std::string &address) {
+  sockaddr_in addr;
+  if (!ParseAddress(address, addr, true)) {
+    SYLAR_LOG_ERROR(g_logger) << "rock server invalid address " << address;
+    return false;
+  }
+  int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    SYLAR_LOG_ERROR(g_logger) << "rock server socket errno=" << errno << " "
+                              << strerror(errno);
+    return false;
+  }
+  int       on  = 1;
+  socklen_t len = sizeof(addr);
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (::bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(sock, SOMAXCONN) != 0 ||
+      getsockname(sock, (sockaddr *)&addr, &len) != 0) {
+    SYLAR_LOG_ERROR(g_logger) << "rock server bind " << address
+                              << " failed, errno=" << errno << " "
+                              << strerror(errno);
+    ::close(sock);
+    return false;
+  }
+  m_socks.push_back(sock);
+  m_addrs.push_back(AddressToString(addr));
+  SYLAR_LOG_INFO(g_logger) << m_name << " listen on " << m_addrs.back();
+  return true;
+}
+
+void RockServer::start() {
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_started || m_stopped) {
+      return;
+    }
+    m_started = true;
+  }
+  RockServer::ptr self = shared_from_this();
+  for (int sock : m_socks) {
+    m_iom->schedule([self, sock]() { self->doAccept(sock); });
+  }
+}
+
+void RockServer::stop() {
+  std::unordered_map<RockStream *, RockStream::ptr> sessions;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_stopped) {
+      return;
+    }
+    m_stopped = true;
+    sessions.swap(m_sessions);
+    if (m_started) {
+      // 唤醒accept协程, 监听socket由accept协程关闭
+      for (int sock : m_socks) {
+        shutdown(sock, SHUT_RDWR);
+      }
+    }
+  }
+  for (auto &i : sessions) {
+    i.second->close();
+  }
+}
+
+void RockServer::doAccept(int sock) {
+  std::weak_ptr<RockServer> weak = shared_from_this();
+  while (true) {
+    int fd = m_iom->accept(sock, nullptr, nullptr);
+    if (fd < 0) {
+      {
+        MutexType::Lock lock(m_mutex);
+        if (m_stopped) {
+          break;
+        }
+      }
+      SYLAR_LOG_ERROR(g_logger) << m_name << " accept errno=" << errno << " "
+                                << strerror(errno);
+      // fd耗尽等情况下避免空转
+      m_iom->sleep(100);
+      continue;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    RockStream::ptr stream = std::make_shared<RockStream>(m_iom, fd);
+    stream->setRequestHandler(m_requestHandler);
+    stream->setCompress(m_compress, m_threshold);
+    stream->setCloseCallback([weak](RockStream::ptr s) {
+      RockServer::ptr server = weak.lock();
+      if (server) {
+        MutexType::Lock lock(server->m_mutex);
+        server->m_sessions.erase(s.get());
+      }
+    });
+    {
+      MutexType::Lock lock(m_mutex);
+      if (m_stopped) {
+        // 未启动的连接在析构时关闭fd
+        break;
+      }
+      m_sessions[stream.get()] = stream;
+    }
+    stream->start();
+  }
+  m_iom->close(sock);
+}
+
+}  // namespace sylar
@@ -0,0 +1,90 @@
+/**
+ * @file rock_server.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief rock协议服务端
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_ROCK_SERVER__H__
+#define __SYLAR_ROCK_SERVER__H__
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+#include "sylar/rock/rock_stream.h"
+
+namespace sylar {
+
+/// @brief rock服务端, 每个监听地址一个accept协程, 每个连接一个RockStream
+class RockServer : public std::enable_shared_from_this<RockServer> {
+public:
+  typedef std::shared_ptr<RockServer> ptr;
+  typedef Mutex                       MutexType;
+
+  /// @brief 构造函数
+  /// @param iom 监听与连接所在的IOManager
+  RockServer(IOManager *iom, const std::string &name = "sylar-rock/1.0");
+
+  /// @brief 析构函数, 关闭未启动的监听socket
+  ~RockServer();
+
+  /// @brief 绑定并监听 ip:port, 端口为0时由系统分配
+  bool bind(const std::string &address);
+
+  /// @brief 启动accept协程
+  /// @details accept协程持有服务端的引用, 退出前需调用stop
+  void start();
+
+  /// @brief 停止监听并关闭全部连接
+  void stop();
+
+  /// @brief 设置连接的请求处理函数, start前调用
+  void setRequestHandler(RockStream::RequestHandler v) {
+    m_requestHandler = v;
+  }
+
+  /// @brief 设置连接发送响应时的压缩方式, start前调用
+  void setCompress(RockMessageDecoder::Compress v, size_t threshold) {
+    m_compress  = v;
+    m_threshold = threshold;
+  }
+
+  /// @brief 实际监听的地址 ip:port
+  const std::vector<std::string> &getAddresses() const {
+    return m_addrs;
+  }
+
+  const std::string &getName() const {
+    return m_name;
+  }
+
+private:
+  void doAccept(int sock);
+
+private:
+  IOManager               *m_iom;
+  std::string              m_name;
+  std::vector<int>         m_socks;
+  std::vector<std::string> m_addrs;
+
+  MutexType                                         m_mutex;
+  bool                                              m_started = false;
+  bool                                              m_stopped = false;
+  std::unordered_map<RockStream *, RockStream::ptr> m_sessions;
+
+  RockStream::RequestHandler   m_requestHandler;
+  RockMessageDecoder::Compress m_compress  = RockMessageDecoder::NONE;
+  size_t                       m_threshold = 0;
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_ROCK_SERVER__H__ */
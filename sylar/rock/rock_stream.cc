@@ -0,0 +1,404 @@
+#include "sylar/rock/rock_stream.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "sylar/fiber.h"
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+/// 收发缓冲区的内存块大小
+static const size_t kBlockSize = 16 * 1024;
+/// 每次recvmsg最多接收的字节数
+static const size_t kReadSize = 64 * 1024;
+/// 发送缓冲区空闲时保留的最大容量
+static const size_t kMaxIdleBuffer = 1024 * 1024;
+
+RockStream::RockStream(IOManager *iom, int fd)
+    : m_iom(iom),
+      m_fd(fd),
+      m_out(new ByteArray(kBlockSize)),
+      m_sending(new ByteArray(kBlockSize)) {
+}
+
+RockStream::~RockStream() {
+  if (m_fd >= 0) {
+    m_iom->close(m_fd);
+  }
+}
+
+RockStream::ptr RockStream::Connect(IOManager         *iom,
+                                    const std::string &host,
+                                    uint64_t           timeout_ms) {
+  sockaddr_in addr;
+  int         fd = -1;
+  if (ParseAddress(host, addr)) {
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  } else {
+    errno = EINVAL;
+  }
+  if (fd >= 0 &&
+      iom->connect(fd, (sockaddr *)&addr, sizeof(addr), timeout_ms) == 0) {
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return std::make_shared<RockStream>(iom, fd);
+  }
+  SYLAR_LOG_ERROR(g_logger) << "rock connect " << host
+                            << " failed, errno=" << errno << " "
+                            << strerror(errno);
+  if (fd >= 0) {
+    iom->close(fd);
+  }
+  return nullptr;
+}
+
+void RockStream::start() {
+  bool write = false;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_closed || m_ioRefs > 0) {
+      return;
+    }
+    m_ioRefs = 1;
+    // 启动前提交的消息
+    if (m_out->getSize() > 0) {
+      m_writing = true;
+      write     = true;
+      ++m_ioRefs;
+    }
+  }
+  RockStream::ptr self = shared_from_this();
+  m_iom->schedule([self]() { self->doRead(); });
+  if (write) {
+    m_iom->schedule([self]() { self->doWrite(); });
+  }
+}
+
+void RockStream::close() {
+  fail("");
+}
+
+bool RockStream::isConnected() const {
+  MutexType::Lock lock(m_mutex);
+  return !m_closed;
+}
+
+void RockStream::request(RockRequest::ptr req,
+                         Callback         cb,
+                         uint64_t         timeout_ms) {
+  uint32_t sn = ++m_sn;
+  req->setSn(sn);
+  ByteArray::ptr frame  = compress(req);
+  bool           closed = false;
+  bool           write  = false;
+  {
+    MutexType::Lock lock(m_mutex);
+    closed = m_closed;
+    if (!closed) {
+      // 先登记请求再启动定时器, 定时器触发时一定能找到该请求
+      Ctx &ctx = m_ctxs[sn];
+      ctx.cb   = std::move(cb);
+      if (timeout_ms != 0 && timeout_ms != ~0ull) {
+        ctx.timer = m_iom->addConditionTimer(
+            timeout_ms, [this, sn]() { onTimeout(sn); }, weak_from_this());
+      }
+      append(req, frame);
+      if (!m_writing && m_ioRefs > 0) {
+        m_writing = true;
+        write     = true;
+        ++m_ioRefs;
+      }
+    }
+  }
+  if (closed) {
+    if (cb) {
+      cb(nullptr);
+    }
+    return;
+  }
+  if (write) {
+    RockStream::ptr self = shared_from_this();
+    m_iom->schedule([self]() { self->doWrite(); });
+  }
+}
+
+RockResponse::ptr RockStream::request(RockRequest::ptr req,
+                                      uint64_t         timeout_ms) {
+  RockResponse::ptr rt;
+  if (FiberExecutor::GetThis()) {
+    FiberSemaphore sem;
+    request(
+        req,
+        [&rt, &sem](RockResponse::ptr rsp) {
+          rt = std::move(rsp);
+          sem.notify();
+        },
+        timeout_ms);
+    sem.wait();
+  } else {
+    Semaphore sem;
+    request(
+        req,
+        [&rt, &sem](RockResponse::ptr rsp) {
+          rt = std::move(rsp);
+          sem.notify();
+        },
+        timeout_ms);
+    sem.wait();
+  }
+  return rt;
+}
+
+bool RockStream::sendMessage(RockMessage::ptr msg) {
+  ByteArray::ptr frame = compress(msg);
+  bool           write = false;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_closed) {
+      return false;
+    }
+    append(msg, frame);
+    if (!m_writing && m_ioRefs > 0) {
+      m_writing = true;
+      write     = true;
+      ++m_ioRefs;
+    }
+  }
+  if (write) {
+    RockStream::ptr self = shared_from_this();
+    m_iom->schedule([self]() { self->doWrite(); });
+  }
+  return true;
+}
+
+ByteArray::ptr RockStream::compress(const RockMessage::ptr &msg) {
+  if (m_compress == RockMessageDecoder::NONE ||
+      msg->getBody().size() < m_threshold) {
+    return nullptr;
+  }
+  ByteArray::ptr frame(new ByteArray(kBlockSize));
+  RockMessageDecoder::Encode(msg, frame, m_compress, m_threshold);
+  frame->setPosition(0);
+  return frame;
+}
+
+void RockStream::append(const RockMessage::ptr &msg,
+                        const ByteArray::ptr   &frame) {
+  if (!frame) {
+    RockMessageDecoder::Encode(msg, m_out);
+    return;
+  }
+  std::vector<iovec> iovs;
+  frame->getReadBuffers(iovs);
+  for (auto &i : iovs) {
+    m_out->write(i.iov_base, i.iov_len);
+  }
+}
+
+void RockStream::doRead() {
+  // 位置为已解析的数据末尾, getSize()为已接收的数据末尾
+  ByteArray::ptr     ba(new ByteArray(kBlockSize));
+  std::vector<iovec> iovs;
+  std::string        reason;
+  while (reason.empty()) {
+    size_t parsed = ba->getPosition();
+    ba->setPosition(ba->getSize());
+    iovs.clear();
+    ba->getWriteBuffers(iovs, kReadSize);
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = iovs.data();
+    msg.msg_iovlen = iovs.size();
+    ssize_t n      = m_iom->recvmsg(m_fd, &msg, 0);
+    if (n <= 0) {
+      reason = n == 0 ? "closed by peer" : strerror(errno);
+      break;
+    }
+    ba->setPosition(ba->getPosition() + n);
+    ba->setPosition(parsed);
+
+    while (true) {
+      RockMessage::ptr m;
+      int              rt = RockMessageDecoder::Decode(ba, m);
+      if (rt == 0) {
+        break;
+      }
+      if (rt < 0) {
+        reason = "protocol error";
+        break;
+      }
+      onMessage(m);
+    }
+    ba->discardRead();
+  }
+  fail(reason);
+  releaseIo();
+}
+
+void RockStream::doWrite() {
+  std::vector<iovec> iovs;
+  while (true) {
+    {
+      MutexType::Lock lock(m_mutex);
+      if (m_closed || m_out->getSize() == 0) {
+        m_writing = false;
+        break;
+      }
+      m_out.swap(m_sending);
+    }
+
+    bool ok = true;
+    m_sending->setPosition(0);
+    while (m_sending->getReadSize() > 0) {
+      iovs.clear();
+      m_sending->getReadBuffers(iovs);
+      msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov    = iovs.data();
+      msg.msg_iovlen = std::min<size_t>(iovs.size(), IOV_MAX);
+      ssize_t n      = m_iom->sendmsg(m_fd, &msg, 0);
+      if (n <= 0) {
+        ok = false;
+        break;
+      }
+      m_sending->setPosition(m_sending->getPosition() + n);
+    }
+    // 发完后保留内存块给下一轮使用, 过大时释放
+    if (ok && m_sending->getSize() <= kMaxIdleBuffer) {
+      m_sending->discardRead();
+    } else {
+      m_sending->clear();
+    }
+    if (!ok) {
+      fail(strerror(errno));
+      MutexType::Lock lock(m_mutex);
+      m_writing = false;
+      break;
+    }
+  }
+  releaseIo();
+}
+
+void RockStream::onTimeout(uint32_t sn) {
+  Callback cb;
+  {
+    MutexType::Lock lock(m_mutex);
+    auto            it = m_ctxs.find(sn);
+    if (it == m_ctxs.end()) {
+      return;
+    }
+    cb = std::move(it->second.cb);
+    m_ctxs.erase(it);
+  }
+  // 只让该请求失败, 连接继续使用, 迟到的响应被丢弃
+  SYLAR_LOG_WARN(g_logger) << "rock request timeout, sn=" << sn;
+  if (cb) {
+    cb(nullptr);
+  }
+}
+
+void RockStream::onMessage(RockMessage::ptr msg) {
+  if (msg->getType() == RockMessage::RESPONSE) {
+    Ctx ctx;
+    {
+      MutexType::Lock lock(m_mutex);
+      auto            it = m_ctxs.find(msg->getSn());
+      if (it == m_ctxs.end()) {
+        return;
+      }
+      ctx = std::move(it->second);
+      m_ctxs.erase(it);
+    }
+    if (ctx.timer) {
+      ctx.timer->cancel();
+    }
+    if (ctx.cb) {
+      ctx.cb(std::static_pointer_cast<RockResponse>(msg));
+    }
+    return;
+  }
+
+  // 每个请求在单独的协程中处理, 慢请求不阻塞读协程与同一连接上的其他请求
+  RockRequest::ptr req  = std::static_pointer_cast<RockRequest>(msg);
+  RockStream::ptr  self = shared_from_this();
+  m_iom->schedule([self, req]() { self->handleRequest(req); });
+}
+
+void RockStream::handleRequest(RockRequest::ptr req) {
+  RockResponse::ptr rsp = req->createResponse();
+  if (!m_requestHandler) {
+    rsp->setResult(404);
+    rsp->setResultStr("no request handler");
+  } else if (!m_requestHandler(req, rsp, shared_from_this())) {
+    fail("closed by handler");
+    return;
+  }
+  sendMessage(rsp);
+}
+
+void RockStream::fail(const std::string &reason) {
+  std::unordered_map<uint32_t, Ctx> ctxs;
+  int                               fd = -1;
+  int                               sock;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (m_closed) {
+      return;
+    }
+    m_closed = true;
+    sock     = m_fd;
+    ctxs.swap(m_ctxs);
+    m_out->clear();
+    if (m_ioRefs > 0) {
+      // 唤醒阻塞在fd上的读写协程, fd由最后退出的协程关闭
+      shutdown(m_fd, SHUT_RDWR);
+    } else {
+      fd   = m_fd;
+      m_fd = -1;
+    }
+  }
+  if (!reason.empty()) {
+    SYLAR_LOG_INFO(g_logger) << "rock stream fd=" << sock
+                             << " closed: " << reason;
+  }
+  if (fd >= 0) {
+    m_iom->close(fd);
+  }
+  for (auto &i : ctxs) {
+    if (i.second.timer) {
+      i.second.timer->cancel();
+    }
+    if (i.second.cb) {
+      i.second.cb(nullptr);
+    }
+  }
+}
+
+void RockStream::releaseIo() {
+  int fd = -1;
+  {
+    MutexType::Lock lock(m_mutex);
+    if (--m_ioRefs > 0) {
+      return;
+    }
+    fd   = m_fd;
+    m_fd = -1;
+  }
+  m_iom->close(fd);
+  if (m_closeCb) {
+    m_closeCb(shared_from_this());
+  }
+}
+
+}  // namespace sylar
@@ -0,0 +1,159 @@
+/**
+ * @file rock_stream.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief rock协议连接: 单连接上的并发请求复用
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_ROCK_STREAM__H__
+#define __SYLAR_ROCK_STREAM__H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "sylar/bytearray.h"
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+#include "sylar/rock/rock_protocol.h"
+
+namespace sylar {
+
+/// @brief rock协议连接, 客户端与服务端共用
+/// @details 请求分配递增的序列号后写入发送缓冲区, 写协程每次把缓冲区中的全部帧
+///          用一次sendmsg发出; 读协程把数据直接收进ByteArray的内存块并逐帧解码,
+///          响应按序列号交给对应请求的回调, 因此多个请求可以同时在途且乱序返回.
+///          收到的每个请求在iom上单独的协程中交给RequestHandler处理后回复,
+///          读协程继续解码后续消息, 同一连接上的请求并发处理, 响应可能乱序.
+///          连接出错或关闭后, 未完成的请求以nullptr回调
+class RockStream : public std::enable_shared_from_this<RockStream> {
+public:
+  typedef std::shared_ptr<RockStream> ptr;
+  typedef Mutex                       MutexType;
+
+  /// @brief 响应回调, 在IO线程中执行, 失败或超时参数为nullptr
+  typedef std::function<void(RockResponse::ptr)> Callback;
+
+  /// @brief 请求处理函数, 填写rsp后由连接发回; 返回false关闭连接
+  /// @details 每个请求在单独的协程中执行, 挂起等待不影响该连接上的其他请求
+  typedef std::function<bool(
+      RockRequest::ptr req, RockResponse::ptr rsp, RockStream::ptr stream)>
+      RequestHandler;
+
+  /// @brief 连接关闭回调
+  typedef std::function<void(RockStream::ptr stream)> CloseCallback;
+
+  /// @brief 构造函数
+  /// @param iom 连接所在的IOManager
+  /// @param fd 已连接的socket, 由RockStream负责关闭
+  RockStream(IOManager *iom, int fd);
+
+  /// @brief 析构函数, 未启动的连接在此关闭fd
+  ~RockStream();
+
+  /// @brief 连接到 ip:port
+  /// @pre 在iom的协程中调用
+  /// @return 失败返回nullptr
+  static RockStream::ptr Connect(IOManager         *iom,
+                                 const std::string &host,
+                                 uint64_t           timeout_ms);
+
+  /// @brief 启动读协程, 设置回调与压缩方式后调用
+  void start();
+
+  /// @brief 关闭连接
+  void close();
+
+  /// @brief 异步请求, 自动分配序列号
+  /// @param timeout_ms 超时时间, 超时后回调nullptr
+  void request(RockRequest::ptr req, Callback cb, uint64_t timeout_ms);
+
+  /// @brief 同步请求
+  /// @details 在协程中调用只挂起当前协程, 否则阻塞当前线程
+  RockResponse::ptr request(RockRequest::ptr req, uint64_t timeout_ms);
+
+  /// @brief 发送消息
+  /// @return 连接已关闭返回false
+  bool sendMessage(RockMessage::ptr msg);
+
+  void setRequestHandler(RequestHandler v) {
+    m_requestHandler = v;
+  }
+
+  void setCloseCallback(CloseCallback v) {
+    m_closeCb = v;
+  }
+
+  /// @brief 设置发送时的压缩方式
+  /// @param threshold 消息body不小于该长度才压缩
+  void setCompress(RockMessageDecoder::Compress v, size_t threshold) {
+    m_compress  = v;
+    m_threshold = threshold;
+  }
+
+  bool isConnected() const;
+
+private:
+  /// @brief 等待响应的请求
+  struct Ctx {
+    Callback   cb;
+    Timer::ptr timer;
+  };
+
+  /// @brief 需要压缩时在锁外编码成帧, 避免压缩阻塞其他请求
+  /// @return 不压缩返回nullptr
+  ByteArray::ptr compress(const RockMessage::ptr &msg);
+
+  /// @brief 追加到发送缓冲区, 调用方持有m_mutex
+  /// @param frame compress的结果, 为空时直接编码到发送缓冲区
+  void append(const RockMessage::ptr &msg, const ByteArray::ptr &frame);
+
+  void doRead();
+  void doWrite();
+  void onTimeout(uint32_t sn);
+
+  /// @brief 处理收到的消息, 请求交给新协程中的handleRequest
+  void onMessage(RockMessage::ptr msg);
+
+  /// @brief 调用RequestHandler并发回响应, 在单独的协程中执行
+  void handleRequest(RockRequest::ptr req);
+
+  /// @brief 断开连接, 全部等待中的请求失败
+  void fail(const std::string &reason);
+
+  /// @brief 读写协程退出, 最后一个退出时关闭fd
+  void releaseIo();
+
+private:
+  IOManager *m_iom;
+  int        m_fd;
+
+  mutable MutexType m_mutex;
+  bool              m_closed  = false;
+  bool              m_writing = false;
+  /// 读写协程数量
+  int                   m_ioRefs = 0;
+  std::atomic<uint32_t> m_sn{0};
+  /// 待发送的帧
+  ByteArray::ptr m_out;
+  /// 写协程正在发送的帧
+  ByteArray::ptr                    m_sending;
+  std::unordered_map<uint32_t, Ctx> m_ctxs;
+
+  RequestHandler               m_requestHandler;
+  CloseCallback                m_closeCb;
+  RockMessageDecoder::Compress m_compress  = RockMessageDecoder::NONE;
+  size_t                       m_threshold = 0;
+};
+
+}  // namespace sylar
+
+#endif /* __SYLAR_ROCK_STREAM__H__ */
@@ -0,0 +1,446 @@
+#include "sylar/scheduler.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <ostream>
+
+#include "sylar/macro.h"
+
+namespace sylar {
+
+/// 当前线程的调度器
+static thread_local Scheduler *t_scheduler = nullptr;
+/// 当前线程的调度协程
+static thread_local Fiber *t_scheduler_fiber = nullptr;
+/// 当前线程在调度器中的序号
+static thread_local int t_worker_id = -1;
+
+/// 从注入队列一次最多搬运到本线程队列的任务数
+static constexpr size_t kInjectBatch = 32;
+/// 繁忙时每执行多少个任务调用一次tick
+static constexpr uint32_t kTickInterval = 16;
+/// 每2^6个任务计时一次, 计时的开销与短任务本身相当
+static constexpr uint32_t kDispatchSampleShift = 6;
+
+Scheduler::Scheduler(size_t                  threads,
+                     const std::string      &name,
+                     const std::vector<int> &cpus)
+    : m_name(name.empty() ? "scheduler" : name), m_cpus(cpus) {
+  SYLAR_ASSERT(threads > 0);
+  MetricsRegistry *registry = MetricsRegistry::GetInstance();
+  MetricLabels     labels   = {{"scheduler", m_name}};
+  m_taskCount    = registry->counter("sylar_scheduler_tasks_total",
+                                     "tasks dispatched",
+                                     labels);
+  m_stealCount   = registry->counter("sylar_scheduler_steals_total",
+                                     "tasks stolen from other workers",
+                                     labels);
+  m_dispatchTime = registry->histogram("sylar_scheduler_dispatch_seconds",
+                                       "sampled task run time",
+                                       labels);
+  m_workers.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    std::unique_ptr<Worker> w(new Worker);
+    w->id   = i;
+    w->seed = uint32_t(i * 2654435761u + 1);
+    m_workers.push_back(std::move(w));
+  }
+}
+
+Scheduler::~Scheduler() {
+  SYLAR_ASSERT(m_stopping);
+  if (GetThis() == this) {
+    t_scheduler = nullptr;
+  }
+  // 未执行的任务直接释放
+  for (auto &w : m_workers) {
+    Task *task = nullptr;
+    while (w->queue.pop(task)) {
+      delete task;
+    }
+    for (auto i : w->inbox) {
+      delete i;
+    }
+  }
+  while (Task *task = popInject()) {
+    delete task;
+  }
+}
+
+Scheduler *Scheduler::GetThis() {
+  return t_scheduler;
+}
+
+Fiber *Scheduler::GetMainFiber() {
+  return t_scheduler_fiber;
+}
+
+int Scheduler::GetWorkerId() {
+  return t_worker_id;
+}
+
+void Scheduler::setThis() {
+  t_scheduler = this;
+}
+
+void Scheduler::start() {
+  MutexType::Lock lock(m_mutex);
+  if (m_started) {
+    return;
+  }
+  m_started = true;
+  m_stopping.store(false, std::memory_order_seq_cst);
+  for (auto &w : m_workers) {
+    w->thread = std::thread(&Scheduler::run, this, w.get());
+  }
+}
+
+void Scheduler::stop() {
+  SYLAR_ASSERT2(GetThis() != this, "Scheduler::stop in its own worker");
+  m_stopping.store(true, std::memory_order_seq_cst);
+  for (auto &w : m_workers) {
+    if (w->sleeping.exchange(0, std::memory_order_seq_cst)) {
+      tickle(w->id);
+    }
+  }
+  for (auto &w : m_workers) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+  }
+}
+
+void Scheduler::submit(Task *task) {
+  int thread = task->thread;
+  if (thread >= 0) {
+    SYLAR_ASSERT(size_t(thread) < m_workers.size());
+    Worker *w = m_workers[thread].get();
+    {
+      Spinlock::Lock lock(w->inboxMutex);
+      w->inbox.push_back(task);
+    }
+    w->inboxSize.fetch_add(1, std::memory_order_release);
+  } else if (t_scheduler == this) {
+    m_workers[t_worker_id]->queue.push(task);
+  } else {
+    pushInject(task);
+  }
+
+  // 与prepareSleep配对: 任务入队后再检查空闲线程, 避免唤醒丢失
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_idleThreadCount.load(std::memory_order_relaxed) > 0) {
+    wakeup(thread);
+  }
+}
+
+void Scheduler::wakeup(int thread) {
+  if (thread >= 0) {
+    Worker *w = m_workers[thread].get();
+    if (w->sleeping.load(std::memory_order_relaxed) &&
+        w->sleeping.exchange(0, std::memory_order_acq_rel)) {
+      tickle(w->id);
+    }
+    return;
+  }
+
+  size_t n     = m_workers.size();
+  size_t start = m_wakeCursor.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < n; ++i) {
+    Worker *w = m_workers[(start + i) % n].get();
+    if (w->sleeping.load(std::memory_order_relaxed) &&
+        w->sleeping.exchange(0, std::memory_order_acq_rel)) {
+      tickle(w->id);
+      return;
+    }
+  }
+}
+
+void Scheduler::pushInject(Task *task) {
+  // 先链接再发布, 消费者取到的栈总是完整的
+  task->next = m_injectHead.load(std::memory_order_relaxed);
+  while (!m_injectHead.compare_exchange_weak(task->next,
+                                             task,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+  }
+  m_injectSize.fetch_add(1, std::memory_order_release);
+}
+
+Scheduler::Task *Scheduler::popInject() {
+  if (!m_injectList) {
+    // 栈顶是最新提交的任务, 反转成提交顺序
+    Task *top = m_injectHead.exchange(nullptr, std::memory_order_acquire);
+    while (top) {
+      Task *next   = top->next;
+      top->next    = m_injectList;
+      m_injectList = top;
+      top          = next;
+    }
+    if (!m_injectList) {
+      return nullptr;
+    }
+  }
+  Task *task   = m_injectList;
+  m_injectList = task->next;
+  return task;
+}
+
+Scheduler::Task *Scheduler::nextTask(Worker *w) {
+  Task *task = nullptr;
+  if (w->inboxSize.load(std::memory_order_acquire) > 0) {
+    Spinlock::Lock lock(w->inboxMutex);
+    if (!w->inbox.empty()) {
+      task = w->inbox.front();
+      w->inbox.pop_front();
+      w->inboxSize.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+
+  if (w->queue.pop(task)) {
+    return task;
+  }
+
+  // 只有一个线程能取注入队列, 没抢到的线程直接去窃取或睡眠,
+  // 取到的线程把多余的任务放入自己的队列, 释放时仍有剩余则唤醒一个线程
+  if (m_injectSize.load(std::memory_order_acquire) > 0 &&
+      !m_injectBusy.load(std::memory_order_relaxed) &&
+      !m_injectBusy.exchange(true, std::memory_order_acquire)) {
+    size_t n = m_injectSize.load(std::memory_order_acquire);
+    // 按线程数均分, 多搬运的部分放入本线程队列供其他线程窃取.
+    // n/workers+1在单线程时大于n, 必须再与n取小, 否则会多取
+    size_t batch = std::min({n / m_workers.size() + 1, n, kInjectBatch});
+    size_t taken = 0;
+    while (taken < batch) {
+      Task *t = popInject();
+      if (!t) {
+        break;
+      }
+      if (taken++ == 0) {
+        task = t;
+      } else {
+        w->queue.push(t);
+      }
+    }
+    if (taken > 0) {
+      m_injectSize.fetch_sub(taken, std::memory_order_relaxed);
+    }
+    m_injectBusy.store(false, std::memory_order_release);
+
+    // 外部线程提交时只唤醒一个线程, 拿到多个任务的线程负责接力唤醒下一个,
+    // 使睡眠线程逐个加入窃取, 而不是由本线程串行执行整批任务.
+    // 与prepareSleep配对: 没抢到的线程可能已经睡眠, 剩余的任务需要有人来取
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ((taken > 1 || m_injectSize.load(std::memory_order_relaxed) > 0) &&
+        hasIdleThreads()) {
+      wakeup(-1);
+    }
+    if (task) {
+      return task;
+    }
+  }
+
+  return steal(w);
+}
+
+Scheduler::Task *Scheduler::steal(Worker *w) {
+  size_t n = m_workers.size();
+  if (n <= 1) {
+    return nullptr;
+  }
+  // xorshift 随机选择起始线程, 避免所有空闲线程窃取同一个
+  w->seed ^= w->seed << 13;
+  w->seed ^= w->seed >> 17;
+  w->seed ^= w->seed << 5;
+  size_t start = w->seed % n;
+
+  Task *task = nullptr;
+  for (int round = 0; round < 2; ++round) {
+    bool contended = false;
+    for (size_t i = 0; i < n; ++i) {
+      Worker *victim = m_workers[(start + i) % n].get();
+      if (victim == w || victim->queue.empty()) {
+        continue;
+      }
+      if (victim->queue.steal(task)) {
+        m_stealCount->inc();
+        return task;
+      }
+      contended = true;
+    }
+    if (!contended) {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+void Scheduler::dispatch(Task *task, Fiber::ptr &cb_fiber) {
+  m_taskCount->inc();
+  ScopedTimer timer(ScopedTimer::Sample(kDispatchSampleShift)
+                        ? m_dispatchTime.get()
+                        : nullptr);
+  if (task->fiber) {
+    Fiber::ptr fiber = std::move(task->fiber);
+    delete task;
+    // 唤醒方可能在原线程切出完成前投递, 状态只能由resume读取
+    if (fiber->resume() == Fiber::READY) {
+      schedule(std::move(fiber));
+    }
+    // HOLD状态由唤醒方持有并重新投递
+    return;
+  }
+
+  if (cb_fiber) {
+    cb_fiber->reset(std::move(task->cb));
+  } else {
+    cb_fiber.reset(new Fiber(std::move(task->cb)));
+  }
+  delete task;
+
+  Fiber::State state = cb_fiber->resume();
+  if (state == Fiber::READY) {
+    schedule(std::move(cb_fiber));
+  } else if (state == Fiber::TERM || state == Fiber::EXCEPT) {
+    // 执行完毕, 保留协程栈供下一个函数复用
+    cb_fiber->reset(nullptr);
+  } else {
+    cb_fiber.reset();
+  }
+}
+
+void Scheduler::run(Worker *w) {
+  setThis();
+  t_worker_id = int(w->id);
+  FiberExecutor::SetThis(this);
+
+  std::string thread_name = m_name + "_" + std::to_string(w->id);
+  pthread_setname_np(pthread_self(), thread_name.substr(0, 15).c_str());
+  if (!m_cpus.empty()) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(m_cpus[w->id % m_cpus.size()], &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+  }
+
+  t_scheduler_fiber = Fiber::GetThis().get();
+  onThreadStart(w->id);
+
+  Fiber::ptr idle_fiber(new Fiber(std::bind(&Scheduler::idle, this)));
+  Fiber::ptr cb_fiber;
+  Fiber::State idle_state = Fiber::INIT;
+  while (true) {
+    w->active.store(true, std::memory_order_relaxed);
+    Task *task = nextTask(w);
+    if (task) {
+      dispatch(task, cb_fiber);
+      if (++w->ticks >= kTickInterval) {
+        w->ticks = 0;
+        tick();
+      }
+      continue;
+    }
+    w->ticks = 0;
+    w->active.store(false, std::memory_order_seq_cst);
+
+    if (idle_state == Fiber::TERM || idle_state == Fiber::EXCEPT) {
+      break;
+    }
+    m_idleThreadCount.fetch_add(1, std::memory_order_seq_cst);
+    idle_state = idle_fiber->resume();
+    m_idleThreadCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // 通知其他线程重新检查是否可以退出
+  for (auto &i : m_workers) {
+    if (i.get() != w && i->sleeping.exchange(0, std::memory_order_acq_rel)) {
+      tickle(i->id);
+    }
+  }
+  FiberExecutor::SetThis(nullptr);
+  t_worker_id = -1;
+  t_scheduler = nullptr;
+}
+
+void Scheduler::tickle(size_t worker) {
+  FutexWake(&m_workers[worker]->sleeping, 1);
+}
+
+bool Scheduler::stopping() {
+  if (!m_stopping.load(std::memory_order_acquire) ||
+      m_injectSize.load(std::memory_order_acquire) > 0) {
+    return false;
+  }
+  for (auto &w : m_workers) {
+    if (!w->queue.empty() || w->inboxSize.load(std::memory_order_acquire) ||
+        w->active.load(std::memory_order_acquire)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Scheduler::idle() {
+  Worker *w = m_workers[t_worker_id].get();
+  while (!stopping()) {
+    if (prepareSleep()) {
+      while (w->sleeping.load(std::memory_order_acquire) == 1) {
+        FutexWait(&w->sleeping, 1);
+      }
+    }
+    finishSleep();
+    Fiber::YieldToHold();
+  }
+}
+
+bool Scheduler::prepareSleep() {
+  Worker *w = m_workers[t_worker_id].get();
+  w->sleeping.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (hasPendingTask() || stopping()) {
+    w->sleeping.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void Scheduler::finishSleep() {
+  m_workers[t_worker_id]->sleeping.store(0, std::memory_order_relaxed);
+}
+
+bool Scheduler::hasPendingTask() const {
+  // 注入队列正被其他线程取出时不算, 持有者释放时会唤醒
+  if (m_injectSize.load(std::memory_order_acquire) > 0 &&
+      !m_injectBusy.load(std::memory_order_acquire)) {
+    return true;
+  }
+  Worker *self = t_worker_id >= 0 ? m_workers[t_worker_id].get() : nullptr;
+  if (self && self->inboxSize.load(std::memory_order_acquire) > 0) {
+    return true;
+  }
+  for (auto &w : m_workers) {
+    if (!w->queue.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::ostream &Scheduler::dump(std::ostream &os) {
+  os << "[Scheduler name=" << m_name << " size=" << m_workers.size()
+     << " idle_count=" << m_idleThreadCount.load()
+     << " inject=" << m_injectSize.load()
+     << " stopping=" << m_stopping.load() << " ]" << std::endl
+     << "    ";
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    if (i) {
+      os << ", ";
+    }
+    os << m_workers[i]->queue.size();
+  }
+  return os;
+}
+
+}  // namespace sylar
@@ -0,0 +1,255 @@
+/**
+ * @file scheduler.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 协程调度器封装
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SCHEDULER__H__
+#define __SCHEDULER__H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sylar/fiber.h"
+#include "sylar/metrics.h"
+#include "sylar/mutex.h"
+#include "sylar/noncopyable.h"
+#include "sylar/work_steal_queue.h"
+
+namespace sylar {
+
+/// @brief 协程调度器
+/// @details 封装的是N-M的协程调度器, 内部有一个线程池, 支持协程在线程池里面切换
+///          每个工作线程拥有一个Chase-Lev队列, 工作线程内提交的任务进入本线程队列,
+///          外部线程提交的任务进入全局注入队列, 空闲线程从其他线程窃取任务
+class Scheduler : public FiberExecutor, Noncopyable {
+public:
+  typedef std::shared_ptr<Scheduler> ptr;
+  typedef Mutex                      MutexType;
+
+  /// @brief 构造函数
+  /// @param threads 线程数量
+  /// @param name 调度器名称
+  /// @param cpus 绑定的CPU列表, 第i个线程绑定cpus[i % cpus.size()], 为空不绑定
+  Scheduler(size_t                  threads = 1,
+            const std::string      &name    = "",
+            const std::vector<int> &cpus    = {});
+
+  /// @brief 析构函数
+  virtual ~Scheduler();
+
+  /// @brief 返回调度器名称
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  /// @brief 返回线程数量
+  size_t getThreadCount() const {
+    return m_workers.size();
+  }
+
+  /// @brief 返回绑定的CPU列表
+  const std::vector<int> &getCpus() const {
+    return m_cpus;
+  }
+
+  /// @brief 返回当前线程所在调度器
+  static Scheduler *GetThis();
+
+  /// @brief 返回当前线程的调度协程
+  static Fiber *GetMainFiber();
+
+  /// @brief 返回当前线程在所属调度器中的序号, 非工作线程返回-1
+  static int GetWorkerId();
+
+  /// @brief 启动协程调度器
+  void start();
+
+  /// @brief 停止协程调度器, 等待已提交的任务执行完毕
+  /// @pre 不能在本调度器的工作线程中调用
+  void stop();
+
+  /// @brief 调度协程
+  /// @param fc 协程或函数
+  /// @param thread 协程执行的线程序号, -1标识任意线程
+  template <class FiberOrCb>
+  void schedule(FiberOrCb fc, int thread = -1) {
+    submit(new Task(std::move(fc), thread));
+  }
+
+  /// @brief 批量调度协程
+  /// @param begin 协程数组的开始
+  /// @param end 协程数组的结束
+  template <class InputIterator>
+  void schedule(InputIterator begin, InputIterator end) {
+    while (begin != end) {
+      submit(new Task(std::move(*begin), -1));
+      ++begin;
+    }
+  }
+
+  /// @brief 投递被唤醒的协程, 实现FiberExecutor
+  void post(Fiber::ptr fiber) override {
+    schedule(std::move(fiber));
+  }
+
+  /// @brief 输出调度器状态
+  std::ostream &dump(std::ostream &os);
+
+protected:
+  /// @brief 唤醒指定的睡眠线程
+  /// @param worker 线程序号
+  virtual void tickle(size_t worker);
+
+  /// @brief 返回是否可以停止
+  virtual bool stopping();
+
+  /// @brief 协程无任务可调度时执行idle协程
+  virtual void idle();
+
+  /// @brief 标记当前线程即将睡眠, 并再次检查是否有任务
+  /// @details 睡眠前必须调用, 返回true才可真正阻塞, 阻塞结束后调用finishSleep
+  ///          与submit中的检查构成Dekker式同步, 保证唤醒不丢失
+  /// @return 是否可以睡眠
+  bool prepareSleep();
+
+  /// @brief 当前线程睡眠结束
+  void finishSleep();
+
+  /// @brief 当前线程是否有待执行的任务(含可窃取的任务)
+  bool hasPendingTask() const;
+
+  /// @brief 是否有空闲线程
+  bool hasIdleThreads() const {
+    return m_idleThreadCount.load(std::memory_order_relaxed) > 0;
+  }
+
+  /// @brief 设置当前的协程调度器
+  void setThis();
+
+  /// @brief 唤醒一个睡眠线程
+  /// @param thread 指定线程, -1表示任意线程
+  void wakeup(int thread);
+
+  /// @brief 每执行kTickInterval个任务回调一次, 繁忙时也能及时处理IO等事件
+  virtual void tick() {
+  }
+
+  /// @brief 线程启动后, 进入调度循环前的回调
+  /// @param worker 线程序号
+  virtual void onThreadStart(size_t /*worker*/) {
+  }
+
+private:
+  /// @brief 调度任务, 协程或函数二选一
+  struct Task {
+    Task(Fiber::ptr f, int thr) : fiber(std::move(f)), thread(thr) {
+    }
+
+    Task(std::function<void()> f, int thr) : cb(std::move(f)), thread(thr) {
+    }
+
+    /// 协程
+    Fiber::ptr fiber;
+    /// 协程执行函数
+    std::function<void()> cb;
+    /// 线程序号
+    int thread;
+    /// 注入队列中的下一个任务
+    Task *next = nullptr;
+  };
+
+  /// @brief 工作线程
+  struct alignas(kCacheLineSize) Worker {
+    /// 本线程任务队列
+    WorkStealQueue<Task *> queue;
+    /// 指定在本线程执行的任务, 不可被窃取
+    Spinlock           inboxMutex;
+    std::deque<Task *> inbox;
+    std::atomic<size_t> inboxSize{0};
+    /// 是否处于(或即将进入)睡眠, 唤醒方通过CAS 1->0 获得唤醒权
+    alignas(kCacheLineSize) std::atomic<uint32_t> sleeping{0};
+    /// 是否正在执行任务
+    std::atomic<bool> active{false};
+    /// 线程序号
+    size_t id = 0;
+    /// 窃取时的随机数状态
+    uint32_t seed = 0;
+    /// 距上次tick执行的任务数
+    uint32_t ticks = 0;
+    /// 线程
+    std::thread thread;
+  };
+
+  /// @brief 提交任务并按需唤醒空闲线程
+  void submit(Task *task);
+
+  /// @brief 外部线程提交任务到注入队列, 无锁, 可多线程并发调用
+  void pushInject(Task *task);
+
+  /// @brief 从注入队列按提交顺序取出一个任务, 只能由持有m_injectBusy的线程调用
+  /// @return 队列为空时返回nullptr
+  Task *popInject();
+
+  /// @brief 获取下一个任务
+  Task *nextTask(Worker *w);
+
+  /// @brief 从其他线程窃取任务
+  Task *steal(Worker *w);
+
+  /// @brief 执行任务
+  /// @param task 任务
+  /// @param cb_fiber 复用的函数执行协程
+  void dispatch(Task *task, Fiber::ptr &cb_fiber);
+
+  /// @brief 工作线程主函数
+  void run(Worker *w);
+
+private:
+  /// 调度器名称
+  std::string m_name;
+  /// 绑定的CPU列表
+  std::vector<int> m_cpus;
+  /// 工作线程
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  /// Mutex, 保护启动
+  MutexType m_mutex;
+  /// 全局注入队列, 接收外部线程提交的任务. 侵入式多生产者单消费者:
+  /// 生产者CAS压入m_injectHead(后进先出), 消费者持有m_injectBusy时
+  /// 在m_injectList(先进先出)取空后一次取走整个栈并反转
+  alignas(kCacheLineSize) std::atomic<Task *> m_injectHead{nullptr};
+  alignas(kCacheLineSize) Task *m_injectList = nullptr;
+  std::atomic<bool>   m_injectBusy{false};
+  std::atomic<size_t> m_injectSize{0};
+  /// 空闲线程数量
+  std::atomic<size_t> m_idleThreadCount{0};
+  /// 唤醒时的起始扫描位置
+  std::atomic<size_t> m_wakeCursor{0};
+  /// 是否正在停止
+  std::atomic<bool> m_stopping{true};
+  /// 是否已启动
+  bool m_started = false;
+  /// 执行的任务数
+  Counter::ptr m_taskCount;
+  /// 窃取到的任务数
+  Counter::ptr m_stealCount;
+  /// 任务单次执行时间, 按比例采样
+  Histogram::ptr m_dispatchTime;
+};
+
+}  // namespace sylar
+
+#endif /* __SCHEDULER__H__ */
@@ -0,0 +1,104 @@
+#include "sylar/stack_allocator.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace sylar {
+
+namespace {
+
+/// 每次映射的内存块大小
+static constexpr size_t kChunkBytes = 4 * 1024 * 1024;
+
+/// 读取vm.max_map_count, 用于估算保护页预算
+size_t GetMaxMapCount() {
+  size_t count = 65530;
+  FILE  *fp    = fopen("/proc/sys/vm/max_map_count", "r");
+  if (fp) {
+    unsigned long v = 0;
+    if (fscanf(fp, "%lu", &v) == 1 && v > 0) {
+      count = v;
+    }
+    fclose(fp);
+  }
+  return count;
+}
+
+}  // namespace
+
+StackAllocator::StackAllocator() {
+  m_pageSize = sysconf(_SC_PAGESIZE);
+  // 每个保护页最多使VMA增加2个, 只使用上限的一半, 留给堆/线程栈/文件映射
+  m_guardBudget = GetMaxMapCount() / 4;
+}
+
+StackAllocator::~StackAllocator() {
+  for (auto &i : m_chunks) {
+    munmap(i.first, i.second);
+  }
+}
+
+FiberStack StackAllocator::alloc(size_t size) {
+  size = (size + m_pageSize - 1) & ~(m_pageSize - 1);
+  FiberStack stack;
+  {
+    Spinlock::Lock lock(m_mutex);
+    auto          &freelist = m_freelists[size];
+    if (freelist.empty()) {
+      refill(size, freelist);
+    }
+    stack = freelist.back();
+    freelist.pop_back();
+  }
+  m_inUse.fetch_add(1, std::memory_order_relaxed);
+  return stack;
+}
+
+void StackAllocator::dealloc(const FiberStack &stack) {
+  if (!stack.base) {
+    return;
+  }
+  m_inUse.fetch_sub(1, std::memory_order_relaxed);
+  Spinlock::Lock lock(m_mutex);
+  m_freelists[stack.size].push_back(stack);
+}
+
+void StackAllocator::refill(size_t size, std::vector<FiberStack> &freelist) {
+  size_t slot  = size + m_pageSize;
+  size_t count = kChunkBytes / slot;
+  if (count == 0) {
+    count = 1;
+  }
+  size_t len = slot * count;
+  void  *mem = mmap(nullptr,
+                   len,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                   -1,
+                   0);
+  if (mem == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  m_chunks.emplace_back(mem, len);
+  m_mappedBytes.fetch_add(len, std::memory_order_relaxed);
+
+  freelist.reserve(freelist.size() + count);
+  // 逆序放入, 使地址低的栈先被分配
+  for (size_t i = count; i > 0; --i) {
+    char      *slot_base = static_cast<char *>(mem) + (i - 1) * slot;
+    FiberStack stack;
+    stack.base = slot_base + m_pageSize;
+    stack.size = size;
+    if (m_guarded < m_guardBudget &&
+        mprotect(slot_base, m_pageSize, PROT_NONE) == 0) {
+      stack.guarded = true;
+      ++m_guarded;
+    }
+    freelist.push_back(stack);
+  }
+}
+
+}  // namespace sylar
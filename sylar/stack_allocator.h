@@ -0,0 +1,104 @@
+/**
+ * @file stack_allocator.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 协程栈池化分配器
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __STACK_ALLOCATOR__H__
+#define __STACK_ALLOCATOR__H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include "sylar/mutex.h"
+#include "sylar/noncopyable.h"
+#include "sylar/singleton.h"
+
+namespace sylar {
+
+/// @brief 协程栈
+struct FiberStack {
+  /// 栈底(低地址), 可用区域为[base, base + size)
+  void *base = nullptr;
+  /// 可用大小
+  size_t size = 0;
+  /// 是否带保护页
+  bool guarded = false;
+
+  /// @brief 栈顶(高地址)
+  void *top() const {
+    return static_cast<char *>(base) + size;
+  }
+};
+
+/// @brief 协程栈分配器
+/// @details 按大小分类池化, 栈从大块mmap内存中切分, 归还后复用而不munmap
+///          每个栈的低地址端可带一页PROT_NONE保护页, 栈溢出时直接SIGSEGV
+///          保护页会拆分VMA, 受vm.max_map_count限制, 超出预算后的栈不再带保护页
+class StackAllocator : Noncopyable {
+public:
+  /// @brief 构造函数
+  StackAllocator();
+
+  /// @brief 析构函数, 释放全部映射
+  ~StackAllocator();
+
+  /// @brief 分配栈
+  /// @param size 栈大小, 会向上取整到页大小
+  /// @return 协程栈
+  FiberStack alloc(size_t size);
+
+  /// @brief 归还栈到池中
+  /// @param stack 协程栈
+  void dealloc(const FiberStack &stack);
+
+  /// @brief 已映射的总字节数(含保护页)
+  size_t getMappedBytes() const {
+    return m_mappedBytes.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 当前正在使用的栈数量
+  size_t getInUse() const {
+    return m_inUse.load(std::memory_order_relaxed);
+  }
+
+private:
+  /// @brief 从新映射的内存块中切分一批栈到空闲链表
+  /// @param size 栈大小(已按页对齐)
+  /// @param freelist 对应大小的空闲链表
+  void refill(size_t size, std::vector<FiberStack> &freelist);
+
+private:
+  /// 页大小
+  size_t m_pageSize;
+  /// 允许带保护页的栈数量上限
+  size_t m_guardBudget;
+  /// 已带保护页的栈数量
+  size_t m_guarded = 0;
+  /// 按大小分类的空闲栈
+  std::unordered_map<size_t, std::vector<FiberStack>> m_freelists;
+  /// 所有映射的内存块(地址, 长度)
+  std::vector<std::pair<void *, size_t>> m_chunks;
+  /// 保护m_freelists/m_chunks
+  Spinlock m_mutex;
+  /// 已映射的总字节数
+  std::atomic<size_t> m_mappedBytes{0};
+  /// 使用中的栈数量
+  std::atomic<size_t> m_inUse{0};
+};
+
+/// 协程栈分配器单例
+typedef sylar::Singleton<StackAllocator> StackAllocatorMgr;
+
+}  // namespace sylar
+
+#endif /* __STACK_ALLOCATOR__H__ */
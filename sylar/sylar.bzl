@@ -851,3 +851,53 @@ def tafpb_proto_library(
         gen_pbcc = gen_pbcc,
         **kargs
     )
+
+def sylar_orm_library(
+        name,
+        srcs = [],
+        deps = [],
+        rootpath = "",
+        orm_gen = None,
+        **kargs):
+    """Bazel rule to create a C++ library from ORM table descriptions
+
+    Each `<base>.xml` in srcs produces `<base>_info.h` and `<base>_info.cc`
+    (a data class and its DAO) in the package's genfiles directory; include
+    them as "<package>/<base>_info.h".
+
+    Args:
+      name: the name of the cc_library.
+      srcs: the table description files (.xml), one table per file.
+      deps: other cc_library targets depended by the generated cc_library.
+      orm_gen: the label of the code generator.
+      **kargs: other keyword arguments that are passed to cc_library.
+    """
+    if orm_gen == None:
+        orm_gen = "%s//sylar/tools/orm_gen:orm_gen" % rootpath
+    gen_hdrs = []
+    gen_srcs = []
+    for src in srcs:
+        if not src.endswith(".xml"):
+            fail("sylar_orm_library srcs must be .xml files: %s" % src, "srcs")
+        base = src.split("/")[-1][:-len(".xml")]
+        gen_hdrs.append(base + "_info.h")
+        gen_srcs.append(base + "_info.cc")
+
+    native.genrule(
+        name = name + "_genorm",
+        srcs = srcs,
+        outs = gen_hdrs + gen_srcs,
+        tools = [orm_gen],
+        cmd = "$(location %s) --out_dir=$(@D) --include_prefix=%s $(SRCS)" % (
+            orm_gen,
+            native.package_name(),
+        ),
+    )
+
+    native.cc_library(
+        name = name,
+        srcs = gen_srcs,
+        hdrs = gen_hdrs,
+        deps = deps + ["%s//sylar:db" % rootpath],
+        **kargs
+    )
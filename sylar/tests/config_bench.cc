@@ -0,0 +1,145 @@
+/**
+ * @file config_bench.cc
+ * @brief 配置读取性能测试: 更新线程持续修改配置时读取线程的单次读取耗时
+ * @details 用法: config_bench [读取线程数] [每线程读取次数]
+ *          对比读写锁保护的读取, ConfigVar::getValue(原子读/线程局部快照) 与
+ *          ConfigVar::getSnapshot(atomic<shared_ptr>快照), ConfigVar::Cached
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sylar/config.h"
+#include "sylar/mutex.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  size_t threads = 4;
+  size_t reads   = 5000000;
+};
+
+auto g_timeout = sylar::Config::Lookup<uint64_t>(
+    "bench.timeout", 1000, "bench timeout");
+auto g_hosts = sylar::Config::Lookup(
+    "bench.hosts", std::map<std::string, int>{{"a", 1}}, "bench hosts");
+
+/// @brief 读取线程执行fn opt.reads次, 同时更新线程每毫秒调用一次update
+template <class Fn, class Update>
+double Run(const Options &opt, Fn fn, Update update) {
+  std::atomic<bool>        stop{false};
+  std::atomic<uint64_t>    total{0};
+  std::vector<std::thread> threads;
+  std::thread              writer([&]() {
+    for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+      update(i);
+      usleep(1000);
+    }
+  });
+  for (size_t t = 0; t < opt.threads; ++t) {
+    threads.emplace_back([&]() {
+      uint64_t sum   = 0;
+      uint64_t begin = NowNs();
+      for (size_t i = 0; i < opt.reads; ++i) {
+        sum += fn();
+      }
+      total.fetch_add(NowNs() - begin);
+      if (sum == 42) {
+        printf("\n");
+      }
+    });
+  }
+  for (auto &i : threads) {
+    i.join();
+  }
+  stop = true;
+  writer.join();
+  return double(total) / (opt.threads * opt.reads);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.threads = strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    opt.reads = strtoul(argv[2], nullptr, 10);
+  }
+  printf("threads=%lu reads=%lu\n",
+         (unsigned long)opt.threads,
+         (unsigned long)opt.reads);
+
+  {
+    sylar::RWMutex             mutex;
+    std::map<std::string, int> hosts{{"a", 1}};
+    double                     ns = Run(
+        opt,
+        [&]() {
+          sylar::RWMutex::ReadLock lock(mutex);
+          return hosts.size();
+        },
+        [&](uint64_t i) {
+          sylar::RWMutex::WriteLock lock(mutex);
+          hosts["a"] = int(i);
+        });
+    printf("%-16s %8.2f ns/read\n", "rwmutex_map", ns);
+  }
+  {
+    double ns = Run(
+        opt,
+        []() { return g_timeout->getValue(); },
+        [](uint64_t i) { g_timeout->setValue(1000 + i % 2); });
+    printf("%-16s %8.2f ns/read\n", "getValue", ns);
+  }
+  {
+    double ns = Run(
+        opt,
+        []() { return g_hosts->getSnapshot()->size(); },
+        [](uint64_t i) {
+          std::map<std::string, int> hosts{{"a", int(i)}};
+          g_hosts->setValue(hosts);
+        });
+    printf("%-16s %8.2f ns/read\n", "getSnapshot_map", ns);
+  }
+  {
+    double ns = Run(
+        opt,
+        []() { return g_hosts->getValue().size(); },
+        [](uint64_t i) {
+          std::map<std::string, int> hosts{{"a", int(i)}};
+          g_hosts->setValue(hosts);
+        });
+    printf("%-16s %8.2f ns/read\n", "getValue_map", ns);
+  }
+  {
+    double ns = Run(
+        opt,
+        []() {
+          static thread_local sylar::ConfigVar<
+              std::map<std::string, int> >::Cached t_hosts(g_hosts);
+          return t_hosts.get().size();
+        },
+        [](uint64_t i) {
+          std::map<std::string, int> hosts{{"a", int(i)}};
+          g_hosts->setValue(hosts);
+        });
+    printf("%-16s %8.2f ns/read\n", "cached_map", ns);
+  }
+  return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file echo_bench.cc
+ * @brief IOManager回环echo性能测试: 吞吐与p50/p99往返延迟
+ * @details 用法: echo_bench [线程数] [连接数] [每连接消息数] [消息大小]
+ *          分别使用epoll与io_uring后端, io_uring额外测试固定缓冲区读写
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  size_t threads     = 4;
+  size_t connections = 64;
+  size_t messages    = 10000;
+  size_t size        = 64;
+};
+
+/// @brief 一个连接的读写方式
+class Conn {
+public:
+  Conn(sylar::IOManager *iom, int fd, bool fixed, size_t size)
+      : m_iom(iom), m_fd(fd) {
+    if (fixed) {
+      m_fixed = iom->acquireBuffer();
+    }
+    if (!m_fixed) {
+      m_buf.resize(size);
+    }
+  }
+
+  ~Conn() {
+    if (m_fixed) {
+      m_iom->releaseBuffer(m_fixed);
+    }
+    m_iom->close(m_fd);
+  }
+
+  char *data() {
+    return m_fixed ? (char *)m_fixed->data : &m_buf[0];
+  }
+
+  ssize_t read(size_t len) {
+    return m_fixed ? m_iom->readFixed(m_fd, m_fixed, len)
+                   : m_iom->recv(m_fd, data(), len);
+  }
+
+  /// @brief 读满len字节
+  bool readAll(size_t len) {
+    size_t off = 0;
+    while (off < len) {
+      ssize_t n = m_fixed ? m_iom->readFixed(m_fd, m_fixed, len - off)
+                          : m_iom->recv(m_fd, data() + off, len - off);
+      if (n <= 0) {
+        return false;
+      }
+      off += n;
+    }
+    return true;
+  }
+
+  /// @brief 写满len字节
+  bool writeAll(size_t len) {
+    size_t off = 0;
+    while (off < len) {
+      ssize_t n = m_fixed ? m_iom->writeFixed(m_fd, m_fixed, len - off)
+                          : m_iom->send(m_fd, data() + off, len - off);
+      if (n <= 0) {
+        return false;
+      }
+      off += n;
+    }
+    return true;
+  }
+
+private:
+  sylar::IOManager   *m_iom;
+  int                 m_fd;
+  sylar::FixedBuffer *m_fixed = nullptr;
+  std::vector<char>   m_buf;
+};
+
+struct Result {
+  double   kmsgs = 0;
+  uint64_t p50   = 0;
+  uint64_t p99   = 0;
+  size_t   errors = 0;
+};
+
+Result Run(sylar::IOManager::Backend backend, bool fixed, const Options &opt) {
+  sylar::IOManager iom(opt.threads, "echo", backend);
+  iom.start();
+
+  int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  int on        = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len        = sizeof(addr);
+  if (bind(listen_fd, (sockaddr *)&addr, len) || listen(listen_fd, 1024) ||
+      getsockname(listen_fd, (sockaddr *)&addr, &len)) {
+    perror("listen");
+    exit(1);
+  }
+
+  std::vector<std::vector<uint64_t> > latency(opt.connections);
+  std::atomic<size_t>                 errors{0};
+  std::atomic<size_t>                 done{0};
+  sylar::Semaphore                    finish;
+
+  // 服务端: 接收固定数量的连接, 每个连接一个echo协程
+  iom.schedule([&]() {
+    for (size_t i = 0; i < opt.connections; ++i) {
+      int fd = iom.accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) {
+        ++errors;
+        continue;
+      }
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      iom.schedule([&, fd]() {
+        Conn conn(&iom, fd, fixed, opt.size);
+        while (true) {
+          ssize_t n = conn.read(opt.size);
+          if (n <= 0 || !conn.writeAll(n)) {
+            break;
+          }
+        }
+      });
+    }
+    iom.close(listen_fd);
+  });
+
+  uint64_t begin = NowNs();
+  for (size_t i = 0; i < opt.connections; ++i) {
+    iom.schedule([&, i]() {
+      int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      if (iom.connect(fd, (sockaddr *)&addr, sizeof(addr), 3000) == 0) {
+        Conn conn(&iom, fd, fixed, opt.size);
+        memset(conn.data(), 'x', opt.size);
+        latency[i].reserve(opt.messages);
+        for (size_t m = 0; m < opt.messages; ++m) {
+          uint64_t t0 = NowNs();
+          if (!conn.writeAll(opt.size) || !conn.readAll(opt.size)) {
+            ++errors;
+            break;
+          }
+          latency[i].push_back(NowNs() - t0);
+        }
+      } else {
+        ++errors;
+        iom.close(fd);
+      }
+      if (done.fetch_add(1) + 1 == opt.connections) {
+        finish.notify();
+      }
+    });
+  }
+  finish.wait();
+  uint64_t end = NowNs();
+  iom.stop();
+
+  std::vector<uint64_t> all;
+  for (auto &i : latency) {
+    all.insert(all.end(), i.begin(), i.end());
+  }
+  Result r;
+  r.errors = errors;
+  if (!all.empty()) {
+    std::sort(all.begin(), all.end());
+    r.kmsgs = double(all.size()) * 1e6 / (end - begin);
+    r.p50   = all[all.size() / 2];
+    r.p99   = all[all.size() * 99 / 100];
+  }
+  return r;
+}
+
+void Print(const char *name, const Result &r) {
+  printf("%-16s %10.1f Kmsg/s  p50 %8lu ns  p99 %8lu ns  errors %lu\n",
+         name,
+         r.kmsgs,
+         (unsigned long)r.p50,
+         (unsigned long)r.p99,
+         (unsigned long)r.errors);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.threads = strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    opt.connections = strtoul(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    opt.messages = strtoul(argv[3], nullptr, 10);
+  }
+  if (argc > 4) {
+    opt.size = strtoul(argv[4], nullptr, 10);
+  }
+  printf("threads=%lu connections=%lu messages=%lu size=%lu\n",
+         (unsigned long)opt.threads,
+         (unsigned long)opt.connections,
+         (unsigned long)opt.messages,
+         (unsigned long)opt.size);
+
+  Print("epoll", Run(sylar::IOManager::EPOLL, false, opt));
+  {
+    sylar::IOManager probe(1, "probe", sylar::IOManager::IO_URING);
+    if (probe.getBackend() != sylar::IOManager::IO_URING) {
+      printf("io_uring unavailable\n");
+      return 0;
+    }
+  }
+  Print("io_uring", Run(sylar::IOManager::IO_URING, false, opt));
+  Print("io_uring_fixed", Run(sylar::IOManager::IO_URING, true, opt));
+  return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file fiber_bench.cc
+ * @brief 协程性能测试: 切换延迟与单协程内存占用
+ * @details 用法: fiber_bench [切换次数] [协程数量]
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "sylar/fiber.h"
+#include "sylar/stack_allocator.h"
+
+namespace {
+
+/// 单线程执行者, 用于驱动FiberSemaphore唤醒的协程
+class LoopExecutor : public sylar::FiberExecutor {
+public:
+  void post(sylar::Fiber::ptr fiber) override {
+    m_ready.push_back(std::move(fiber));
+  }
+
+  void run() {
+    while (!m_ready.empty()) {
+      sylar::Fiber::ptr fiber = std::move(m_ready.front());
+      m_ready.pop_front();
+      fiber->resume();
+    }
+  }
+
+private:
+  std::deque<sylar::Fiber::ptr> m_ready;
+};
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/// 进程常驻内存(字节)
+size_t GetRss() {
+  size_t pages = 0;
+  FILE  *fp    = fopen("/proc/self/statm", "r");
+  if (fp) {
+    unsigned long size = 0, rss = 0;
+    if (fscanf(fp, "%lu %lu", &size, &rss) == 2) {
+      pages = rss;
+    }
+    fclose(fp);
+  }
+  return pages * sysconf(_SC_PAGESIZE);
+}
+
+void BenchSwitch(uint64_t count) {
+  sylar::Fiber::ptr fiber(new sylar::Fiber([count]() {
+    for (uint64_t i = 0; i < count; ++i) {
+      sylar::Fiber::YieldToHold();
+    }
+  }));
+
+  uint64_t begin = NowNs();
+  while (fiber->getState() != sylar::Fiber::TERM) {
+    fiber->resume();
+  }
+  uint64_t end = NowNs();
+  // 每次resume + yield 为两次切换
+  printf("resume/yield: %lu round trips, %.1f ns/switch\n",
+         (unsigned long)count,
+         double(end - begin) / (count * 2));
+}
+
+void BenchSemaphore(uint64_t count) {
+  LoopExecutor executor;
+  sylar::FiberExecutor::SetThis(&executor);
+
+  sylar::FiberSemaphore ping;
+  sylar::FiberSemaphore pong;
+  sylar::Fiber::ptr     a(new sylar::Fiber([&]() {
+    for (uint64_t i = 0; i < count; ++i) {
+      ping.notify();
+      pong.wait();
+    }
+  }));
+  sylar::Fiber::ptr     b(new sylar::Fiber([&]() {
+    for (uint64_t i = 0; i < count; ++i) {
+      ping.wait();
+      pong.notify();
+    }
+  }));
+
+  uint64_t begin = NowNs();
+  executor.post(a);
+  executor.post(b);
+  executor.run();
+  uint64_t end = NowNs();
+  printf("FiberSemaphore ping-pong: %lu round trips, %.1f ns/round trip\n",
+         (unsigned long)count,
+         double(end - begin) / count);
+  sylar::FiberExecutor::SetThis(nullptr);
+}
+
+void BenchMemory(size_t count) {
+  auto   allocator  = sylar::StackAllocatorMgr::GetInstance();
+  size_t rss_begin  = GetRss();
+  size_t map_begin  = allocator->getMappedBytes();
+  auto   heap_begin = mallinfo2().uordblks;
+
+  std::vector<sylar::Fiber::ptr> fibers;
+  fibers.reserve(count);
+  uint64_t begin = NowNs();
+  for (size_t i = 0; i < count; ++i) {
+    fibers.emplace_back(new sylar::Fiber([]() {
+      // 模拟一次连接处理所需的少量栈空间
+      char buf[512];
+      memset(buf, 0, sizeof(buf));
+      sylar::Fiber::YieldToHold();
+      asm volatile("" : : "r"(buf) : "memory");
+    }));
+    fibers.back()->resume();
+  }
+  uint64_t end = NowNs();
+
+  size_t rss  = GetRss() - rss_begin;
+  size_t map  = allocator->getMappedBytes() - map_begin;
+  size_t heap = mallinfo2().uordblks - heap_begin;
+  printf("%lu suspended fibers (stack %lu KB): create+first resume %.1f ns, "
+         "rss %.1f KB/fiber, heap %.1f B/fiber, mapped %.1f KB/fiber\n",
+         (unsigned long)count,
+         (unsigned long)(sylar::Fiber::GetDefaultStackSize() / 1024),
+         double(end - begin) / count,
+         double(rss) / count / 1024,
+         double(heap) / count,
+         double(map) / count / 1024);
+
+  for (auto &i : fibers) {
+    i->resume();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t switches = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+  size_t   fibers   = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+
+  sylar::Fiber::GetThis();
+  BenchSwitch(switches);
+  BenchSemaphore(switches / 10);
+  BenchMemory(fibers);
+  return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file log_bench.cc
+ * @brief 异步日志性能测试: 单次调用耗时, p99, 写出吞吐
+ * @details 用法: log_bench [线程数] [每线程日志条数] [日志文件]
+ *          对比同步写文件(互斥锁+write)与异步日志的drop/block策略,
+ *          并测试被过滤级别的调用开销
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "sylar/log.h"
+#include "sylar/mutex.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  size_t      threads  = 4;
+  size_t      messages = 200000;
+  std::string file     = "/tmp/sylar_log_bench.log";
+};
+
+struct Result {
+  double   ns_per_call = 0;
+  uint64_t p99         = 0;
+  double   mbps        = 0;
+  uint64_t dropped     = 0;
+};
+
+uint64_t FileSize(const std::string &file) {
+  struct stat st;
+  return stat(file.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+/// @brief 每个线程写入opt.messages条日志, 每64条采样一次单次耗时
+/// @param fn 写一条日志, 参数为序号
+template <class Fn>
+Result Run(const Options &opt, Fn fn, std::function<void()> finish) {
+  std::vector<std::vector<uint64_t> > samples(opt.threads);
+  std::vector<uint64_t>               busy(opt.threads);
+  std::vector<std::thread>            threads;
+
+  uint64_t begin = NowNs();
+  for (size_t t = 0; t < opt.threads; ++t) {
+    threads.emplace_back([&, t]() {
+      samples[t].reserve(opt.messages / 64 + 1);
+      uint64_t start = NowNs();
+      for (size_t i = 0; i < opt.messages; ++i) {
+        if (i % 64 == 0) {
+          uint64_t t0 = NowNs();
+          fn(i);
+          samples[t].push_back(NowNs() - t0);
+        } else {
+          fn(i);
+        }
+      }
+      busy[t] = NowNs() - start;
+    });
+  }
+  for (auto &i : threads) {
+    i.join();
+  }
+  finish();
+  uint64_t end = NowNs();
+
+  Result                r;
+  std::vector<uint64_t> all;
+  uint64_t              total = 0;
+  for (size_t t = 0; t < opt.threads; ++t) {
+    all.insert(all.end(), samples[t].begin(), samples[t].end());
+    total += busy[t];
+  }
+  std::sort(all.begin(), all.end());
+  r.ns_per_call = double(total) / (opt.threads * opt.messages);
+  r.p99         = all.empty() ? 0 : all[all.size() * 99 / 100];
+  r.mbps        = double(FileSize(opt.file)) * 1e3 / (end - begin);
+  return r;
+}
+
+void Print(const char *name, const Result &r) {
+  printf("%-12s %8.1f ns/call  p99 %8lu ns  %8.1f MB/s  dropped %lu\n",
+         name,
+         r.ns_per_call,
+         (unsigned long)r.p99,
+         r.mbps,
+         (unsigned long)r.dropped);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.threads = strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    opt.messages = strtoul(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    opt.file = argv[3];
+  }
+  printf("threads=%lu messages=%lu file=%s\n",
+         (unsigned long)opt.threads,
+         (unsigned long)opt.messages,
+         opt.file.c_str());
+
+  sylar::LoggerManager *mgr    = sylar::LoggerMgr::GetInstance();
+  sylar::Logger::ptr    logger = mgr->getLogger("bench");
+  logger->setLevel(sylar::LogLevel::INFO);
+  sylar::LogFormatter formatter;
+
+  // 同步写文件: 调用线程格式化并在锁内write
+  {
+    unlink(opt.file.c_str());
+    int fd = open(opt.file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    sylar::Mutex mutex;
+    Result       r = Run(
+        opt,
+        [&](size_t i) {
+          std::string msg =
+              fmt::format("bench message {} value {:.3f}", i, i * 0.5);
+          sylar::LogEvent event;
+          event.logger  = logger.get();
+          event.level   = sylar::LogLevel::INFO;
+          event.time    = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+          event.file    = __FILE__;
+          event.line    = __LINE__;
+          event.message = msg;
+          fmt::memory_buffer buf;
+          sylar::Mutex::Lock lock(mutex);
+          formatter.format(buf, event);
+          if (::write(fd, buf.data(), buf.size()) < 0) {
+            perror("write");
+          }
+        },
+        []() {});
+    close(fd);
+    Print("sync", r);
+  }
+
+  const struct {
+    const char                       *name;
+    sylar::LoggerManager::FullPolicy policy;
+  } policies[] = {
+      {"async_drop", sylar::LoggerManager::DROP},
+      {"async_block", sylar::LoggerManager::BLOCK},
+  };
+  for (auto &p : policies) {
+    unlink(opt.file.c_str());
+    logger->clearAppenders();
+    logger->addAppender(
+        sylar::LogAppender::ptr(new sylar::FileLogAppender(opt.file)));
+    mgr->setFullPolicy(p.policy);
+    uint64_t dropped = mgr->getDropped();
+    Result   r       = Run(
+        opt,
+        [&](size_t i) {
+          SYLAR_LOG_FMT_INFO(
+              logger, "bench message {} value {:.3f}", i, i * 0.5);
+        },
+        [&]() { mgr->flush(); });
+    r.dropped = mgr->getDropped() - dropped;
+    Print(p.name, r);
+  }
+
+  // 被过滤级别: 只有级别比较, 参数不求值
+  {
+    uint64_t begin = NowNs();
+    for (size_t i = 0; i < opt.messages; ++i) {
+      SYLAR_LOG_FMT_DEBUG(
+          logger, "bench message {} value {:.3f}", i, i * 0.5);
+    }
+    printf("%-12s %8.1f ns/call\n",
+           "disabled",
+           double(NowNs() - begin) / opt.messages);
+  }
+
+  logger->clearAppenders();
+  unlink(opt.file.c_str());
+  return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file metrics_bench.cc
+ * @brief 指标统计性能测试: 单次记录开销, 多线程扩展性与抓取耗时
+ * @details 用法: metrics_bench [线程数] [每线程次数]
+ *          与共享的std::atomic对比, 并校验线程退出后计数不丢失与分位数误差
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "sylar/metrics.h"
+#include "sylar/mutex.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  size_t threads = 4;
+  size_t ops     = 10000000;
+};
+
+/// @brief threads个线程各执行fn(ops), 返回全部线程合计的每秒百万次操作数
+double RunThreads(size_t threads, size_t ops, std::function<void(size_t)> fn) {
+  std::vector<std::thread> ts;
+  uint64_t                 begin = NowNs();
+  for (size_t i = 0; i < threads; ++i) {
+    ts.emplace_back([&fn, ops]() { fn(ops); });
+  }
+  for (auto &t : ts) {
+    t.join();
+  }
+  return threads * ops * 1e3 / (NowNs() - begin);
+}
+
+void Report(const char *name, size_t threads, double mops) {
+  printf("%-22s threads %2lu  %8.1f Mops/s  %6.2f ns/op\n",
+         name,
+         (unsigned long)threads,
+         mops,
+         1e3 / mops);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.threads = strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    opt.ops = strtoul(argv[2], nullptr, 10);
+  }
+  printf("threads=%lu ops=%lu\n",
+         (unsigned long)opt.threads,
+         (unsigned long)opt.ops);
+
+  sylar::MetricsRegistry *registry = sylar::MetricsRegistry::GetInstance();
+  sylar::Counter::ptr     counter  = registry->counter("bench_total", "bench");
+  sylar::Histogram::ptr   hist     = registry->histogram("bench_ns", "bench");
+  std::atomic<uint64_t>   shared{0};
+  int                     rt = 0;
+
+  for (size_t threads : {size_t(1), opt.threads}) {
+    double mops = RunThreads(threads, opt.ops, [&](size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        shared.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+    Report("atomic fetch_add", threads, mops);
+
+    mops = RunThreads(threads, opt.ops, [&](size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        counter->inc();
+      }
+    });
+    Report("Counter::inc", threads, mops);
+
+    mops = RunThreads(threads, opt.ops, [&](size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        hist->record(i & 0xffff);
+      }
+    });
+    Report("Histogram::record", threads, mops);
+
+    mops = RunThreads(threads, opt.ops / 10, [&](size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        sylar::ScopedTimer timer(hist.get());
+      }
+    });
+    Report("ScopedTimer", threads, mops);
+  }
+
+  // 线程均已退出, 值由注册表合并保留
+  uint64_t expect = opt.ops * (1 + opt.threads);
+  if (counter->value() != expect) {
+    fprintf(stderr,
+            "counter %lu != %lu\n",
+            (unsigned long)counter->value(),
+            (unsigned long)expect);
+    rt = 1;
+  }
+
+  // 分位数误差不超过一个子桶
+  sylar::Histogram::ptr uniform = registry->histogram("uniform_ns", "bench");
+  for (uint64_t i = 1; i <= 1000000; ++i) {
+    uniform->record(i);
+  }
+  sylar::Histogram::Snapshot snapshot = uniform->snapshot();
+  double                     p50      = snapshot.quantile(0.5) / 500000.0;
+  double                     p99      = snapshot.quantile(0.99) / 990000.0;
+  printf("uniform 1..1e6         p50 x%.3f  p99 x%.3f  mean %.0f\n",
+         p50,
+         p99,
+         snapshot.mean());
+  if (p50 < 1 || p50 > 1.125 || p99 < 1 || p99 > 1.125) {
+    fprintf(stderr, "quantile out of range\n");
+    rt = 1;
+  }
+
+  // 竞争的锁记录等待时间
+  sylar::Mutex mutex;
+  uint64_t     value = 0;
+  RunThreads(opt.threads, opt.ops / 10, [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      sylar::Mutex::Lock lock(mutex);
+      ++value;
+    }
+  });
+  sylar::Histogram::Snapshot wait =
+      registry
+          ->histogram("sylar_lock_wait_seconds",
+                      "time spent waiting for contended locks",
+                      {{"type", "mutex"}})
+          ->snapshot();
+  printf("mutex wait             count %lu  p50 %lu ns  p99 %lu ns\n",
+         (unsigned long)wait.count,
+         (unsigned long)wait.quantile(0.5),
+         (unsigned long)wait.quantile(0.99));
+
+  // 抓取: 合并全部指标
+  uint64_t begin = NowNs();
+  for (auto &m : registry->getMetrics()) {
+    if (m->getType() == sylar::Metric::HISTOGRAM) {
+      static_cast<sylar::Histogram &>(*m).snapshot();
+    }
+  }
+  printf("scrape                 %lu metrics  %.1f us\n",
+         (unsigned long)registry->getMetrics().size(),
+         (NowNs() - begin) / 1000.0);
+  return rt;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file metrics_test.cc
+ * @brief /metrics导出的单元测试
+ * @details 通过配置metrics.address启动MetricsServer, 抓取一次/metrics,
+ *          检查直方图的桶边界, 累计计数与_count/_sum
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "sylar/config.h"
+#include "sylar/metrics.h"
+#include "sylar/metrics_exporter.h"
+
+namespace {
+
+using sylar::Config;
+using sylar::Histogram;
+using sylar::MetricsRegistry;
+using sylar::MetricsServerMgr;
+
+/// @brief 以HTTP/1.0请求path, 返回响应体, 失败返回空串
+std::string HttpGet(int port, const std::string &path) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return "";
+  }
+  sockaddr_in addr{};
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  std::string rsp;
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0) {
+    std::string req = "GET " + path + " HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n";
+    if (write(fd, req.data(), req.size()) == (ssize_t)req.size()) {
+      char buf[4096];
+      while (true) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+          break;
+        }
+        rsp.append(buf, n);
+      }
+    }
+  }
+  close(fd);
+
+  size_t pos = rsp.find("\r\n\r\n");
+  if (rsp.compare(0, 9, "HTTP/1.1 ") != 0 &&
+      rsp.compare(0, 9, "HTTP/1.0 ") != 0) {
+    return "";
+  }
+  if (rsp.compare(9, 3, "200") != 0 || pos == std::string::npos) {
+    return "";
+  }
+  return rsp.substr(pos + 4);
+}
+
+/// @brief 一个直方图序列的抓取结果
+struct Scraped {
+  /// le -> 累计计数
+  std::map<double, uint64_t> buckets;
+  uint64_t                   count = 0;
+  double                     sum   = 0;
+  bool                       found = false;
+};
+
+/// @brief 从文本格式中取出name{label}的直方图
+Scraped ParseHistogram(const std::string &body,
+                       const std::string &name,
+                       const std::string &label) {
+  Scraped            rt;
+  std::istringstream in(body);
+  std::string        line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#' ||
+        line.find(label) == std::string::npos) {
+      continue;
+    }
+    size_t sp = line.rfind(' ');
+    if (sp == std::string::npos) {
+      continue;
+    }
+    double value = strtod(line.c_str() + sp + 1, nullptr);
+    if (line.compare(0, name.size() + 7, name + "_count{") == 0) {
+      rt.count = value;
+      rt.found = true;
+    } else if (line.compare(0, name.size() + 5, name + "_sum{") == 0) {
+      rt.sum = value;
+    } else if (line.compare(0, name.size() + 8, name + "_bucket{") == 0) {
+      size_t le = line.find("le=\"");
+      if (le == std::string::npos) {
+        continue;
+      }
+      // strtod也能解析"+Inf"
+      rt.buckets[strtod(line.c_str() + le + 4, nullptr)] = value;
+    }
+  }
+  return rt;
+}
+
+/// @brief 是否有边界le, 文本格式的小数与计算出的边界可能差几个ulp
+bool HasBound(const Scraped &s, double le) {
+  auto it = s.buckets.lower_bound(le * (1 - 1e-12));
+  return it != s.buckets.end() && it->first <= le * (1 + 1e-12);
+}
+
+TEST(MetricsExporterTest, ScrapeHistogramBuckets) {
+  Histogram::ptr hist = MetricsRegistry::GetInstance()->histogram(
+      "sylar_test_scrape_seconds", "scrape test", {{"case", "buckets"}});
+  // 纳秒, 都不在导出的桶边界上
+  const uint64_t values[] = {100, 1000, 1000, 1000000};
+  for (uint64_t v : values) {
+    hist->record(v);
+  }
+
+  Config::LoadFromYaml(YAML::Load("metrics:\n  address: 127.0.0.1:0\n"));
+  int port = MetricsServerMgr::GetInstance()->getPort();
+  ASSERT_GT(port, 0);
+  EXPECT_EQ("127.0.0.1:0", MetricsServerMgr::GetInstance()->getAddress());
+
+  std::string body = HttpGet(port, "/metrics");
+  ASSERT_FALSE(body.empty());
+  EXPECT_NE(std::string::npos,
+            body.find("# TYPE sylar_test_scrape_seconds histogram"));
+
+  Scraped s = ParseHistogram(body, "sylar_test_scrape_seconds",
+                             "case=\"buckets\"");
+  ASSERT_TRUE(s.found);
+  EXPECT_EQ(4u, s.count);
+  EXPECT_NEAR(1.0021e-3, s.sum, 1e-9);
+
+  // 边界递增, 最后一个为+Inf且等于总数; 每个桶的累计数与记录的值一致
+  ASSERT_GT(s.buckets.size(), 2u);
+  EXPECT_TRUE(std::isinf(s.buckets.rbegin()->first));
+  EXPECT_EQ(s.count, s.buckets.rbegin()->second);
+  EXPECT_DOUBLE_EQ(64e-9, s.buckets.begin()->first);
+  for (auto &i : s.buckets) {
+    uint64_t expect = 0;
+    for (uint64_t v : values) {
+      expect += v * 1e-9 <= i.first;
+    }
+    EXPECT_EQ(expect, i.second) << "le=" << i.first;
+  }
+  // 每个2的幂区间两个边界: 2^k与1.5*2^k
+  EXPECT_TRUE(HasBound(s, 96e-9));
+  EXPECT_TRUE(HasBound(s, 128e-9));
+  EXPECT_FALSE(HasBound(s, 112e-9));
+
+  Config::LoadFromYaml(YAML::Load("metrics:\n  address: \"\"\n"));
+  EXPECT_EQ(0, MetricsServerMgr::GetInstance()->getPort());
+  EXPECT_EQ("", MetricsServerMgr::GetInstance()->getAddress());
+}
+
+}  // namespace
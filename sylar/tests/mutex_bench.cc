@@ -0,0 +1,166 @@
+/**
+ * @file mutex_bench.cc
+ * @brief 锁性能对比: sylar::Mutex/Spinlock/RWMutex vs pthread_mutex/sem_t
+ * @details 用法: mutex_bench [每线程迭代次数]
+ *          分别在1~64个线程下执行短临界区, 输出每次加解锁的平均耗时(ns)
+ */
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sylar/mutex.h"
+
+namespace {
+
+/// pthread_mutex 适配
+class PthreadMutex {
+public:
+  PthreadMutex() {
+    pthread_mutex_init(&m_mutex, nullptr);
+  }
+  ~PthreadMutex() {
+    pthread_mutex_destroy(&m_mutex);
+  }
+  void lock() {
+    pthread_mutex_lock(&m_mutex);
+  }
+  void unlock() {
+    pthread_mutex_unlock(&m_mutex);
+  }
+
+private:
+  pthread_mutex_t m_mutex;
+};
+
+/// 二值sem_t 适配
+class SemMutex {
+public:
+  SemMutex() {
+    sem_init(&m_sem, 0, 1);
+  }
+  ~SemMutex() {
+    sem_destroy(&m_sem);
+  }
+  void lock() {
+    sem_wait(&m_sem);
+  }
+  void unlock() {
+    sem_post(&m_sem);
+  }
+
+private:
+  sem_t m_sem;
+};
+
+/// RWMutex 读锁适配
+struct RWMutexRead {
+  void lock() {
+    mutex.rdlock();
+  }
+  void unlock() {
+    mutex.unlock();
+  }
+  sylar::RWMutex mutex;
+};
+
+/// RWMutex 写锁适配
+struct RWMutexWrite {
+  void lock() {
+    mutex.wrlock();
+  }
+  void unlock() {
+    mutex.unlock();
+  }
+  sylar::RWMutex mutex;
+};
+
+/// 被保护的共享数据, 模拟短临界区
+struct alignas(sylar::kCacheLineSize) Shared {
+  uint64_t counter = 0;
+  uint64_t sum     = 0;
+};
+
+/// @brief 执行一轮测试
+/// @tparam LockType 锁类型
+/// @tparam kWrite 临界区内是否修改共享数据, 读锁场景只读
+template <class LockType, bool kWrite = true>
+double Run(int threads, uint64_t iterations) {
+  LockType          mutex;
+  Shared            shared;
+  std::atomic<bool> start{false};
+  std::atomic<uint64_t> sink{0};
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&]() {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      uint64_t local = 0;
+      for (uint64_t n = 0; n < iterations; ++n) {
+        mutex.lock();
+        if (kWrite) {
+          ++shared.counter;
+          shared.sum += n;
+        } else {
+          local += shared.sum;
+        }
+        mutex.unlock();
+      }
+      sink.fetch_add(local, std::memory_order_relaxed);
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (auto &t : workers) {
+    t.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  if (kWrite && shared.counter != threads * iterations) {
+    fprintf(stderr, "lost update: %lu\n", (unsigned long)shared.counter);
+    exit(1);
+  }
+  double ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  return ns / (threads * iterations);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+  const int thread_nums[] = {1, 2, 4, 8, 16, 32, 64};
+
+  printf("iterations per thread: %lu, unit: ns/op\n",
+         (unsigned long)iterations);
+  printf("%8s %12s %12s %12s %12s %14s %12s\n",
+         "threads",
+         "sylar_mutex",
+         "spinlock",
+         "rw_write",
+         "rw_read",
+         "pthread_mutex",
+         "sem_t");
+  for (int threads : thread_nums) {
+    printf("%8d %12.1f %12.1f %12.1f %12.1f %14.1f %12.1f\n",
+           threads,
+           Run<sylar::Mutex>(threads, iterations),
+           Run<sylar::Spinlock>(threads, iterations),
+           Run<RWMutexWrite>(threads, iterations),
+           Run<RWMutexRead, false>(threads, iterations),
+           Run<PthreadMutex>(threads, iterations),
+           Run<SemMutex>(threads, iterations));
+    fflush(stdout);
+  }
+  return 0;
+}
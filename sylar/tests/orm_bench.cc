@@ -0,0 +1,167 @@
+/**
+ * @file orm_bench.cc
+ * @brief ORM生成代码的性能测试: 每次预编译与连接缓存预编译语句, 逐条与批量插入
+ * @details 用法: orm_bench [行数] [数据库文件, 默认:memory:]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "bin/orm_conf/user_info.h"
+#include "sylar/db/sqlite3.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  size_t      rows = 20000;
+  std::string db   = ":memory:";
+};
+
+std::vector<test::orm::UserInfo::ptr> MakeUsers(size_t n, size_t base) {
+  std::vector<test::orm::UserInfo::ptr> users;
+  for (size_t i = 0; i < n; ++i) {
+    test::orm::UserInfo::ptr u(new test::orm::UserInfo);
+    u->setName("user_" + std::to_string(base + i));
+    u->setEmail("user_" + std::to_string(base + i) + "@sylar.top");
+    u->setPhone("1380000" + std::to_string(base + i));
+    u->setStatus(i % 4);
+    u->setCreateTime(time(0));
+    users.push_back(u);
+  }
+  return users;
+}
+
+sylar::SQLite3::ptr Open(const Options &opt) {
+  if (opt.db != ":memory:") {
+    unlink(opt.db.c_str());
+  }
+  sylar::SQLite3::ptr db = sylar::SQLite3::Create(opt.db);
+  if (!db || test::orm::UserInfoDao::CreateTableSQLite3(db) != 0) {
+    fprintf(stderr, "open %s failed\n", opt.db.c_str());
+    exit(1);
+  }
+  return db;
+}
+
+void Report(const char *name, size_t n, uint64_t ns) {
+  printf("%-22s %10.2f us/row\n", name, ns / 1000.0 / n);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.rows = strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    opt.db = argv[2];
+  }
+  printf("rows=%lu db=%s\n", (unsigned long)opt.rows, opt.db.c_str());
+
+  {
+    // 对照: 每次插入都重新预编译, 自动提交
+    sylar::SQLite3::ptr db    = Open(opt);
+    auto                users = MakeUsers(opt.rows, 0);
+    uint64_t            begin = NowNs();
+    for (auto &u : users) {
+      sylar::IStmt::ptr stmt = db->prepare(
+          "INSERT INTO user (name, email, phone, status, create_time, "
+          "update_time) VALUES (?, ?, ?, ?, ?, ?)");
+      stmt->bindString(1, u->getName());
+      stmt->bindString(2, u->getEmail());
+      stmt->bindString(3, u->getPhone());
+      stmt->bindInt32(4, u->getStatus());
+      stmt->bindTime(5, u->getCreateTime());
+      stmt->bindTime(6, u->getUpdateTime());
+      stmt->execute();
+    }
+    Report("insert_prepare", opt.rows, NowNs() - begin);
+  }
+
+  sylar::SQLite3::ptr db = Open(opt);
+  {
+    auto     users = MakeUsers(opt.rows, 0);
+    uint64_t begin = NowNs();
+    for (auto &u : users) {
+      test::orm::UserInfoDao::Insert(u, db);
+    }
+    Report("insert_cached", opt.rows, NowNs() - begin);
+  }
+  {
+    auto     users = MakeUsers(opt.rows, opt.rows);
+    uint64_t begin = NowNs();
+    if (test::orm::UserInfoDao::BatchInsert(users, db) != 0) {
+      fprintf(stderr, "BatchInsert failed: %s\n", db->getErrStr().c_str());
+      return 1;
+    }
+    Report("batch_insert", opt.rows, NowNs() - begin);
+    if (users.back()->getId() != int64_t(opt.rows * 2)) {
+      fprintf(stderr, "unexpected id %ld\n", (long)users.back()->getId());
+      return 1;
+    }
+  }
+  {
+    std::vector<test::orm::UserInfo::ptr> users;
+    for (size_t i = 1; i <= opt.rows; ++i) {
+      users.push_back(test::orm::UserInfoDao::Query(i, db));
+      users.back()->setStatus(9);
+    }
+    uint64_t begin = NowNs();
+    if (test::orm::UserInfoDao::BatchInsertOrUpdate(users, db) != 0) {
+      fprintf(stderr, "BatchInsertOrUpdate failed\n");
+      return 1;
+    }
+    Report("batch_upsert", opt.rows, NowNs() - begin);
+  }
+  {
+    uint64_t begin = NowNs();
+    size_t   found = 0;
+    for (size_t i = 1; i <= opt.rows; ++i) {
+      sylar::ISQLData::ptr data = db->query(
+          "SELECT id, name, email, phone, status, create_time, update_time "
+          "FROM user WHERE id = %lu",
+          (unsigned long)i);
+      found += data->next();
+    }
+    Report("query_prepare", opt.rows, NowNs() - begin);
+
+    begin = NowNs();
+    for (size_t i = 1; i <= opt.rows; ++i) {
+      found += test::orm::UserInfoDao::Query(i, db) != nullptr;
+    }
+    Report("query_cached", opt.rows, NowNs() - begin);
+
+    begin = NowNs();
+    for (size_t i = 0; i < opt.rows; ++i) {
+      found += test::orm::UserInfoDao::QueryByName(
+                   "user_" + std::to_string(i), db) != nullptr;
+    }
+    Report("query_by_name", opt.rows, NowNs() - begin);
+    if (found != opt.rows * 3) {
+      fprintf(stderr, "found %lu rows, expect %lu\n",
+              (unsigned long)found,
+              (unsigned long)opt.rows * 3);
+      return 1;
+    }
+  }
+  {
+    std::vector<test::orm::UserInfo::ptr> users;
+    uint64_t                              begin = NowNs();
+    test::orm::UserInfoDao::QueryByStatus(users, 9, db);
+    Report("query_by_status", users.size(), NowNs() - begin);
+  }
+  printf("cached statements: %lu\n", (unsigned long)db->getCachedStmtCount());
+  return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file orm_test.cc
+ * @brief ORM生成的UserInfoDao在SQLite3内存数据库上的单元测试
+ * @details 覆盖插入回填id, upsert, 唯一/非唯一索引查询, 批量插入冲突回滚与语句缓存复用
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bin/orm_conf/user_info.h"
+#include "sylar/db/sqlite3.h"
+
+namespace {
+
+using test::orm::UserInfo;
+using test::orm::UserInfoDao;
+
+UserInfo::ptr MakeUser(const std::string &name, int32_t status = 0) {
+  UserInfo::ptr u(new UserInfo);
+  u->setName(name);
+  u->setEmail(name + "@sylar.top");
+  u->setPhone("13800000000");
+  u->setStatus(status);
+  u->setCreateTime(time(0));
+  return u;
+}
+
+size_t CountRows(sylar::IDB::ptr db) {
+  std::vector<UserInfo::ptr> users;
+  EXPECT_EQ(0, UserInfoDao::QueryAll(users, db));
+  return users.size();
+}
+
+class OrmTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_db = sylar::SQLite3::Create(":memory:");
+    ASSERT_TRUE(m_db);
+    ASSERT_EQ(0, UserInfoDao::CreateTableSQLite3(m_db));
+  }
+
+  sylar::SQLite3::ptr m_db;
+};
+
+TEST_F(OrmTest, InsertBackfillsId) {
+  UserInfo::ptr a = MakeUser("a");
+  UserInfo::ptr b = MakeUser("b");
+  ASSERT_EQ(0, UserInfoDao::Insert(a, m_db));
+  ASSERT_EQ(0, UserInfoDao::Insert(b, m_db));
+  EXPECT_EQ(1, a->getId());
+  EXPECT_EQ(2, b->getId());
+
+  UserInfo::ptr v = UserInfoDao::Query(b->getId(), m_db);
+  ASSERT_TRUE(v);
+  EXPECT_EQ("b", v->getName());
+  EXPECT_EQ("b@sylar.top", v->getEmail());
+  EXPECT_EQ(b->getCreateTime(), v->getCreateTime());
+}
+
+TEST_F(OrmTest, InsertOrUpdate) {
+  // id为0时插入并回填
+  UserInfo::ptr u = MakeUser("a", 1);
+  ASSERT_EQ(0, UserInfoDao::InsertOrUpdate(u, m_db));
+  ASSERT_EQ(1, u->getId());
+
+  // 主键已存在时更新其他列, 不新增行
+  u->setStatus(7);
+  u->setPhone("13900000000");
+  ASSERT_EQ(0, UserInfoDao::InsertOrUpdate(u, m_db));
+  EXPECT_EQ(1u, CountRows(m_db));
+  UserInfo::ptr v = UserInfoDao::Query(1, m_db);
+  ASSERT_TRUE(v);
+  EXPECT_EQ(7, v->getStatus());
+  EXPECT_EQ("13900000000", v->getPhone());
+
+  // 指定的主键不存在时按该主键插入
+  UserInfo::ptr w = MakeUser("w");
+  w->setId(100);
+  ASSERT_EQ(0, UserInfoDao::InsertOrUpdate(w, m_db));
+  EXPECT_EQ(2u, CountRows(m_db));
+  ASSERT_TRUE(UserInfoDao::Query(100, m_db));
+}
+
+TEST_F(OrmTest, QueryByUniqueIndex) {
+  ASSERT_EQ(0, UserInfoDao::Insert(MakeUser("a"), m_db));
+  ASSERT_EQ(0, UserInfoDao::Insert(MakeUser("b"), m_db));
+
+  UserInfo::ptr v = UserInfoDao::QueryByName("b", m_db);
+  ASSERT_TRUE(v);
+  EXPECT_EQ(2, v->getId());
+  v = UserInfoDao::QueryByEmail("a@sylar.top", m_db);
+  ASSERT_TRUE(v);
+  EXPECT_EQ(1, v->getId());
+
+  // 未命中后同一缓存语句仍可继续使用
+  EXPECT_FALSE(UserInfoDao::QueryByName("none", m_db));
+  EXPECT_FALSE(UserInfoDao::QueryByName("none", m_db));
+  v = UserInfoDao::QueryByName("a", m_db);
+  ASSERT_TRUE(v);
+  EXPECT_EQ(1, v->getId());
+}
+
+TEST_F(OrmTest, QueryByNonUniqueIndex) {
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(0, UserInfoDao::Insert(MakeUser(std::to_string(i), i % 3), m_db));
+  }
+  std::vector<UserInfo::ptr> users;
+  ASSERT_EQ(0, UserInfoDao::QueryByStatus(users, 0, m_db));
+  ASSERT_EQ(4u, users.size());
+  for (auto &u : users) {
+    EXPECT_EQ(0, u->getStatus());
+  }
+
+  users.clear();
+  ASSERT_EQ(0, UserInfoDao::QueryByStatus(users, 5, m_db));
+  EXPECT_TRUE(users.empty());
+
+  users.clear();
+  ASSERT_EQ(0, UserInfoDao::QueryByStatus(users, 1, m_db));
+  EXPECT_EQ(3u, users.size());
+}
+
+TEST_F(OrmTest, BatchInsertRollbackOnConflict) {
+  ASSERT_EQ(0, UserInfoDao::Insert(MakeUser("a"), m_db));
+
+  std::vector<UserInfo::ptr> ok = {MakeUser("b"), MakeUser("c")};
+  ASSERT_EQ(0, UserInfoDao::BatchInsert(ok, m_db));
+  EXPECT_EQ(2, ok[0]->getId());
+  EXPECT_EQ(3, ok[1]->getId());
+
+  // 第三行与已有的name冲突, 整批回滚
+  std::vector<UserInfo::ptr> bad = {MakeUser("d"), MakeUser("e"), MakeUser("a")};
+  EXPECT_NE(0, UserInfoDao::BatchInsert(bad, m_db));
+  EXPECT_EQ(3u, CountRows(m_db));
+  EXPECT_FALSE(UserInfoDao::QueryByName("d", m_db));
+
+  // 回滚后连接与缓存语句仍可用
+  std::vector<UserInfo::ptr> again = {MakeUser("d")};
+  ASSERT_EQ(0, UserInfoDao::BatchInsert(again, m_db));
+  EXPECT_EQ(4u, CountRows(m_db));
+}
+
+TEST_F(OrmTest, BatchInsertOrUpdate) {
+  std::vector<UserInfo::ptr> users = {MakeUser("a"), MakeUser("b")};
+  ASSERT_EQ(0, UserInfoDao::BatchInsert(users, m_db));
+  users[0]->setStatus(9);
+  users.push_back(MakeUser("c", 9));
+  ASSERT_EQ(0, UserInfoDao::BatchInsertOrUpdate(users, m_db));
+  EXPECT_EQ(3, users[2]->getId());
+
+  std::vector<UserInfo::ptr> found;
+  ASSERT_EQ(0, UserInfoDao::QueryByStatus(found, 9, m_db));
+  EXPECT_EQ(2u, found.size());
+}
+
+TEST_F(OrmTest, StatementCacheReuse) {
+  ASSERT_EQ(0, UserInfoDao::Insert(MakeUser("a"), m_db));
+  ASSERT_TRUE(UserInfoDao::Query(1, m_db));
+  ASSERT_TRUE(UserInfoDao::QueryByName("a", m_db));
+  size_t cached = m_db->getCachedStmtCount();
+  EXPECT_GT(cached, 0u);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(0, UserInfoDao::Insert(MakeUser("u" + std::to_string(i)), m_db));
+    ASSERT_TRUE(UserInfoDao::Query(i + 2, m_db));
+    ASSERT_TRUE(UserInfoDao::QueryByName("u" + std::to_string(i), m_db));
+  }
+  // 重复调用复用已缓存的语句, 不再新增
+  EXPECT_EQ(cached, m_db->getCachedStmtCount());
+
+  // 清空缓存后重新预编译
+  m_db->clearStmtCache();
+  EXPECT_EQ(0u, m_db->getCachedStmtCount());
+  ASSERT_TRUE(UserInfoDao::Query(1, m_db));
+  EXPECT_EQ(1u, m_db->getCachedStmtCount());
+}
+
+}  // namespace
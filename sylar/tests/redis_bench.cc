@@ -0,0 +1,142 @@
+/**
+ * @file redis_bench.cc
+ * @brief Redis客户端性能测试: 逐条同步, 流水线与并发异步请求的吞吐
+ * @details 用法: redis_bench [host] [请求数] [流水线批量] [并发数]
+ *          连接已启动的redis服务, host默认127.0.0.1:6379. 功能测试见redis_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sylar/db/redis.h"
+#include "sylar/fox_thread.h"
+#include "sylar/mutex.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  std::string host        = "127.0.0.1:6379";
+  size_t      requests    = 100000;
+  size_t      batch       = 100;
+  size_t      concurrency = 64;
+};
+
+void Report(const char *name, size_t n, uint64_t ns, size_t errors) {
+  printf("%-12s %10.1f Kops/s  %8.2f us/op  errors %lu\n",
+         name,
+         n * 1e6 / ns,
+         ns / 1000.0 / n,
+         (unsigned long)errors);
+}
+
+bool IsStr(const sylar::RedisReply::ptr &r, std::string_view v) {
+  return r && r->getType() == sylar::RedisReply::STRING && r->getStr() == v;
+}
+
+/// @brief 逐条同步, 每条命令一个往返
+void RunSequential(sylar::IRedis::ptr redis, const Options &opt) {
+  size_t   errors = 0;
+  uint64_t begin  = NowNs();
+  for (size_t i = 0; i < opt.requests; ++i) {
+    errors += !IsStr(redis->cmd({"GET", "bench"}), "value");
+  }
+  Report("sequential", opt.requests, NowNs() - begin, errors);
+}
+
+/// @brief 每批batch条命令一起发出
+void RunPipeline(sylar::IRedis::ptr redis, const Options &opt) {
+  std::vector<sylar::IRedis::Args> cmds(opt.batch, {"GET", "bench"});
+  size_t                           errors = 0;
+  uint64_t                         begin  = NowNs();
+  for (size_t i = 0; i < opt.requests; i += opt.batch) {
+    for (auto &r : redis->pipeline(cmds)) {
+      errors += !IsStr(r, "value");
+    }
+  }
+  Report("pipeline", opt.requests, NowNs() - begin, errors);
+}
+
+/// @brief concurrency个请求同时在途, 每完成一个发出下一个
+void RunAsync(sylar::IRedis::ptr redis, const Options &opt) {
+  std::atomic<size_t>   issued{0};
+  std::atomic<size_t>   done{0};
+  std::atomic<size_t>   errors{0};
+  sylar::Semaphore      finish;
+  std::function<void()> issue = [&]() {
+    if (issued.fetch_add(1) >= opt.requests) {
+      return;
+    }
+    redis->cmdAsync({"GET", "bench"}, [&](sylar::RedisReply::ptr r) {
+      errors += !IsStr(r, "value");
+      if (done.fetch_add(1) + 1 == opt.requests) {
+        finish.notify();
+      } else {
+        issue();
+      }
+    });
+  };
+  uint64_t begin = NowNs();
+  for (size_t i = 0; i < opt.concurrency; ++i) {
+    issue();
+  }
+  finish.wait();
+  Report("async", opt.requests, NowNs() - begin, errors);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.host = argv[1];
+  }
+  if (argc > 2) {
+    opt.requests = strtoul(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    opt.batch = strtoul(argv[3], nullptr, 10);
+  }
+  if (argc > 4) {
+    opt.concurrency = strtoul(argv[4], nullptr, 10);
+  }
+  printf("host=%s requests=%lu batch=%lu concurrency=%lu\n",
+         opt.host.c_str(),
+         (unsigned long)opt.requests,
+         (unsigned long)opt.batch,
+         (unsigned long)opt.concurrency);
+
+  sylar::FoxThreadMgr::GetInstance()->init({{"redis", {"redis", 1, 0}}});
+  sylar::RedisMgr::GetInstance()->init({{"bench",
+                                         {{"host", opt.host},
+                                          {"type", "fox_redis"},
+                                          {"pool", "2"},
+                                          {"timeout", "1000"}}}});
+
+  int                rt    = 0;
+  sylar::IRedis::ptr redis = sylar::RedisMgr::GetInstance()->get("bench");
+  if (!redis || !redis->cmd({"SET", "bench", "value"})) {
+    fprintf(stderr, "SET failed\n");
+    rt = 1;
+  } else {
+    RunSequential(redis, opt);
+    RunPipeline(redis, opt);
+    RunAsync(redis, opt);
+  }
+
+  redis.reset();
+  sylar::RedisMgr::GetInstance()->init({});
+  sylar::FoxThreadMgr::GetInstance()->stop();
+  return rt;
+}
@@ -0,0 +1,628 @@
+/**
+ * @file redis_test.cc
+ * @brief RESP解析器与Redis客户端的单元测试
+ * @details 解析器覆盖任意位置拆包, 数组解析中途换缓冲区与协议错误.
+ *          客户端连接进程内的RESP假服务器, 假服务器使用独立的请求解码,
+ *          不依赖被测的RespParser. 覆盖流水线, MOVED/ASK重定向, 在途请求超时
+ *          与线程/协程中的同步调用
+ */
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "sylar/db/redis.h"
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+
+namespace {
+
+using sylar::RedisReply;
+using sylar::RespParser;
+
+uint64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool IsStr(const RedisReply::ptr &r, std::string_view v) {
+  return r && r->getType() == RedisReply::STRING && r->getStr() == v;
+}
+
+bool IsStatus(const RedisReply::ptr &r, std::string_view v) {
+  return r && r->getType() == RedisReply::STATUS && r->getStr() == v;
+}
+
+/// @brief 把data写入parser, 每次写入后取出全部完整的回复
+/// @return 是否没有协议错误
+bool Feed(RespParser                   &parser,
+          std::string_view              data,
+          std::vector<RedisReply::ptr> &out) {
+  while (!data.empty()) {
+    size_t len = 0;
+    char  *buf = parser.prepare(len);
+    size_t n   = std::min(len, data.size());
+    memcpy(buf, data.data(), n);
+    parser.commit(n);
+    data.remove_prefix(n);
+    RedisReply::ptr r;
+    int             rt = 0;
+    while ((rt = parser.parse(r)) == 1) {
+      out.push_back(std::move(r));
+    }
+    if (rt < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<std::string> ToStrings(const std::vector<RedisReply::ptr> &rs) {
+  std::vector<std::string> v;
+  for (auto &i : rs) {
+    v.push_back(i->toString());
+  }
+  return v;
+}
+
+/// 覆盖全部回复类型, 包含空字符串, 空数组, nil数组与多层嵌套
+const std::string kWire = "+OK\r\n"
+                          "-ERR bad\r\n"
+                          ":-42\r\n"
+                          "$5\r\nhello\r\n"
+                          "$0\r\n\r\n"
+                          "$-1\r\n"
+                          "*-1\r\n"
+                          "*0\r\n"
+                          "*3\r\n*2\r\n$1\r\na\r\n:1\r\n"
+                          "$-1\r\n"
+                          "*1\r\n*1\r\n+deep\r\n";
+
+const std::vector<std::string> kExpect = {
+    "OK",
+    "(error) ERR bad",
+    "(integer) -42",
+    "\"hello\"",
+    "\"\"",
+    "(nil)",
+    "(nil)",
+    "[]",
+    "[[\"a\", (integer) 1], (nil), [[deep]]]",
+};
+
+TEST(RespParserTest, ReplySplitAtEveryByte) {
+  for (size_t i = 0; i <= kWire.size(); ++i) {
+    RespParser                   parser;
+    std::vector<RedisReply::ptr> out;
+    ASSERT_TRUE(Feed(parser, std::string_view(kWire).substr(0, i), out));
+    ASSERT_TRUE(Feed(parser, std::string_view(kWire).substr(i), out));
+    EXPECT_EQ(kExpect, ToStrings(out)) << "split at " << i;
+  }
+
+  // 逐字节写入
+  RespParser                   parser;
+  std::vector<RedisReply::ptr> out;
+  for (char c : kWire) {
+    ASSERT_TRUE(Feed(parser, std::string_view(&c, 1), out));
+  }
+  EXPECT_EQ(kExpect, ToStrings(out));
+}
+
+TEST(RespParserTest, NestedArrayAcrossReallocation) {
+  std::vector<std::string> values;
+  std::string              wire = "*3\r\n*40\r\n";
+  for (int i = 0; i < 40; ++i) {
+    values.push_back(std::string(30, 'a' + i % 26) + std::to_string(i));
+    wire += "$" + std::to_string(values.back().size()) + "\r\n" +
+            values.back() + "\r\n";
+  }
+  std::string big(5000, 'z');
+  wire += "*2\r\n:7\r\n$" + std::to_string(big.size()) + "\r\n";
+  wire += big + "\r\n";
+  wire += "$3\r\nend\r\n";
+
+  // 小缓冲区使数组解析途中多次换缓冲区, 先持有一个回复使旧缓冲区不能原地复用
+  RespParser                   parser(64);
+  std::vector<RedisReply::ptr> held;
+  ASSERT_TRUE(Feed(parser, "$4\r\nheld\r\n", held));
+  ASSERT_EQ(1u, held.size());
+
+  std::vector<RedisReply::ptr> out;
+  for (size_t off = 0; off < wire.size(); off += 7) {
+    ASSERT_TRUE(Feed(parser, std::string_view(wire).substr(off, 7), out));
+  }
+  // 之后的数据会复用已释放的内存, 检查已解析的元素仍指向有效的缓冲区
+  ASSERT_TRUE(Feed(parser, "$4\r\nnext\r\n", out));
+  ASSERT_EQ(2u, out.size());
+
+  EXPECT_TRUE(IsStr(held[0], "held"));
+  const RedisReply &r = *out[0];
+  ASSERT_EQ(RedisReply::ARRAY, r.getType());
+  ASSERT_EQ(3u, r.size());
+  ASSERT_EQ(40u, r[0].size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], r[0][i].getStr()) << i;
+  }
+  ASSERT_EQ(2u, r[1].size());
+  EXPECT_EQ(7, r[1][0].getInteger());
+  EXPECT_EQ(big, r[1][1].getStr());
+  EXPECT_EQ("end", r[2].getStr());
+  EXPECT_TRUE(IsStr(out[1], "next"));
+}
+
+TEST(RespParserTest, ArrayGrowsWhileParsing) {
+  // 外层数组超过预留长度, 在子数组之间扩容; 头部声明的长度不预先分配
+  std::string wire = "*1500\r\n";
+  for (int i = 0; i < 1500; ++i) {
+    std::string v = std::to_string(i);
+    wire += "*2\r\n:" + v + "\r\n$" + std::to_string(v.size()) + "\r\n" + v +
+            "\r\n";
+  }
+
+  RespParser                   parser(256);
+  std::vector<RedisReply::ptr> out;
+  ASSERT_TRUE(Feed(parser, "*67108864\r\n:1\r\n", out));
+  EXPECT_TRUE(out.empty());
+
+  RespParser parser2(256);
+  for (size_t off = 0; off < wire.size(); off += 5) {
+    ASSERT_TRUE(Feed(parser2, std::string_view(wire).substr(off, 5), out));
+  }
+  ASSERT_EQ(1u, out.size());
+  const RedisReply &r = *out[0];
+  ASSERT_EQ(1500u, r.size());
+  for (size_t i = 0; i < r.size(); ++i) {
+    ASSERT_EQ(2u, r[i].size()) << i;
+    EXPECT_EQ((int64_t)i, r[i][0].getInteger());
+    EXPECT_EQ(std::to_string(i), r[i][1].getStr());
+  }
+}
+
+TEST(RespParserTest, ProtocolError) {
+  for (const char *wire : {"!x\r\n",
+                           "+OK\rX",
+                           ":12a\r\n",
+                           "$abc\r\n",
+                           "$3\r\nabcXY",
+                           "*x\r\n",
+                           "*1\r\n?\r\n"}) {
+    RespParser                   parser;
+    std::vector<RedisReply::ptr> out;
+    EXPECT_FALSE(Feed(parser, wire, out)) << wire;
+    EXPECT_FALSE(parser.getError().empty()) << wire;
+  }
+}
+
+TEST(RespParserTest, Encode) {
+  std::string out;
+  RespParser::Encode(out, {"SET", "k", ""});
+  EXPECT_EQ("*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$0\r\n\r\n", out);
+}
+
+/// @brief 解码客户端发出的请求(bulk字符串数组), 与RespParser相互独立
+/// @return 消耗的字节数, 数据不完整返回0, 格式错误返回-1
+ssize_t DecodeRequest(std::string_view in, std::vector<std::string> &args) {
+  args.clear();
+  size_t pos      = 0;
+  auto   readLine = [&](char prefix, long &n) -> int {
+    size_t end = in.find("\r\n", pos);
+    if (end == std::string_view::npos) {
+      return 0;
+    }
+    if (in[pos] != prefix) {
+      return -1;
+    }
+    auto rt = std::from_chars(in.data() + pos + 1, in.data() + end, n);
+    if (rt.ptr != in.data() + end || n < 0) {
+      return -1;
+    }
+    pos = end + 2;
+    return 1;
+  };
+  long count = 0;
+  int  rt    = readLine('*', count);
+  if (rt <= 0) {
+    return rt;
+  }
+  for (long i = 0; i < count; ++i) {
+    long len = 0;
+    if ((rt = readLine('$', len)) <= 0) {
+      return rt;
+    }
+    if (in.size() < pos + len + 2) {
+      return 0;
+    }
+    if (in.substr(pos + len, 2) != "\r\n") {
+      return -1;
+    }
+    args.emplace_back(in.substr(pos, len));
+    pos += len + 2;
+  }
+  return count > 0 ? pos : -1;
+}
+
+void AppendBulk(std::string &out, std::string_view v) {
+  out += "$" + std::to_string(v.size()) + "\r\n";
+  out.append(v);
+  out += "\r\n";
+}
+
+/// @brief 假节点, 负责[slot_begin, slot_end]的槽位
+/// @details HANG命令之后该连接不再回复. migrating_slot上的读写回复ASK,
+///          importing_slot上的读写只有紧跟在ASKING之后才处理, 否则回复MOVED
+struct FakeNode {
+  int                     listen_fd      = -1;
+  int                     port           = 0;
+  int                     slot_begin     = 0;
+  int                     slot_end       = 16383;
+  int                     migrating_slot = -1;
+  FakeNode               *migrating_to   = nullptr;
+  int                     importing_slot = -1;
+  std::vector<FakeNode *> all;
+  /// 回复的ASK数
+  std::atomic<int> asks{0};
+  /// ASKING之后处理的请求数
+  std::atomic<int> asked{0};
+};
+
+/// 全部假节点共享的数据
+sylar::Mutex                                 s_mutex;
+std::unordered_map<std::string, std::string> s_store;
+
+std::string Address(const FakeNode *node) {
+  return "127.0.0.1:" + std::to_string(node->port);
+}
+
+void Handle(const std::vector<std::string> &req,
+            FakeNode                       *node,
+            bool                           &asking,
+            std::string                    &out) {
+  const std::string &cmd          = req[0];
+  bool               after_asking = asking;
+  asking                          = false;
+  if (cmd == "PING") {
+    out += "+PONG\r\n";
+  } else if (cmd == "ASKING") {
+    asking = true;
+    out += "+OK\r\n";
+  } else if (cmd == "CLUSTER") {
+    out += "*" + std::to_string(node->all.size()) + "\r\n";
+    for (auto n : node->all) {
+      out += "*3\r\n:" + std::to_string(n->slot_begin) + "\r\n:" +
+             std::to_string(n->slot_end) + "\r\n*2\r\n";
+      AppendBulk(out, "127.0.0.1");
+      out += ":" + std::to_string(n->port) + "\r\n";
+    }
+  } else if ((cmd == "GET" && req.size() == 2) ||
+             (cmd == "SET" && req.size() == 3)) {
+    const std::string &key  = req[1];
+    int                slot = sylar::FoxRedisCluster::KeySlot(key);
+    if (slot == node->migrating_slot) {
+      ++node->asks;
+      out += "-ASK " + std::to_string(slot) + " " +
+             Address(node->migrating_to) + "\r\n";
+      return;
+    }
+    if (slot == node->importing_slot && after_asking) {
+      ++node->asked;
+    } else if (slot < node->slot_begin || slot > node->slot_end) {
+      for (auto n : node->all) {
+        if (slot >= n->slot_begin && slot <= n->slot_end) {
+          out += "-MOVED " + std::to_string(slot) + " " + Address(n) + "\r\n";
+        }
+      }
+      return;
+    }
+    sylar::Mutex::Lock lock(s_mutex);
+    if (cmd == "SET") {
+      s_store[key] = req[2];
+      out += "+OK\r\n";
+    } else {
+      auto it = s_store.find(key);
+      if (it == s_store.end()) {
+        out += "$-1\r\n";
+      } else {
+        AppendBulk(out, it->second);
+      }
+    }
+  } else {
+    out += "-ERR unknown command '" + cmd + "'\r\n";
+  }
+}
+
+/// @brief 一个客户端连接, 每次把收到的全部命令的回复合并发送
+void Serve(sylar::IOManager *iom, int fd, FakeNode *node) {
+  std::string              in;
+  std::string              out;
+  std::vector<std::string> args;
+  bool                     asking = false;
+  bool                     hang   = false;
+  char                     buf[4096];
+  while (true) {
+    ssize_t n = iom->recv(fd, buf, sizeof(buf));
+    if (n <= 0) {
+      break;
+    }
+    if (hang) {
+      continue;
+    }
+    in.append(buf, n);
+    size_t  off  = 0;
+    ssize_t used = 0;
+    while ((used = DecodeRequest(std::string_view(in).substr(off), args)) >
+           0) {
+      off += used;
+      if (args[0] == "HANG") {
+        hang = true;
+        break;
+      }
+      Handle(args, node, asking, out);
+    }
+    in.erase(0, off);
+    size_t sent = 0;
+    while (sent < out.size()) {
+      ssize_t w = iom->send(fd, out.data() + sent, out.size() - sent);
+      if (w <= 0) {
+        break;
+      }
+      sent += w;
+    }
+    if (used < 0 || sent < out.size()) {
+      break;
+    }
+    out.clear();
+  }
+  iom->close(fd);
+}
+
+class RedisTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    {
+      sylar::Mutex::Lock lock(s_mutex);
+      s_store.clear();
+    }
+    m_server.reset(new sylar::IOManager(1, "fake_redis"));
+    m_server->start();
+    m_client.reset(new sylar::IOManager(1, "redis"));
+    m_client->start();
+  }
+
+  void TearDown() override {
+    m_client->stop();
+    for (auto &n : m_nodes) {
+      shutdown(n->listen_fd, SHUT_RDWR);
+    }
+    m_server->stop();
+    for (auto &n : m_nodes) {
+      close(n->listen_fd);
+    }
+  }
+
+  /// @brief 启动负责[begin, end]槽位的假节点, 同一测试中的节点组成集群
+  FakeNode *addNode(int begin, int end) {
+    m_nodes.emplace_back(new FakeNode);
+    FakeNode *node   = m_nodes.back().get();
+    node->slot_begin = begin;
+    node->slot_end   = end;
+    for (auto &n : m_nodes) {
+      n->all.push_back(node);
+      if (n.get() != node) {
+        node->all.push_back(n.get());
+      }
+    }
+
+    node->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int on          = 1;
+    setsockopt(node->listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len        = sizeof(addr);
+    EXPECT_EQ(0, bind(node->listen_fd, (sockaddr *)&addr, len));
+    EXPECT_EQ(0, listen(node->listen_fd, 128));
+    EXPECT_EQ(0, getsockname(node->listen_fd, (sockaddr *)&addr, &len));
+    node->port            = ntohs(addr.sin_port);
+    sylar::IOManager *iom = m_server.get();
+    iom->schedule([iom, node]() {
+      while (true) {
+        int fd = iom->accept(node->listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+          break;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        iom->schedule([iom, fd, node]() {
+          Serve(iom, fd, node);
+        });
+      }
+    });
+    return node;
+  }
+
+  sylar::IOManager::ptr                  m_server;
+  sylar::IOManager::ptr                  m_client;
+  std::vector<std::unique_ptr<FakeNode>> m_nodes;
+};
+
+TEST_F(RedisTest, CmdAndPipeline) {
+  FakeNode            *node = addNode(0, 16383);
+  sylar::FoxRedis::ptr redis(
+      new sylar::FoxRedis(m_client, Address(node), 2, 1000));
+
+  EXPECT_TRUE(IsStatus(redis->cmd({"PING"}), "PONG"));
+  EXPECT_TRUE(IsStatus(redis->cmd({"SET", "k", "v"}), "OK"));
+  EXPECT_TRUE(IsStr(redis->cmd({"GET", "k"}), "v"));
+  RedisReply::ptr r = redis->cmd({"GET", "none"});
+  ASSERT_TRUE(r);
+  EXPECT_TRUE(r->isNil());
+  r = redis->cmd({"NOPE"});
+  ASSERT_TRUE(r);
+  EXPECT_TRUE(r->isError());
+
+  // 命令轮询分配到多个连接, 不同连接之间没有顺序保证, 写完再读
+  std::vector<std::string>         keys;
+  std::vector<sylar::IRedis::Args> sets;
+  std::vector<sylar::IRedis::Args> gets;
+  for (int i = 0; i < 100; ++i) {
+    keys.push_back("p" + std::to_string(i));
+  }
+  for (auto &k : keys) {
+    sets.push_back({"SET", k, k});
+    gets.push_back({"GET", k});
+  }
+  for (auto &r : redis->pipeline(sets)) {
+    EXPECT_TRUE(IsStatus(r, "OK"));
+  }
+  auto rts = redis->pipeline(gets);
+  ASSERT_EQ(keys.size(), rts.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(IsStr(rts[i], keys[i])) << keys[i];
+  }
+  EXPECT_TRUE(redis->pipeline({}).empty());
+}
+
+TEST_F(RedisTest, ConnectFailure) {
+  // 端口未监听与地址无法解析
+  sylar::FoxRedis::ptr redis(
+      new sylar::FoxRedis(m_client, "127.0.0.1:1", 1, 100));
+  EXPECT_FALSE(redis->cmd({"PING"}));
+  sylar::FoxRedis::ptr bad(new sylar::FoxRedis(m_client, "localhost", 1, 100));
+  EXPECT_FALSE(bad->cmd({"PING"}));
+}
+
+TEST_F(RedisTest, TimeoutFailsInFlightRequests) {
+  FakeNode            *node = addNode(0, 16383);
+  sylar::FoxRedis::ptr redis(
+      new sylar::FoxRedis(m_client, Address(node), 1, 200));
+  ASSERT_TRUE(IsStatus(redis->cmd({"PING"}), "PONG"));
+
+  // HANG之后服务端不再回复, 同一批发出的请求全部超时失败
+  uint64_t begin = NowMs();
+  auto     rts   = redis->pipeline({{"PING"}, {"HANG"}, {"PING"}, {"PING"}});
+  uint64_t used  = NowMs() - begin;
+  ASSERT_EQ(4u, rts.size());
+  EXPECT_TRUE(IsStatus(rts[0], "PONG"));
+  for (size_t i = 1; i < rts.size(); ++i) {
+    EXPECT_FALSE(rts[i]) << i;
+  }
+  EXPECT_GE(used, 200u);
+  EXPECT_LT(used, 2000u);
+
+  // 超时断开后重新连接
+  EXPECT_TRUE(IsStatus(redis->cmd({"PING"}), "PONG"));
+}
+
+TEST_F(RedisTest, ClusterMovedRedirect) {
+  FakeNode *a = addNode(0, 8191);
+  addNode(8192, 16383);
+  auto cluster =
+      std::make_shared<sylar::FoxRedisCluster>(m_client, Address(a), 1, 1000);
+
+  std::vector<std::string>         keys;
+  std::vector<sylar::IRedis::Args> sets;
+  std::vector<sylar::IRedis::Args> gets;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back("key:" + std::to_string(i));
+  }
+  for (auto &k : keys) {
+    sets.push_back({"SET", k, k});
+    gets.push_back({"GET", k});
+  }
+  for (auto &r : cluster->pipeline(sets)) {
+    EXPECT_TRUE(IsStatus(r, "OK"));
+  }
+  auto rts = cluster->pipeline(gets);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(IsStr(rts[i], keys[i])) << keys[i];
+  }
+
+  // 超过解析缓冲区的值
+  std::string big(1 << 20, 'x');
+  EXPECT_TRUE(IsStatus(cluster->cmd({"SET", "{key:1}big", big}), "OK"));
+  EXPECT_TRUE(IsStr(cluster->cmd({"GET", "{key:1}big"}), big));
+}
+
+TEST_F(RedisTest, ClusterAskRedirect) {
+  FakeNode   *a    = addNode(0, 8191);
+  FakeNode   *b    = addNode(8192, 16383);
+  std::string key  = "ask:key";
+  int         slot = sylar::FoxRedisCluster::KeySlot(key);
+  FakeNode   *src  = slot <= a->slot_end ? a : b;
+  FakeNode   *dst  = src == a ? b : a;
+  src->migrating_slot = slot;
+  src->migrating_to   = dst;
+  dst->importing_slot = slot;
+  auto cluster =
+      std::make_shared<sylar::FoxRedisCluster>(m_client, Address(a), 1, 1000);
+
+  EXPECT_TRUE(IsStatus(cluster->cmd({"SET", key, "v"}), "OK"));
+  EXPECT_TRUE(IsStr(cluster->cmd({"GET", key}), "v"));
+  // 每次都先访问源节点, ASK不更新槽位映射; 目标节点只在ASKING之后处理
+  EXPECT_EQ(2, src->asks.load());
+  EXPECT_EQ(2, dst->asked.load());
+  {
+    sylar::Mutex::Lock lock(s_mutex);
+    EXPECT_EQ("v", s_store[key]);
+  }
+}
+
+TEST_F(RedisTest, SyncCallsFromThreadsAndFibers) {
+  const int            kCallers = 4;
+  const int            kCalls   = 2000;
+  FakeNode            *node     = addNode(0, 16383);
+  sylar::FoxRedis::ptr redis(
+      new sylar::FoxRedis(m_client, Address(node), 2, 1000));
+  std::atomic<int>     errors{0};
+  auto                 run = [&]() {
+    for (int i = 0; i < kCalls; ++i) {
+      errors += !IsStatus(redis->cmd({"PING"}), "PONG");
+      if (i % 16 == 0) {
+        for (auto &r : redis->pipeline({{"PING"}, {"PING"}, {"PING"}})) {
+          errors += !IsStatus(r, "PONG");
+        }
+      }
+    }
+  };
+
+  // 回复在IO线程中完成, 等待方返回后立即释放栈上的latch
+  sylar::IOManager callers(2, "redis_caller");
+  sylar::Semaphore finish;
+  callers.start();
+  for (int i = 0; i < kCallers; ++i) {
+    callers.schedule([&]() {
+      run();
+      finish.notify();
+    });
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kCallers; ++i) {
+    threads.emplace_back(run);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  // stop不等待挂起在信号量上的协程
+  for (int i = 0; i < kCallers; ++i) {
+    finish.wait();
+  }
+  callers.stop();
+  EXPECT_EQ(0, errors.load());
+}
+
+}  // namespace
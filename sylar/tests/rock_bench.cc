@@ -0,0 +1,251 @@
+/**
+ * @file rock_bench.cc
+ * @brief rock协议回环性能测试: 同步往返与单连接多请求在途的吞吐和延迟
+ * @details 用法: rock_bench [请求数] [body字节数] [并发数]
+ *          依次测试不压缩, snappy与zlib, 服务端原样回显并校验
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sylar/iomanager.h"
+#include "sylar/mutex.h"
+#include "sylar/rock/rock_server.h"
+#include "sylar/rock/rock_stream.h"
+
+namespace {
+
+/// 回显
+const uint32_t kCmdEcho = 1;
+/// 延迟200ms后回显, 用于验证超时
+const uint32_t kCmdSlow = 2;
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  size_t requests    = 100000;
+  size_t payload     = 1024;
+  size_t concurrency = 64;
+};
+
+/// @brief 可压缩的body, 近似常见的结构化数据
+std::string MakeBody(size_t size) {
+  std::string body;
+  for (size_t i = 0; body.size() < size; ++i) {
+    body += "{\"id\":" + std::to_string(i) + ",\"name\":\"user" +
+            std::to_string(i % 100) + "\",\"status\":\"active\"},";
+  }
+  body.resize(size);
+  return body;
+}
+
+sylar::RockRequest::ptr MakeRequest(uint32_t cmd, const std::string &body) {
+  sylar::RockRequest::ptr req(new sylar::RockRequest);
+  req->setCmd(cmd);
+  req->setBody(body);
+  return req;
+}
+
+bool IsEcho(const sylar::RockResponse::ptr &rsp, const std::string &body) {
+  return rsp && rsp->getResult() == 0 && rsp->getBody() == body;
+}
+
+void Report(const char            *name,
+            size_t                 n,
+            uint64_t               ns,
+            std::vector<uint64_t> &lats,
+            size_t                 errors) {
+  std::sort(lats.begin(), lats.end());
+  double p50 = lats.empty() ? 0 : lats[lats.size() / 2] / 1000.0;
+  double p99 = lats.empty() ? 0 : lats[lats.size() * 99 / 100] / 1000.0;
+  printf("%-18s %10.1f Kops/s  p50 %8.2f us  p99 %8.2f us  errors %lu\n",
+         name,
+         n * 1e6 / ns,
+         p50,
+         p99,
+         (unsigned long)errors);
+}
+
+/// @brief 逐条同步, 每个请求一个往返
+void RunSequential(sylar::RockStream::ptr stream,
+                   const Options         &opt,
+                   const std::string     &body,
+                   const std::string     &name) {
+  size_t                n = std::max<size_t>(opt.requests / 10, 1);
+  size_t                errors = 0;
+  std::vector<uint64_t> lats;
+  lats.reserve(n);
+  uint64_t begin = NowNs();
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t start = NowNs();
+    errors += !IsEcho(stream->request(MakeRequest(kCmdEcho, body), 1000), body);
+    lats.push_back(NowNs() - start);
+  }
+  Report((name + " sequential").c_str(), n, NowNs() - begin, lats, errors);
+}
+
+/// @brief concurrency个请求在同一连接上同时在途, 每完成一个发出下一个
+void RunConcurrent(sylar::RockStream::ptr stream,
+                   const Options         &opt,
+                   const std::string     &body,
+                   const std::string     &name) {
+  std::atomic<size_t>   issued{0};
+  std::atomic<size_t>   done{0};
+  std::atomic<size_t>   errors{0};
+  std::vector<uint64_t> lats(opt.requests);
+  sylar::Semaphore      finish;
+  std::function<void()> issue = [&]() {
+    size_t i = issued.fetch_add(1);
+    if (i >= opt.requests) {
+      return;
+    }
+    uint64_t start = NowNs();
+    stream->request(
+        MakeRequest(kCmdEcho, body),
+        [&, i, start](sylar::RockResponse::ptr rsp) {
+          lats[i] = NowNs() - start;
+          errors += !IsEcho(rsp, body);
+          if (done.fetch_add(1) + 1 == opt.requests) {
+            finish.notify();
+          } else {
+            issue();
+          }
+        },
+        1000);
+  };
+  uint64_t begin = NowNs();
+  for (size_t i = 0; i < opt.concurrency; ++i) {
+    issue();
+  }
+  finish.wait();
+  Report((name + " concurrent").c_str(),
+         opt.requests,
+         NowNs() - begin,
+         lats,
+         errors);
+}
+
+/// @brief 超时, 并发处理, 大body与连接失败
+bool CheckErrors(sylar::IOManager      *iom,
+                 sylar::RockStream::ptr stream) {
+  size_t errors = 0;
+  // 超时只影响该请求, 迟到的响应被丢弃, 连接继续可用
+  errors += stream->request(MakeRequest(kCmdSlow, "slow"), 50) != nullptr;
+  errors += !IsEcho(stream->request(MakeRequest(kCmdEcho, "ok"), 1000), "ok");
+  // 服务端并发处理同一连接上的请求, 慢请求在途时后续请求立即返回
+  sylar::Semaphore         slow_done;
+  sylar::RockResponse::ptr slow;
+  stream->request(
+      MakeRequest(kCmdSlow, "slow"),
+      [&](sylar::RockResponse::ptr rsp) {
+        slow = rsp;
+        slow_done.notify();
+      },
+      1000);
+  uint64_t begin = NowNs();
+  errors += !IsEcho(stream->request(MakeRequest(kCmdEcho, "fast"), 1000),
+                    "fast");
+  errors += NowNs() - begin > 100 * 1000 * 1000;
+  slow_done.wait();
+  errors += !IsEcho(slow, "slow");
+  // 跨越多个内存块的body
+  std::string big = MakeBody(4 << 20);
+  errors += !IsEcho(stream->request(MakeRequest(kCmdEcho, big), 5000), big);
+
+  sylar::Semaphore       sem;
+  sylar::RockStream::ptr down;
+  iom->schedule([&]() {
+    down = sylar::RockStream::Connect(iom, "127.0.0.1:1", 100);
+    sem.notify();
+  });
+  sem.wait();
+  errors += down != nullptr;
+  printf("checks             errors %lu\n", (unsigned long)errors);
+  return errors == 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1) {
+    opt.requests = strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    opt.payload = strtoul(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    opt.concurrency = strtoul(argv[3], nullptr, 10);
+  }
+  printf("requests=%lu payload=%lu concurrency=%lu\n",
+         (unsigned long)opt.requests,
+         (unsigned long)opt.payload,
+         (unsigned long)opt.concurrency);
+
+  sylar::IOManager server_iom(1, "rock_server");
+  sylar::IOManager client_iom(1, "rock_client");
+  server_iom.start();
+  client_iom.start();
+
+  std::string body = MakeBody(opt.payload);
+  int         rt   = 0;
+  for (auto c : {sylar::RockMessageDecoder::NONE,
+                 sylar::RockMessageDecoder::SNAPPY,
+                 sylar::RockMessageDecoder::ZLIB}) {
+    sylar::RockServer::ptr server(new sylar::RockServer(&server_iom));
+    server->setCompress(c, 256);
+    server->setRequestHandler([&server_iom](sylar::RockRequest::ptr  req,
+                                            sylar::RockResponse::ptr rsp,
+                                            sylar::RockStream::ptr) {
+      if (req->getCmd() == kCmdSlow) {
+        server_iom.sleep(200);
+      }
+      rsp->setBody(req->getBody());
+      return true;
+    });
+    if (!server->bind("127.0.0.1:0")) {
+      return 1;
+    }
+    server->start();
+
+    sylar::Semaphore       sem;
+    sylar::RockStream::ptr stream;
+    client_iom.schedule([&]() {
+      stream = sylar::RockStream::Connect(
+          &client_iom, server->getAddresses()[0], 1000);
+      sem.notify();
+    });
+    sem.wait();
+    if (!stream) {
+      return 1;
+    }
+    stream->setCompress(c, 256);
+    stream->start();
+
+    std::string name = sylar::RockMessageDecoder::CompressToString(c);
+    RunSequential(stream, opt, body, name);
+    RunConcurrent(stream, opt, body, name);
+    if (c == sylar::RockMessageDecoder::NONE &&
+        !CheckErrors(&client_iom, stream)) {
+      rt = 1;
+    }
+
+    stream->close();
+    server->stop();
+  }
+
+  client_iom.stop();
+  server_iom.stop();
+  return rt;
+}
@@ -0,0 +1,356 @@
+/**
+ * @file rock_test.cc
+ * @brief ByteArray与rock帧编解码的单元测试
+ * @details 覆盖varint/zigzag边界值, 截断数据的读取, 任意位置切分的帧,
+ *          错误的magic/长度, snappy/zlib压缩往返
+ */
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sylar/bytearray.h"
+#include "sylar/rock/rock_protocol.h"
+
+namespace {
+
+using sylar::ByteArray;
+using sylar::RockMessage;
+using sylar::RockMessageDecoder;
+using sylar::RockRequest;
+using sylar::RockResponse;
+
+/// varint按7位分组, 取每组长度的两侧
+const uint64_t kVarintBounds[] = {0,
+                                  1,
+                                  127,
+                                  128,
+                                  16383,
+                                  16384,
+                                  (1ull << 21) - 1,
+                                  1ull << 21,
+                                  (1ull << 28) - 1,
+                                  1ull << 28,
+                                  (1ull << 35) - 1,
+                                  1ull << 35,
+                                  (1ull << 63) - 1,
+                                  1ull << 63,
+                                  std::numeric_limits<uint64_t>::max()};
+
+size_t VarintSize(uint64_t v) {
+  size_t n = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    ++n;
+  }
+  return n;
+}
+
+TEST(ByteArrayTest, VarintBoundaries) {
+  // 小内存块使编码跨块
+  ByteArray ba(3);
+  for (uint64_t v : kVarintBounds) {
+    size_t start = ba.getPosition();
+    ba.writeUint64(v);
+    EXPECT_EQ(VarintSize(v), ba.getPosition() - start) << v;
+    if (v <= std::numeric_limits<uint32_t>::max()) {
+      start = ba.getPosition();
+      ba.writeUint32(v);
+      EXPECT_EQ(VarintSize(v), ba.getPosition() - start) << v;
+    }
+  }
+  ba.writeUint32(std::numeric_limits<uint32_t>::max());
+  ba.setPosition(0);
+  for (uint64_t v : kVarintBounds) {
+    EXPECT_EQ(v, ba.readUint64());
+    if (v <= std::numeric_limits<uint32_t>::max()) {
+      EXPECT_EQ(v, ba.readUint32());
+    }
+  }
+  EXPECT_EQ(std::numeric_limits<uint32_t>::max(), ba.readUint32());
+  EXPECT_EQ(0u, ba.getReadSize());
+}
+
+TEST(ByteArrayTest, ZigzagBoundaries) {
+  const int32_t i32[] = {0,
+                         -1,
+                         1,
+                         -64,
+                         63,
+                         -65,
+                         64,
+                         std::numeric_limits<int32_t>::min(),
+                         std::numeric_limits<int32_t>::max()};
+  const int64_t i64[] = {0,
+                         -1,
+                         1,
+                         -64,
+                         64,
+                         std::numeric_limits<int32_t>::min() - 1ll,
+                         std::numeric_limits<int32_t>::max() + 1ll,
+                         std::numeric_limits<int64_t>::min(),
+                         std::numeric_limits<int64_t>::max()};
+  ByteArray ba(3);
+  for (int32_t v : i32) {
+    ba.writeInt32(v);
+  }
+  for (int64_t v : i64) {
+    ba.writeInt64(v);
+  }
+  ba.setPosition(0);
+  // zigzag使绝对值小的负数也只占1字节
+  EXPECT_EQ(0, ba.readInt32());
+  EXPECT_EQ(1u, ba.getPosition());
+  EXPECT_EQ(-1, ba.readInt32());
+  EXPECT_EQ(2u, ba.getPosition());
+  for (size_t i = 2; i < sizeof(i32) / sizeof(i32[0]); ++i) {
+    EXPECT_EQ(i32[i], ba.readInt32());
+  }
+  for (int64_t v : i64) {
+    EXPECT_EQ(v, ba.readInt64());
+  }
+  EXPECT_EQ(0u, ba.getReadSize());
+}
+
+TEST(ByteArrayTest, TruncatedReadsThrow) {
+  {
+    ByteArray ba;
+    ba.writeFuint16(10);
+    ba.write("abc", 3);
+    ba.setPosition(0);
+    EXPECT_THROW(ba.readStringF16(), std::out_of_range);
+  }
+  {
+    ByteArray ba;
+    ba.writeFuint32(1u << 30);
+    ba.write("abc", 3);
+    ba.setPosition(0);
+    EXPECT_THROW(ba.readStringF32(), std::out_of_range);
+  }
+  {
+    ByteArray ba;
+    ba.writeUint64(1ull << 40);
+    ba.write("abc", 3);
+    ba.setPosition(0);
+    EXPECT_THROW(ba.readStringVint(), std::out_of_range);
+  }
+  {
+    // varint没有结束字节
+    ByteArray ba;
+    ba.write("\x80\x80", 2);
+    ba.setPosition(0);
+    EXPECT_THROW(ba.readUint32(), std::out_of_range);
+    ba.setPosition(0);
+    EXPECT_THROW(ba.readUint64(), std::out_of_range);
+  }
+  {
+    ByteArray ba;
+    ba.write("\x01\x02\x03", 3);
+    ba.setPosition(0);
+    EXPECT_THROW(ba.readFuint32(), std::out_of_range);
+  }
+}
+
+RockMessage::ptr MakeRequest(uint32_t sn, const std::string &body) {
+  RockRequest::ptr req(new RockRequest);
+  req->setSn(sn);
+  req->setCmd(100 + sn);
+  req->setBody(body);
+  return req;
+}
+
+RockMessage::ptr MakeResponse(uint32_t sn, const std::string &body) {
+  RockResponse::ptr rsp(new RockResponse);
+  rsp->setSn(sn);
+  rsp->setCmd(100 + sn);
+  rsp->setResult(-(int32_t)sn);
+  rsp->setResultStr("result " + std::to_string(sn));
+  rsp->setBody(body);
+  return rsp;
+}
+
+void ExpectSame(const RockMessage::ptr &expect, const RockMessage::ptr &got) {
+  ASSERT_TRUE(got);
+  ASSERT_EQ(expect->getType(), got->getType());
+  EXPECT_EQ(expect->getSn(), got->getSn());
+  EXPECT_EQ(expect->getCmd(), got->getCmd());
+  EXPECT_EQ(expect->getBody(), got->getBody());
+  if (expect->getType() == RockMessage::RESPONSE) {
+    auto e = std::static_pointer_cast<RockResponse>(expect);
+    auto g = std::static_pointer_cast<RockResponse>(got);
+    EXPECT_EQ(e->getResult(), g->getResult());
+    EXPECT_EQ(e->getResultStr(), g->getResultStr());
+  }
+}
+
+/// @brief 在ba末尾追加数据, 不改变解析位置
+void Append(ByteArray &ba, const std::string &data) {
+  size_t pos = ba.getPosition();
+  ba.setPosition(ba.getSize());
+  ba.write(data.data(), data.size());
+  ba.setPosition(pos);
+}
+
+std::string Encode(
+    const RockMessage::ptr      &msg,
+    RockMessageDecoder::Compress compress  = RockMessageDecoder::NONE,
+    size_t                       threshold = 0) {
+  ByteArray::ptr ba(new ByteArray(64));
+  RockMessageDecoder::Encode(msg, ba, compress, threshold);
+  ba->setPosition(0);
+  return ba->toString();
+}
+
+/// @brief 改写帧头中的长度
+void SetLength(std::string &frame, uint32_t len) {
+  frame[4] = len >> 24;
+  frame[5] = len >> 16;
+  frame[6] = len >> 8;
+  frame[7] = len;
+}
+
+/// @brief 帧头中的压缩方式
+int FrameCompress(const std::string &frame) {
+  return frame[3] & 0x3;
+}
+
+TEST(RockCodecTest, DecodeSplitAtEveryByte) {
+  std::vector<RockMessage::ptr> msgs = {
+      MakeRequest(1, "hello"),
+      MakeResponse(2, std::string(300, 'x')),
+      MakeRequest(3, ""),
+      MakeRequest(4, std::string(2000, 'y')),
+      MakeResponse(5, std::string(1000, 'z')),
+  };
+  std::string wire = Encode(msgs[0]) + Encode(msgs[1]) + Encode(msgs[2]) +
+                     Encode(msgs[3], RockMessageDecoder::SNAPPY) +
+                     Encode(msgs[4], RockMessageDecoder::ZLIB);
+  ASSERT_EQ(RockMessageDecoder::SNAPPY,
+            FrameCompress(Encode(msgs[3], RockMessageDecoder::SNAPPY)));
+  ASSERT_EQ(RockMessageDecoder::ZLIB,
+            FrameCompress(Encode(msgs[4], RockMessageDecoder::ZLIB)));
+
+  for (size_t split = 0; split <= wire.size(); ++split) {
+    ByteArray::ptr                ba(new ByteArray(16));
+    std::vector<RockMessage::ptr> got;
+    RockMessage::ptr              m;
+    for (auto &part : {wire.substr(0, split), wire.substr(split)}) {
+      Append(*ba, part);
+      int rt = 0;
+      while ((rt = RockMessageDecoder::Decode(ba, m)) == 1) {
+        got.push_back(m);
+      }
+      ASSERT_EQ(0, rt) << "split=" << split;
+    }
+    ASSERT_EQ(msgs.size(), got.size()) << "split=" << split;
+    for (size_t i = 0; i < msgs.size(); ++i) {
+      ExpectSame(msgs[i], got[i]);
+    }
+    EXPECT_EQ(0u, ba->getReadSize());
+  }
+}
+
+int DecodeString(const std::string &frame) {
+  ByteArray::ptr ba(new ByteArray);
+  ba->write(frame.data(), frame.size());
+  ba->setPosition(0);
+  RockMessage::ptr m;
+  int              rt = RockMessageDecoder::Decode(ba, m);
+  if (rt == 0) {
+    // 数据不足时位置不变
+    EXPECT_EQ(0u, ba->getPosition());
+  }
+  return rt;
+}
+
+TEST(RockCodecTest, BadMagicAndLength) {
+  std::string frame = Encode(MakeRequest(1, "hello"));
+  ASSERT_EQ(1, DecodeString(frame));
+  EXPECT_EQ(0, DecodeString(frame.substr(0, 7)));
+  EXPECT_EQ(0, DecodeString(frame.substr(0, frame.size() - 1)));
+
+  std::string bad = frame;
+  bad[0]          = 0;
+  EXPECT_EQ(-1, DecodeString(bad));
+  bad    = frame;
+  bad[1] = 0;
+  EXPECT_EQ(-1, DecodeString(bad));
+  bad    = frame;
+  bad[2] = 2;
+  EXPECT_EQ(-1, DecodeString(bad));
+
+  size_t len = frame.size() - RockMessageDecoder::kHeaderSize;
+  bad        = frame;
+  SetLength(bad, RockMessageDecoder::kMaxBodySize + 1);
+  EXPECT_EQ(-1, DecodeString(bad));
+  // 长度比body短: 消息被截断
+  bad = frame;
+  SetLength(bad, len - 1);
+  EXPECT_EQ(-1, DecodeString(bad));
+  // 长度比body长: 多出的字节不属于消息
+  bad = frame + "x";
+  SetLength(bad, len + 1);
+  EXPECT_EQ(-1, DecodeString(bad));
+  // 未知的消息类型与压缩方式
+  bad    = frame;
+  bad[8] = 9;
+  EXPECT_EQ(-1, DecodeString(bad));
+  bad    = frame;
+  bad[3] = 3;
+  EXPECT_EQ(-1, DecodeString(bad));
+  // 空body
+  EXPECT_EQ(-1, DecodeString(frame.substr(0, 4) + std::string(4, '\0')));
+}
+
+TEST(RockCodecTest, CompressRoundTrip) {
+  std::string text;
+  for (int i = 0; text.size() < 200 * 1024; ++i) {
+    text += std::string(500 + i % 13, 'a' + i % 26);
+  }
+  // 伪随机数据压缩后不会变小
+  std::string noise(4096, '\0');
+  uint32_t    seed = 1;
+  for (auto &c : noise) {
+    seed = seed * 1103515245 + 12345;
+    c    = seed >> 16;
+  }
+
+  for (auto compress : {RockMessageDecoder::SNAPPY, RockMessageDecoder::ZLIB}) {
+    SCOPED_TRACE(RockMessageDecoder::CompressToString(compress));
+    std::vector<RockMessage::ptr> msgs = {MakeRequest(1, text),
+                                          MakeResponse(2, text),
+                                          MakeRequest(3, noise),
+                                          MakeRequest(4, "tiny")};
+    std::vector<std::string>      frames;
+    for (auto &m : msgs) {
+      frames.push_back(Encode(m, compress, 64));
+    }
+    EXPECT_EQ(compress, FrameCompress(frames[0]));
+    EXPECT_LT(frames[0].size(), text.size() / 2);
+    EXPECT_EQ(compress, FrameCompress(frames[1]));
+    EXPECT_EQ(RockMessageDecoder::NONE, FrameCompress(frames[2]));
+    EXPECT_EQ(RockMessageDecoder::NONE, FrameCompress(frames[3]));
+
+    ByteArray::ptr ba(new ByteArray(1024));
+    for (auto &f : frames) {
+      ba->write(f.data(), f.size());
+    }
+    ba->setPosition(0);
+    for (auto &expect : msgs) {
+      RockMessage::ptr m;
+      ASSERT_EQ(1, RockMessageDecoder::Decode(ba, m));
+      ExpectSame(expect, m);
+    }
+    EXPECT_EQ(0u, ba->getReadSize());
+
+    // 压缩数据被截断
+    std::string bad = frames[0].substr(0, frames[0].size() - 4);
+    SetLength(bad, bad.size() - RockMessageDecoder::kHeaderSize);
+    EXPECT_EQ(-1, DecodeString(bad));
+  }
+}
+
+}  // namespace
@@ -0,0 +1,224 @@
+/**
+ * @file scheduler_bench.cc
+ * @brief 调度器性能测试: 任务吞吐与p99派发延迟
+ * @details 用法: scheduler_bench [线程数] [任务数]
+ *          对比 sylar::Scheduler(工作窃取) 与 mutex+condvar 全局队列线程池
+ *          external: 外部线程提交全部任务
+ *          external4: 4个外部线程并发提交全部任务
+ *          fanout:   工作线程内递归派生子任务
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sylar/mutex.h"
+#include "sylar/scheduler.h"
+
+namespace {
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/// 模拟任务的计算量
+void Work() {
+  volatile uint64_t x = 0;
+  for (int i = 0; i < 50; ++i) {
+    x = x + i;
+  }
+}
+
+/// 基线: 单个全局队列 + mutex + condition_variable
+class CondVarPool {
+public:
+  explicit CondVarPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+      m_threads.emplace_back([this]() {
+        while (true) {
+          std::function<void()> cb;
+          {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+              return;
+            }
+            cb = std::move(m_tasks.front());
+            m_tasks.pop_front();
+          }
+          cb();
+        }
+      });
+    }
+  }
+
+  ~CondVarPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto &t : m_threads) {
+      t.join();
+    }
+  }
+
+  void schedule(std::function<void()> cb) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push_back(std::move(cb));
+    }
+    m_cond.notify_one();
+  }
+
+private:
+  std::mutex                        m_mutex;
+  std::condition_variable           m_cond;
+  std::deque<std::function<void()>> m_tasks;
+  std::vector<std::thread>          m_threads;
+  bool                              m_stop = false;
+};
+
+/// 统计结果
+struct Result {
+  double   mops = 0;
+  uint64_t p50  = 0;
+  uint64_t p99  = 0;
+};
+
+/// 按线程分片记录派发延迟, 避免统计本身引入竞争
+struct LatencyRecorder {
+  explicit LatencyRecorder(size_t count) : samples(count) {
+  }
+
+  void record(size_t idx, uint64_t submit_ns) {
+    samples[idx] = NowNs() - submit_ns;
+  }
+
+  void fill(Result &r) {
+    std::sort(samples.begin(), samples.end());
+    r.p50 = samples[samples.size() / 2];
+    r.p99 = samples[samples.size() * 99 / 100];
+  }
+
+  std::vector<uint64_t> samples;
+};
+
+/// producers个外部线程各提交count/producers个任务
+template <class Pool>
+Result RunExternal(Pool &pool, size_t count, size_t producers = 1) {
+  size_t                   per   = count / producers;
+  size_t                   total = per * producers;
+  LatencyRecorder          latency(total);
+  std::atomic<size_t>      done{0};
+  sylar::Semaphore         finish;
+  std::vector<std::thread> threads;
+  uint64_t                 begin = NowNs();
+  for (size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p]() {
+      for (size_t i = p * per; i < (p + 1) * per; ++i) {
+        uint64_t submit = NowNs();
+        // total按值捕获: 最后一个任务通知后本函数即返回,
+        // 其他任务此时可能还没读完
+        pool.schedule([&, i, submit, total]() {
+          latency.record(i, submit);
+          Work();
+          if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == total) {
+            finish.notify();
+          }
+        });
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  finish.wait();
+  uint64_t end = NowNs();
+
+  Result r;
+  r.mops = double(total) * 1000 / (end - begin);
+  latency.fill(r);
+  return r;
+}
+
+/// 工作线程内二叉树式派生子任务, 叶子数为count
+template <class Pool>
+Result RunFanout(Pool &pool, size_t count) {
+  LatencyRecorder     latency(count * 2);
+  std::atomic<size_t> index{0};
+  std::atomic<size_t> done{0};
+  sylar::Semaphore    finish;
+
+  std::function<void(size_t, uint64_t)> spawn;
+  spawn = [&](size_t leaves, uint64_t submit) {
+    latency.record(index.fetch_add(1, std::memory_order_relaxed), submit);
+    Work();
+    if (leaves <= 1) {
+      if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+        finish.notify();
+      }
+      return;
+    }
+    size_t   left = leaves / 2;
+    uint64_t now  = NowNs();
+    pool.schedule([&, left, now]() { spawn(left, now); });
+    pool.schedule([&, leaves, left, now]() { spawn(leaves - left, now); });
+  };
+
+  uint64_t begin = NowNs();
+  pool.schedule([&, begin]() { spawn(count, begin); });
+  finish.wait();
+  uint64_t end = NowNs();
+
+  Result r;
+  r.mops = double(index.load()) * 1000 / (end - begin);
+  latency.samples.resize(index.load());
+  latency.fill(r);
+  return r;
+}
+
+void Print(const char *pool, const char *mode, const Result &r) {
+  printf("%-12s %-9s %10.2f Mtask/s  p50 %8lu ns  p99 %8lu ns\n",
+         pool,
+         mode,
+         r.mops,
+         (unsigned long)r.p50,
+         (unsigned long)r.p99);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t threads = argc > 1 ? strtoul(argv[1], nullptr, 10) : 8;
+  size_t count   = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000;
+  printf("threads=%lu tasks=%lu\n",
+         (unsigned long)threads,
+         (unsigned long)count);
+
+  {
+    sylar::Scheduler sc(threads, "bench");
+    sc.start();
+    Print("scheduler", "external", RunExternal(sc, count));
+    Print("scheduler", "external4", RunExternal(sc, count, 4));
+    Print("scheduler", "fanout", RunFanout(sc, count));
+    sc.stop();
+  }
+  {
+    CondVarPool pool(threads);
+    Print("condvar", "external", RunExternal(pool, count));
+    Print("condvar", "external4", RunExternal(pool, count, 4));
+    Print("condvar", "fanout", RunFanout(pool, count));
+  }
+  return 0;
+}
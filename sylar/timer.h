@@ -0,0 +1,146 @@
+/**
+ * @file timer.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 定时器封装
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __TIMER__H__
+#define __TIMER__H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "sylar/mutex.h"
+
+namespace sylar {
+
+class TimerManager;
+
+/// @brief 定时器
+class Timer : public std::enable_shared_from_this<Timer> {
+  friend class TimerManager;
+
+public:
+  /// 定时器的智能指针类型
+  typedef std::shared_ptr<Timer> ptr;
+
+  /// @brief 取消定时器
+  bool cancel();
+
+  /// @brief 刷新设置定时器的执行时间
+  bool refresh();
+
+  /// @brief 重置定时器时间
+  /// @param ms 定时器执行间隔时间(毫秒)
+  /// @param from_now 是否从当前时间开始计算
+  bool reset(uint64_t ms, bool from_now);
+
+private:
+  /// @brief 构造函数
+  /// @param ms 定时器执行间隔时间
+  /// @param cb 回调函数
+  /// @param recurring 是否循环
+  /// @param manager 定时器管理器
+  Timer(uint64_t              ms,
+        std::function<void()> cb,
+        bool                  recurring,
+        TimerManager         *manager);
+
+  /// @brief 构造函数
+  /// @param next 执行的时间戳(毫秒)
+  Timer(uint64_t next);
+
+private:
+  /// 是否循环定时器
+  bool m_recurring = false;
+  /// 执行周期
+  uint64_t m_ms = 0;
+  /// 精确的执行时间
+  uint64_t m_next = 0;
+  /// 回调函数
+  std::function<void()> m_cb;
+  /// 定时器管理器
+  TimerManager *m_manager = nullptr;
+
+private:
+  /// @brief 定时器比较仿函数
+  struct Comparator {
+    /// @brief 比较定时器的智能指针的大小(按执行时间排序)
+    bool operator()(const Timer::ptr &lhs, const Timer::ptr &rhs) const;
+  };
+};
+
+/// @brief 定时器管理器
+class TimerManager {
+  friend class Timer;
+
+public:
+  /// 读写锁类型
+  typedef RWMutex RWMutexType;
+
+  /// @brief 构造函数
+  TimerManager();
+
+  /// @brief 析构函数
+  virtual ~TimerManager();
+
+  /// @brief 添加定时器
+  /// @param ms 定时器执行间隔时间
+  /// @param cb 定时器回调函数
+  /// @param recurring 是否循环定时器
+  Timer::ptr addTimer(uint64_t              ms,
+                      std::function<void()> cb,
+                      bool                  recurring = false);
+
+  /// @brief 添加条件定时器
+  /// @param ms 定时器执行间隔时间
+  /// @param cb 定时器回调函数
+  /// @param weak_cond 条件, 触发时已失效则不执行回调
+  /// @param recurring 是否循环
+  Timer::ptr addConditionTimer(uint64_t              ms,
+                               std::function<void()> cb,
+                               std::weak_ptr<void>   weak_cond,
+                               bool                  recurring = false);
+
+  /// @brief 到最近一个定时器执行的时间间隔(毫秒), 没有定时器返回~0ull
+  uint64_t getNextTimer();
+
+  /// @brief 获取需要执行的定时器的回调函数列表
+  /// @param[out] cbs 回调函数数组
+  void listExpiredCallbacks(std::vector<std::function<void()> > &cbs);
+
+  /// @brief 是否有定时器
+  bool hasTimer();
+
+  /// @brief 当前单调时钟(毫秒)
+  static uint64_t GetCurrentMS();
+
+protected:
+  /// @brief 当有新的定时器插入到定时器的首部, 执行该函数
+  virtual void onTimerInsertedAtFront() = 0;
+
+  /// @brief 将定时器添加到管理器中
+  void addTimer(Timer::ptr val, RWMutexType::WriteLock &lock);
+
+private:
+  /// Mutex
+  RWMutexType m_mutex;
+  /// 定时器集合
+  std::set<Timer::ptr, Timer::Comparator> m_timers;
+  /// 是否触发onTimerInsertedAtFront
+  std::atomic<bool> m_tickled{false};
+};
+
+}  // namespace sylar
+
+#endif /* __TIMER__H__ */
@@ -0,0 +1,77 @@
+/**
+ * @file orm_gen.cc
+ * @brief ORM代码生成工具, 由表描述xml生成数据结构和DAO
+ * @details 用法: orm_gen --out_dir=DIR [--include_prefix=PATH] a.xml [b.xml...]
+ *          每个xml生成DIR/<文件名>_info.h和DIR/<文件名>_info.cc,
+ *          cc中以 "PATH/<文件名>_info.h" 引用头文件
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "sylar/tools/orm_gen/table.h"
+#include "sylar/tools/orm_gen/xml.h"
+
+namespace {
+
+void Usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s --out_dir=DIR [--include_prefix=PATH] a.xml [b.xml...]\n",
+          prog);
+}
+
+/// @brief 输出文件名前缀: 去掉目录和.xml后缀
+std::string BaseName(const std::string &file) {
+  size_t      pos  = file.rfind('/');
+  std::string base = pos == std::string::npos ? file : file.substr(pos + 1);
+  if (base.size() > 4 && base.compare(base.size() - 4, 4, ".xml") == 0) {
+    base.resize(base.size() - 4);
+  }
+  return base;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string              out_dir = ".";
+  std::string              include_prefix;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 10, "--out_dir=") == 0) {
+      out_dir = arg.substr(10);
+    } else if (arg.compare(0, 17, "--include_prefix=") == 0) {
+      include_prefix = arg.substr(17);
+    } else if (arg == "-h" || arg == "--help") {
+      Usage(argv[0]);
+      return 0;
+    } else if (arg.compare(0, 2, "--") == 0) {
+      fprintf(stderr, "unknown option %s\n", arg.c_str());
+      Usage(argv[0]);
+      return 1;
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty()) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  for (auto &file : files) {
+    std::string            err;
+    sylar::orm::XmlElement root;
+    sylar::orm::Table      table;
+    std::string            source = file.substr(file.rfind('/') + 1);
+    if (!sylar::orm::ParseXmlFile(file, root, err) ||
+        !table.init(root, err) ||
+        !table.gen(out_dir, BaseName(file), include_prefix, source, err)) {
+      fprintf(stderr, "%s: %s\n", file.c_str(), err.c_str());
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,1066 @@
+#include "sylar/tools/orm_gen/table.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace sylar {
+namespace orm {
+
+namespace {
+
+/// 生成代码中使用的局部变量名和常见关键字, 作为参数名时追加下划线
+const std::set<std::string> s_reserved = {
+    "class", "conn",     "data",  "default",  "delete",  "double",
+    "float", "i",        "info",  "infos",    "insert",  "int",
+    "new",   "operator", "private", "public", "results", "rt",
+    "sql",   "stmt",     "template", "this",  "trans",   "union",
+    "unsigned", "v",
+};
+
+bool IsIdentifier(const std::string &v) {
+  if (v.empty() || !isalpha((unsigned char)v[0])) {
+    return false;
+  }
+  for (auto c : v) {
+    if (!isalnum((unsigned char)c) && c != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief create_time -> CreateTime
+std::string Camel(const std::string &v) {
+  std::string rt;
+  bool        upper = true;
+  for (auto c : v) {
+    if (c == '_') {
+      upper = true;
+      continue;
+    }
+    rt.push_back(upper ? toupper((unsigned char)c) : c);
+    upper = false;
+  }
+  return rt;
+}
+
+std::string ToUpper(std::string v) {
+  std::transform(v.begin(), v.end(), v.begin(), ::toupper);
+  return v;
+}
+
+/// @brief 转换为C++字符串字面量
+std::string CppQuote(const std::string &v) {
+  std::string rt = "\"";
+  for (auto c : v) {
+    switch (c) {
+      case '"':
+        rt += "\\\"";
+        break;
+      case '\\':
+        rt += "\\\\";
+        break;
+      case '\n':
+        rt += "\\n";
+        break;
+      case '\t':
+        rt += "\\t";
+        break;
+      default:
+        rt.push_back(c);
+    }
+  }
+  return rt + "\"";
+}
+
+/// @brief 转换为SQL字符串字面量
+std::string SqlQuote(const std::string &v) {
+  std::string rt = "'";
+  for (auto c : v) {
+    if (c == '\'') {
+      rt.push_back('\'');
+    }
+    rt.push_back(c);
+  }
+  return rt + "'";
+}
+
+bool IsNumber(const std::string &v, bool integer) {
+  if (v.empty()) {
+    return false;
+  }
+  char *end = nullptr;
+  if (integer) {
+    strtoll(v.c_str(), &end, 10);
+  } else {
+    strtod(v.c_str(), &end);
+  }
+  return *end == '\0';
+}
+
+std::string Join(const std::vector<std::string> &v, const std::string &sep) {
+  std::string rt;
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (i) {
+      rt += sep;
+    }
+    rt += v[i];
+  }
+  return rt;
+}
+
+/// @brief 参数名, 与生成代码的局部变量冲突时追加下划线
+std::string ParamName(const std::string &col) {
+  return s_reserved.count(col) ? col + "_" : col;
+}
+
+/// @brief 输出函数声明/定义头, 超过80列时每个参数一行并对齐
+void Signature(std::ostream                   &os,
+               const std::string              &prefix,
+               const std::vector<std::string> &params,
+               const std::string              &suffix) {
+  std::string line = prefix + "(" + Join(params, ", ") + ")" + suffix;
+  if (line.size() <= 80 || params.size() <= 1) {
+    os << line << "\n";
+    return;
+  }
+  std::string indent(prefix.size() + 1, ' ');
+  os << prefix << "(";
+  for (size_t i = 0; i < params.size(); ++i) {
+    if (i) {
+      os << ",\n" << indent;
+    }
+    os << params[i];
+  }
+  os << ")" << suffix << "\n";
+}
+
+void OpenNamespace(std::ostream &os, const std::vector<std::string> &ns) {
+  for (auto &i : ns) {
+    os << "namespace " << i << " {\n";
+  }
+  if (!ns.empty()) {
+    os << "\n";
+  }
+}
+
+void CloseNamespace(std::ostream &os, const std::vector<std::string> &ns) {
+  for (auto it = ns.rbegin(); it != ns.rend(); ++it) {
+    os << "}  // namespace " << *it << "\n";
+  }
+  if (!ns.empty()) {
+    os << "\n";
+  }
+}
+
+std::vector<std::string> SplitNamespace(const std::string &ns) {
+  std::vector<std::string> rt;
+  std::stringstream        ss(ns);
+  std::string              item;
+  while (std::getline(ss, item, '.')) {
+    if (!item.empty()) {
+      rt.push_back(item);
+    }
+  }
+  return rt;
+}
+
+struct TypeInfo {
+  Column::Type type;
+  const char  *name;
+  const char  *cpp;
+  const char  *sqlite3;
+  const char  *fun;
+};
+
+const TypeInfo s_types[] = {
+    {Column::TYPE_INT8, "int8", "int8_t", "INTEGER", "Int8"},
+    {Column::TYPE_UINT8, "uint8", "uint8_t", "INTEGER", "Uint8"},
+    {Column::TYPE_INT16, "int16", "int16_t", "INTEGER", "Int16"},
+    {Column::TYPE_UINT16, "uint16", "uint16_t", "INTEGER", "Uint16"},
+    {Column::TYPE_INT32, "int32", "int32_t", "INTEGER", "Int32"},
+    {Column::TYPE_UINT32, "uint32", "uint32_t", "INTEGER", "Uint32"},
+    {Column::TYPE_INT64, "int64", "int64_t", "INTEGER", "Int64"},
+    {Column::TYPE_UINT64, "uint64", "uint64_t", "INTEGER", "Uint64"},
+    {Column::TYPE_FLOAT, "float", "float", "REAL", "Float"},
+    {Column::TYPE_DOUBLE, "double", "double", "REAL", "Double"},
+    {Column::TYPE_STRING, "string", "std::string", "TEXT", "String"},
+    {Column::TYPE_TEXT, "text", "std::string", "TEXT", "String"},
+    {Column::TYPE_BLOB, "blob", "std::string", "BLOB", "Blob"},
+    {Column::TYPE_TIMESTAMP, "timestamp", "time_t", "INTEGER", "Time"},
+};
+
+const TypeInfo &GetTypeInfo(Column::Type type) {
+  for (auto &i : s_types) {
+    if (i.type == type) {
+      return i;
+    }
+  }
+  return s_types[0];
+}
+
+}  // namespace
+
+Column::Type Column::ParseType(const std::string &v) {
+  for (auto &i : s_types) {
+    if (v == i.name) {
+      return i.type;
+    }
+  }
+  if (v == "datetime") {
+    return TYPE_TIMESTAMP;
+  }
+  return TYPE_NULL;
+}
+
+bool Column::init(const XmlElement &node, std::string &err) {
+  m_name          = node.getAttr("name");
+  m_type          = node.getAttr("type");
+  m_desc          = node.getAttr("desc");
+  m_default       = node.getAttr("default");
+  m_update        = node.getAttr("update");
+  m_length        = atoi(node.getAttr("length", "0").c_str());
+  m_autoIncrement = node.getAttr("auto_increment") == "true";
+  m_dtype         = ParseType(m_type);
+
+  std::string where = "line " + std::to_string(node.line) + ": column '" +
+                      m_name + "'";
+  if (!IsIdentifier(m_name)) {
+    err = where + " invalid name";
+    return false;
+  }
+  if (m_dtype == TYPE_NULL) {
+    err = where + " unknown type '" + m_type + "'";
+    return false;
+  }
+  if (m_autoIncrement && !isInteger()) {
+    err = where + " auto_increment requires an integer type";
+    return false;
+  }
+  if (!m_default.empty() && m_dtype != TYPE_STRING && m_dtype != TYPE_TEXT &&
+      m_dtype != TYPE_BLOB && !isDefaultNow() &&
+      !IsNumber(m_default, m_dtype != TYPE_FLOAT && m_dtype != TYPE_DOUBLE)) {
+    err = where + " invalid default '" + m_default + "'";
+    return false;
+  }
+  if (!m_update.empty() && !isUpdateNow()) {
+    err = where + " only timestamp update=\"current_timestamp\" is supported";
+    return false;
+  }
+  return true;
+}
+
+std::string Column::getCamelName() const {
+  return Camel(m_name);
+}
+
+std::string Column::getMemberName() const {
+  std::string camel = Camel(m_name);
+  camel[0]          = tolower((unsigned char)camel[0]);
+  return "m_" + camel;
+}
+
+std::string Column::getDTypeString() const {
+  return GetTypeInfo(m_dtype).cpp;
+}
+
+std::string Column::getSQLite3TypeString() const {
+  return GetTypeInfo(m_dtype).sqlite3;
+}
+
+std::string Column::getBindString() const {
+  return std::string("bind") + GetTypeInfo(m_dtype).fun;
+}
+
+std::string Column::getGetString() const {
+  return std::string("get") + GetTypeInfo(m_dtype).fun;
+}
+
+std::string Column::getDefaultValueString() const {
+  if (m_dtype == TYPE_STRING || m_dtype == TYPE_TEXT || m_dtype == TYPE_BLOB) {
+    return m_default.empty() ? "" : CppQuote(m_default);
+  }
+  if (isDefaultNow()) {
+    return "time(0)";
+  }
+  return m_default.empty() ? "0" : m_default;
+}
+
+std::string Column::getSQLite3Default() const {
+  if (m_dtype == TYPE_STRING || m_dtype == TYPE_TEXT || m_dtype == TYPE_BLOB) {
+    return "DEFAULT " + SqlQuote(m_default);
+  }
+  if (isDefaultNow()) {
+    return "DEFAULT (CAST(strftime('%s', 'now') AS INTEGER))";
+  }
+  return "DEFAULT " + (m_default.empty() ? std::string("0") : m_default);
+}
+
+bool Index::init(const XmlElement &node, std::string &err) {
+  m_name = node.getAttr("name");
+  m_desc = node.getAttr("desc");
+
+  std::string where = "line " + std::to_string(node.line) + ": index '" +
+                      m_name + "'";
+  std::string type = node.getAttr("type");
+  if (type == "pk") {
+    m_dtype = TYPE_PK;
+  } else if (type == "uniq") {
+    m_dtype = TYPE_UNIQ;
+  } else if (type == "index") {
+    m_dtype = TYPE_INDEX;
+  } else {
+    err = where + " unknown type '" + type + "'";
+    return false;
+  }
+  if (!IsIdentifier(m_name)) {
+    err = where + " invalid name";
+    return false;
+  }
+
+  std::stringstream ss(node.getAttr("cols"));
+  std::string       col;
+  while (std::getline(ss, col, ',')) {
+    col.erase(0, col.find_first_not_of(" \t"));
+    col.erase(col.find_last_not_of(" \t") + 1);
+    if (!col.empty()) {
+      m_cols.push_back(col);
+    }
+  }
+  if (m_cols.empty()) {
+    err = where + " has no cols";
+    return false;
+  }
+  return true;
+}
+
+bool Table::init(const XmlElement &root, std::string &err) {
+  if (root.name != "table") {
+    err = "root element must be <table>";
+    return false;
+  }
+  m_name      = root.getAttr("name");
+  m_namespace = root.getAttr("namespace");
+  m_desc      = root.getAttr("desc");
+  if (!IsIdentifier(m_name)) {
+    err = "invalid table name '" + m_name + "'";
+    return false;
+  }
+  for (auto &i : SplitNamespace(m_namespace)) {
+    if (!IsIdentifier(i)) {
+      err = "invalid namespace '" + m_namespace + "'";
+      return false;
+    }
+  }
+
+  for (auto &group : root.children) {
+    if (group.name == "columns") {
+      for (auto &node : group.children) {
+        if (node.name != "column") {
+          continue;
+        }
+        Column::ptr col(new Column);
+        if (!col->init(node, err)) {
+          return false;
+        }
+        if (getCol(col->getName())) {
+          err = "duplicate column '" + col->getName() + "'";
+          return false;
+        }
+        if (col->isAutoIncrement()) {
+          if (m_autoIncrement) {
+            err = "more than one auto_increment column";
+            return false;
+          }
+          m_autoIncrement = col;
+        }
+        m_cols.push_back(col);
+      }
+    } else if (group.name == "indexs") {
+      for (auto &node : group.children) {
+        if (node.name != "index") {
+          continue;
+        }
+        Index::ptr idx(new Index);
+        if (!idx->init(node, err)) {
+          return false;
+        }
+        for (auto &i : m_idxs) {
+          if (i->getName() == idx->getName()) {
+            err = "duplicate index '" + idx->getName() + "'";
+            return false;
+          }
+        }
+        if (idx->isPK()) {
+          if (m_pk) {
+            err = "more than one pk index";
+            return false;
+          }
+          m_pk = idx;
+        }
+        m_idxs.push_back(idx);
+      }
+    }
+  }
+
+  if (m_cols.empty()) {
+    err = "table '" + m_name + "' has no columns";
+    return false;
+  }
+  if (!m_pk) {
+    err = "table '" + m_name + "' has no pk index";
+    return false;
+  }
+  for (auto &idx : m_idxs) {
+    for (auto &i : idx->getCols()) {
+      if (!getCol(i)) {
+        err = "index '" + idx->getName() + "' references unknown column '" +
+              i + "'";
+        return false;
+      }
+    }
+  }
+  if (m_autoIncrement && (m_pk->getCols().size() != 1 ||
+                          m_pk->getCols()[0] != m_autoIncrement->getName())) {
+    err = "auto_increment column '" + m_autoIncrement->getName() +
+          "' must be the only pk column";
+    return false;
+  }
+  return true;
+}
+
+Column::ptr Table::getCol(const std::string &name) const {
+  for (auto &i : m_cols) {
+    if (i->getName() == name) {
+      return i;
+    }
+  }
+  return nullptr;
+}
+
+bool Table::isPKCol(const std::string &name) const {
+  auto &cols = m_pk->getCols();
+  return std::find(cols.begin(), cols.end(), name) != cols.end();
+}
+
+std::string Table::getClassName() const {
+  return Camel(m_name) + "Info";
+}
+
+std::string Table::getDaoClassName() const {
+  return Camel(m_name) + "InfoDao";
+}
+
+std::string Table::getIndexSuffix(Index::ptr idx) const {
+  std::string rt;
+  for (auto &i : idx->getCols()) {
+    rt += Camel(i);
+  }
+  return rt;
+}
+
+std::string Table::getIndexParams(Index::ptr idx) const {
+  std::vector<std::string> params;
+  for (auto &i : idx->getCols()) {
+    params.push_back("const " + getCol(i)->getDTypeString() + " &" +
+                     ParamName(i));
+  }
+  return Join(params, ", ");
+}
+
+std::string Table::getIndexWhere(Index::ptr idx) const {
+  std::vector<std::string> where;
+  for (auto &i : idx->getCols()) {
+    where.push_back(i + " = ?");
+  }
+  return Join(where, " AND ");
+}
+
+bool Table::gen(const std::string &out_dir,
+                const std::string &base,
+                const std::string &include_prefix,
+                const std::string &source,
+                std::string       &err) {
+  std::string header = base + "_info.h";
+  std::string include =
+      include_prefix.empty() ? header : include_prefix + "/" + header;
+  std::string dir = out_dir.empty() ? "." : out_dir;
+
+  std::stringstream hs;
+  genHeader(hs, source);
+  std::stringstream cs;
+  genSource(cs, include, source);
+
+  for (auto &i : {std::make_pair(dir + "/" + header, hs.str()),
+                  std::make_pair(dir + "/" + base + "_info.cc", cs.str())}) {
+    std::ofstream ofs(i.first, std::ios::trunc);
+    ofs << i.second;
+    ofs.close();
+    if (!ofs) {
+      err = "write " + i.first + " failed";
+      return false;
+    }
+  }
+  return true;
+}
+
+void Table::genHeader(std::ostream &os, const std::string &source) const {
+  std::vector<std::string> ns = SplitNamespace(m_namespace);
+  std::string              guard =
+      "__" + ToUpper(Join(ns, "_") + (ns.empty() ? "" : "_") + m_name) +
+      "_INFO__H__";
+
+  os << "// Generated by orm_gen from " << source << ". DO NOT EDIT!\n\n";
+  os << "#ifndef " << guard << "\n";
+  os << "#define " << guard << "\n\n";
+  os << "#include <stdint.h>\n";
+  os << "#include <time.h>\n\n";
+  os << "#include <memory>\n";
+  os << "#include <string>\n";
+  os << "#include <vector>\n\n";
+  os << "#include \"sylar/db/db.h\"\n\n";
+  OpenNamespace(os, ns);
+  os << "class " << getDaoClassName() << ";\n\n";
+  genClass(os);
+  genDaoDecl(os);
+  CloseNamespace(os, ns);
+  os << "#endif /* " << guard << " */\n";
+}
+
+void Table::genClass(std::ostream &os) const {
+  std::string cls = getClassName();
+  os << "/// @brief " << (m_desc.empty() ? m_name : m_desc) << "\n";
+  os << "class " << cls << " {\n";
+  os << "  friend class " << getDaoClassName() << ";\n\n";
+  os << "public:\n";
+  os << "  typedef std::shared_ptr<" << cls << "> ptr;\n\n";
+  os << "  " << cls << "();\n\n";
+
+  for (auto &i : m_cols) {
+    std::string type = i->getDTypeString();
+    if (!i->getDesc().empty()) {
+      os << "  /// @brief " << i->getDesc() << "\n";
+    }
+    os << "  const " << type << " &get" << i->getCamelName()
+       << "() const {\n";
+    os << "    return " << i->getMemberName() << ";\n";
+    os << "  }\n\n";
+    os << "  void set" << i->getCamelName() << "(const " << type
+       << " &v) {\n";
+    os << "    " << i->getMemberName() << " = v;\n";
+    os << "  }\n\n";
+  }
+  os << "  std::string toString() const;\n\n";
+
+  size_t width = 0;
+  for (auto &i : m_cols) {
+    width = std::max(width, i->getDTypeString().size());
+  }
+  os << "private:\n";
+  for (auto &i : m_cols) {
+    std::string type = i->getDTypeString();
+    os << "  " << type << std::string(width - type.size() + 1, ' ')
+       << i->getMemberName() << ";\n";
+  }
+  os << "};\n\n";
+}
+
+void Table::genDaoDecl(std::ostream &os) const {
+  std::string cls  = getClassName();
+  std::string ptr  = cls + "::ptr";
+  std::string conn = "sylar::IDB::ptr conn";
+  std::string vec  = "std::vector<" + ptr + "> &results";
+
+  os << "/// @brief " << m_name
+     << "表访问, 语句使用连接的预编译缓存, 同一连接不可并发使用\n";
+  os << "class " << getDaoClassName() << " {\n";
+  os << "public:\n";
+  os << "  /// @brief 插入";
+  if (m_autoIncrement) {
+    os << ", 回填" << m_autoIncrement->getName();
+  }
+  os << "\n";
+  Signature(os, "  static int Insert", {ptr + " info", conn}, ";");
+  os << "  /// @brief 插入, 主键冲突时更新其他列\n";
+  Signature(os, "  static int InsertOrUpdate", {ptr + " info", conn}, ";");
+  os << "  /// @brief 按主键更新\n";
+  Signature(os, "  static int Update", {ptr + " info", conn}, ";");
+  os << "  /// @brief 在一个事务内批量插入\n";
+  Signature(os,
+            "  static int BatchInsert",
+            {"const std::vector<" + ptr + "> &infos", conn},
+            ";");
+  os << "  /// @brief 在一个事务内批量插入或更新\n";
+  Signature(os,
+            "  static int BatchInsertOrUpdate",
+            {"const std::vector<" + ptr + "> &infos", conn},
+            ";");
+  Signature(os, "  static int Delete", {ptr + " info", conn}, ";");
+  for (auto &idx : m_idxs) {
+    Signature(os,
+              "  static int DeleteBy" + getIndexSuffix(idx),
+              {getIndexParams(idx), conn},
+              ";");
+  }
+  Signature(os, "  static int QueryAll", {vec, conn}, ";");
+  for (auto &idx : m_idxs) {
+    if (!idx->getDesc().empty()) {
+      os << "  /// @brief " << idx->getDesc() << "\n";
+    }
+    if (idx->isPK()) {
+      Signature(os,
+                "  static " + ptr + " Query",
+                {getIndexParams(idx), conn},
+                ";");
+    } else if (idx->isUnique()) {
+      Signature(os,
+                "  static " + ptr + " QueryBy" + getIndexSuffix(idx),
+                {getIndexParams(idx), conn},
+                ";");
+    } else {
+      Signature(os,
+                "  static int QueryBy" + getIndexSuffix(idx),
+                {vec, getIndexParams(idx), conn},
+                ";");
+    }
+  }
+  os << "  /// @brief 建表及索引\n";
+  Signature(os, "  static int CreateTableSQLite3", {conn}, ";");
+  os << "\n";
+  os << "private:\n";
+  Signature(os,
+            "  static void BindInsert",
+            {"sylar::IStmt &stmt", "const " + cls + " &info"},
+            ";");
+  Signature(os,
+            "  static void BindAll",
+            {"sylar::IStmt &stmt", "const " + cls + " &info"},
+            ";");
+  Signature(os,
+            "  static void BindUpdate",
+            {"sylar::IStmt &stmt", "const " + cls + " &info"},
+            ";");
+  Signature(os, "  static " + ptr + " Parse", {"sylar::ISQLData &data"}, ";");
+  os << "};\n\n";
+}
+
+void Table::genSource(std::ostream      &os,
+                      const std::string &include,
+                      const std::string &source) const {
+  std::vector<std::string> ns  = SplitNamespace(m_namespace);
+  std::string              cls = getClassName();
+
+  os << "// Generated by orm_gen from " << source << ". DO NOT EDIT!\n\n";
+  os << "#include \"" << include << "\"\n\n";
+  os << "#include <sstream>\n\n";
+  OpenNamespace(os, ns);
+
+  // 构造函数
+  std::vector<std::string> inits;
+  for (auto &i : m_cols) {
+    std::string v = i->getDefaultValueString();
+    if (!v.empty()) {
+      inits.push_back(i->getMemberName() + "(" + v + ")");
+    }
+  }
+  os << cls << "::" << cls << "()";
+  for (size_t i = 0; i < inits.size(); ++i) {
+    os << (i ? ",\n      " : "\n    : ") << inits[i];
+  }
+  os << " {\n}\n\n";
+
+  os << "std::string " << cls << "::toString() const {\n";
+  os << "  std::stringstream ss;\n";
+  os << "  ss << \"[" << cls << "\"";
+  for (auto &i : m_cols) {
+    os << "\n     << \" " << i->getName() << "=\" << ";
+    if (i->getDType() == Column::TYPE_INT8 ||
+        i->getDType() == Column::TYPE_UINT8) {
+      os << "(int)";
+    }
+    os << i->getMemberName();
+  }
+  os << " << \"]\";\n";
+  os << "  return ss.str();\n";
+  os << "}\n\n";
+
+  genDao(os);
+  CloseNamespace(os, ns);
+}
+
+void Table::genDao(std::ostream &os) const {
+  std::string cls  = getClassName();
+  std::string dao  = getDaoClassName();
+  std::string ptr  = cls + "::ptr";
+  std::string conn = "sylar::IDB::ptr conn";
+  std::string vec  = "std::vector<" + ptr + "> &results";
+
+  std::vector<std::string> all_cols;
+  std::vector<std::string> insert_cols;
+  std::vector<std::string> update_sets;
+  std::vector<std::string> upsert_sets;
+  for (auto &i : m_cols) {
+    all_cols.push_back(i->getName());
+    if (!i->isAutoIncrement()) {
+      insert_cols.push_back(i->getName());
+    }
+    if (!isPKCol(i->getName())) {
+      update_sets.push_back(i->getName() + " = ?");
+      upsert_sets.push_back(i->getName() + " = excluded." + i->getName());
+    }
+  }
+  std::string select =
+      "SELECT " + Join(all_cols, ", ") + " FROM " + m_name;
+  std::string insert_sql =
+      insert_cols.empty()
+          ? "INSERT INTO " + m_name + " DEFAULT VALUES"
+          : "INSERT INTO " + m_name + " (" + Join(insert_cols, ", ") +
+                ") VALUES (" +
+                Join(std::vector<std::string>(insert_cols.size(), "?"),
+                     ", ") +
+                ")";
+  std::string upsert_sql =
+      "INSERT INTO " + m_name + " (" + Join(all_cols, ", ") + ") VALUES (" +
+      Join(std::vector<std::string>(all_cols.size(), "?"), ", ") +
+      ") ON CONFLICT (" + Join(m_pk->getCols(), ", ") + ") DO " +
+      (upsert_sets.empty() ? "NOTHING"
+                           : "UPDATE SET " + Join(upsert_sets, ", "));
+  std::string update_sql = "UPDATE " + m_name + " SET " +
+                           Join(update_sets, ", ") + " WHERE " +
+                           getIndexWhere(m_pk);
+
+  // 同一sql在单条和批量操作间共享, 以复用连接缓存的预编译语句
+  auto gen_sql = [&os](const std::string &name, const std::string &sql) {
+    os << "static const std::string &" << name << "() {\n";
+    os << "  static const std::string sql =\n";
+    os << "      " << CppQuote(sql) << ";\n";
+    os << "  return sql;\n";
+    os << "}\n\n";
+  };
+  gen_sql("InsertSQL", insert_sql);
+  gen_sql("InsertOrUpdateSQL", upsert_sql);
+
+  auto gen_prepare = [&os](const std::string &sql, const std::string &fail) {
+    os << "  sylar::IStmt::ptr stmt = conn->prepareCached(" << sql << ");\n";
+    os << "  if (!stmt) {\n";
+    os << "    return " << fail << ";\n";
+    os << "  }\n";
+  };
+  auto gen_touch = [this, &os](const std::string &info, int indent) {
+    for (auto &i : m_cols) {
+      if (i->isUpdateNow()) {
+        os << std::string(indent, ' ') << info << "->" << i->getMemberName()
+           << " = time(0);\n";
+      }
+    }
+  };
+  auto gen_bind = [&os](Column::ptr col, int idx, const std::string &value) {
+    os << "  stmt." << col->getBindString() << "(" << idx << ", " << value
+       << ");\n";
+  };
+
+  // 绑定和解析
+  Signature(os,
+            "void " + dao + "::BindInsert",
+            {"sylar::IStmt &stmt", "const " + cls + " &info"},
+            " {");
+  int idx = 0;
+  for (auto &i : m_cols) {
+    if (!i->isAutoIncrement()) {
+      gen_bind(i, ++idx, "info." + i->getMemberName());
+    }
+  }
+  os << "}\n\n";
+
+  Signature(os,
+            "void " + dao + "::BindAll",
+            {"sylar::IStmt &stmt", "const " + cls + " &info"},
+            " {");
+  idx = 0;
+  for (auto &i : m_cols) {
+    gen_bind(i, ++idx, "info." + i->getMemberName());
+  }
+  os << "}\n\n";
+
+  Signature(os,
+            "void " + dao + "::BindUpdate",
+            {"sylar::IStmt &stmt", "const " + cls + " &info"},
+            " {");
+  idx = 0;
+  for (auto &i : m_cols) {
+    if (!isPKCol(i->getName())) {
+      gen_bind(i, ++idx, "info." + i->getMemberName());
+    }
+  }
+  for (auto &i : m_pk->getCols()) {
+    gen_bind(getCol(i), ++idx, "info." + getCol(i)->getMemberName());
+  }
+  os << "}\n\n";
+
+  Signature(os, ptr + " " + dao + "::Parse", {"sylar::ISQLData &data"}, " {");
+  os << "  " << ptr << " v(new " << cls << ");\n";
+  idx = 0;
+  for (auto &i : m_cols) {
+    if (i->isString()) {
+      os << "  v->" << i->getMemberName() << ".assign(data.getStringView("
+         << idx++ << "));\n";
+    } else {
+      os << "  v->" << i->getMemberName() << " = data." << i->getGetString()
+         << "(" << idx++ << ");\n";
+    }
+  }
+  os << "  return v;\n";
+  os << "}\n\n";
+
+  // 写操作
+  Signature(os, "int " + dao + "::Insert", {ptr + " info", conn}, " {");
+  gen_prepare("InsertSQL()", "conn->getErrno()");
+  os << "  BindInsert(*stmt, *info);\n";
+  os << "  int rt = stmt->execute();\n";
+  if (m_autoIncrement) {
+    os << "  if (rt == 0) {\n";
+    os << "    info->" << m_autoIncrement->getMemberName()
+       << " = stmt->getLastInsertId();\n";
+    os << "  }\n";
+  }
+  os << "  return rt;\n";
+  os << "}\n\n";
+
+  Signature(os, "int " + dao + "::InsertOrUpdate", {ptr + " info", conn}, " {");
+  if (m_autoIncrement) {
+    os << "  if (info->" << m_autoIncrement->getMemberName() << " == 0) {\n";
+    os << "    return Insert(info, conn);\n";
+    os << "  }\n";
+  }
+  gen_touch("info", 2);
+  gen_prepare("InsertOrUpdateSQL()", "conn->getErrno()");
+  os << "  BindAll(*stmt, *info);\n";
+  os << "  return stmt->execute();\n";
+  os << "}\n\n";
+
+  Signature(os, "int " + dao + "::Update", {ptr + " info", conn}, " {");
+  if (update_sets.empty()) {
+    os << "  return 0;\n";
+  } else {
+    gen_touch("info", 2);
+    os << "  static const std::string sql =\n";
+    os << "      " << CppQuote(update_sql) << ";\n";
+    gen_prepare("sql", "conn->getErrno()");
+    os << "  BindUpdate(*stmt, *info);\n";
+    os << "  return stmt->execute();\n";
+  }
+  os << "}\n\n";
+
+  Signature(os,
+            "int " + dao + "::BatchInsert",
+            {"const std::vector<" + ptr + "> &infos", conn},
+            " {");
+  os << "  if (infos.empty()) {\n";
+  os << "    return 0;\n";
+  os << "  }\n";
+  os << "  sylar::ITransaction::ptr trans = conn->openTransaction(false);\n";
+  os << "  if (!trans->begin()) {\n";
+  os << "    return conn->getErrno();\n";
+  os << "  }\n";
+  gen_prepare("InsertSQL()", "conn->getErrno()");
+  os << "  for (auto &i : infos) {\n";
+  os << "    BindInsert(*stmt, *i);\n";
+  os << "    int rt = stmt->execute();\n";
+  os << "    if (rt != 0) {\n";
+  os << "      trans->rollback();\n";
+  os << "      return rt;\n";
+  os << "    }\n";
+  if (m_autoIncrement) {
+    os << "    i->" << m_autoIncrement->getMemberName()
+       << " = stmt->getLastInsertId();\n";
+  }
+  os << "  }\n";
+  os << "  return trans->commit() ? 0 : conn->getErrno();\n";
+  os << "}\n\n";
+
+  Signature(os,
+            "int " + dao + "::BatchInsertOrUpdate",
+            {"const std::vector<" + ptr + "> &infos", conn},
+            " {");
+  os << "  if (infos.empty()) {\n";
+  os << "    return 0;\n";
+  os << "  }\n";
+  os << "  sylar::ITransaction::ptr trans = conn->openTransaction(false);\n";
+  os << "  if (!trans->begin()) {\n";
+  os << "    return conn->getErrno();\n";
+  os << "  }\n";
+  gen_prepare("InsertOrUpdateSQL()", "conn->getErrno()");
+  if (m_autoIncrement) {
+    os << "  sylar::IStmt::ptr insert;\n";
+  }
+  os << "  for (auto &i : infos) {\n";
+  os << "    int rt = 0;\n";
+  if (m_autoIncrement) {
+    os << "    if (i->" << m_autoIncrement->getMemberName() << " == 0) {\n";
+    os << "      if (!insert && !(insert = conn->prepareCached(InsertSQL()))) "
+          "{\n";
+    os << "        return conn->getErrno();\n";
+    os << "      }\n";
+    os << "      BindInsert(*insert, *i);\n";
+    os << "      if ((rt = insert->execute()) == 0) {\n";
+    os << "        i->" << m_autoIncrement->getMemberName()
+       << " = insert->getLastInsertId();\n";
+    os << "      }\n";
+    os << "    } else {\n";
+    gen_touch("i", 6);
+    os << "      BindAll(*stmt, *i);\n";
+    os << "      rt = stmt->execute();\n";
+    os << "    }\n";
+  } else {
+    gen_touch("i", 4);
+    os << "    BindAll(*stmt, *i);\n";
+    os << "    rt = stmt->execute();\n";
+  }
+  os << "    if (rt != 0) {\n";
+  os << "      trans->rollback();\n";
+  os << "      return rt;\n";
+  os << "    }\n";
+  os << "  }\n";
+  os << "  return trans->commit() ? 0 : conn->getErrno();\n";
+  os << "}\n\n";
+
+  // 删除
+  Signature(os, "int " + dao + "::Delete", {ptr + " info", conn}, " {");
+  std::vector<std::string> pk_args;
+  for (auto &i : m_pk->getCols()) {
+    pk_args.push_back("info->" + getCol(i)->getMemberName());
+  }
+  pk_args.push_back("conn");
+  os << "  return DeleteBy" << getIndexSuffix(m_pk) << "("
+     << Join(pk_args, ", ") << ");\n";
+  os << "}\n\n";
+
+  auto gen_bind_index = [this, &os](Index::ptr index) {
+    int n = 0;
+    for (auto &i : index->getCols()) {
+      os << "  stmt->" << getCol(i)->getBindString() << "(" << ++n << ", "
+         << ParamName(i) << ");\n";
+    }
+  };
+
+  for (auto &index : m_idxs) {
+    Signature(os,
+              "int " + dao + "::DeleteBy" + getIndexSuffix(index),
+              {getIndexParams(index), conn},
+              " {");
+    os << "  static const std::string sql =\n";
+    os << "      "
+       << CppQuote("DELETE FROM " + m_name + " WHERE " +
+                   getIndexWhere(index))
+       << ";\n";
+    gen_prepare("sql", "conn->getErrno()");
+    gen_bind_index(index);
+    os << "  return stmt->execute();\n";
+    os << "}\n\n";
+  }
+
+  // 查询
+  auto gen_query_list = [&os]() {
+    os << "  sylar::ISQLData::ptr data = stmt->query();\n";
+    os << "  if (!data) {\n";
+    os << "    return conn->getErrno();\n";
+    os << "  }\n";
+    os << "  while (data->next()) {\n";
+    os << "    results.push_back(Parse(*data));\n";
+    os << "  }\n";
+    os << "  return data->getErrno();\n";
+  };
+
+  Signature(os, "int " + dao + "::QueryAll", {vec, conn}, " {");
+  os << "  static const std::string sql =\n";
+  os << "      " << CppQuote(select) << ";\n";
+  gen_prepare("sql", "conn->getErrno()");
+  gen_query_list();
+  os << "}\n\n";
+
+  for (auto &index : m_idxs) {
+    std::string sql = select + " WHERE " + getIndexWhere(index);
+    if (index->isUnique()) {
+      Signature(os,
+                ptr + " " + dao +
+                    (index->isPK() ? "::Query"
+                                   : "::QueryBy" + getIndexSuffix(index)),
+                {getIndexParams(index), conn},
+                " {");
+      os << "  static const std::string sql =\n";
+      os << "      " << CppQuote(sql) << ";\n";
+      gen_prepare("sql", "nullptr");
+      gen_bind_index(index);
+      os << "  sylar::ISQLData::ptr data = stmt->query();\n";
+      os << "  if (!data || !data->next()) {\n";
+      os << "    return nullptr;\n";
+      os << "  }\n";
+      os << "  " << ptr << " v = Parse(*data);\n";
+      // 单行查询不会读到结束, 主动重置以释放读锁
+      os << "  stmt->reset();\n";
+      os << "  return v;\n";
+    } else {
+      Signature(os,
+                "int " + dao + "::QueryBy" + getIndexSuffix(index),
+                {vec, getIndexParams(index), conn},
+                " {");
+      os << "  static const std::string sql =\n";
+      os << "      " << CppQuote(sql) << ";\n";
+      gen_prepare("sql", "conn->getErrno()");
+      gen_bind_index(index);
+      gen_query_list();
+    }
+    os << "}\n\n";
+  }
+
+  genCreateTable(os);
+}
+
+void Table::genCreateTable(std::ostream &os) const {
+  std::vector<std::string> defs;
+  for (auto &i : m_cols) {
+    if (i->isAutoIncrement()) {
+      defs.push_back(i->getName() + " INTEGER PRIMARY KEY AUTOINCREMENT");
+    } else {
+      defs.push_back(i->getName() + " " + i->getSQLite3TypeString() +
+                     " NOT NULL " + i->getSQLite3Default());
+    }
+  }
+  if (!m_autoIncrement) {
+    defs.push_back("PRIMARY KEY (" + Join(m_pk->getCols(), ", ") + ")");
+  }
+
+  Signature(os,
+            "int " + getDaoClassName() + "::CreateTableSQLite3",
+            {"sylar::IDB::ptr conn"},
+            " {");
+  // 使用std::string重载, 避免sql中的%被当作格式串
+  os << "  return conn->execute(std::string(\n";
+  os << "      " << CppQuote("CREATE TABLE IF NOT EXISTS " + m_name + " (");
+  for (size_t i = 0; i < defs.size(); ++i) {
+    os << "\n      "
+       << CppQuote(defs[i] + (i + 1 == defs.size() ? "" : ", "));
+  }
+  os << "\n      " << CppQuote(");");
+  for (auto &idx : m_idxs) {
+    if (idx->isPK()) {
+      continue;
+    }
+    os << "\n      "
+       << CppQuote(std::string("CREATE ") +
+                   (idx->isUnique() ? "UNIQUE " : "") +
+                   "INDEX IF NOT EXISTS " + m_name + "_" + idx->getName() +
+                   " ON " + m_name + " (" + Join(idx->getCols(), ", ") +
+                   ");");
+  }
+  os << "));\n";
+  os << "}\n\n";
+}
+
+}  // namespace orm
+}  // namespace sylar
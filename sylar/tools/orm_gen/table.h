@@ -0,0 +1,225 @@
+/**
+ * @file table.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief ORM表描述及C++代码生成
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_ORM_TABLE__H__
+#define __SYLAR_ORM_TABLE__H__
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sylar/tools/orm_gen/xml.h"
+
+namespace sylar {
+namespace orm {
+
+/// @brief 列描述, 对应<column>
+class Column {
+public:
+  typedef std::shared_ptr<Column> ptr;
+
+  /// @brief 列类型
+  enum Type {
+    TYPE_NULL = 0,
+    TYPE_INT8,
+    TYPE_UINT8,
+    TYPE_INT16,
+    TYPE_UINT16,
+    TYPE_INT32,
+    TYPE_UINT32,
+    TYPE_INT64,
+    TYPE_UINT64,
+    TYPE_FLOAT,
+    TYPE_DOUBLE,
+    TYPE_STRING,
+    TYPE_TEXT,
+    TYPE_BLOB,
+    TYPE_TIMESTAMP,
+  };
+
+  /// @brief 类型名转换为Type, 未知类型返回TYPE_NULL
+  static Type ParseType(const std::string &v);
+
+  bool init(const XmlElement &node, std::string &err);
+
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  const std::string &getDesc() const {
+    return m_desc;
+  }
+
+  const std::string &getDefault() const {
+    return m_default;
+  }
+
+  Type getDType() const {
+    return m_dtype;
+  }
+
+  bool isAutoIncrement() const {
+    return m_autoIncrement;
+  }
+
+  bool isInteger() const {
+    return m_dtype >= TYPE_INT8 && m_dtype <= TYPE_UINT64;
+  }
+
+  bool isString() const {
+    return m_dtype == TYPE_STRING || m_dtype == TYPE_TEXT;
+  }
+
+  /// @brief 默认值是否为当前时间
+  bool isDefaultNow() const {
+    return m_dtype == TYPE_TIMESTAMP && m_default == "current_timestamp";
+  }
+
+  /// @brief 更新时是否写入当前时间
+  bool isUpdateNow() const {
+    return m_dtype == TYPE_TIMESTAMP && m_update == "current_timestamp";
+  }
+
+  /// @brief 驼峰名, create_time -> CreateTime
+  std::string getCamelName() const;
+  /// @brief 成员变量名, create_time -> m_createTime
+  std::string getMemberName() const;
+  /// @brief C++类型
+  std::string getDTypeString() const;
+  /// @brief SQLite3类型
+  std::string getSQLite3TypeString() const;
+  /// @brief IStmt绑定函数名
+  std::string getBindString() const;
+  /// @brief ISQLData读取函数名
+  std::string getGetString() const;
+  /// @brief 成员初始值
+  std::string getDefaultValueString() const;
+  /// @brief SQLite3列定义中的DEFAULT子句
+  std::string getSQLite3Default() const;
+
+private:
+  std::string m_name;
+  std::string m_type;
+  std::string m_desc;
+  std::string m_default;
+  std::string m_update;
+  int         m_length        = 0;
+  Type        m_dtype         = TYPE_NULL;
+  bool        m_autoIncrement = false;
+};
+
+/// @brief 索引描述, 对应<index>
+class Index {
+public:
+  typedef std::shared_ptr<Index> ptr;
+
+  /// @brief 索引类型
+  enum Type {
+    TYPE_NULL = 0,
+    TYPE_PK,
+    TYPE_UNIQ,
+    TYPE_INDEX,
+  };
+
+  bool init(const XmlElement &node, std::string &err);
+
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  const std::string &getDesc() const {
+    return m_desc;
+  }
+
+  const std::vector<std::string> &getCols() const {
+    return m_cols;
+  }
+
+  Type getDType() const {
+    return m_dtype;
+  }
+
+  bool isPK() const {
+    return m_dtype == TYPE_PK;
+  }
+
+  bool isUnique() const {
+    return m_dtype == TYPE_PK || m_dtype == TYPE_UNIQ;
+  }
+
+private:
+  std::string              m_name;
+  std::string              m_desc;
+  std::vector<std::string> m_cols;
+  Type                     m_dtype = TYPE_NULL;
+};
+
+/// @brief 表描述, 对应<table>, 生成数据结构和DAO
+class Table {
+public:
+  typedef std::shared_ptr<Table> ptr;
+
+  bool init(const XmlElement &root, std::string &err);
+
+  /// @brief 生成代码
+  /// @param out_dir 输出目录
+  /// @param base 输出文件名前缀, 生成base_info.h和base_info.cc
+  /// @param include_prefix 生成的cc引用头文件的路径前缀
+  /// @param source 描述文件名, 写入生成文件的注释
+  bool gen(const std::string &out_dir,
+           const std::string &base,
+           const std::string &include_prefix,
+           const std::string &source,
+           std::string       &err);
+
+  const std::string &getName() const {
+    return m_name;
+  }
+
+  /// @brief 数据结构类名, user -> UserInfo
+  std::string getClassName() const;
+  /// @brief DAO类名, user -> UserInfoDao
+  std::string getDaoClassName() const;
+
+private:
+  void genHeader(std::ostream &os, const std::string &source) const;
+  void genSource(std::ostream      &os,
+                 const std::string &include,
+                 const std::string &source) const;
+  void genClass(std::ostream &os) const;
+  void genDaoDecl(std::ostream &os) const;
+  void genDao(std::ostream &os) const;
+  void genCreateTable(std::ostream &os) const;
+
+  Column::ptr getCol(const std::string &name) const;
+  /// @brief 按索引列生成的函数名后缀, name,email -> NameEmail
+  std::string getIndexSuffix(Index::ptr idx) const;
+  /// @brief 按索引列生成的参数列表, const std::string &name, ...
+  std::string getIndexParams(Index::ptr idx) const;
+  /// @brief 按索引列生成的where子句, name = ? AND email = ?
+  std::string getIndexWhere(Index::ptr idx) const;
+  bool        isPKCol(const std::string &name) const;
+
+private:
+  std::string              m_name;
+  std::string              m_namespace;
+  std::string              m_desc;
+  std::vector<Column::ptr> m_cols;
+  std::vector<Index::ptr>  m_idxs;
+  Index::ptr               m_pk;
+  Column::ptr              m_autoIncrement;
+};
+
+}  // namespace orm
+}  // namespace sylar
+
+#endif /* __SYLAR_ORM_TABLE__H__ */
@@ -0,0 +1,275 @@
+#include "sylar/tools/orm_gen/xml.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace sylar {
+namespace orm {
+
+namespace {
+
+/// @brief 递归下降解析器, 支持元素, 属性, 注释, 声明和CDATA
+class XmlParser {
+public:
+  XmlParser(const std::string &text) : m_text(text) {
+  }
+
+  bool parse(XmlElement &root, std::string &err) {
+    skipMisc();
+    if (!parseElement(root)) {
+      err = m_err;
+      return false;
+    }
+    skipMisc();
+    if (m_pos != m_text.size()) {
+      error("unexpected content after root element");
+      err = m_err;
+      return false;
+    }
+    return true;
+  }
+
+private:
+  bool eof() const {
+    return m_pos >= m_text.size();
+  }
+
+  bool startsWith(const char *s) const {
+    return m_text.compare(m_pos, strlen(s), s) == 0;
+  }
+
+  void advance(size_t n) {
+    for (size_t i = 0; i < n && m_pos < m_text.size(); ++i, ++m_pos) {
+      if (m_text[m_pos] == '\n') {
+        ++m_line;
+      }
+    }
+  }
+
+  /// @brief 跳到end之后, 不存在时返回false
+  bool skipPast(const char *end) {
+    size_t pos = m_text.find(end, m_pos);
+    if (pos == std::string::npos) {
+      return error(std::string("unterminated, expect '") + end + "'");
+    }
+    advance(pos + strlen(end) - m_pos);
+    return true;
+  }
+
+  void skipSpace() {
+    while (!eof() && isspace((unsigned char)m_text[m_pos])) {
+      advance(1);
+    }
+  }
+
+  /// @brief 跳过空白, 注释, 处理指令和DOCTYPE
+  bool skipMisc() {
+    while (true) {
+      skipSpace();
+      if (startsWith("<!--")) {
+        if (!skipPast("-->")) {
+          return false;
+        }
+      } else if (startsWith("<?")) {
+        if (!skipPast("?>")) {
+          return false;
+        }
+      } else if (startsWith("<!DOCTYPE")) {
+        if (!skipPast(">")) {
+          return false;
+        }
+      } else {
+        return true;
+      }
+    }
+  }
+
+  bool error(const std::string &msg) {
+    if (m_err.empty()) {
+      m_err = "line " + std::to_string(m_line) + ": " + msg;
+    }
+    return false;
+  }
+
+  static bool IsNameChar(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || c == '.' ||
+           c == ':';
+  }
+
+  bool parseName(std::string &name) {
+    size_t begin = m_pos;
+    while (!eof() && IsNameChar(m_text[m_pos])) {
+      advance(1);
+    }
+    if (begin == m_pos) {
+      return error("expect name");
+    }
+    name = m_text.substr(begin, m_pos - begin);
+    return true;
+  }
+
+  /// @brief 解码实体引用
+  bool decode(const std::string &raw, std::string &out) {
+    out.clear();
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (raw[i] != '&') {
+        out.push_back(raw[i]);
+        continue;
+      }
+      size_t end = raw.find(';', i);
+      if (end == std::string::npos) {
+        return error("bad entity in '" + raw + "'");
+      }
+      std::string ent = raw.substr(i + 1, end - i - 1);
+      if (ent == "lt") {
+        out.push_back('<');
+      } else if (ent == "gt") {
+        out.push_back('>');
+      } else if (ent == "amp") {
+        out.push_back('&');
+      } else if (ent == "quot") {
+        out.push_back('"');
+      } else if (ent == "apos") {
+        out.push_back('\'');
+      } else {
+        return error("unknown entity '&" + ent + ";'");
+      }
+      i = end;
+    }
+    return true;
+  }
+
+  bool parseAttrs(XmlElement &e) {
+    while (true) {
+      skipSpace();
+      if (eof()) {
+        return error("unterminated element <" + e.name + ">");
+      }
+      char c = m_text[m_pos];
+      if (c == '/' || c == '>') {
+        return true;
+      }
+      std::string key;
+      if (!parseName(key)) {
+        return false;
+      }
+      skipSpace();
+      if (eof() || m_text[m_pos] != '=') {
+        return error("expect '=' after attribute " + key);
+      }
+      advance(1);
+      skipSpace();
+      if (eof() || (m_text[m_pos] != '"' && m_text[m_pos] != '\'')) {
+        return error("expect quoted value for attribute " + key);
+      }
+      char   quote = m_text[m_pos];
+      size_t end   = m_text.find(quote, m_pos + 1);
+      if (end == std::string::npos) {
+        return error("unterminated value for attribute " + key);
+      }
+      std::string value;
+      if (!decode(m_text.substr(m_pos + 1, end - m_pos - 1), value)) {
+        return false;
+      }
+      if (!e.attrs.emplace(key, value).second) {
+        return error("duplicate attribute " + key + " in <" + e.name + ">");
+      }
+      advance(end + 1 - m_pos);
+    }
+  }
+
+  bool parseElement(XmlElement &e) {
+    if (eof() || m_text[m_pos] != '<') {
+      return error("expect '<'");
+    }
+    e.line = m_line;
+    advance(1);
+    if (!parseName(e.name) || !parseAttrs(e)) {
+      return false;
+    }
+    if (startsWith("/>")) {
+      advance(2);
+      return true;
+    }
+    advance(1);  // '>'
+
+    while (true) {
+      // 文本内容不参与描述, 直接跳过
+      while (!eof() && m_text[m_pos] != '<') {
+        advance(1);
+      }
+      if (eof()) {
+        return error("unterminated element <" + e.name + ">");
+      }
+      if (startsWith("</")) {
+        advance(2);
+        std::string name;
+        if (!parseName(name)) {
+          return false;
+        }
+        if (name != e.name) {
+          return error("mismatched </" + name + ">, expect </" + e.name +
+                       ">");
+        }
+        skipSpace();
+        if (eof() || m_text[m_pos] != '>') {
+          return error("expect '>' after </" + name);
+        }
+        advance(1);
+        return true;
+      }
+      if (startsWith("<!--")) {
+        if (!skipPast("-->")) {
+          return false;
+        }
+      } else if (startsWith("<![CDATA[")) {
+        if (!skipPast("]]>")) {
+          return false;
+        }
+      } else if (startsWith("<?")) {
+        if (!skipPast("?>")) {
+          return false;
+        }
+      } else {
+        e.children.emplace_back();
+        if (!parseElement(e.children.back())) {
+          return false;
+        }
+      }
+    }
+  }
+
+private:
+  const std::string &m_text;
+  size_t             m_pos  = 0;
+  int                m_line = 1;
+  std::string        m_err;
+};
+
+}  // namespace
+
+bool ParseXml(const std::string &text, XmlElement &root, std::string &err) {
+  XmlParser parser(text);
+  return parser.parse(root, err);
+}
+
+bool ParseXmlFile(const std::string &file, XmlElement &root, std::string &err) {
+  std::ifstream ifs(file);
+  if (!ifs) {
+    err = "open " + file + " failed";
+    return false;
+  }
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  if (!ParseXml(ss.str(), root, err)) {
+    err = file + ": " + err;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace orm
+}  // namespace sylar
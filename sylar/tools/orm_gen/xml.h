@@ -0,0 +1,56 @@
+/**
+ * @file xml.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief ORM描述文件使用的最小XML解析
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __SYLAR_ORM_XML__H__
+#define __SYLAR_ORM_XML__H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sylar {
+namespace orm {
+
+/// @brief XML元素, 只保留元素名, 属性和子元素, 忽略文本内容
+struct XmlElement {
+  std::string                        name;
+  std::map<std::string, std::string> attrs;
+  std::vector<XmlElement>            children;
+  /// 元素所在行号, 用于错误提示
+  int line = 0;
+
+  /// @brief 属性是否存在
+  bool hasAttr(const std::string &key) const {
+    return attrs.find(key) != attrs.end();
+  }
+
+  /// @brief 返回属性值, 不存在时返回def
+  std::string getAttr(const std::string &key,
+                      const std::string &def = "") const {
+    auto it = attrs.find(key);
+    return it == attrs.end() ? def : it->second;
+  }
+};
+
+/// @brief 解析XML文本
+/// @param text XML文本
+/// @param root 输出根元素
+/// @param err 失败时的错误信息
+/// @return 是否成功
+bool ParseXml(const std::string &text, XmlElement &root, std::string &err);
+
+/// @brief 读取并解析XML文件
+bool ParseXmlFile(const std::string &file, XmlElement &root, std::string &err);
+
+}  // namespace orm
+}  // namespace sylar
+
+#endif /* __SYLAR_ORM_XML__H__ */
@@ -0,0 +1,161 @@
+/**
+ * @file work_steal_queue.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief Chase-Lev 工作窃取双端队列
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __WORK_STEAL_QUEUE__H__
+#define __WORK_STEAL_QUEUE__H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "sylar/mutex.h"
+#include "sylar/noncopyable.h"
+
+namespace sylar {
+
+/// @brief Chase-Lev 工作窃取队列
+/// @details 所有者线程在bottom端push/pop(LIFO), 其他线程在top端steal(FIFO)
+///          实现参考 Lê et al. "Correct and Efficient Work-Stealing for Weak
+///          Memory Models"; 扩容后的旧数组延迟到析构时释放, 保证窃取者安全读取
+/// @tparam T 元素类型, 需可平凡拷贝(通常为指针)
+template <class T>
+class WorkStealQueue : Noncopyable {
+public:
+  /// @brief 构造函数
+  /// @param capacity 初始容量, 向上取整为2的幂
+  explicit WorkStealQueue(size_t capacity = 256) {
+    size_t cap = 1;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    m_arrays.emplace_back(new Array(cap));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+  }
+
+  /// @brief 压入元素, 仅所有者线程调用
+  void push(T item) {
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_acquire);
+    Array  *a = m_array.load(std::memory_order_relaxed);
+    if (b - t > int64_t(a->capacity()) - 1) {
+      a = grow(a, b, t);
+    }
+    a->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// @brief 弹出最近压入的元素, 仅所有者线程调用
+  /// @param[out] item 元素
+  /// @return 是否成功
+  bool pop(T &item) {
+    int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+    Array  *a = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+    if (t > b) {
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    item = a->get(b);
+    if (t == b) {
+      // 最后一个元素, 与窃取者竞争
+      bool ok = m_top.compare_exchange_strong(t,
+                                              t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed);
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      return ok;
+    }
+    return true;
+  }
+
+  /// @brief 窃取最早压入的元素, 任意线程调用
+  /// @param[out] item 元素
+  /// @return 是否成功, 队列为空或竞争失败时返回false
+  bool steal(T &item) {
+    int64_t t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    Array *a = m_array.load(std::memory_order_acquire);
+    item     = a->get(t);
+    return m_top.compare_exchange_strong(t,
+                                         t + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed);
+  }
+
+  /// @brief 元素数量(近似值)
+  size_t size() const {
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+    return b > t ? size_t(b - t) : 0;
+  }
+
+  /// @brief 是否为空(近似值)
+  bool empty() const {
+    return size() == 0;
+  }
+
+private:
+  /// @brief 环形数组
+  class Array {
+  public:
+    explicit Array(size_t capacity)
+        : m_mask(capacity - 1), m_data(new std::atomic<T>[capacity]) {
+    }
+
+    size_t capacity() const {
+      return m_mask + 1;
+    }
+
+    void put(int64_t i, T item) {
+      m_data[i & m_mask].store(item, std::memory_order_relaxed);
+    }
+
+    T get(int64_t i) const {
+      return m_data[i & m_mask].load(std::memory_order_relaxed);
+    }
+
+  private:
+    size_t                         m_mask;
+    std::unique_ptr<std::atomic<T>[]> m_data;
+  };
+
+  /// @brief 容量翻倍, 仅所有者线程调用
+  Array *grow(Array *a, int64_t b, int64_t t) {
+    Array *n = new Array(a->capacity() * 2);
+    for (int64_t i = t; i < b; ++i) {
+      n->put(i, a->get(i));
+    }
+    m_arrays.emplace_back(n);
+    m_array.store(n, std::memory_order_release);
+    return n;
+  }
+
+private:
+  alignas(kCacheLineSize) std::atomic<int64_t> m_top{0};
+  alignas(kCacheLineSize) std::atomic<int64_t> m_bottom{0};
+  std::atomic<Array *> m_array{nullptr};
+  /// 全部数组(含扩容前的旧数组), 仅所有者线程修改
+  std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
+}  // namespace sylar
+
+#endif /* __WORK_STEAL_QUEUE__H__ */
@@ -0,0 +1,185 @@
+#include "sylar/worker.h"
+
+#include <yaml-cpp/yaml.h>
+
+#include <vector>
+
+#include "sylar/config.h"
+#include "sylar/log.h"
+
+namespace sylar {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+template <>
+class LexicalCast<std::string, WorkerDefine> {
+public:
+  WorkerDefine operator()(const std::string &v) {
+    YAML::Node   n = YAML::Load(v);
+    WorkerDefine wd;
+    if (!n["thread_num"].IsDefined()) {
+      throw std::invalid_argument("thread_num is null");
+    }
+    wd.thread_num = n["thread_num"].as<size_t>();
+    if (n["cpus"].IsSequence()) {
+      wd.cpus = n["cpus"].as<std::vector<int> >();
+    }
+    return wd;
+  }
+};
+
+template <>
+class LexicalCast<WorkerDefine, std::string> {
+public:
+  std::string operator()(const WorkerDefine &i) {
+    YAML::Node n;
+    n["thread_num"] = i.thread_num;
+    if (!i.cpus.empty()) {
+      n["cpus"] = i.cpus;
+    }
+    std::stringstream ss;
+    ss << n;
+    return ss.str();
+  }
+};
+
+/// 线程池配置, 对应worker.yml的workers节点
+static ConfigVar<std::map<std::string, WorkerDefine> >::ptr g_worker_defines =
+    Config::Lookup("workers",
+                   std::map<std::string, WorkerDefine>(),
+                   "worker config");
+
+struct WorkerIniter {
+  WorkerIniter() {
+    g_worker_defines->addListener(
+        [](const std::map<std::string, WorkerDefine> &old_value,
+           const std::map<std::string, WorkerDefine> &new_value) {
+          WorkerMgr::GetInstance()->init(new_value);
+        });
+  }
+};
+
+static WorkerIniter __worker_init;
+
+WorkerManager::WorkerManager() {
+}
+
+WorkerManager::~WorkerManager() {
+  for (auto &i : m_retired) {
+    i.join();
+  }
+}
+
+void WorkerManager::add(Scheduler::ptr s) {
+  RWMutex::WriteLock lock(m_mutex);
+  m_datas.emplace(s->getName(), s);
+}
+
+Scheduler::ptr WorkerManager::get(const std::string &name) {
+  RWMutex::ReadLock lock(m_mutex);
+  auto              it = m_datas.find(name);
+  return it == m_datas.end() ? nullptr : it->second;
+}
+
+bool WorkerManager::init(const YAML::Node &workers) {
+  if (!workers.IsMap()) {
+    SYLAR_LOG_ERROR(g_logger) << "WorkerManager::init workers is not a map";
+    return false;
+  }
+  std::map<std::string, WorkerDefine> defines;
+  for (auto it = workers.begin(); it != workers.end(); ++it) {
+    std::string name   = it->first.as<std::string>();
+    YAML::Node  config = it->second;
+    if (!config["thread_num"].IsDefined()) {
+      SYLAR_LOG_ERROR(g_logger) << "WorkerManager::init worker " << name
+                                << " thread_num is null";
+      return false;
+    }
+    WorkerDefine &wd = defines[name];
+    wd.thread_num    = config["thread_num"].as<size_t>();
+    if (config["cpus"].IsSequence()) {
+      wd.cpus = config["cpus"].as<std::vector<int>>();
+    }
+  }
+  return init(defines);
+}
+
+bool WorkerManager::init(const std::map<std::string, WorkerDefine> &defines) {
+  Mutex::Lock lock(m_initMutex);
+  for (auto &i : defines) {
+    if (i.second.thread_num == 0) {
+      SYLAR_LOG_ERROR(g_logger) << "WorkerManager::init worker " << i.first
+                                << " thread_num is 0";
+      return false;
+    }
+  }
+  for (auto &i : defines) {
+    Scheduler::ptr old = get(i.first);
+    if (old && old->getThreadCount() == i.second.thread_num &&
+        old->getCpus() == i.second.cpus) {
+      continue;
+    }
+    Scheduler::ptr s(
+        new Scheduler(i.second.thread_num, i.first, i.second.cpus));
+    s->start();
+    {
+      RWMutex::WriteLock lock(m_mutex);
+      m_datas[i.first] = s;
+    }
+    if (old) {
+      // 可能在旧调度器的工作线程中触发, 由后台线程等待其执行完已提交的任务
+      m_retired.emplace_back([old]() { old->stop(); });
+    }
+  }
+  m_stop = getCount() == 0;
+  return true;
+}
+
+bool WorkerManager::loadFile(const std::string &file) {
+  try {
+    YAML::Node root = YAML::LoadFile(file);
+    return init(root["workers"]);
+  } catch (std::exception &ex) {
+    SYLAR_LOG_ERROR(g_logger) << "WorkerManager::loadFile " << file
+                              << " error: " << ex.what();
+  }
+  return false;
+}
+
+void WorkerManager::stop() {
+  std::vector<std::thread> retired;
+  {
+    Mutex::Lock lock(m_initMutex);
+    retired.swap(m_retired);
+  }
+  for (auto &i : retired) {
+    i.join();
+  }
+  if (m_stop) {
+    return;
+  }
+  std::map<std::string, Scheduler::ptr> datas;
+  {
+    RWMutex::WriteLock lock(m_mutex);
+    datas.swap(m_datas);
+  }
+  for (auto &i : datas) {
+    i.second->stop();
+  }
+  m_stop = true;
+}
+
+uint32_t WorkerManager::getCount() {
+  RWMutex::ReadLock lock(m_mutex);
+  return m_datas.size();
+}
+
+std::ostream &WorkerManager::dump(std::ostream &os) {
+  RWMutex::ReadLock lock(m_mutex);
+  for (auto &i : m_datas) {
+    i.second->dump(os) << std::endl;
+  }
+  return os;
+}
+
+}  // namespace sylar
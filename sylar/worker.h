@@ -0,0 +1,139 @@
+/**
+ * @file worker.h
+ * @author koritafei (koritafei@gmail.com)
+ * @brief 按名称管理的工作线程池
+ * @version 0.1
+ * @date 2023-08-02
+ *
+ * @copyright Copyright (c) 2023 by koritafei
+ *
+ */
+
+#ifndef __WORKER__H__
+#define __WORKER__H__
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sylar/mutex.h"
+#include "sylar/scheduler.h"
+#include "sylar/singleton.h"
+
+namespace YAML {
+class Node;
+}
+
+namespace sylar {
+
+/// @brief 工作线程池配置
+struct WorkerDefine {
+  /// 线程数量
+  size_t thread_num = 0;
+  /// 绑定的CPU列表
+  std::vector<int> cpus;
+
+  bool operator==(const WorkerDefine &oth) const {
+    return thread_num == oth.thread_num && cpus == oth.cpus;
+  }
+};
+
+/// @brief 工作线程池管理器
+/// @details 对应配置 workers 节点, 例如:
+///          workers:
+///              io:
+///                  thread_num: 8
+///                  cpus: [0, 1, 2, 3]
+///          配置重新加载时线程数或CPU列表变化的线程池会被替换: 创建新的调度器接收
+///          后续任务, 旧调度器在后台执行完已提交的任务后停止. 配置中删除的线程池保持运行.
+///          替换后不应再向之前get()得到的旧调度器提交任务
+class WorkerManager {
+public:
+  /// @brief 构造函数
+  WorkerManager();
+
+  /// @brief 析构函数, 等待被替换的调度器停止
+  ~WorkerManager();
+
+  /// @brief 添加调度器, 同名调度器已存在时忽略
+  /// @param s 调度器
+  void add(Scheduler::ptr s);
+
+  /// @brief 按名称获取调度器
+  /// @param name 名称
+  /// @return 调度器, 不存在返回nullptr
+  Scheduler::ptr get(const std::string &name);
+
+  /// @brief 按workers配置节点创建并启动调度器
+  /// @param workers workers 节点
+  /// @return 是否成功
+  bool init(const YAML::Node &workers);
+
+  /// @brief 按配置创建/替换调度器
+  /// @param defines 线程池名称到配置的映射
+  /// @return 是否成功
+  bool init(const std::map<std::string, WorkerDefine> &defines);
+
+  /// @brief 从yaml文件的workers节点初始化
+  /// @param file 配置文件路径
+  /// @return 是否成功
+  bool loadFile(const std::string &file);
+
+  /// @brief 停止全部调度器
+  void stop();
+
+  /// @brief 是否已停止
+  bool isStoped() const {
+    return m_stop;
+  }
+
+  /// @brief 调度器数量
+  uint32_t getCount();
+
+  /// @brief 在指定的调度器上调度协程
+  /// @param name 调度器名称
+  /// @param fc 协程或函数
+  /// @param thread 协程执行的线程序号, -1标识任意线程
+  /// @return 调度器是否存在
+  template <class FiberOrCb>
+  bool schedule(const std::string &name, FiberOrCb fc, int thread = -1) {
+    auto s = get(name);
+    if (!s) {
+      return false;
+    }
+    s->schedule(std::move(fc), thread);
+    return true;
+  }
+
+  /// @brief 输出全部调度器状态
+  std::ostream &dump(std::ostream &os);
+
+private:
+  RWMutex                               m_mutex;
+  std::map<std::string, Scheduler::ptr> m_datas;
+  bool                                  m_stop = false;
+  /// 串行化init, 保护m_retired
+  Mutex m_initMutex;
+  /// 停止被替换调度器的线程
+  std::vector<std::thread> m_retired;
+};
+
+/// @brief 工作线程池单例的Tag
+struct WorkerTag {};
+
+/// @brief 工作线程池管理器单例, 第N个实例
+/// @details 同一进程需要多组互相隔离的线程池(如测试中新旧两套配置并存)时使用不同的N,
+///          各组线程池在自己的管理器内按名称创建与查找
+template <int N = 0>
+using WorkerMgrN = sylar::Singleton<WorkerManager, WorkerTag, N>;
+
+/// 工作线程池管理器单例, 由workers配置驱动
+typedef WorkerMgrN<0> WorkerMgr;
+
+}  // namespace sylar
+
+#endif /* __WORKER__H__ */
@@ -283,6 +283,12 @@ def sylar_workspace(path_prefix = "", tf_repo_name = "", **kwargs):
         build_file = clean_dep("//third_party/openssl:BUILD"),
     )
 
+    native.new_local_repository(
+        name = "sqlite3",
+        path = "/usr",
+        build_file = clean_dep("//third_party/sqlite3:BUILD"),
+    )
+
     # jsoncpp
     jsoncpp_ver = kwargs.get("jsoncpp_ver", "1.9.3")
     jsoncpp_sha256 = kwargs.get("jsoncpp_sha256", "8593c1d69e703563d94d8c12244e2e18893eeb9a8a9f8aa3d09a327aa45c8f7d")